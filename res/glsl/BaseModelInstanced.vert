@@ -0,0 +1,32 @@
+#version 450
+
+#include "CameraDef.glsl"
+
+layout (location = 0) in vec3 inPosition;
+layout (location = 1) in vec3 inNormal;
+
+// Per instance (see SceneInstance)
+layout (location = 2) in mat4 inModelMatrix;
+layout (location = 6) in vec4 inColor;
+
+layout (location = 0) out VS_DATA {
+  // World space
+  vec4 wPosition;
+  vec4 wNormal;
+  vec4 color;
+} outVS;
+
+layout (set = 0, binding = 0) uniform CameraUniform {
+  CameraProperties camera;
+} uCamera;
+
+void main() {
+  outVS.wPosition = inModelMatrix * vec4(inPosition, 1.0);
+  outVS.wNormal = inModelMatrix * vec4(inNormal, 0.0);
+  outVS.color = inColor;
+
+  gl_Position =
+    uCamera.camera.viewProjection * outVS.wPosition;
+
+  gl_Position.y *= -1.0;
+}
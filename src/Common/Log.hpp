@@ -1,27 +1,49 @@
 #pragma once
 
 #include <stdio.h>
+#include "Logger.hpp"
 
-#define LOG_ERRORV(str, ...)                    \
-  printf("ERROR:%s: ", __FUNCTION__);           \
-  printf(str, __VA_ARGS__)
+/*
+   Messages below this level get compiled out entirely
+   (0 = info, 1 = warnings, 2 = errors only)
+*/
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL 0
+#endif
 
-#define LOG_WARNINGV(str, ...)                  \
-  printf("WARNING:%s: ", __FUNCTION__);         \
-  printf(str, __VA_ARGS__)
+// Comparing against 0 would warn (-Wtype-limits) in every translation unit
+#if LOG_MIN_LEVEL > 0
+#define LOG_IS_ENABLED(level) ((int)(level) >= LOG_MIN_LEVEL)
+#else
+#define LOG_IS_ENABLED(level) true
+#endif
 
-#define LOG_INFOV(str, ...)                     \
-  printf("INFO:%s: ", __FUNCTION__);            \
-  printf(str, __VA_ARGS__)
+// Errors don't go through the rate limiter - they never get dropped
+#define LOG_IMPL(level, ...)                                    \
+  do {                                                          \
+    if constexpr (LOG_IS_ENABLED(level)) {                      \
+      static ::Ondine::LogRateLimiter logRateLimiter;           \
+      if ((level) == ::Ondine::LogLevel::Error ||               \
+          logRateLimiter.allow(__FUNCTION__)) {                 \
+        ::Ondine::logMessage(level, __FUNCTION__, __VA_ARGS__); \
+      }                                                         \
+    }                                                           \
+  } while (0)
 
-#define LOG_ERROR(str)                          \
-  printf("ERROR:%s: ", __FUNCTION__);           \
-  printf(str)
+#define LOG_ERRORV(str, ...)                                    \
+  LOG_IMPL(::Ondine::LogLevel::Error, str, __VA_ARGS__)
 
-#define LOG_WARNING(str)                        \
-  printf("WARNING:%s: ", __FUNCTION__);         \
-  printf(str)
+#define LOG_WARNINGV(str, ...)                                  \
+  LOG_IMPL(::Ondine::LogLevel::Warning, str, __VA_ARGS__)
 
-#define LOG_INFO(str)                           \
-  printf("INFO:%s: ", __FUNCTION__);            \
-  printf(str)
+#define LOG_INFOV(str, ...)                                     \
+  LOG_IMPL(::Ondine::LogLevel::Info, str, __VA_ARGS__)
+
+#define LOG_ERROR(str)                                          \
+  LOG_IMPL(::Ondine::LogLevel::Error, str)
+
+#define LOG_WARNING(str)                                        \
+  LOG_IMPL(::Ondine::LogLevel::Warning, str)
+
+#define LOG_INFO(str)                                           \
+  LOG_IMPL(::Ondine::LogLevel::Info, str)
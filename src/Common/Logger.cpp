@@ -0,0 +1,335 @@
+#include <chrono>
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+#include "Logger.hpp"
+#include "Utils.hpp"
+#include "Memory.hpp"
+
+namespace Ondine {
+
+Logger *gLogger = nullptr;
+
+static const char *const LEVEL_NAMES[] = {
+  "INFO", "WARNING", "ERROR"
+};
+
+void Logger::init(
+  LogOutput output,
+  const char *path,
+  size_t maxFileSize,
+  uint32_t maxFileCount) {
+  mRings = nullptr;
+  mStopRequested = false;
+  mErrorPending = false;
+  mOutput = output;
+  mFile = stdout;
+  mPath = path;
+  mBytesWritten = 0;
+  mMaxFileSize = maxFileSize;
+  mMaxFileCount = maxFileCount;
+
+  if (mOutput == LogOutput::RotatingFile) {
+    openFile();
+  }
+
+  mRunning = true;
+  mWriter = std::thread([this] () {writerRuntime();});
+
+  // Make sure that whatever is still in the rings makes it out on exit()
+  atexit(flushLog);
+}
+
+void Logger::shutdown() {
+  if (!mRunning) {
+    return;
+  }
+
+  // Nothing new gets pushed from now on - pushers waiting for room bail out
+  mRunning.store(false, std::memory_order_release);
+
+  { // Tell the writer to finish what's left
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    mStopRequested = true;
+  }
+
+  mWake.notify_one();
+  mWriter.join();
+
+  // Anything that got pushed in between
+  drain();
+
+  if (mFile != stdout) {
+    fclose(mFile);
+    mFile = stdout;
+  }
+
+  /*
+    The rings themselves don't get freed - threads can outlive the logger
+    and hold on to them.
+  */
+}
+
+void Logger::push(
+  LogLevel level, const char *function,
+  const char *format, va_list args) {
+  char message[MAX_MESSAGE_LENGTH];
+
+  int prefixLength = snprintf(
+    message, MAX_MESSAGE_LENGTH, "%s:%s: ",
+    LEVEL_NAMES[(int)level], function);
+
+  int bodyLength = vsnprintf(
+    message + prefixLength, MAX_MESSAGE_LENGTH - prefixLength, format, args);
+
+  uint32_t length = (uint32_t)prefixLength + (uint32_t)MAX(bodyLength, 0);
+  if (length >= MAX_MESSAGE_LENGTH) {
+    // Truncated - at least keep the line ending
+    length = MAX_MESSAGE_LENGTH - 1;
+    message[length - 1] = '\n';
+  }
+
+  uint32_t recordCount = (length + RECORD_TEXT_SIZE - 1) / RECORD_TEXT_SIZE;
+  Ring *ring = getThreadRing();
+
+  uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+  for (;;) {
+    uint32_t head = ring->head.load(std::memory_order_acquire);
+    if (RING_RECORD_COUNT - (tail - head) >= recordCount) {
+      break;
+    }
+
+    if (level == LogLevel::Error) {
+      if (!mRunning.load(std::memory_order_acquire)) {
+        // The writer is gone and won't make room - skip the ring
+        fwrite(message, 1, length, stdout);
+        fflush(stdout);
+        return;
+      }
+
+      // Errors never get dropped - wait for the writer to catch up
+      wakeWriter();
+      std::this_thread::yield();
+    }
+    else {
+      ring->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+
+  for (uint32_t i = 0; i < recordCount; ++i) {
+    Record &record = ring->records[(tail + i) % RING_RECORD_COUNT];
+    uint32_t offset = i * RECORD_TEXT_SIZE;
+    uint32_t chunkLength = MIN(RECORD_TEXT_SIZE, length - offset);
+
+    record.length = (uint16_t)chunkLength;
+    memcpy(record.text, message + offset, chunkLength);
+  }
+
+  ring->tail.store(tail + recordCount, std::memory_order_release);
+
+  if (level == LogLevel::Error) {
+    wakeWriter();
+  }
+}
+
+void Logger::flush() {
+  if (mRunning) {
+    drain();
+  }
+  else {
+    fflush(mFile);
+  }
+}
+
+bool Logger::isRunning() const {
+  return mRunning.load(std::memory_order_relaxed);
+}
+
+Logger::Ring *Logger::getThreadRing() {
+  static thread_local Ring *threadRing = nullptr;
+
+  if (!threadRing) {
+    Ring *ring = flAlloc<Ring>();
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+
+    std::unique_lock<std::mutex> lock(mRingRegistrationMutex);
+    ring->next = mRings.load(std::memory_order_relaxed);
+    mRings.store(ring, std::memory_order_release);
+
+    threadRing = ring;
+  }
+
+  return threadRing;
+}
+
+bool Logger::drain() {
+  std::unique_lock<std::mutex> lock(mDrainMutex);
+
+  bool wroteSomething = false;
+
+  for (
+    Ring *ring = mRings.load(std::memory_order_acquire);
+    ring;
+    ring = ring->next) {
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+
+    wroteSomething |= (head != tail);
+
+    while (head != tail) {
+      Record &record = ring->records[head % RING_RECORD_COUNT];
+      write(record.text, record.length);
+      ++head;
+    }
+
+    ring->head.store(head, std::memory_order_release);
+
+    uint32_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped) {
+      char message[64];
+      int length = snprintf(
+        message, sizeof(message),
+        "WARNING:Logger: dropped %u messages\n", dropped);
+      write(message, length);
+
+      wroteSomething = true;
+    }
+  }
+
+  if (wroteSomething) {
+    fflush(mFile);
+  }
+
+  return wroteSomething;
+}
+
+void Logger::writerRuntime() {
+  static constexpr auto WRITE_INTERVAL = std::chrono::milliseconds(5);
+
+  for (;;) {
+    bool stop;
+
+    {
+      std::unique_lock<std::mutex> lock(mWakeMutex);
+      mWake.wait_for(
+        lock, WRITE_INTERVAL,
+        [this] {return mStopRequested || mErrorPending;});
+
+      stop = mStopRequested;
+      mErrorPending = false;
+    }
+
+    drain();
+
+    if (stop) {
+      break;
+    }
+  }
+}
+
+void Logger::wakeWriter() {
+  {
+    std::unique_lock<std::mutex> lock(mWakeMutex);
+    mErrorPending = true;
+  }
+
+  mWake.notify_one();
+}
+
+void Logger::write(const char *text, size_t length) {
+  fwrite(text, 1, length, mFile);
+
+  if (mOutput == LogOutput::RotatingFile) {
+    mBytesWritten += length;
+    if (mBytesWritten >= mMaxFileSize) {
+      rotateFile();
+    }
+  }
+}
+
+void Logger::openFile() {
+  mFile = fopen(mPath, "w");
+  mBytesWritten = 0;
+
+  if (!mFile) {
+    printf(
+      "WARNING:%s: Failed to open log file %s, logging to stdout\n",
+      __FUNCTION__, mPath);
+
+    mFile = stdout;
+    mOutput = LogOutput::Stdout;
+  }
+}
+
+void Logger::rotateFile() {
+  fclose(mFile);
+
+  // <path>.n-1 -> <path>.n, ..., <path> -> <path>.1
+  for (uint32_t i = mMaxFileCount - 1; i > 0; --i) {
+    std::string from = std::string(mPath);
+    if (i > 1) {
+      from += "." + std::to_string(i - 1);
+    }
+
+    std::string to = std::string(mPath) + "." + std::to_string(i);
+
+    remove(to.c_str());
+    rename(from.c_str(), to.c_str());
+  }
+
+  openFile();
+}
+
+bool LogRateLimiter::allow(const char *function) {
+  using namespace std::chrono;
+
+  uint32_t now = (uint32_t)duration_cast<seconds>(
+    steady_clock::now().time_since_epoch()).count();
+
+  uint32_t window = mWindow.load(std::memory_order_relaxed);
+  if (window != now &&
+      mWindow.compare_exchange_strong(window, now, std::memory_order_relaxed)) {
+    uint32_t previousCount = mCount.exchange(0, std::memory_order_relaxed);
+
+    if (previousCount > MAX_MESSAGES_PER_SECOND) {
+      logMessage(
+        LogLevel::Warning, function, "Suppressed %u messages\n",
+        previousCount - MAX_MESSAGES_PER_SECOND);
+    }
+  }
+
+  return mCount.fetch_add(1, std::memory_order_relaxed) <
+    MAX_MESSAGES_PER_SECOND;
+}
+
+void logMessage(
+  LogLevel level, const char *function,
+  const char *format, ...) {
+  va_list args;
+  va_start(args, format);
+
+  if (gLogger && gLogger->isRunning()) {
+    gLogger->push(level, function, format, args);
+  }
+  else {
+    // Logger isn't up (yet / anymore) - just write straight to stdout
+    printf("%s:%s: ", LEVEL_NAMES[(int)level], function);
+    vprintf(format, args);
+  }
+
+  va_end(args);
+}
+
+void flushLog() {
+  if (gLogger) {
+    gLogger->flush();
+  }
+  else {
+    fflush(stdout);
+  }
+}
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <stdio.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <condition_variable>
+
+namespace Ondine {
+
+enum class LogLevel : uint8_t {
+  Info,
+  Warning,
+  Error
+};
+
+enum class LogOutput {
+  Stdout,
+  // Rotates through <path>, <path>.1, ... <path>.n once the file gets too big
+  RotatingFile
+};
+
+/*
+  Every thread that logs gets its own single producer / single consumer
+  ring of fixed size records. The calling thread only ever formats the
+  message and copies it in - all the actual I/O happens on the writer thread.
+*/
+class Logger {
+public:
+  void init(
+    LogOutput output = LogOutput::Stdout,
+    const char *path = nullptr,
+    size_t maxFileSize = 4 * 1024 * 1024,
+    uint32_t maxFileCount = 4);
+
+  void shutdown();
+
+  void push(
+    LogLevel level, const char *function,
+    const char *format, va_list args);
+
+  // Blocks until everything which was pushed so far has been written out
+  void flush();
+
+  bool isRunning() const;
+
+private:
+  static constexpr uint32_t RECORD_SIZE = 256;
+  static constexpr uint32_t RING_RECORD_COUNT = 512;
+  // Longer messages get truncated
+  static constexpr uint32_t MAX_MESSAGE_LENGTH = 4096;
+
+  // Messages longer than one record span several consecutive ones
+  struct Record {
+    uint16_t length;
+    char text[RECORD_SIZE - sizeof(uint16_t)];
+  };
+
+  static constexpr uint32_t RECORD_TEXT_SIZE = sizeof(Record::text);
+
+  struct Ring {
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> dropped;
+    Record records[RING_RECORD_COUNT];
+    Ring *next;
+  };
+
+  Ring *getThreadRing();
+  // Returns whether or not anything was written
+  bool drain();
+  void writerRuntime();
+  // Makes the writer drain the rings now instead of at the next interval
+  void wakeWriter();
+  void write(const char *text, size_t length);
+  void openFile();
+  void rotateFile();
+
+private:
+  std::atomic<bool> mRunning;
+  std::atomic<Ring *> mRings;
+  std::mutex mRingRegistrationMutex;
+
+  // Only one thread may consume from the rings at any time
+  std::mutex mDrainMutex;
+
+  std::thread mWriter;
+  std::mutex mWakeMutex;
+  std::condition_variable mWake;
+  bool mStopRequested;
+  // An error was pushed - set under mWakeMutex
+  bool mErrorPending;
+
+  LogOutput mOutput;
+  FILE *mFile;
+  const char *mPath;
+  size_t mBytesWritten;
+  size_t mMaxFileSize;
+  uint32_t mMaxFileCount;
+};
+
+extern Logger *gLogger;
+
+/*
+  Limits how many messages a single call site can emit per second - stops
+  a log in a per frame path from flooding the output.
+*/
+class LogRateLimiter {
+public:
+  static constexpr uint32_t MAX_MESSAGES_PER_SECOND = 128;
+
+  bool allow(const char *function);
+
+private:
+  std::atomic<uint32_t> mWindow {};
+  std::atomic<uint32_t> mCount {};
+};
+
+#ifdef __GNUC__
+__attribute__((format(printf, 3, 4)))
+#endif
+void logMessage(
+  LogLevel level, const char *function,
+  const char *format, ...);
+
+// Called when things go horribly wrong (PANIC_AND_EXIT)
+void flushLog();
+
+}
@@ -18,4 +18,42 @@ ImagePixels getImagePixelsFromBuffer(const Buffer &data) {
   return ret;
 }
 
+uint64_t *radixSort(
+  uint64_t *keys, uint64_t *scratch, uint32_t count,
+  uint32_t firstBit, uint32_t lastBit) {
+  uint64_t *src = keys;
+  uint64_t *dst = scratch;
+
+  if (count == 0) {
+    return src;
+  }
+
+  for (uint32_t shift = firstBit; shift < lastBit; shift += 8) {
+    uint32_t histogram[256] = {};
+    for (uint32_t i = 0; i < count; ++i) {
+      ++histogram[(src[i] >> shift) & 0xFF];
+    }
+
+    // All keys have the same digit - this pass wouldn't change anything
+    if (histogram[(src[0] >> shift) & 0xFF] == count) {
+      continue;
+    }
+
+    uint32_t offset = 0;
+    for (uint32_t digit = 0; digit < 256; ++digit) {
+      uint32_t digitCount = histogram[digit];
+      histogram[digit] = offset;
+      offset += digitCount;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+      dst[histogram[(src[i] >> shift) & 0xFF]++] = src[i];
+    }
+
+    std::swap(src, dst);
+  }
+
+  return src;
+}
+
 }
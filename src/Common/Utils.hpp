@@ -6,6 +6,7 @@
 #include <malloc.h>
 #include <string.h>
 #include "Buffer.hpp"
+#include "Logger.hpp"
 
 #define STACK_ALLOC(type, n) (type *)alloca(sizeof(type) * (n))
 #define BIT(n) (1 << n)
@@ -27,6 +28,7 @@
 #endif
 
 #define PANIC_AND_EXIT()                        \
+  ::Ondine::flushLog();                         \
   printf("\n***STOPPING SESSION***\n");         \
   exit(-1)
 
@@ -49,6 +51,25 @@ inline uint32_t popCount(
 #endif
 }
 
+inline uint32_t popCount64(uint64_t bits) {
+#ifndef __GNUC__
+    return (uint32_t)__popcnt64(bits);
+#else
+    return __builtin_popcountll(bits);
+#endif
+}
+
+// Index of the lowest set bit (bits can't be 0)
+inline uint32_t lowestBit64(uint64_t bits) {
+#ifndef __GNUC__
+    unsigned long index;
+    _BitScanForward64(&index, bits);
+    return index;
+#else
+    return __builtin_ctzll(bits);
+#endif
+}
+
 inline void zeroMemory(void *ptr, uint32_t size) {
   memset(ptr, 0, size);
 }
@@ -67,6 +88,15 @@ struct ImagePixels {
 
 ImagePixels getImagePixelsFromBuffer(const Buffer &data);
 
+/*
+   Stable LSD radix sort (8 bits per pass) of the keys on bits [firstBit,
+   lastBit). Scratch needs to be able to hold count keys. Returns whichever
+   of keys / scratch ended up with the sorted keys.
+*/
+uint64_t *radixSort(
+  uint64_t *keys, uint64_t *scratch, uint32_t count,
+  uint32_t firstBit = 0, uint32_t lastBit = 64);
+
 // Only use very rarely to avoid return warning in functions that PANIC_AND_EXIT
 template <typename T>
 struct NullReference {
@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <assert.h>
+#include "Log.hpp"
+#include "Memory.hpp"
+#include "AsyncIO.hpp"
+#include "FileEvent.hpp"
+
+namespace Ondine::Core {
+
+AsyncIO *gAsyncIO = nullptr;
+
+void AsyncIO::init() {
+  mStopRequested = false;
+  mNextID = 0;
+  mThread = std::thread([this] () {runtime();});
+}
+
+void AsyncIO::shutdown() {
+  { // Whatever is still queued gets finished first
+    std::unique_lock<std::mutex> lock(mMutex);
+    mStopRequested = true;
+  }
+
+  mRequestsAvailable.notify_one();
+  mThread.join();
+}
+
+IORequestID AsyncIO::submit(const IORequest &request) {
+  IORequestID id;
+  submit(&request, 1, &id);
+  return id;
+}
+
+void AsyncIO::submit(
+  const IORequest *requests, uint32_t count, IORequestID *ids) {
+  { // Paths get resolved here so that the I/O thread never touches gFileSystem
+    std::unique_lock<std::mutex> lock(mMutex);
+
+    for (uint32_t i = 0; i < count; ++i) {
+      IORequestID id = mNextID++;
+
+      PendingRequest &pending = mRequests[id];
+      pending.request = requests[i];
+      pending.fullPath = gFileSystem->getFullPath(
+        requests[i].mountPoint, requests[i].path);
+      pending.status = IOStatus::Queued;
+      pending.bytesTransferred = 0;
+
+      mQueues[(int)requests[i].priority].push_back(id);
+
+      if (ids) {
+        ids[i] = id;
+      }
+    }
+  }
+
+  mRequestsAvailable.notify_one();
+}
+
+bool AsyncIO::cancel(IORequestID id) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  auto request = mRequests.find(id);
+  if (request == mRequests.end() ||
+      request->second.status != IOStatus::Queued) {
+    return false;
+  }
+
+  auto &queue = mQueues[(int)request->second.request.priority];
+  for (auto it = queue.begin(); it != queue.end(); ++it) {
+    if (*it == id) {
+      queue.erase(it);
+      break;
+    }
+  }
+
+  request->second.status = IOStatus::Cancelled;
+  mCompleted.push_back(id);
+  mRequestsCompleted.notify_all();
+
+  return true;
+}
+
+IOCompletion AsyncIO::wait(IORequestID id) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  auto request = mRequests.find(id);
+  assert(request != mRequests.end());
+
+  mRequestsCompleted.wait(lock, [&request] {
+    return request->second.status != IOStatus::Queued &&
+      request->second.status != IOStatus::InProgress;
+  });
+
+  IOCompletion completion = makeCompletion(id, request->second);
+
+  // Make sure tick() doesn't dispatch this one
+  for (auto it = mCompleted.begin(); it != mCompleted.end(); ++it) {
+    if (*it == id) {
+      mCompleted.erase(it);
+      break;
+    }
+  }
+
+  mRequests.erase(request);
+
+  return completion;
+}
+
+void AsyncIO::tick(OnEventProc onEventProc) {
+  struct Dispatch {
+    IOCompletion completion;
+    IOCompletionProc proc;
+  };
+
+  std::vector<Dispatch> dispatches;
+
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    if (mCompleted.empty()) {
+      return;
+    }
+
+    dispatches.reserve(mCompleted.size());
+    for (auto id : mCompleted) {
+      auto request = mRequests.find(id);
+      dispatches.push_back({
+        makeCompletion(id, request->second),
+        request->second.request.onComplete});
+
+      mRequests.erase(request);
+    }
+
+    mCompleted.clear();
+  }
+
+  // Callbacks are free to submit new requests
+  for (auto &dispatch : dispatches) {
+    if (dispatch.proc) {
+      dispatch.proc(dispatch.completion);
+    }
+    else {
+      auto *ioComplete = lnEmplaceAlloc<EventIOComplete>();
+      ioComplete->completion = dispatch.completion;
+      onEventProc(ioComplete);
+    }
+  }
+}
+
+void AsyncIO::runtime() {
+  struct {
+    IORequestID id;
+    /*
+       Safe to use without the lock - nobody else touches a request which
+       is in progress and unordered_map doesn't move its elements
+    */
+    PendingRequest *request;
+  } batch[IO_BATCH_SIZE];
+
+  for (;;) {
+    uint32_t batchSize = 0;
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mRequestsAvailable.wait(lock, [this] {
+        bool hasRequests = false;
+        for (auto &queue : mQueues) {
+          hasRequests |= !queue.empty();
+        }
+
+        return hasRequests || mStopRequested;
+      });
+
+      // Highest priority first
+      for (auto &queue : mQueues) {
+        while (!queue.empty() && batchSize < IO_BATCH_SIZE) {
+          IORequestID id = queue.front();
+          queue.pop_front();
+
+          PendingRequest &request = mRequests[id];
+          request.status = IOStatus::InProgress;
+
+          batch[batchSize++] = {id, &request};
+        }
+      }
+
+      if (!batchSize && mStopRequested) {
+        break;
+      }
+    }
+
+    for (uint32_t i = 0; i < batchSize; ++i) {
+      IOStatus status = process(*batch[i].request);
+
+      {
+        std::unique_lock<std::mutex> lock(mMutex);
+        batch[i].request->status = status;
+        mCompleted.push_back(batch[i].id);
+      }
+
+      mRequestsCompleted.notify_all();
+    }
+  }
+}
+
+IOStatus AsyncIO::process(PendingRequest &pending) {
+  IORequest &request = pending.request;
+  FILE *file = nullptr;
+
+  if (request.operation == IOOperation::Read) {
+    file = fopen(pending.fullPath.c_str(), "rb");
+  }
+  else {
+    // Writing at an offset shouldn't truncate the file
+    if (request.offset) {
+      file = fopen(pending.fullPath.c_str(), "r+b");
+    }
+
+    if (!file) {
+      file = fopen(pending.fullPath.c_str(), "wb");
+    }
+  }
+
+  if (!file) {
+    LOG_ERRORV("Failed to open %s\n", pending.fullPath.c_str());
+    return IOStatus::Failed;
+  }
+
+  if (request.operation == IOOperation::Read) {
+    fseek(file, 0, SEEK_END);
+    size_t fileSize = ftell(file);
+    size_t available = fileSize > request.offset ?
+      fileSize - request.offset : 0;
+
+    if (!request.buffer.data) {
+      request.buffer.size = available;
+      request.buffer.data = flAllocv<uint8_t>(available);
+    }
+
+    fseek(file, (long)request.offset, SEEK_SET);
+    pending.bytesTransferred = fread(
+      request.buffer.data, 1, MIN(available, request.buffer.size), file);
+  }
+  else {
+    fseek(file, (long)request.offset, SEEK_SET);
+    pending.bytesTransferred = fwrite(
+      request.buffer.data, 1, request.buffer.size, file);
+  }
+
+  fclose(file);
+
+  // Short reads (file too small) and short writes (disk full) both fail
+  if (pending.bytesTransferred != request.buffer.size) {
+    LOG_ERRORV(
+      "Only transferred %zu out of %zu bytes for %s\n",
+      pending.bytesTransferred, (size_t)request.buffer.size,
+      pending.fullPath.c_str());
+
+    return IOStatus::Failed;
+  }
+
+  return IOStatus::Completed;
+}
+
+IOCompletion AsyncIO::makeCompletion(
+  IORequestID id, const PendingRequest &pending) {
+  IOCompletion completion = {};
+  completion.id = id;
+  completion.operation = pending.request.operation;
+  completion.status = pending.status;
+  completion.buffer = pending.request.buffer;
+  completion.bytesTransferred = pending.bytesTransferred;
+  completion.userData = pending.request.userData;
+  return completion;
+}
+
+}
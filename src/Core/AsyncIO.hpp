@@ -0,0 +1,130 @@
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+#include <condition_variable>
+
+#include "Buffer.hpp"
+#include "Event.hpp"
+#include "FileSystem.hpp"
+
+namespace Ondine::Core {
+
+using IORequestID = uint32_t;
+
+enum class IOOperation : uint8_t {
+  Read,
+  Write
+};
+
+enum class IOPriority : uint8_t {
+  High,
+  Normal,
+  Low,
+  Count
+};
+
+enum class IOStatus : uint8_t {
+  Queued,
+  InProgress,
+  Completed,
+  Failed,
+  Cancelled
+};
+
+struct IOCompletion {
+  IORequestID id;
+  IOOperation operation;
+  IOStatus status;
+  /*
+     For reads which didn't provide a destination, this is a buffer allocated
+     with flAllocv which the receiver now owns
+  */
+  Buffer buffer;
+  size_t bytesTransferred;
+  void *userData;
+};
+
+using IOCompletionProc = void (*)(const IOCompletion &completion);
+
+struct IORequest {
+  IOOperation operation;
+  MountPoint mountPoint;
+  /* Path relative to the mount point */
+  std::string path;
+  /*
+     Reads: destination (if data is null, the rest of the file from offset
+     gets read into a newly allocated buffer)
+     Writes: source - needs to stay alive until the request completes
+  */
+  Buffer buffer;
+  size_t offset;
+  IOPriority priority;
+  /* If null, an EventIOComplete gets posted instead */
+  IOCompletionProc onComplete;
+  void *userData;
+};
+
+/*
+   Runs file reads / writes on a dedicated I/O thread. Completions get
+   handed back on whichever thread calls tick() (the main thread).
+*/
+class AsyncIO {
+public:
+  void init();
+  void shutdown();
+
+  IORequestID submit(const IORequest &request);
+  // Queues all requests at once (single lock / wake up)
+  void submit(const IORequest *requests, uint32_t count, IORequestID *ids);
+
+  // Fails if the I/O thread already picked up the request
+  bool cancel(IORequestID id);
+
+  /*
+     Blocks until the request is done. The completion gets returned here
+     and won't be dispatched by tick().
+  */
+  IOCompletion wait(IORequestID id);
+
+  // Dispatches all completions which haven't been waited on
+  void tick(OnEventProc onEventProc);
+
+private:
+  struct PendingRequest {
+    IORequest request;
+    std::string fullPath;
+    IOStatus status;
+    size_t bytesTransferred;
+  };
+
+  void runtime();
+  IOStatus process(PendingRequest &request);
+  IOCompletion makeCompletion(IORequestID id, const PendingRequest &request);
+
+private:
+  // How many requests the I/O thread grabs every time it takes the lock
+  static constexpr uint32_t IO_BATCH_SIZE = 16;
+
+  std::thread mThread;
+  std::mutex mMutex;
+  // I/O thread waits on this for new requests
+  std::condition_variable mRequestsAvailable;
+  // wait() waits on this for completions
+  std::condition_variable mRequestsCompleted;
+  bool mStopRequested;
+
+  IORequestID mNextID;
+  std::unordered_map<IORequestID, PendingRequest> mRequests;
+  std::deque<IORequestID> mQueues[(int)IOPriority::Count];
+  std::vector<IORequestID> mCompleted;
+};
+
+extern AsyncIO *gAsyncIO;
+
+}
@@ -24,8 +24,10 @@ enum class EventType {
   CursorDisplayChange,
   Breakpoint,
   PathChanged,
+  IOComplete,
   ViewHierarchyChange,
   TerrainToolChange,
+  TerrainGenerationProgress,
   Invalid
 };
 
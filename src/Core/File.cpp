@@ -32,6 +32,12 @@ Buffer File::readBinary() {
   return buffer;
 }
 
+FileMapping File::map(FileAccessHint hint) {
+  FileMapping mapping;
+  mapping.init(path, hint);
+  return mapping;
+}
+
 std::string File::readText() {
   std::string output;
   output.reserve(size);
@@ -6,6 +6,7 @@
 #include <iostream>
 #include "Utils.hpp"
 #include "Buffer.hpp"
+#include "FileMapping.hpp"
 
 namespace Ondine::Core {
 
@@ -31,8 +32,10 @@ public:
   File(const std::string &path, FileOpenTypeBits type);
   File(const File &other);
 
-  /* Returns the number of bytes read */
+  /* The returned buffer is owned by the caller (flFreev) */
   Buffer readBinary();
+  /* Prefer this for read-only access - doesn't copy anything */
+  FileMapping map(FileAccessHint hint = FileAccessHint::Sequential);
   std::string readText();
 
   /* Returns the number of bytes written */
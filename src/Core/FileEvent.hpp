@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Event.hpp"
+#include "AsyncIO.hpp"
 #include "FileSystem.hpp"
 
 namespace Ondine::Core {
@@ -12,4 +13,11 @@ struct EventPathChanged : Event {
   TrackPathID id;
 };
 
+/* Posted for finished async I/O requests which didn't have a callback */
+struct EventIOComplete : Event {
+  EVENT_DEF(EventIOComplete, File, IOComplete);
+
+  IOCompletion completion;
+};
+
 }
@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include "Log.hpp"
+#include "Memory.hpp"
+#include "FileMapping.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace Ondine::Core {
+
+FileMapping::FileMapping(const FileMapping &other)
+  : mRegion(other.mRegion) {
+  if (mRegion) {
+    mRegion->refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+FileMapping &FileMapping::operator=(const FileMapping &other) {
+  if (other.mRegion) {
+    other.mRegion->refCount.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  release();
+  mRegion = other.mRegion;
+
+  return *this;
+}
+
+FileMapping::~FileMapping() {
+  release();
+}
+
+static bool readIntoMemory(const std::string &path, uint8_t **data, size_t *size) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  *size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+
+  *data = flAllocv<uint8_t>(*size);
+  fread(*data, 1, *size, file);
+  fclose(file);
+
+  return true;
+}
+
+bool FileMapping::init(const std::string &path, FileAccessHint hint) {
+  release();
+
+  Region *region = flAlloc<Region>();
+  region->base = nullptr;
+  region->size = 0;
+  region->refCount = 1;
+  region->isHeap = false;
+
+#ifdef _WIN32
+  region->fileHandle = INVALID_HANDLE_VALUE;
+  region->mappingHandle = NULL;
+
+  DWORD flags = FILE_ATTRIBUTE_NORMAL;
+  if (hint == FileAccessHint::Sequential) {
+    flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+  }
+  else if (hint == FileAccessHint::Random) {
+    flags |= FILE_FLAG_RANDOM_ACCESS;
+  }
+
+  HANDLE file = CreateFileA(
+    path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+    OPEN_EXISTING, flags, NULL);
+
+  if (file == INVALID_HANDLE_VALUE) {
+    LOG_ERRORV("Couldn't find file %s\n", path.c_str());
+    flFree(region);
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  GetFileSizeEx(file, &fileSize);
+  region->size = (size_t)fileSize.QuadPart;
+  region->fileHandle = file;
+
+  if (region->size) {
+    HANDLE mapping = CreateFileMappingA(
+      file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+    if (mapping) {
+      region->mappingHandle = mapping;
+      region->base = (uint8_t *)MapViewOfFile(
+        mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+  }
+#else
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_ERRORV("Couldn't find file %s\n", path.c_str());
+    flFree(region);
+    return false;
+  }
+
+  struct stat fileStat;
+  fstat(fd, &fileStat);
+  region->size = (size_t)fileStat.st_size;
+
+  if (region->size) {
+    void *base = mmap(
+      nullptr, region->size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    if (base != MAP_FAILED) {
+      region->base = (uint8_t *)base;
+
+      int advice = MADV_SEQUENTIAL;
+      if (hint == FileAccessHint::Random) {
+        advice = MADV_RANDOM;
+      }
+      else if (hint == FileAccessHint::WillNeed) {
+        advice = MADV_WILLNEED;
+      }
+
+      madvise(base, region->size, advice);
+    }
+  }
+
+  // The mapping stays valid after the descriptor gets closed
+  close(fd);
+#endif
+
+  if (region->size && !region->base) {
+    LOG_WARNINGV("Failed to map %s, reading it instead\n", path.c_str());
+
+    // Whatever handles were opened get cleaned up when the region is freed
+    mRegion = region;
+    if (!readIntoMemory(path, &region->base, &region->size)) {
+      release();
+      return false;
+    }
+
+    region->isHeap = true;
+  }
+
+  mRegion = region;
+
+  return true;
+}
+
+void FileMapping::release() {
+  if (!mRegion) {
+    return;
+  }
+
+  if (mRegion->refCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    if (mRegion->isHeap) {
+      flFreev(mRegion->base);
+    }
+#ifdef _WIN32
+    else if (mRegion->base) {
+      UnmapViewOfFile(mRegion->base);
+    }
+
+    if (mRegion->mappingHandle) {
+      CloseHandle(mRegion->mappingHandle);
+    }
+
+    if (mRegion->fileHandle != INVALID_HANDLE_VALUE) {
+      CloseHandle(mRegion->fileHandle);
+    }
+#else
+    else if (mRegion->base) {
+      munmap(mRegion->base, mRegion->size);
+    }
+#endif
+
+    flFree(mRegion);
+  }
+
+  mRegion = nullptr;
+}
+
+bool FileMapping::isValid() const {
+  return mRegion != nullptr;
+}
+
+const uint8_t *FileMapping::data() const {
+  return mRegion ? mRegion->base : nullptr;
+}
+
+size_t FileMapping::size() const {
+  return mRegion ? mRegion->size : 0;
+}
+
+Buffer FileMapping::view() const {
+  return {(uint8_t *)data(), size()};
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <stdint.h>
+#include <stddef.h>
+#include "Buffer.hpp"
+
+namespace Ondine::Core {
+
+/* Passed down to madvise so the kernel knows how to prefetch */
+enum class FileAccessHint {
+  Sequential,
+  Random,
+  // Fault the whole file in straight away
+  WillNeed
+};
+
+/*
+  Read-only view over a memory mapped file. Copies share the same mapping
+  which gets unmapped when the last copy goes away. Falls back to reading
+  the file into memory if it can't be mapped.
+*/
+class FileMapping {
+public:
+  FileMapping() = default;
+  FileMapping(const FileMapping &other);
+  FileMapping &operator=(const FileMapping &other);
+  ~FileMapping();
+
+  /* This is the actual full path to the file */
+  bool init(const std::string &path, FileAccessHint hint);
+  void release();
+
+  bool isValid() const;
+  const uint8_t *data() const;
+  size_t size() const;
+
+  /* For things which expect a Buffer - the contents must not be modified */
+  Buffer view() const;
+
+private:
+  struct Region {
+    uint8_t *base;
+    size_t size;
+    std::atomic<uint32_t> refCount;
+    // Set if mapping failed and the contents were read into memory instead
+    bool isHeap;
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+  };
+
+  Region *mRegion = nullptr;
+};
+
+}
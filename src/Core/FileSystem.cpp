@@ -12,6 +12,14 @@ FileSystem *gFileSystem = nullptr;
 FileSystem::FileSystem()
   : mTrackInterval(0.1f) {
   mPrevTrackTime = getCurrentTime();
+  mIsWatching = mWatcher.init();
+}
+
+void FileSystem::shutdown() {
+  if (mIsWatching) {
+    mWatcher.shutdown();
+    mIsWatching = false;
+  }
 }
 
 void FileSystem::addMountPoint(MountPoint id, const std::string &directory) {
@@ -29,6 +37,27 @@ File FileSystem::createFile(
   return File(mMountPoints[mountPoint] + path, type);
 }
 
+FileMapping FileSystem::mapFile(
+  MountPoint mountPoint,
+  const std::string &path,
+  FileAccessHint hint) {
+  assert(mMountPoints[mountPoint].length() > 0);
+
+  FileMapping mapping;
+  if (!mapping.init(mMountPoints[mountPoint] + path, hint)) {
+    assert(0);
+  }
+
+  return mapping;
+}
+
+std::string FileSystem::getFullPath(
+  MountPoint mountPoint,
+  const std::string &path) {
+  assert(mMountPoints[mountPoint].length() > 0);
+  return mMountPoints[mountPoint] + path;
+}
+
 bool FileSystem::isPathValid(
   MountPoint mountPoint,
   const std::string &path) {
@@ -53,6 +82,10 @@ TrackPathID FileSystem::trackPath(
 
     mTrackedPaths[id].lastTime = calculateLastWriteTime(mTrackedPaths[id]);
 
+    if (mIsWatching) {
+      mWatcher.watch(id, mMountPoints[mountPoint] + path);
+    }
+
     return id;
   }
   else {
@@ -61,26 +94,43 @@ TrackPathID FileSystem::trackPath(
 }
 
 void FileSystem::trackFiles(OnEventProc onEventProc) {
+  if (mIsWatching) {
+    // Nothing to do unless the watcher saw something
+    if (mWatcher.hasChanges()) {
+      mChangedPaths.clear();
+      mWatcher.popChanges(mChangedPaths);
+
+      for (auto id : mChangedPaths) {
+        checkTrackedPath(id, onEventProc);
+      }
+    }
+
+    return;
+  }
+
   auto now = getCurrentTime();
 
   if (getTimeDifference(now, mPrevTrackTime) > mTrackInterval) {
     mPrevTrackTime = now;
 
     for (uint32_t i = 0; i < mTrackedPaths.size(); ++i) {
-      auto &path = mTrackedPaths[i];
-      TrackPathID id = i;
+      checkTrackedPath(i, onEventProc);
+    }
+  }
+}
 
-      auto lastWriteTime = calculateLastWriteTime(path);
+void FileSystem::checkTrackedPath(TrackPathID id, OnEventProc onEventProc) {
+  auto &path = mTrackedPaths[id];
+  auto lastWriteTime = calculateLastWriteTime(path);
 
-      if (lastWriteTime != path.lastTime) {
-        path.lastTime = lastWriteTime;
+  /* Opening a file for writing without modifying it still wakes the watcher */
+  if (lastWriteTime != path.lastTime) {
+    path.lastTime = lastWriteTime;
 
-        auto *pathChanged = lnEmplaceAlloc<EventPathChanged>();
-        pathChanged->path = path.path.c_str();
-        pathChanged->id = id;
-        onEventProc(pathChanged);
-      }
-    }
+    auto *pathChanged = lnEmplaceAlloc<EventPathChanged>();
+    pathChanged->path = path.path.c_str();
+    pathChanged->id = id;
+    onEventProc(pathChanged);
   }
 }
 
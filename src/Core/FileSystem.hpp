@@ -9,6 +9,7 @@
 #include "File.hpp"
 #include "Time.hpp"
 #include "Event.hpp"
+#include "FileWatcher.hpp"
 
 namespace Ondine::Core {
 
@@ -32,11 +33,15 @@ struct TrackedPath {
 /* 
    File system contains basic file / directory interaction but also
    basic resource tracker (i.e. did files marked as resources get changed?)
+   Tracked files get watched on a background thread where that's supported,
+   otherwise they get polled every mTrackInterval.
 */
 class FileSystem {
 public:
   FileSystem();
 
+  void shutdown();
+
   void addMountPoint(MountPoint id, const std::string &directory);
 
   File createFile(
@@ -46,6 +51,16 @@ public:
     const std::string &path,
     FileOpenTypeBits type);
 
+  /* Read-only memory mapping of the whole file */
+  FileMapping mapFile(
+    MountPoint mountPoint,
+    const std::string &path,
+    FileAccessHint hint = FileAccessHint::Sequential);
+
+  std::string getFullPath(
+    MountPoint mountPoint,
+    const std::string &path);
+
   bool isPathValid(
     MountPoint mountPoint,
     const std::string &path);
@@ -60,6 +75,8 @@ public:
 
 private:
   FileTime calculateLastWriteTime(const TrackedPath &trackedPath);
+  // Posts EventPathChanged if the file actually got modified
+  void checkTrackedPath(TrackPathID id, OnEventProc onEventProc);
 
 private:
   std::string mMountPoints[MAX_MOUNT_POINTS];
@@ -68,6 +85,10 @@ private:
   TimeStamp mPrevTrackTime;
   // Seconds
   const float mTrackInterval;
+
+  bool mIsWatching;
+  FileWatcher mWatcher;
+  std::vector<TrackPathID> mChangedPaths;
 };
 
 extern FileSystem *gFileSystem;
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <filesystem>
+#include "Log.hpp"
+#include "FileWatcher.hpp"
+
+#ifdef __linux__
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace Ondine::Core {
+
+#ifdef __linux__
+
+bool FileWatcher::init() {
+  mHasChanges = false;
+
+  mNotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (mNotifyFD < 0) {
+    LOG_WARNING("Failed to initialise inotify, falling back to polling\n");
+    return false;
+  }
+
+  mWakeFD = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  mThread = std::thread([this] () {runtime();});
+
+  return true;
+}
+
+void FileWatcher::shutdown() {
+  uint64_t wake = 1;
+  write(mWakeFD, &wake, sizeof(wake));
+  mThread.join();
+
+  close(mWakeFD);
+  close(mNotifyFD);
+}
+
+void FileWatcher::watch(TrackPathID id, const std::string &path) {
+  /*
+     Watch the directory rather than the file itself - a lot of programs
+     write to a temporary file and rename it over the original which would
+     leave a watch on the file pointing to the old inode.
+  */
+  std::filesystem::path fsPath(path);
+  std::string directory = fsPath.parent_path().string();
+  std::string name = fsPath.filename().string();
+
+  if (directory.empty()) {
+    directory = ".";
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  int wd;
+  auto watch = mDirectoryToWatch.find(directory);
+  if (watch == mDirectoryToWatch.end()) {
+    wd = inotify_add_watch(
+      mNotifyFD, directory.c_str(),
+      IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+    if (wd < 0) {
+      LOG_WARNINGV("Failed to watch directory %s\n", directory.c_str());
+      return;
+    }
+
+    mDirectoryToWatch[directory] = wd;
+  }
+  else {
+    wd = watch->second;
+  }
+
+  std::vector<TrackPathID> &ids = mWatchedDirectories[wd].files[name];
+  if (std::find(ids.begin(), ids.end(), id) == ids.end()) {
+    ids.push_back(id);
+  }
+}
+
+void FileWatcher::runtime() {
+  // Large enough for a bunch of events with file names
+  alignas(inotify_event) char buffer[4096];
+
+  pollfd fds[2] = {
+    {mNotifyFD, POLLIN, 0},
+    {mWakeFD, POLLIN, 0}
+  };
+
+  int timeout = -1;
+
+  for (;;) {
+    poll(fds, 2, timeout);
+
+    if (fds[1].revents & POLLIN) {
+      break;
+    }
+
+    TimeStamp now = getCurrentTime();
+
+    for (;;) {
+      ssize_t length = read(mNotifyFD, buffer, sizeof(buffer));
+      if (length <= 0) {
+        break;
+      }
+
+      std::unique_lock<std::mutex> lock(mMutex);
+
+      for (char *ptr = buffer; ptr < buffer + length;) {
+        auto *event = (inotify_event *)ptr;
+        ptr += sizeof(inotify_event) + event->len;
+
+        if (!event->len) {
+          continue;
+        }
+
+        auto directory = mWatchedDirectories.find(event->wd);
+        if (directory == mWatchedDirectories.end()) {
+          continue;
+        }
+
+        auto file = directory->second.files.find(event->name);
+        if (file != directory->second.files.end()) {
+          // Keep pushing it back while the writes keep on coming
+          for (TrackPathID id : file->second) {
+            mPendingChanges[id] = now;
+          }
+        }
+      }
+    }
+
+    timeout = flushSettledChanges();
+  }
+}
+
+int FileWatcher::flushSettledChanges() {
+  TimeStamp now = getCurrentTime();
+  float nextFlush = -1.0f;
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  for (auto it = mPendingChanges.begin(); it != mPendingChanges.end();) {
+    float elapsed = getTimeDifference(now, it->second);
+
+    if (elapsed >= COALESCE_INTERVAL) {
+      mChanges.push_back(it->first);
+      it = mPendingChanges.erase(it);
+    }
+    else {
+      float remaining = COALESCE_INTERVAL - elapsed;
+      if (nextFlush < 0.0f || remaining < nextFlush) {
+        nextFlush = remaining;
+      }
+
+      ++it;
+    }
+  }
+
+  if (!mChanges.empty()) {
+    mHasChanges.store(true, std::memory_order_release);
+  }
+
+  return nextFlush < 0.0f ? -1 : (int)(nextFlush * 1000.0f) + 1;
+}
+
+#else
+
+bool FileWatcher::init() {
+  mHasChanges = false;
+  return false;
+}
+
+void FileWatcher::shutdown() {
+
+}
+
+void FileWatcher::watch(TrackPathID id, const std::string &path) {
+
+}
+
+#endif
+
+bool FileWatcher::hasChanges() const {
+  return mHasChanges.load(std::memory_order_acquire);
+}
+
+void FileWatcher::popChanges(std::vector<TrackPathID> &changes) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  changes.insert(changes.end(), mChanges.begin(), mChanges.end());
+  mChanges.clear();
+  mHasChanges.store(false, std::memory_order_relaxed);
+}
+
+}
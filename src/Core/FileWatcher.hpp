@@ -0,0 +1,66 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <unordered_map>
+
+#include "Time.hpp"
+
+namespace Ondine::Core {
+
+using TrackPathID = int32_t;
+
+/*
+   Watches files for writes on a background thread (inotify on Linux).
+   Bursts of writes to the same file (editors / compilers often write several
+   times in a row) get merged into a single change.
+*/
+class FileWatcher {
+public:
+  // Returns false if the platform isn't supported - caller needs to poll
+  bool init();
+  void shutdown();
+
+  /* Path is the actual full path to the file */
+  void watch(TrackPathID id, const std::string &path);
+
+  // Just an atomic load - cheap enough to call every frame
+  bool hasChanges() const;
+  // Appends the IDs of the paths which changed since the last call
+  void popChanges(std::vector<TrackPathID> &changes);
+
+private:
+  void runtime();
+  // Returns how long the thread can sleep for (milliseconds, -1 = forever)
+  int flushSettledChanges();
+
+private:
+  // Wait for this long after the last write before reporting a change
+  static constexpr float COALESCE_INTERVAL = 0.05f;
+
+  struct WatchedDirectory {
+    // Several tracked paths may point to the same file
+    std::unordered_map<std::string, std::vector<TrackPathID>> files;
+  };
+
+  int mNotifyFD;
+  // Used to wake up the watcher thread on shutdown
+  int mWakeFD;
+  std::thread mThread;
+
+  std::mutex mMutex;
+  std::unordered_map<std::string, int> mDirectoryToWatch;
+  std::unordered_map<int, WatchedDirectory> mWatchedDirectories;
+
+  // Only touched by the watcher thread
+  std::unordered_map<TrackPathID, TimeStamp> mPendingChanges;
+
+  std::atomic<bool> mHasChanges;
+  std::vector<TrackPathID> mChanges;
+};
+
+}
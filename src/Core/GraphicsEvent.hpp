@@ -18,4 +18,13 @@ struct EventViewHierarchyChange : Event {
   Array<const char *, AllocationType::Linear> views;
 };
 
+// Terrain generated in the background was handed to the renderer
+struct EventTerrainGenerationProgress : Event {
+  EVENT_DEF(
+    EventTerrainGenerationProgress, Graphics, TerrainGenerationProgress);
+
+  uint32_t finishedColumnCount;
+  uint32_t columnCount;
+};
+
 }
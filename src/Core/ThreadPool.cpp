@@ -1,3 +1,5 @@
+#include <assert.h>
+#include "Utils.hpp"
 #include "ThreadPool.hpp"
 
 namespace Ondine::Core {
@@ -9,7 +11,8 @@ void ThreadPool::init() {
   mCoreCount = std::thread::hardware_concurrency();
   mWorkers.init(mCoreCount);
   mWorkers.size = mCoreCount;
-  mJobs.init(30);
+  mJobs.init(MAX_JOB_COUNT);
+  mQueuedJobs.init(MAX_JOB_COUNT);
 
   for (int i = 0; i < mWorkers.size; ++i) {
     mWorkers[i].init(i);
@@ -17,9 +20,15 @@ void ThreadPool::init() {
 }
 
 void ThreadPool::tick() {
+  startQueuedJobs();
+
   for (int i = 0; i < mWorkers.size; ++i) {
-    if (mWorkers[i].isFinished() && mWorkers[i].getJobID() != -1) {
-      mJobs[mWorkers[i].getJobID()].isRunning = false;
+    JobID jobID = mWorkers[i].getJobID();
+
+    // The job may have been started again on another worker since
+    if (jobID != -1 && mJobs[jobID].workerID == i &&
+        !mWorkers[i].isRunningJob(jobID)) {
+      mJobs[jobID].isRunning = false;
     }
   }
 }
@@ -35,28 +44,125 @@ void ThreadPool::destroyJob(JobID jobID) {
 }
 
 void ThreadPool::startJob(JobID job, void *parameters) {
-  for (int i = 0; i < mWorkers.size; ++i) {
-    // Yes this is stupid but we'll fix later
-    if (mWorkers[i].isFinished()) {
-      mJobs[job].parameters = parameters;
+  mJobs[job].parameters = parameters;
+
+  if (!tryStartJob(job)) {
+    assert(mQueuedJobs.size < mQueuedJobs.capacity);
+
+    mJobs[job].workerID = -1;
+    mJobs[job].isRunning = true;
+    mQueuedJobs[mQueuedJobs.size++] = job;
+  }
+}
+
+bool ThreadPool::isJobFinished(JobID jobID) {
+  const Job &job = mJobs[jobID];
+
+  if (!job.isRunning) {
+    return true;
+  }
+  else if (job.workerID == -1) {
+    // Still queued
+    return false;
+  }
+  else {
+    return !mWorkers[job.workerID].isRunningJob(jobID);
+  }
+}
 
-      mWorkers[i].startIfIdle(mJobs[job]);
+int ThreadPool::getJobStatus(JobID jobID) {
+  if (mJobs[jobID].workerID == -1) {
+    return 0;
+  }
 
+  return mWorkers[mJobs[jobID].workerID].getReturnCode();
+}
+
+bool ThreadPool::tryStartJob(JobID job) {
+  // Workers can get claimed by parallelFor helpers at any point
+  for (int i = 0; i < mWorkers.size; ++i) {
+    if (mWorkers[i].startIfIdle(mJobs[job])) {
       mJobs[job].workerID = i;
       mJobs[job].isRunning = true;
 
-      break;
+      return true;
     }
   }
+
+  return false;
 }
 
-bool ThreadPool::isJobFinished(JobID jobID) {
-  return !mJobs[jobID].isRunning ||
-    mWorkers[mJobs[jobID].workerID].isFinished();
+void ThreadPool::startQueuedJobs() {
+  uint32_t queuedCount = 0;
+
+  for (uint32_t i = 0; i < mQueuedJobs.size; ++i) {
+    if (!tryStartJob(mQueuedJobs[i])) {
+      mQueuedJobs[queuedCount++] = mQueuedJobs[i];
+    }
+  }
+
+  mQueuedJobs.size = queuedCount;
 }
 
-int ThreadPool::getJobStatus(JobID jobID) {
-  return mWorkers[mJobs[jobID].workerID].getReturnCode();
+void ThreadPool::parallelFor(uint32_t count, ParallelProc proc, void *data) {
+  if (count == 0) {
+    return;
+  }
+
+  ParallelForState state;
+  state.proc = proc;
+  state.data = data;
+  state.count = count;
+  state.nextIndex = 0;
+  state.helpersLeft = 0;
+
+  uint32_t helperCount = 0;
+
+  // The calling thread takes care of at least one of the indices
+  for (int i = 0; i < mWorkers.size && helperCount + 1 < count; ++i) {
+    if (mWorkers[i].startHelperIfIdle(runParallelFor, &state)) {
+      ++helperCount;
+    }
+  }
+
+  runParallelIndices(state);
+
+  // Indices are all taken by now, this waits for the helpers' last ones
+  std::unique_lock<std::mutex> lock(state.helpersMutex);
+  state.helpersLeft += (int32_t)helperCount;
+  state.helpersDone.wait(lock, [&state] {return state.helpersLeft == 0;});
+}
+
+int ThreadPool::workerCount() const {
+  return mWorkers.size;
+}
+
+int ThreadPool::threadIndex() const {
+  return Worker::currentID() + 1;
+}
+
+int ThreadPool::runParallelFor(void *parameters) {
+  auto *state = (ParallelForState *)parameters;
+  runParallelIndices(*state);
+
+  // The state lives on parallelFor's stack - gone once it stops waiting
+  std::lock_guard<std::mutex> lock(state->helpersMutex);
+  if (--state->helpersLeft == 0) {
+    state->helpersDone.notify_one();
+  }
+
+  return 0;
+}
+
+void ThreadPool::runParallelIndices(ParallelForState &state) {
+  for (;;) {
+    uint32_t index = state.nextIndex.fetch_add(1, std::memory_order_relaxed);
+    if (index >= state.count) {
+      break;
+    }
+
+    state.proc(index, state.data);
+  }
 }
   
 }
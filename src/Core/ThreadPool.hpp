@@ -1,6 +1,7 @@
 #pragma once
 
 #include <mutex>
+#include <atomic>
 #include <thread>
 #include <condition_variable>
 
@@ -12,6 +13,7 @@
 namespace Ondine::Core {
 
 using JobID = int;
+using ParallelProc = void (*)(uint32_t index, void *data);
 
 class ThreadPool {
 public:
@@ -21,15 +23,56 @@ public:
   JobID createJob(JobProc proc);
   void destroyJob(JobID jobID);
 
-  // TODO: Change this to queueJob when parallelism becomes more prevalent
+  /*
+     Starts the job on an idle worker. If there is none (parallelFor can
+     be holding them), it gets queued and started from tick() instead -
+     isJobFinished reports it as running in the meantime.
+  */
   void startJob(JobID jobID, void *parameters);
   bool isJobFinished(JobID jobID);
   int getJobStatus(JobID jobID);
 
+  /*
+     Calls proc for every index in [0, count) on the idle workers and on the
+     calling thread. Blocks until all indices are done. If no worker is idle,
+     everything just runs on the calling thread.
+  */
+  void parallelFor(uint32_t count, ParallelProc proc, void *data);
+
+  int workerCount() const;
+  /*
+     0 for any thread which isn't a worker (i.e. the main thread), worker
+     ID + 1 otherwise. Always less than workerCount() + 1.
+  */
+  int threadIndex() const;
+
+private:
+  struct ParallelForState {
+    ParallelProc proc;
+    void *data;
+    uint32_t count;
+    std::atomic<uint32_t> nextIndex;
+
+    // Helpers which are still running (goes below 0 until all are claimed)
+    int32_t helpersLeft;
+    std::mutex helpersMutex;
+    std::condition_variable helpersDone;
+  };
+
+  bool tryStartJob(JobID jobID);
+  void startQueuedJobs();
+
+  static int runParallelFor(void *parameters);
+  static void runParallelIndices(ParallelForState &state);
+
 private:
+  static constexpr uint32_t MAX_JOB_COUNT = 30;
+
   int mCoreCount;
   Array<Worker> mWorkers;
   NumericMap<Job> mJobs;
+  // Jobs started while no worker was idle (only the main thread starts jobs)
+  Array<JobID> mQueuedJobs;
 };
 
 extern ThreadPool *gThreadPool;
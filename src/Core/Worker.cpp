@@ -2,26 +2,41 @@
 
 namespace Ondine::Core {
 
+thread_local int Worker::sCurrentID = -1;
+
 void Worker::init(int id) {
   mID = id;
   mJobRequested = false;
+  mIsHelping = false;
   mThread = std::thread([this] () {runtime();});
   mJob.id = -1;
 }
 
 void Worker::runtime() {
+  sCurrentID = mID;
+
   LOG_INFOV("Worker %d has started a running\n", mID);
 
   for (;;) {
     std::unique_lock<std::mutex> lock (mMutex);
     mReady.wait(lock, [this] {return mJobRequested;});
+    bool isHelping = mIsHelping;
     lock.unlock();
 
-    int returnCode = mJob.proc(mJob.parameters);
+    int returnCode = 0;
+    if (isHelping) {
+      mHelperProc(mHelperParameters);
+    }
+    else {
+      returnCode = mJob.proc(mJob.parameters);
+    }
 
     lock.lock();
     mJobRequested = false;
-    mReturnCode = returnCode;
+    mIsHelping = false;
+    if (!isHelping) {
+      mReturnCode = returnCode;
+    }
     lock.unlock();
   }
 }
@@ -43,11 +58,33 @@ bool Worker::startIfIdle(Job job) {
   }
 }
 
+bool Worker::startHelperIfIdle(JobProc proc, void *parameters) {
+  std::unique_lock<std::mutex> lock (mMutex);
+
+  if (mJobRequested) {
+    return false;
+  }
+  else {
+    mHelperProc = proc;
+    mHelperParameters = parameters;
+    mIsHelping = true;
+    mJobRequested = true;
+    mReady.notify_one();
+
+    return true;
+  }
+}
+
 bool Worker::isFinished() {
   std::unique_lock<std::mutex> lock (mMutex);
   return !mJobRequested;
 }
 
+bool Worker::isRunningJob(JobID jobID) {
+  std::unique_lock<std::mutex> lock (mMutex);
+  return mJobRequested && !mIsHelping && mJob.id == jobID;
+}
+
 int Worker::getReturnCode() {
   std::unique_lock<std::mutex> lock (mMutex);
   return !mReturnCode;
@@ -57,4 +94,8 @@ JobID Worker::getJobID() {
   return mJob.id;
 }
 
+int Worker::currentID() {
+  return sCurrentID;
+}
+
 }
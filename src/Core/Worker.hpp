@@ -24,18 +24,33 @@ public:
   void init(int id);
 
   bool startIfIdle(Job job);
+  /*
+     Runs proc without touching the worker's job (ThreadPool::parallelFor
+     helpers), so whoever polls that job doesn't get confused by it.
+  */
+  bool startHelperIfIdle(JobProc proc, void *parameters);
   bool isFinished();
+  // Whether the worker is still busy with this job (not with a helper)
+  bool isRunningJob(JobID jobID);
   int getReturnCode();
   JobID getJobID();
 
+  // ID of the worker running the calling thread, -1 if it isn't a worker
+  static int currentID();
+
 private:
   void runtime();
 
 private:
+  static thread_local int sCurrentID;
+
   int mID;
   Job mJob;
   int mReturnCode;
   bool mJobRequested;
+  bool mIsHelping;
+  JobProc mHelperProc;
+  void *mHelperParameters;
 
   std::mutex mMutex;
   std::thread mThread;
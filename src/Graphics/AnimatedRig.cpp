@@ -46,11 +46,10 @@ void AnimatedRig::init(
   mInterpolatedTransformsBuffer.init(
     graphicsContext.device(),
     sizeof(glm::mat4) * skeleton.bones.size(),
-    (int)VulkanBufferFlag::UniformBuffer);
+    VulkanBufferFlag::UniformBuffer | VulkanBufferFlag::UploadTarget);
 
   mInterpolatedTransformsBuffer.fillWithStaging(
     graphicsContext.device(),
-    graphicsContext.commandPool(),
     {(uint8_t *)mInterpolatedTransforms.data, mInterpolatedTransforms.memSize()});
 
   mInterpolatedTransformsUniform.init(
@@ -9,14 +9,13 @@ namespace Ondine::Graphics {
 Assimp::Importer *gAssimpImporter = nullptr;
 
 const aiScene *importScene(const char *path) {
-  Core::File modelFile = Core::gFileSystem->createFile(
+  Core::FileMapping modelFile = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    path, Core::FileOpenType::Binary | Core::FileOpenType::In);
-
-  Buffer modelData = modelFile.readBinary();
+    path, Core::FileAccessHint::WillNeed);
 
+  /* Assimp doesn't hold on to the memory once the scene has been read */
   return gAssimpImporter->ReadFileFromMemory(
-    modelData.data, modelData.size, aiProcess_Triangulate);
+    modelFile.data(), modelFile.size(), aiProcess_Triangulate);
 }
 
 }
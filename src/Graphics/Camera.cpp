@@ -9,7 +9,7 @@ void Camera::init(
   mCameraBuffer.init(
     graphicsContext.device(),
     sizeof(CameraProperties),
-    (int)VulkanBufferFlag::UniformBuffer);
+    VulkanBufferFlag::UniformBuffer | VulkanBufferFlag::UploadTarget);
 
   mUniform.init(
     graphicsContext.device(),
@@ -20,7 +20,6 @@ void Camera::init(
   if (properties) {
     mCameraBuffer.fillWithStaging(
       graphicsContext.device(),
-      graphicsContext.commandPool(),
       {(uint8_t *)properties, sizeof(CameraProperties)});
   }
 }
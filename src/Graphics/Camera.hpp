@@ -25,6 +25,10 @@ public:
   alignas(16) glm::vec3 wUp;
   float fov;
 
+  inline const glm::mat4 &viewProjection() const {
+    return mViewProjection;
+  }
+
 private:
   float mAspectRatio;
   float mNear;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <atomic>
 #include <stdint.h>
 #include <glm/glm.hpp>
 #include "QuadTree.hpp"
@@ -22,9 +23,85 @@ extern const int8_t VOXEL_EDGE_CONNECT[256][16];
 constexpr uint32_t CHUNK_DIM = 16;
 constexpr int32_t INVALID_CHUNK_INDEX = -1;
 constexpr uint32_t CHUNK_VOLUME = CHUNK_DIM * CHUNK_DIM * CHUNK_DIM;
+// Level 0 is the chunk itself (16^3), the last one a single voxel
+constexpr uint32_t CHUNK_MIP_LEVEL_COUNT = 5;
+// Voxels of levels 1 to 4 (8^3 + 4^3 + 2^3 + 1^3)
+constexpr uint32_t CHUNK_MIP_VOLUME = 512 + 64 + 8 + 1;
+
+// How a voxel of a mip level is made from the 2x2x2 voxels under it
+enum class DensityMipReduction : uint8_t {
+  Min,
+  Max,
+  Average
+};
 
-struct Chunk {
+constexpr inline uint32_t getMipDim(uint32_t level) {
+  return CHUNK_DIM >> level;
+}
+
+/*
+   A mip voxel stands for the middle of the block it was reduced from, not
+   for its lattice point: this is how far past it (in level 0 voxels).
+*/
+constexpr inline float getMipSampleOffset(uint32_t level) {
+  return (float)((1 << level) - 1) * 0.5f;
+}
+
+// Where the level starts in ChunkVoxels::mips (level > 0)
+constexpr inline uint32_t getMipOffset(uint32_t level) {
+  uint32_t offset = 0;
+  for (uint32_t l = 1; l < level; ++l) {
+    offset += getMipDim(l) * getMipDim(l) * getMipDim(l);
+  }
+
+  return offset;
+}
+
+static_assert(
+  getMipOffset(CHUNK_MIP_LEVEL_COUNT) == CHUNK_MIP_VOLUME,
+  "CHUNK_MIP_VOLUME doesn't match the mip levels");
+
+constexpr inline uint32_t getMipVoxelIndex(
+  const glm::ivec3 &coord, uint32_t level) {
+  uint32_t dim = getMipDim(level);
+  return coord.z * (dim * dim) + coord.y * dim + coord.x;
+}
+
+// One version of a chunk's voxels
+struct ChunkVoxels {
   Voxel voxels[CHUNK_VOLUME];
+  /*
+     Mip pyramid of the voxels. A voxel at level l covers the 2^l voxels
+     (along each axis) starting at its coordinate * 2^l.
+  */
+  Voxel mips[CHUNK_MIP_VOLUME];
+
+  // Ray queries skip chunks which can't contain the surface
+  uint16_t minDensity;
+  uint16_t maxDensity;
+
+  const Voxel *mipLevel(uint32_t level) const {
+    return level ? mips + getMipOffset(level) : voxels;
+  }
+
+  Voxel *mipLevel(uint32_t level) {
+    return level ? mips + getMipOffset(level) : voxels;
+  }
+};
+
+struct Chunk {
+  /*
+     Published version of the voxels - it never changes once published.
+     Writers work on a copy (pending) which then replaces it (see
+     Terrain::beginChunkWrite / publishChunkWrites), so readers like the
+     meshing job never see a half written chunk.
+  */
+  std::atomic<ChunkVoxels *> voxels;
+  // Only the terrain's writer looks at these
+  ChunkVoxels *pending;
+  // Voxels [dirtyStart, dirtyEnd) of pending were written to
+  glm::ivec3 dirtyStart;
+  glm::ivec3 dirtyEnd;
 
   uint32_t chunkStackIndex;
   bool needsUpdating;
@@ -35,6 +112,10 @@ struct Chunk {
   glm::ivec3 chunkCoord;
 
   NumericMapKey chunkGroupKey;
+
+  const ChunkVoxels *read() const {
+    return voxels.load(std::memory_order_acquire);
+  }
 };
 
 enum { B8_R_MAX = 0b111, B8_G_MAX = 0b111, B8_B_MAX = 0b11 };
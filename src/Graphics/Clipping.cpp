@@ -7,7 +7,7 @@ void Clipping::init(
   float clipFactor, float radius) {
   mUBO.init(
     graphicsContext.device(), sizeof(mData),
-    (int)VulkanBufferFlag::UniformBuffer);
+    VulkanBufferFlag::UniformBuffer | VulkanBufferFlag::UploadTarget);
 
   uniform.init(
     graphicsContext.device(),
@@ -19,8 +19,7 @@ void Clipping::init(
   mData.clippingRadius = radius;
 
   mUBO.fillWithStaging(
-    graphicsContext.device(), graphicsContext.commandPool(),
-    {(uint8_t *)&mData, sizeof(mData)});
+    graphicsContext.device(), {(uint8_t *)&mData, sizeof(mData)});
 }
 
 }
@@ -205,7 +205,7 @@ void DeferredLighting::init(
           VulkanPipelineDescriptorLayout{
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4});
 
-        res.init(
+        res.initDeferred(
           graphicsContext.device(),
           graphicsContext.descriptorLayouts(),
           pipelineConfig);
@@ -239,7 +239,7 @@ void DeferredLighting::init(
           VulkanPipelineDescriptorLayout{
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
 
-        res.init(
+        res.initDeferred(
           graphicsContext.device(),
           graphicsContext.descriptorLayouts(),
           pipelineConfig);
@@ -261,7 +261,7 @@ void DeferredLighting::init(
     mLightingPropertiesBuffer.init(
       graphicsContext.device(),
       sizeof(LightingProperties::data),
-      (int)VulkanBufferFlag::UniformBuffer);
+      VulkanBufferFlag::UniformBuffer | VulkanBufferFlag::UploadTarget);
 
     mLightingPropertiesUniform.init(
       graphicsContext.device(),
@@ -272,7 +272,6 @@ void DeferredLighting::init(
     if (properties) {
       mLightingPropertiesBuffer.fillWithStaging(
         graphicsContext.device(),
-        graphicsContext.commandPool(),
         {(uint8_t *)&properties->data, sizeof(LightingProperties::data)});
     }
   }
@@ -447,17 +446,15 @@ void DeferredLighting::precomputeBRDFLut(VulkanContext &graphicsContext) {
 
   VulkanPipeline precomputeBRDFPipeline;
   { // Create precompute graphics pipeline
-    Core::File precomputeVsh = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeVsh = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/TexturedQuad.vert.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
-    Buffer vsh = precomputeVsh.readBinary();
+      "res/spv/TexturedQuad.vert.spv");
+    Buffer vsh = precomputeVsh.view();
 
-    Core::File precomputeFsh = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeFsh = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/BRDFLut.frag.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
-    Buffer fsh = precomputeFsh.readBinary();
+      "res/spv/BRDFLut.frag.spv");
+    Buffer fsh = precomputeFsh.view();
 
     VulkanPipelineConfig pipelineConfig(
       {precomputeBRDFRenderPass, 0},
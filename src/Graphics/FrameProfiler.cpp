@@ -0,0 +1,255 @@
+#include <stdio.h>
+#include <assert.h>
+#include <string.h>
+#include "Log.hpp"
+#include "Utils.hpp"
+#include "VulkanDevice.hpp"
+#include "FrameProfiler.hpp"
+#include "VulkanCommandBuffer.hpp"
+
+namespace Ondine::Graphics {
+
+void ProfilerTimings::addCPU(float ms) {
+  cpuTotal += ms;
+  cpuMax = MAX(cpuMax, ms);
+  ++cpuSamples;
+}
+
+void ProfilerTimings::addGPU(float ms) {
+  if (gpuSamples == 0) {
+    gpuMin = gpuMax = ms;
+  }
+  else {
+    gpuMin = MIN(gpuMin, ms);
+    gpuMax = MAX(gpuMax, ms);
+  }
+
+  gpuTotal += ms;
+  ++gpuSamples;
+}
+
+FrameProfiler::FrameProfiler()
+  : mIsEnabled(false),
+    mIsFrameOpen(false) {
+
+}
+
+void FrameProfiler::init(const VulkanDevice &device, uint32_t framesInFlight) {
+  assert(framesInFlight <= MAX_FRAMES_IN_FLIGHT);
+
+  mIsEnabled = true;
+  mIsFrameOpen = false;
+  mCurrentFrame = 0;
+  mStageCount = 0;
+  mFrameTimings = {};
+  memset(mPending, 0, sizeof(mPending));
+
+  mTimestampPeriod = device.timestampPeriod();
+  if (mTimestampPeriod > 0.0f) {
+    mQueryPool.init(
+      device, VK_QUERY_TYPE_TIMESTAMP, QUERIES_PER_FRAME * framesInFlight);
+  }
+  else {
+    LOG_WARNING("Device doesn't support timestamps, only timing the CPU\n");
+  }
+}
+
+void FrameProfiler::destroy(const VulkanDevice &device) {
+  if (mIsEnabled && mTimestampPeriod > 0.0f) {
+    mQueryPool.destroy(device);
+  }
+
+  mIsEnabled = false;
+}
+
+bool FrameProfiler::isEnabled() const {
+  return mIsEnabled;
+}
+
+void FrameProfiler::beginFrame(
+  const VulkanDevice &device, const VulkanFrame &frame) {
+  if (!mIsEnabled) {
+    return;
+  }
+
+  if (mIsFrameOpen) {
+    mFrameTimings.addCPU(
+      Core::getTimeDifference(mLastMark, mFrameStart) * 1000.0f);
+  }
+
+  mCurrentFrame = frame.frameInFlight;
+
+  if (mTimestampPeriod > 0.0f) {
+    // The fence of this frame in flight was just waited on
+    readResults(device, mCurrentFrame);
+
+    uint32_t first = mCurrentFrame * QUERIES_PER_FRAME;
+    frame.primaryCommandBuffer.resetQueries(
+      mQueryPool, first, QUERIES_PER_FRAME);
+    frame.primaryCommandBuffer.writeTimestamp(
+      mQueryPool, first, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+  }
+
+  mPending[mCurrentFrame].stageCount = 0;
+  mIsFrameOpen = true;
+  mFrameStart = mLastMark = Core::getCurrentTime();
+}
+
+void FrameProfiler::endStage(const VulkanFrame &frame, const char *name) {
+  if (!mIsEnabled) {
+    return;
+  }
+
+  endStage(
+    frame, name,
+    Core::getTimeDifference(Core::getCurrentTime(), mLastMark) * 1000.0f);
+}
+
+void FrameProfiler::endStage(
+  const VulkanFrame &frame, const char *name, float cpuTime) {
+  if (!mIsEnabled) {
+    return;
+  }
+
+  PendingFrame &pending = mPending[mCurrentFrame];
+  assert(pending.stageCount < MAX_STAGES);
+
+  uint32_t stageIndex = findStage(name);
+
+  mStages[stageIndex].timings.addCPU(cpuTime);
+  mLastMark = Core::getCurrentTime();
+
+  if (mTimestampPeriod > 0.0f) {
+    frame.primaryCommandBuffer.writeTimestamp(
+      mQueryPool,
+      mCurrentFrame * QUERIES_PER_FRAME + 1 + pending.stageCount);
+  }
+
+  pending.stages[pending.stageCount++] = stageIndex;
+}
+
+void FrameProfiler::flush(const VulkanDevice &device) {
+  if (!mIsEnabled) {
+    return;
+  }
+
+  if (mIsFrameOpen) {
+    mFrameTimings.addCPU(
+      Core::getTimeDifference(mLastMark, mFrameStart) * 1000.0f);
+    mIsFrameOpen = false;
+  }
+
+  if (mTimestampPeriod > 0.0f) {
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+      readResults(device, i);
+    }
+  }
+}
+
+uint32_t FrameProfiler::stageCount() const {
+  return mStageCount;
+}
+
+const ProfilerStage &FrameProfiler::stage(uint32_t index) const {
+  return mStages[index];
+}
+
+const ProfilerTimings &FrameProfiler::frameTimings() const {
+  return mFrameTimings;
+}
+
+void FrameProfiler::logSummary() const {
+  auto average = [](float total, uint32_t samples) {
+    return samples ? total / (float)samples : 0.0f;
+  };
+
+  LOG_INFOV(
+    "Frame timings (%d frames, milliseconds):\n",
+    (int)mFrameTimings.cpuSamples);
+
+  for (uint32_t i = 0; i <= mStageCount; ++i) {
+    const char *name = i < mStageCount ? mStages[i].name : "Frame";
+    const ProfilerTimings &timings =
+      i < mStageCount ? mStages[i].timings : mFrameTimings;
+
+    LOG_INFOV(
+      "\t* %-16s cpu %7.3f (max %7.3f) gpu %7.3f (min %7.3f max %7.3f)\n",
+      name,
+      average(timings.cpuTotal, timings.cpuSamples), timings.cpuMax,
+      average(timings.gpuTotal, timings.gpuSamples),
+      timings.gpuMin, timings.gpuMax);
+  }
+}
+
+void FrameProfiler::writeReport(Core::File &file) const {
+  auto average = [](float total, uint32_t samples) {
+    return samples ? total / (float)samples : 0.0f;
+  };
+
+  char line[256];
+  int length = snprintf(
+    line, sizeof(line),
+    "stage,cpu_avg_ms,cpu_max_ms,gpu_avg_ms,gpu_min_ms,gpu_max_ms,samples\n");
+  file.write(line, length);
+
+  for (uint32_t i = 0; i <= mStageCount; ++i) {
+    const char *name = i < mStageCount ? mStages[i].name : "Frame";
+    const ProfilerTimings &timings =
+      i < mStageCount ? mStages[i].timings : mFrameTimings;
+
+    length = snprintf(
+      line, sizeof(line), "%s,%f,%f,%f,%f,%f,%u\n",
+      name,
+      average(timings.cpuTotal, timings.cpuSamples), timings.cpuMax,
+      average(timings.gpuTotal, timings.gpuSamples),
+      timings.gpuMin, timings.gpuMax, timings.cpuSamples);
+    file.write(line, length);
+  }
+}
+
+uint32_t FrameProfiler::findStage(const char *name) {
+  for (uint32_t i = 0; i < mStageCount; ++i) {
+    if (mStages[i].name == name || !strcmp(mStages[i].name, name)) {
+      return i;
+    }
+  }
+
+  assert(mStageCount < MAX_STAGES);
+
+  ProfilerStage &stage = mStages[mStageCount];
+  stage.name = name;
+  stage.timings = {};
+
+  return mStageCount++;
+}
+
+void FrameProfiler::readResults(
+  const VulkanDevice &device, uint32_t frameInFlight) {
+  PendingFrame &pending = mPending[frameInFlight];
+  if (!pending.stageCount) {
+    return;
+  }
+
+  uint64_t timestamps[QUERIES_PER_FRAME];
+  bool isAvailable = mQueryPool.getResults(
+    device, frameInFlight * QUERIES_PER_FRAME,
+    pending.stageCount + 1, timestamps);
+
+  if (isAvailable) {
+    // Timestamp period is in nanoseconds
+    float toMilliseconds = mTimestampPeriod / 1000000.0f;
+
+    for (uint32_t i = 0; i < pending.stageCount; ++i) {
+      float ms = (float)(timestamps[i + 1] - timestamps[i]) * toMilliseconds;
+      mStages[pending.stages[i]].timings.addGPU(ms);
+    }
+
+    mFrameTimings.addGPU(
+      (float)(timestamps[pending.stageCount] - timestamps[0]) *
+      toMilliseconds);
+  }
+
+  pending.stageCount = 0;
+}
+
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <stdint.h>
+#include "File.hpp"
+#include "Time.hpp"
+#include "VulkanFrame.hpp"
+#include "VulkanQueryPool.hpp"
+
+namespace Ondine::Graphics {
+
+class VulkanDevice;
+
+/* All in milliseconds */
+struct ProfilerTimings {
+  float cpuTotal;
+  float cpuMax;
+  uint32_t cpuSamples;
+
+  float gpuTotal;
+  float gpuMin;
+  float gpuMax;
+  uint32_t gpuSamples;
+
+  void addCPU(float ms);
+  void addGPU(float ms);
+};
+
+struct ProfilerStage {
+  const char *name;
+  ProfilerTimings timings;
+};
+
+/*
+   Times the stages of a frame on the CPU (command recording) and on the GPU
+   (timestamp queries). The GPU results of a frame in flight get read back
+   the next time the same frame in flight begins - its fence has been waited
+   on by then, so this never stalls.
+*/
+class FrameProfiler {
+public:
+  FrameProfiler();
+
+  void init(const VulkanDevice &device, uint32_t framesInFlight);
+  void destroy(const VulkanDevice &device);
+
+  bool isEnabled() const;
+
+  void beginFrame(const VulkanDevice &device, const VulkanFrame &frame);
+  /*
+     Marks the end of the stage which started at the previous mark (or at
+     the start of the frame). Name needs to be a string literal.
+  */
+  void endStage(const VulkanFrame &frame, const char *name);
+  /*
+     Same but for stages which were recorded on another thread, cpuTime (in
+     milliseconds) being how long the recording took.
+  */
+  void endStage(const VulkanFrame &frame, const char *name, float cpuTime);
+
+  // Reads back all pending results - the device needs to be idle
+  void flush(const VulkanDevice &device);
+
+  uint32_t stageCount() const;
+  const ProfilerStage &stage(uint32_t index) const;
+  const ProfilerTimings &frameTimings() const;
+
+  void logSummary() const;
+  // CSV with a line per stage (and one for the whole frame)
+  void writeReport(Core::File &file) const;
+
+private:
+  uint32_t findStage(const char *name);
+  void readResults(const VulkanDevice &device, uint32_t frameInFlight);
+
+private:
+  static constexpr uint32_t MAX_STAGES = 16;
+  static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 3;
+  // One timestamp at the start of the frame + one per stage
+  static constexpr uint32_t QUERIES_PER_FRAME = MAX_STAGES + 1;
+
+  struct PendingFrame {
+    uint32_t stageCount;
+    // Index into mStages of every stage recorded that frame (in order)
+    uint32_t stages[MAX_STAGES];
+  };
+
+  bool mIsEnabled;
+  float mTimestampPeriod;
+  VulkanQueryPool mQueryPool;
+  PendingFrame mPending[MAX_FRAMES_IN_FLIGHT];
+
+  uint32_t mCurrentFrame;
+  bool mIsFrameOpen;
+  Core::TimeStamp mFrameStart;
+  Core::TimeStamp mLastMark;
+
+  uint32_t mStageCount;
+  ProfilerStage mStages[MAX_STAGES];
+  ProfilerTimings mFrameTimings;
+};
+
+}
@@ -18,6 +18,7 @@ void GBuffer::init(
   mGBufferFormats[1] = VK_FORMAT_R16G16B16A16_SFLOAT;
   mGBufferFormats[2] = VK_FORMAT_R32G32B32A32_SFLOAT;
   mGBufferFormats[3] = ctxProperties.depthFormat;
+  mIsPlaced = false;
 
   if (!sGBufferRenderPass) { // Create render pass
     sGBufferRenderPass = flAlloc<VulkanRenderPass>();
@@ -73,6 +74,23 @@ void GBuffer::endRender(VulkanFrame &frame) {
 void GBuffer::resize(VulkanContext &vulkanContext, Resolution newResolution) {
   destroyTargets(vulkanContext);
   mGBufferExtent = {newResolution.width, newResolution.height};
+  // Placements were made for the old size
+  mIsPlaced = false;
+  initTargets(vulkanContext);
+}
+
+void GBuffer::placeTargets(
+  VulkanContext &vulkanContext,
+  const VulkanTexturePlacement *placements) {
+  destroyTargets(vulkanContext);
+
+  mIsPlaced = placements != nullptr;
+  if (mIsPlaced) {
+    for (int i = 0; i < Count; ++i) {
+      mPlacements[i] = placements[i];
+    }
+  }
+
   initTargets(vulkanContext);
 }
 
@@ -93,26 +111,30 @@ VkExtent2D GBuffer::extent() const {
 }
 
 void GBuffer::initTargets(VulkanContext &graphicsContext) {
-  { // Create attachment textures
+  { // Create attachment textures (may be placed by the render graph)
     mGBufferTextures[Albedo].init(
       graphicsContext.device(), TextureType::T2D | TextureType::Attachment,
       TextureContents::Color, mGBufferFormats[Albedo], VK_FILTER_LINEAR,
-      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1);
+      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1,
+      mIsPlaced ? &mPlacements[Albedo] : nullptr);
 
     mGBufferTextures[Normal].init(
       graphicsContext.device(), TextureType::T2D | TextureType::Attachment,
       TextureContents::Color, mGBufferFormats[Normal], VK_FILTER_LINEAR,
-      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1);
+      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1,
+      mIsPlaced ? &mPlacements[Normal] : nullptr);
 
     mGBufferTextures[Position].init(
       graphicsContext.device(), TextureType::T2D | TextureType::Attachment,
       TextureContents::Color, mGBufferFormats[Position], VK_FILTER_LINEAR,
-      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1);
+      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1,
+      mIsPlaced ? &mPlacements[Position] : nullptr);
 
     mGBufferTextures[Depth].init(
       graphicsContext.device(), TextureType::T2D | TextureType::Attachment,
       TextureContents::Depth, mGBufferFormats[Depth], VK_FILTER_NEAREST,
-      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1);
+      {mGBufferExtent.width, mGBufferExtent.height, 1}, 1, 1,
+      mIsPlaced ? &mPlacements[Depth] : nullptr);
 
     mAlbedoUniform.init(
       graphicsContext.device(),
@@ -15,7 +15,12 @@ public:
   void beginRender(VulkanFrame &frame);
   void endRender(VulkanFrame &frame);
 
+  // Resizing puts the targets back in their own memory
   void resize(VulkanContext &vulkanContext, Resolution newResolution);
+  // One placement per target (albedo, normal, position, depth)
+  void placeTargets(
+    VulkanContext &vulkanContext,
+    const VulkanTexturePlacement *placements);
 
   const VulkanRenderPass &renderPass() const override;
   const VulkanFramebuffer &framebuffer() const override;
@@ -46,6 +51,8 @@ private:
   VulkanFramebuffer mGBufferFBO;
   VulkanTexture mGBufferTextures[Count];
   VkFormat mGBufferFormats[Count];
+  VulkanTexturePlacement mPlacements[Count];
+  bool mIsPlaced;
 
   VkExtent2D mGBufferExtent;
 
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include "Math.hpp"
+#include "Time.hpp"
 #include "Terrain.hpp"
 #include "Isosurface.hpp"
 
@@ -43,6 +45,16 @@ void Isosurface::init(const QuadTree &quadTree, VulkanContext &graphicsContext)
   mTransitionUpdates = new IsoGroup *[maxUpdateCount];
   mFullUpdateCount = 0;
   mTransitionUpdateCount = 0;
+  mMeshedFullUpdates = new IsoGroup *[maxUpdateCount];
+  mMeshedTransitionUpdates = new IsoGroup *[maxUpdateCount];
+  mMeshedFullUpdateCount = 0;
+  mMeshedTransitionUpdateCount = 0;
+
+  // Biggest groups which still point to chunks (a voxel per chunk)
+  uint32_t maxChunkCount = pow(
+    2, MIN(quadTree.mMaxLOD, CHUNK_MIP_LEVEL_COUNT - 1));
+  mGroupView.chunks = new const Voxel *[
+    maxChunkCount * maxChunkCount * maxChunkCount];
 }
 
 void Isosurface::bindToTerrain(const Terrain &terrain) {
@@ -53,9 +65,6 @@ void Isosurface::bindToTerrain(const Terrain &terrain) {
 void Isosurface::prepareForUpdate(QuadTree &quadTree, Terrain &terrain) {
   mScale = terrain.mTerrainScale;
 
-  // Generates normals for updated chunks only
-  terrain.generateVoxelNormals();
-
   /* 
      Step #1: Figure out which chunk groups to delete and to create
      Step #2: Figure out which chunk groups to update the meshes for
@@ -121,27 +130,6 @@ void Isosurface::prepareForUpdate(QuadTree &quadTree, Terrain &terrain) {
             group->level = nodeInfo.level;
             current->chunkGroupKey = group->key;
 
-            int stride = (int)pow(2, quadTree.mMaxLOD - nodeInfo.level);
-            float width = stride;
-            
-            glm::vec3 chunkCoordOffset = (glm::vec3)(
-              current->chunkCoord - groupCoord);
-
-            glm::vec3 start = (float)CHUNK_DIM * (chunkCoordOffset / width);
-
-            for (int z = 0 ; z < CHUNK_DIM / stride; ++z) {
-              for (int y = 0 ; y < CHUNK_DIM / stride; ++y) {
-                for (int x = 0 ; x < CHUNK_DIM / stride; ++x) {
-                  glm::ivec3 coord = glm::ivec3(x, y, z);
-
-                  uint32_t dstVIndex = getVoxelIndex(coord + (glm::ivec3)start);
-                  uint32_t srcVIndex = getVoxelIndex(coord * stride);
-
-                  group->voxels[dstVIndex] = current->voxels[srcVIndex];
-                }
-              }
-            }
-
             // Need to add transition updates for neighbouring chunk groups
             if (!group->pushedToFullUpdates) {
               mFullUpdates[mFullUpdateCount++] = group;
@@ -225,8 +213,8 @@ void Isosurface::prepareForUpdate(QuadTree &quadTree, Terrain &terrain) {
   }
 
   // For isogroups containing updated chunks, make sure to update voxel values
-  for (int i = 0; i < terrain.mUpdatedChunks.size; ++i) {
-    Chunk *chunk = terrain.mLoadedChunks[terrain.mUpdatedChunks[i]];
+  for (int i = 0; i < terrain.mMeshedChunks.size; ++i) {
+    Chunk *chunk = terrain.mLoadedChunks[terrain.mMeshedChunks[i]];
 
     glm::ivec3 groupCoord = getIsoGroupCoord(
       quadTree, chunk->chunkCoord);
@@ -244,80 +232,174 @@ void Isosurface::prepareForUpdate(QuadTree &quadTree, Terrain &terrain) {
 
       group->level = nodeInfo.level;
       chunk->chunkGroupKey = group->key;
+    }
+  }
 
-      int stride = (int)pow(2, quadTree.mMaxLOD - nodeInfo.level);
-      float width = stride;
-            
-      glm::vec3 chunkCoordOffset = (glm::vec3)(
-        chunk->chunkCoord - groupCoord);
+  terrain.clearUpdatedChunks();
+  quadTree.clearDiff();
 
-      glm::vec3 start = (float)CHUNK_DIM * (chunkCoordOffset / width);
+  scheduleUpdates(quadTree);
+  runScheduledUpdates(quadTree, terrain);
+}
 
-      for (int z = 0 ; z < CHUNK_DIM / stride; ++z) {
-        for (int y = 0 ; y < CHUNK_DIM / stride; ++y) {
-          for (int x = 0 ; x < CHUNK_DIM / stride; ++x) {
-            glm::ivec3 coord = glm::ivec3(x, y, z);
+bool Isosurface::hasPendingUpdates() const {
+  return mFullUpdateCount || mTransitionUpdateCount;
+}
 
-            uint32_t dstVIndex = getVoxelIndex(coord + (glm::ivec3)start);
-            uint32_t srcVIndex = getVoxelIndex(coord * stride);
+void Isosurface::scheduleUpdates(const QuadTree &quadTree) {
+  uint32_t fullUpdateCount = 0;
+  for (int i = 0; i < mFullUpdateCount; ++i) {
+    IsoGroup *group = mFullUpdates[i];
 
-            group->voxels[dstVIndex] = chunk->voxels[srcVIndex];
-          }
-        }
-      }
+    if (group && group->pushedToFullUpdates) {
+      group->priority = getUpdatePriority(quadTree, *group);
+      mFullUpdates[fullUpdateCount++] = group;
     }
   }
 
-  terrain.clearUpdatedChunks();
-  quadTree.clearDiff();
+  uint32_t transitionUpdateCount = 0;
+  for (int i = 0; i < mTransitionUpdateCount; ++i) {
+    IsoGroup *group = mTransitionUpdates[i];
+
+    // Full updates redo the transitions as well
+    if (group && group->pushedToTransitionUpdates &&
+        !group->pushedToFullUpdates) {
+      group->priority = getUpdatePriority(quadTree, *group);
+      mTransitionUpdates[transitionUpdateCount++] = group;
+    }
+  }
 
-  Voxel surfaceDensity = {(uint16_t)30000};
+  mFullUpdateCount = fullUpdateCount;
+  mTransitionUpdateCount = transitionUpdateCount;
+
+  auto isMoreImportant = [](const IsoGroup *a, const IsoGroup *b) {
+    return a->priority < b->priority ||
+      (a->priority == b->priority && a->level > b->level);
+  };
+
+  std::sort(mFullUpdates, mFullUpdates + mFullUpdateCount, isMoreImportant);
+  std::sort(
+    mTransitionUpdates, mTransitionUpdates + mTransitionUpdateCount,
+    isMoreImportant);
+}
+
+void Isosurface::runScheduledUpdates(
+  const QuadTree &quadTree, const Terrain &terrain) {
+  Core::TimeStamp start = Core::getCurrentTime();
 
   uint32_t vertexCounter = 0;
+  uint32_t full = 0, transition = 0;
 
-  for (int i = 0; i < mFullUpdateCount; ++i) {
-    IsoGroup *group = mFullUpdates[i];
+  // Both lists are sorted - whichever has the more important group goes
+  while (full < mFullUpdateCount || transition < mTransitionUpdateCount) {
+    bool isOverBudget = Core::getTimeDifference(
+      Core::getCurrentTime(), start) > MESHING_TIME_BUDGET;
 
-    uint32_t groupVertexCount = generateVertices(
-      {terrain, quadTree, *group},
-      mVertexPool + vertexCounter);
+    // Always get at least one group done
+    if ((mMeshedFullUpdateCount || mMeshedTransitionUpdateCount) &&
+        isOverBudget) {
+      break;
+    }
 
-    group->vertexCount = groupVertexCount;
-    group->verticesMem = mVertexPool + vertexCounter;
+    bool isFull = transition == mTransitionUpdateCount ||
+      (full < mFullUpdateCount && mFullUpdates[full]->priority <=
+       mTransitionUpdates[transition]->priority);
 
-    vertexCounter += groupVertexCount;
+    if (isFull) {
+      IsoGroup *group = mFullUpdates[full++];
+      gatherGroupView(terrain, quadTree, *group);
 
-    groupVertexCount = generateTransVoxelVertices(
-      {terrain, quadTree, *group},
-      mVertexPool + vertexCounter);
+      uint32_t groupVertexCount = generateVertices(
+        {terrain, quadTree, *group, mGroupView},
+        mVertexPool + vertexCounter);
 
-    group->transVoxelVertexCount = groupVertexCount;
-    group->transVerticesMem = mVertexPool + vertexCounter;
+      group->vertexCount = groupVertexCount;
+      group->verticesMem = mVertexPool + vertexCounter;
 
-    vertexCounter += groupVertexCount;
-  }
+      vertexCounter += groupVertexCount;
 
-  for (int i = 0; i < mTransitionUpdateCount; ++i) {
-    IsoGroup *group = mTransitionUpdates[i];
+      groupVertexCount = generateTransVoxelVertices(
+        {terrain, quadTree, *group, mGroupView},
+        mVertexPool + vertexCounter);
 
-    uint32_t groupVertexCount = generateTransVoxelVertices(
-      {terrain, quadTree, *group},
-      mVertexPool + vertexCounter);
+      group->transVoxelVertexCount = groupVertexCount;
+      group->transVerticesMem = mVertexPool + vertexCounter;
 
-    group->transVoxelVertexCount = groupVertexCount;
-    group->transVerticesMem = mVertexPool + vertexCounter;
+      vertexCounter += groupVertexCount;
 
-    vertexCounter += groupVertexCount;
+      // Any transition update of the group is now done as well
+      group->pushedToFullUpdates = 0;
+      group->pushedToTransitionUpdates = 0;
+      mMeshedFullUpdates[mMeshedFullUpdateCount++] = group;
+    }
+    else {
+      IsoGroup *group = mTransitionUpdates[transition++];
+
+      if (!group->pushedToTransitionUpdates) {
+        continue;
+      }
+
+      gatherGroupView(terrain, quadTree, *group);
+
+      uint32_t groupVertexCount = generateTransVoxelVertices(
+        {terrain, quadTree, *group, mGroupView},
+        mVertexPool + vertexCounter);
+
+      group->transVoxelVertexCount = groupVertexCount;
+      group->transVerticesMem = mVertexPool + vertexCounter;
+
+      vertexCounter += groupVertexCount;
+
+      group->pushedToTransitionUpdates = 0;
+      mMeshedTransitionUpdates[mMeshedTransitionUpdateCount++] = group;
+    }
   }
+
+  // What's left waits for the next pass (and gets rescheduled)
+  mFullUpdateCount -= full;
+  memmove(
+    mFullUpdates, mFullUpdates + full, sizeof(IsoGroup *) * mFullUpdateCount);
+
+  mTransitionUpdateCount -= transition;
+  memmove(
+    mTransitionUpdates, mTransitionUpdates + transition,
+    sizeof(IsoGroup *) * mTransitionUpdateCount);
 }
 
-void Isosurface::syncWithGPU(const VulkanCommandBuffer &commandBuffer) {
-  if (mFullUpdateCount) {
+void Isosurface::cancelUpdates(IsoGroup *group) {
+  if (group->pushedToFullUpdates) {
     for (int i = 0; i < mFullUpdateCount; ++i) {
-      IsoGroup *group = mFullUpdates[i];
+      if (mFullUpdates[i] == group) {
+        mFullUpdates[i] = nullptr;
+      }
+    }
+  }
 
-      group->pushedToFullUpdates = 0;
-      group->pushedToTransitionUpdates = 0;
+  // The group can have a stale entry in here even if the flag is cleared
+  for (int i = 0; i < mTransitionUpdateCount; ++i) {
+    if (mTransitionUpdates[i] == group) {
+      mTransitionUpdates[i] = nullptr;
+    }
+  }
+}
+
+float Isosurface::getUpdatePriority(
+  const QuadTree &quadTree, const IsoGroup &group) {
+  // Distance from the focal point to the group's square (quadtree space)
+  float width = pow(2, quadTree.mMaxLOD - group.level);
+  glm::vec2 start = glm::vec2(group.coord.x, group.coord.z) +
+    glm::vec2(glm::pow(2.0f, quadTree.mMaxLOD - 1));
+
+  glm::vec2 closest = glm::clamp(
+    quadTree.mFocalPoint, start, start + glm::vec2(width));
+
+  return glm::length(quadTree.mFocalPoint - closest);
+}
+
+void Isosurface::syncWithGPU(const VulkanCommandBuffer &commandBuffer) {
+  if (mMeshedFullUpdateCount) {
+    for (int i = 0; i < mMeshedFullUpdateCount; ++i) {
+      IsoGroup *group = mMeshedFullUpdates[i];
 
       if (group->vertices.size()) {
         // This chunk already has allocated memory
@@ -360,17 +442,14 @@ void Isosurface::syncWithGPU(const VulkanCommandBuffer &commandBuffer) {
       }
     }
 
-    mFullUpdateCount = 0;
+    mMeshedFullUpdateCount = 0;
 
     mGPUVerticesAllocator.debugLogState();
   }
 
-  if (mTransitionUpdateCount) {
-    for (int i = 0; i < mTransitionUpdateCount; ++i) {
-      IsoGroup *group = mTransitionUpdates[i];
-      
-      group->pushedToFullUpdates = 0;
-      group->pushedToTransitionUpdates = 0;
+  if (mMeshedTransitionUpdateCount) {
+    for (int i = 0; i < mMeshedTransitionUpdateCount; ++i) {
+      IsoGroup *group = mMeshedTransitionUpdates[i];
 
       if (group->transVoxelVertices.size()) {
         // This chunk already has allocated memory
@@ -393,7 +472,7 @@ void Isosurface::syncWithGPU(const VulkanCommandBuffer &commandBuffer) {
       }
     }
 
-    mTransitionUpdateCount = 0;
+    mMeshedTransitionUpdateCount = 0;
 
     mGPUVerticesAllocator.debugLogState();
   }
@@ -469,6 +548,9 @@ void Isosurface::freeIsoGroup(IsoGroup *group) {
   uint32_t hash = hashIsoGroupCoord(group->coord);
   mIsoGroupIndices.remove(hash);
 
+  // Whatever was scheduled for the group is stale now
+  cancelUpdates(group);
+
   if (group->vertices.size()) {
     mGPUVerticesAllocator.free(group->vertices);
   }
@@ -532,33 +614,86 @@ IsoGroup *Isosurface::getFirstFlatIsoGroup(glm::ivec2 flatCoord) {
   }
 }
 
-uint32_t Isosurface::generateVertices(
-  GenIsoGroupVerticesParams params,
-  IsoVertex *meshVertices) {
-  const auto &terrain = params.terrain;
-  const auto &quadTree = params.quadTree;
-  const auto &group = params.group;
+void Isosurface::gatherGroupView(
+  const Terrain &terrain,
+  const QuadTree &quadTree,
+  const IsoGroup &group) {
+  IsoGroupView &view = mGroupView;
 
-  int groupSize = pow(2, quadTree.mMaxLOD - group.level);
-  int stride = groupSize;
-  // glm::ivec3 groupCoord = group.coord + glm::ivec3(
-  // pow(2, mQuadTree.mMaxLOD - 1));
+  uint32_t mipLevel = quadTree.mMaxLOD - group.level;
+  int groupSize = pow(2, mipLevel);
   glm::ivec3 groupStart = group.coord * (int)CHUNK_DIM;
 
-  // TODO: Optimise the getVoxel operation
-  auto getVoxel = [&terrain, &groupSize, &groupStart](
-    uint32_t x, uint32_t y, uint32_t z) {
-    return terrain.getVoxel(groupStart + glm::ivec3(x, y, z) * groupSize);
-  };
+  view.mipLevel = mipLevel;
+  // Terrain::getVoxel clamps to the last mip level as well
+  view.sampleOffset = getMipSampleOffset(
+    MIN(mipLevel, CHUNK_MIP_LEVEL_COUNT - 1)) / (float)groupSize;
+  view.lodSampleOffset = getMipSampleOffset(
+    MIN(mipLevel ? mipLevel - 1 : 0, CHUNK_MIP_LEVEL_COUNT - 1)) /
+    (float)groupSize;
+
+  if (mipLevel < CHUNK_MIP_LEVEL_COUNT) {
+    view.chunkCount = groupSize;
+    view.chunkShift = CHUNK_MIP_LEVEL_COUNT - 1 - mipLevel;
+  }
+  else {
+    // Chunks are smaller than the group's voxels - nothing to point to
+    view.chunkCount = 1;
+    view.chunkShift = CHUNK_MIP_LEVEL_COUNT - 1;
+  }
 
-  auto getVoxelLOD = [&terrain, &groupSize, &groupStart, &stride](
-    uint32_t x, uint32_t y, uint32_t z,
-    // Offset
-    uint32_t ox, uint32_t oy, uint32_t oz) {
-    return terrain.getVoxel(
-      groupStart + glm::ivec3(x, y, z) * groupSize +
-      glm::ivec3(ox, oy, oz) * stride / 2);
-  };
+  uint32_t chunkCount = view.chunkCount;
+  memset(
+    view.chunks, 0,
+    sizeof(const Voxel *) * chunkCount * chunkCount * chunkCount);
+
+  if (mipLevel < CHUNK_MIP_LEVEL_COUNT) {
+    for (int z = 0; z < groupSize; ++z) {
+      for (int x = 0; x < groupSize; ++x) {
+        glm::ivec2 flatCoord = glm::ivec2(group.coord.x, group.coord.z) +
+          glm::ivec2(x, z);
+        Chunk *current = terrain.getFirstFlatChunk(flatCoord);
+
+        while (current) {
+          glm::ivec3 local = current->chunkCoord - group.coord;
+
+          // Flat chunk coords wrap around in the hash too
+          if (local.x == x && local.z == z &&
+              local.y >= 0 && local.y < groupSize) {
+            uint32_t index = (z * chunkCount + local.y) * chunkCount + x;
+            // Stays valid until the terrain's endReading
+            view.chunks[index] = current->read()->mipLevel(mipLevel);
+          }
+
+          if (current->next == INVALID_CHUNK_INDEX) {
+            current = nullptr;
+          }
+          else {
+            current = terrain.mLoadedChunks[current->next];
+          }
+        }
+      }
+    }
+  }
+
+  // The apron comes from the neighbouring groups
+  const uint32_t APRON_DIM = IsoGroupView::APRON_DIM;
+  for (uint32_t b = 0; b < APRON_DIM; ++b) {
+    for (uint32_t a = 0; a < APRON_DIM; ++a) {
+      view.apron[0][b * APRON_DIM + a] = terrain.getVoxel(
+        groupStart + glm::ivec3(CHUNK_DIM, a, b) * groupSize, mipLevel);
+      view.apron[1][b * APRON_DIM + a] = terrain.getVoxel(
+        groupStart + glm::ivec3(a, CHUNK_DIM, b) * groupSize, mipLevel);
+      view.apron[2][b * APRON_DIM + a] = terrain.getVoxel(
+        groupStart + glm::ivec3(a, b, CHUNK_DIM) * groupSize, mipLevel);
+    }
+  }
+}
+
+uint32_t Isosurface::generateVertices(
+  GenIsoGroupVerticesParams params,
+  IsoVertex *meshVertices) {
+  const auto &view = params.view;
 
   uint32_t vertexCount = 0;
 
@@ -566,19 +701,19 @@ uint32_t Isosurface::generateVertices(
     for (uint32_t y = 1; y < CHUNK_DIM - 1; ++y) {
       for (uint32_t x = 1; x < CHUNK_DIM - 1; ++x) {
         Voxel voxelValues[8] = {
-          group.voxels[getVoxelIndex(x,     y,     z)],
-          group.voxels[getVoxelIndex(x + 1, y,     z)],
-          group.voxels[getVoxelIndex(x,     y + 1, z)],
-          group.voxels[getVoxelIndex(x + 1, y + 1, z)],
-
-          group.voxels[getVoxelIndex(x,     y,     z + 1)],
-          group.voxels[getVoxelIndex(x + 1, y,     z + 1)],
-          group.voxels[getVoxelIndex(x,     y + 1, z + 1)],
-          group.voxels[getVoxelIndex(x + 1, y + 1, z + 1)],
+          view.get(x,     y,     z),
+          view.get(x + 1, y,     z),
+          view.get(x,     y + 1, z),
+          view.get(x + 1, y + 1, z),
+
+          view.get(x,     y,     z + 1),
+          view.get(x + 1, y,     z + 1),
+          view.get(x,     y + 1, z + 1),
+          view.get(x + 1, y + 1, z + 1),
         };
 
         updateVoxelCell(
-          voxelValues, glm::ivec3(x, y, z),
+          voxelValues, glm::ivec3(x, y, z), view.sampleOffset,
           meshVertices, vertexCount);
       }
     }
@@ -646,10 +781,12 @@ void Isosurface::updateIsoGroupFace(
   const auto &terrain = params.terrain;
   const auto &quadTree = params.quadTree;
   const auto &group = params.group;
+  const auto &view = params.view;
 
   int groupSize = pow(2, quadTree.mMaxLOD - group.level);
   glm::ivec3 groupStart = group.coord * (int)CHUNK_DIM;
   int stride = groupSize;
+  uint32_t mipLevel = quadTree.mMaxLOD - group.level;
 
   glm::ivec3 groupCoordOffset = glm::ivec3(0);
   groupCoordOffset[faceAxis] = (int)side * 2 - 1;
@@ -671,18 +808,19 @@ void Isosurface::updateIsoGroupFace(
       {0, 0, 1}, {1, 0, 1}, {0, 1, 1}, {1, 1, 1},
     };
 
-    auto getVoxel = [&terrain, &groupSize, &groupStart](
-      uint32_t x, uint32_t y, uint32_t z) {
-      return terrain.getVoxel(groupStart + glm::ivec3(x, y, z) * groupSize);
+    // Voxels at the group's LOD, only the finer ones need looking up
+    auto getVoxel = [&view](uint32_t x, uint32_t y, uint32_t z) {
+      return view.get(x, y, z);
     };
 
-    auto getVoxelLOD = [&terrain, &groupSize, &groupStart, &stride](
+    auto getVoxelLOD = [&terrain, &groupSize, &groupStart, &stride, mipLevel](
       uint32_t x, uint32_t y, uint32_t z,
       // Offset
       uint32_t ox, uint32_t oy, uint32_t oz) {
+      // Half way between the group's voxels is one mip level down
       return terrain.getVoxel(
         groupStart + glm::ivec3(x, y, z) * groupSize +
-        glm::ivec3(ox, oy, oz) * stride / 2);
+        glm::ivec3(ox, oy, oz) * stride / 2, mipLevel ? mipLevel - 1 : 0);
     };
 
     if (adjacentNode.level <= group.level) {
@@ -705,7 +843,9 @@ void Isosurface::updateIsoGroupFace(
           coord[secondAxis] = d1;
           coord[faceAxis] = d2;
 
-          updateVoxelCell(voxelValues, coord, meshVertices, vertexCount);
+          updateVoxelCell(
+            voxelValues, coord, view.sampleOffset,
+            meshVertices, vertexCount);
         }
       }
     }
@@ -780,7 +920,8 @@ void Isosurface::updateIsoGroupFace(
 
           updateTransVoxelCell(
             voxelValues, transVoxels,
-            axis, coord, meshVertices, vertexCount);
+            axis, coord, view.sampleOffset, view.lodSampleOffset,
+            meshVertices, vertexCount);
         }
       }
     }
@@ -792,6 +933,7 @@ void Isosurface::updateIsoGroupFace(
 void Isosurface::updateVoxelCell(
   Voxel *voxels,
   const glm::ivec3 &coord,
+  float sampleOffset,
   IsoVertex *meshVertices,
   uint32_t &vertexCount) {
   uint8_t bitCombination = 0;
@@ -810,7 +952,7 @@ void Isosurface::updateVoxelCell(
   glm::vec3 vertices[8] = {};
   for (uint32_t i = 0; i < 8; ++i) {
     vertices[i] = NORMALIZED_CUBE_VERTICES[i] +
-      glm::vec3(0.5f) + glm::vec3(coord);
+      glm::vec3(0.5f + sampleOffset) + glm::vec3(coord);
   }
 
   IsoVertex *verts = STACK_ALLOC(IsoVertex, cellData.GetVertexCount());
@@ -871,6 +1013,7 @@ void Isosurface::updateTransVoxelCell(
   Voxel *transVoxels,
   const glm::ivec3 &axis,
   const glm::ivec3 &coord,
+  float sampleOffset, float lodSampleOffset,
   IsoVertex *meshVertices,
   uint32_t &vertexCount) {
   const float percentTrans = 0.125f;
@@ -892,7 +1035,7 @@ void Isosurface::updateTransVoxelCell(
     glm::vec3 vertices[8] = {};
     for (uint32_t i = 0; i < 8; ++i) {
       vertices[i] = NORMALIZED_CUBE_VERTICES[i] +
-        glm::vec3(0.5f) + glm::vec3(coord);
+        glm::vec3(0.5f + sampleOffset) + glm::vec3(coord);
     }
 
     if (axis.x == -1) {
@@ -1011,7 +1154,8 @@ void Isosurface::updateTransVoxelCell(
         vertices[counter][detailed1] = (float)d1 * 0.5f;
         vertices[counter][nonDetailed] = (float)nonDetailedBit;
 
-        vertices[counter] += glm::vec3(coord);
+        // The finer samples come from one mip level down
+        vertices[counter] += glm::vec3(coord) + glm::vec3(lodSampleOffset);
         ++counter;
       }
     }
@@ -1022,7 +1166,7 @@ void Isosurface::updateTransVoxelCell(
         vertices[counter][detailed1] = (float)d1;
         vertices[counter][nonDetailed] = (float)(nonDetailedBit ^ 1);
 
-        vertices[counter] += glm::vec3(coord);
+        vertices[counter] += glm::vec3(coord) + glm::vec3(sampleOffset);
         ++counter;
       }
     }
@@ -20,8 +20,6 @@ struct IsoVertex {
 
 /* A group which can encompass a certain volume of chunks depending on LOD */
 struct IsoGroup {
-  Voxel voxels[CHUNK_VOLUME];
-
   VulkanArenaSlot vertices;
   uint32_t vertexCount;
   IsoVertex *verticesMem;
@@ -34,6 +32,9 @@ struct IsoGroup {
   uint16_t level;
   NumericMapKey key;
 
+  /* Groups with the lowest priority get meshed first */
+  float priority;
+
   union {
     struct {
       uint8_t needsUpdate : 1;
@@ -52,6 +53,52 @@ struct IsoGroup {
   QuadTree::NodeInfo nodeInfo;
 };
 
+/*
+   Voxels an IsoGroup gets meshed from. Points straight at the chunks' mip
+   level which matches the group's LOD (the voxels themselves at the finest
+   LOD) - only the apron on the group's positive faces, which belongs to
+   the neighbouring groups, gets copied.
+*/
+struct IsoGroupView {
+  static constexpr uint32_t APRON_DIM = CHUNK_DIM + 1;
+
+  uint32_t mipLevel;
+  /*
+     Where the samples of the group's level (and the finer ones transition
+     cells use) really sit past their lattice point, in the group's voxels
+  */
+  float sampleOffset;
+  float lodSampleOffset;
+  // Chunks along each axis of the group, log2 of their voxels along each
+  uint32_t chunkCount;
+  uint32_t chunkShift;
+  // chunkCount^3 chunk mip levels, null where there is no chunk
+  const Voxel **chunks;
+  // Voxels where x, y or z (in that order) is CHUNK_DIM
+  Voxel apron[3][APRON_DIM * APRON_DIM];
+
+  // 0 <= x, y, z <= CHUNK_DIM
+  const Voxel &get(uint32_t x, uint32_t y, uint32_t z) const {
+    static const Voxel NULL_VOXEL = {};
+
+    if (x == CHUNK_DIM) return apron[0][z * APRON_DIM + y];
+    if (y == CHUNK_DIM) return apron[1][z * APRON_DIM + x];
+    if (z == CHUNK_DIM) return apron[2][y * APRON_DIM + x];
+
+    const Voxel *chunk = chunks[
+      ((z >> chunkShift) * chunkCount + (y >> chunkShift)) * chunkCount +
+      (x >> chunkShift)];
+
+    if (!chunk) {
+      return NULL_VOXEL;
+    }
+
+    uint32_t mask = (1 << chunkShift) - 1;
+    return chunk[getMipVoxelIndex(
+      glm::ivec3(x & mask, y & mask, z & mask), mipLevel)];
+  }
+};
+
 /* This is what the IsoSurfaceRenderer will be rendering from */
 struct IsoGroupSnapshot {
   glm::ivec3 coord;
@@ -65,9 +112,15 @@ class Isosurface {
 public:
   void init(const QuadTree &quadTree, VulkanContext &graphicsContext);
 
-  /* Adds all updated chunks to full updates, or transition updates */
+  /*
+     Adds all updated chunks to full updates, or transition updates, then
+     meshes as many of the scheduled updates as the budget allows
+  */
   void prepareForUpdate(QuadTree &quadTree, Terrain &terrain);
 
+  /* Updates which didn't fit in the budget of the last meshing pass */
+  bool hasPendingUpdates() const;
+
   /* Make sure that the terrain scale is right */
   void bindToTerrain(const Terrain &terrain);
 
@@ -101,10 +154,28 @@ private:
   IsoGroup *getIsoGroup(const glm::ivec3 &coord);
   void freeIsoGroup(IsoGroup *group);
 
+  /*
+     Drops updates of groups which were deleted or already meshed, then
+     orders the rest: closest to the focal point first, finer LOD first
+  */
+  void scheduleUpdates(const QuadTree &quadTree);
+  /* Meshes scheduled updates until MESHING_TIME_BUDGET runs out */
+  void runScheduledUpdates(const QuadTree &quadTree, const Terrain &terrain);
+  /* Removes the group from the scheduled updates (it's getting freed) */
+  void cancelUpdates(IsoGroup *group);
+  float getUpdatePriority(const QuadTree &quadTree, const IsoGroup &group);
+
+  /* Points mGroupView to the group's chunks and gathers its apron */
+  void gatherGroupView(
+    const Terrain &terrain,
+    const QuadTree &quadTree,
+    const IsoGroup &group);
+
   struct GenIsoGroupVerticesParams {
     const Terrain &terrain;
     const QuadTree &quadTree;
     const IsoGroup &group;
+    const IsoGroupView &view;
   };
 
   uint32_t generateVertices(GenIsoGroupVerticesParams, IsoVertex *out);
@@ -119,6 +190,7 @@ private:
   void updateVoxelCell(
     Voxel *voxels,
     const glm::ivec3 &coord,
+    float sampleOffset,
     IsoVertex *meshVertices,
     uint32_t &vertexCount);
 
@@ -127,6 +199,7 @@ private:
     Voxel *transVoxels,
     const glm::ivec3 &axis,
     const glm::ivec3 &coord,
+    float sampleOffset, float lodSampleOffset,
     IsoVertex *meshVertices,
     uint32_t &vertexCount);
 
@@ -140,6 +213,9 @@ private:
   /* After every update, this gets filled up with vertices */
   IsoVertex *mVertexPool;
 
+  /* Seconds of meshing per pass - what's left waits for the next one */
+  static constexpr float MESHING_TIME_BUDGET = 0.004f;
+
   /* IsoGroups which need a full update - both inner and outer voxels */
   IsoGroup **mFullUpdates;
   uint32_t mFullUpdateCount;
@@ -148,11 +224,20 @@ private:
   IsoGroup **mTransitionUpdates;
   uint32_t mTransitionUpdateCount;
 
+  /* Meshed by the last pass, waiting to be uploaded by syncWithGPU */
+  IsoGroup **mMeshedFullUpdates;
+  uint32_t mMeshedFullUpdateCount;
+  IsoGroup **mMeshedTransitionUpdates;
+  uint32_t mMeshedTransitionUpdateCount;
+
   /* Where the actual IsoGroups are stored */
   NumericMap<IsoGroup *> mIsoGroups;
   FastMap<uint32_t, 1000, 30, 10> mIsoGroupIndices;
   FastMap<uint32_t, 500, 30, 10> mFlatIsoGroupIndices;
 
+  /* The meshing job only looks at one group at a time */
+  IsoGroupView mGroupView;
+
   Voxel mSurfaceDensity;
 
   int mScale;
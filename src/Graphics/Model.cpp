@@ -38,17 +38,40 @@ void ModelConfig::configureVertexInput(VulkanPipelineConfig &config) {
   }
 }
 
+void ModelConfig::configureVertexInput(
+  VulkanPipelineConfig &config, uint32_t instanceSize) {
+  assert(instanceSize % sizeof(glm::vec4) == 0);
+
+  uint32_t instanceAttributeCount = instanceSize / sizeof(glm::vec4);
+  uint32_t instanceBinding = mAttributeCount;
+
+  config.configureVertexInput(
+    mAttributeCount + instanceAttributeCount, mAttributeCount + 1);
+
+  for (int i = 0; i < mAttributeCount; ++i) {
+    config.setBinding(i, mAttributes[i].attribSize, VK_VERTEX_INPUT_RATE_VERTEX);
+    config.setBindingAttribute(i, i, mAttributes[i].format, 0);
+  }
+
+  config.setBinding(
+    instanceBinding, instanceSize, VK_VERTEX_INPUT_RATE_INSTANCE);
+
+  for (int i = 0; i < instanceAttributeCount; ++i) {
+    config.setBindingAttribute(
+      mAttributeCount + i, instanceBinding,
+      VK_FORMAT_R32G32B32A32_SFLOAT, i * sizeof(glm::vec4));
+  }
+}
+
 void Model::init(const ModelConfig &def, VulkanContext &context) {
   mVertexCount = def.mVertexCount;
 
   if (def.mIndexCount > 0) {
     mIndexBuffer.init(
       context.device(), def.mIndices.size,
-      (VulkanBufferFlagBits)VulkanBufferFlag::IndexBuffer);
+      VulkanBufferFlag::IndexBuffer | VulkanBufferFlag::UploadTarget);
 
-    mIndexBuffer.fillWithStaging(
-      context.device(), context.commandPool(),
-      def.mIndices);
+    mIndexBuffer.fillWithStaging(context.device(), def.mIndices);
   }
 
   mVertexBufferCount = 0;
@@ -60,11 +83,9 @@ void Model::init(const ModelConfig &def, VulkanContext &context) {
 
     buf.init(
       context.device(), attribute.data.size,
-      (VulkanBufferFlagBits)VulkanBufferFlag::VertexBuffer);
+      VulkanBufferFlag::VertexBuffer | VulkanBufferFlag::UploadTarget);
 
-    buf.fillWithStaging(
-      context.device(), context.commandPool(),
-      attribute.data);
+    buf.fillWithStaging(context.device(), attribute.data);
 
     mVertexBuffersRaw[i] = buf.mBuffer;
   }
@@ -72,6 +93,22 @@ void Model::init(const ModelConfig &def, VulkanContext &context) {
   mVertexBufferCount = def.mAttributeCount;
   mIndexType = def.mIndexType;
   mIndexCount = def.mIndexCount;
+
+  mBounds = {glm::vec3(0.0f), glm::vec3(0.0f)};
+
+  if (def.mAttributeCount &&
+      def.mAttributes[0].format == VK_FORMAT_R32G32B32_SFLOAT) {
+    const glm::vec3 *positions = (glm::vec3 *)def.mAttributes[0].data.data;
+
+    if (mVertexCount) {
+      mBounds = {positions[0], positions[0]};
+    }
+
+    for (int i = 1; i < mVertexCount; ++i) {
+      mBounds.min = glm::min(mBounds.min, positions[i]);
+      mBounds.max = glm::max(mBounds.max, positions[i]);
+    }
+  }
 }
 
 void Model::bindVertexBuffers(const VulkanCommandBuffer &commandBuffer) const {
@@ -86,10 +123,17 @@ void Model::bindIndexBuffer(const VulkanCommandBuffer &commandBuffer) const {
   commandBuffer.bindIndexBuffer(0, mIndexType, mIndexBuffer);
 }
 
+void Model::bindInstanceBuffer(
+  const VulkanCommandBuffer &commandBuffer,
+  const VulkanBuffer &instances) const {
+  commandBuffer.bindVertexBuffers(mVertexBufferCount, 1, &instances);
+}
+
 void Model::submitForRenderIndexed(
   const VulkanCommandBuffer &commandBuffer,
-  uint32_t instanceCount) const {
-  commandBuffer.drawIndexed(mIndexCount, instanceCount, 0, 0, 0);
+  uint32_t instanceCount,
+  uint32_t firstInstance) const {
+  commandBuffer.drawIndexed(mIndexCount, instanceCount, 0, 0, firstInstance);
 }
 
 void Model::submitForRender(
@@ -98,4 +142,8 @@ void Model::submitForRender(
   commandBuffer.draw(mVertexCount, instanceCount, 0, 0);
 }
 
+const BoundingBox &Model::bounds() const {
+  return mBounds;
+}
+
 }
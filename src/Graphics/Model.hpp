@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include "SceneBVH.hpp"
 #include "VulkanBuffer.hpp"
 #include "VulkanContext.hpp"
 
@@ -22,6 +23,13 @@ public:
     uint32_t indexCount, VkIndexType type, const Buffer &data);
 
   void configureVertexInput(VulkanPipelineConfig &config);
+  /*
+     Same but with an extra per instance binding after the model's bindings.
+     Every 16 bytes of the instance get a vec4 attribute (with locations
+     following the model's attributes).
+  */
+  void configureVertexInput(
+    VulkanPipelineConfig &config, uint32_t instanceSize);
 
 private:
   static constexpr uint32_t MAX_ATTRIBUTE_COUNT = 10;
@@ -51,14 +59,22 @@ public:
 
   void bindVertexBuffers(const VulkanCommandBuffer &commandBuffer) const;
   void bindIndexBuffer(const VulkanCommandBuffer &commandBuffer) const;
+  // Binding right after the model's vertex buffers
+  void bindInstanceBuffer(
+    const VulkanCommandBuffer &commandBuffer,
+    const VulkanBuffer &instances) const;
   void submitForRenderIndexed(
     const VulkanCommandBuffer &commandBuffer,
-    uint32_t instanceCount = 1) const;
+    uint32_t instanceCount = 1,
+    uint32_t firstInstance = 0) const;
 
   void submitForRender(
     const VulkanCommandBuffer &commandBuffer,
     uint32_t instanceCount = 1) const;
 
+  // Model space, from the first attribute (the positions)
+  const BoundingBox &bounds() const;
+
 private:
   static constexpr uint32_t MAX_VERTEX_BUFFER_COUNT = 10;
 
@@ -71,6 +87,7 @@ private:
   uint32_t mIndexCount;
 
   uint32_t mVertexCount;
+  BoundingBox mBounds;
 };
 
 }
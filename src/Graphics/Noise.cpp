@@ -0,0 +1,437 @@
+#include <atomic>
+#include <math.h>
+#include "Noise.hpp"
+#include "Utils.hpp"
+#include "NoiseKernels.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+  defined(_M_IX86)
+#define NOISE_X86
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NOISE_USE_SSE2
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define NOISE_USE_NEON
+#endif
+
+#if defined(NOISE_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+namespace Ondine::Graphics {
+
+namespace {
+
+struct ScalarLane {
+  static constexpr uint32_t WIDTH = 1;
+
+  ScalarLane(float value) : v(value) {}
+
+  static ScalarLane load(const float *p) { return *p; }
+  static void store(float *p, ScalarLane a) { *p = a.v; }
+
+  float v;
+};
+
+inline ScalarLane operator+(ScalarLane a, ScalarLane b) { return a.v + b.v; }
+inline ScalarLane operator-(ScalarLane a, ScalarLane b) { return a.v - b.v; }
+inline ScalarLane operator*(ScalarLane a, ScalarLane b) { return a.v * b.v; }
+inline ScalarLane operator/(ScalarLane a, ScalarLane b) { return a.v / b.v; }
+inline ScalarLane operator-(ScalarLane a) { return -a.v; }
+inline bool operator<(ScalarLane a, ScalarLane b) { return a.v < b.v; }
+inline bool operator>(ScalarLane a, ScalarLane b) { return a.v > b.v; }
+
+inline ScalarLane select(bool mask, ScalarLane a, ScalarLane b) {
+  return mask ? a : b;
+}
+
+inline ScalarLane floor(ScalarLane a) { return floorf(a.v); }
+inline ScalarLane abs(ScalarLane a) { return fabsf(a.v); }
+
+#ifdef NOISE_USE_SSE2
+
+struct SSE2Lane {
+  static constexpr uint32_t WIDTH = 4;
+
+  SSE2Lane(float value) : v(_mm_set1_ps(value)) {}
+  SSE2Lane(__m128 value) : v(value) {}
+
+  static SSE2Lane load(const float *p) { return _mm_loadu_ps(p); }
+  static void store(float *p, SSE2Lane a) { _mm_storeu_ps(p, a.v); }
+
+  __m128 v;
+};
+
+struct SSE2Mask {
+  __m128 v;
+};
+
+inline SSE2Lane operator+(SSE2Lane a, SSE2Lane b) {
+  return _mm_add_ps(a.v, b.v);
+}
+
+inline SSE2Lane operator-(SSE2Lane a, SSE2Lane b) {
+  return _mm_sub_ps(a.v, b.v);
+}
+
+inline SSE2Lane operator*(SSE2Lane a, SSE2Lane b) {
+  return _mm_mul_ps(a.v, b.v);
+}
+
+inline SSE2Lane operator/(SSE2Lane a, SSE2Lane b) {
+  return _mm_div_ps(a.v, b.v);
+}
+
+inline SSE2Lane operator-(SSE2Lane a) {
+  return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f));
+}
+
+inline SSE2Mask operator<(SSE2Lane a, SSE2Lane b) {
+  return {_mm_cmplt_ps(a.v, b.v)};
+}
+
+inline SSE2Mask operator>(SSE2Lane a, SSE2Lane b) {
+  return {_mm_cmpgt_ps(a.v, b.v)};
+}
+
+inline SSE2Lane select(SSE2Mask mask, SSE2Lane a, SSE2Lane b) {
+  return _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v));
+}
+
+inline SSE2Lane abs(SSE2Lane a) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v);
+}
+
+// No round instruction before SSE4.1
+inline SSE2Lane floor(SSE2Lane a) {
+  __m128 sign = _mm_set1_ps(-0.0f);
+
+  __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+  __m128 isAbove = _mm_cmpgt_ps(truncated, a.v);
+  __m128 floored = _mm_sub_ps(
+    truncated, _mm_and_ps(isAbove, _mm_set1_ps(1.0f)));
+
+  // From 2^23 on everything is a whole number (and may not fit in an int)
+  __m128 isSmall = _mm_cmplt_ps(
+    _mm_andnot_ps(sign, a.v), _mm_set1_ps(8388608.0f));
+  floored = _mm_or_ps(
+    _mm_and_ps(isSmall, floored), _mm_andnot_ps(isSmall, a.v));
+
+  // floor(-0) is -0
+  return _mm_or_ps(floored, _mm_and_ps(a.v, sign));
+}
+
+#endif
+
+#ifdef NOISE_USE_NEON
+
+struct NEONLane {
+  static constexpr uint32_t WIDTH = 4;
+
+  NEONLane(float value) : v(vdupq_n_f32(value)) {}
+  NEONLane(float32x4_t value) : v(value) {}
+
+  static NEONLane load(const float *p) { return vld1q_f32(p); }
+  static void store(float *p, NEONLane a) { vst1q_f32(p, a.v); }
+
+  float32x4_t v;
+};
+
+struct NEONMask {
+  uint32x4_t v;
+};
+
+inline NEONLane operator+(NEONLane a, NEONLane b) {
+  return vaddq_f32(a.v, b.v);
+}
+
+inline NEONLane operator-(NEONLane a, NEONLane b) {
+  return vsubq_f32(a.v, b.v);
+}
+
+inline NEONLane operator*(NEONLane a, NEONLane b) {
+  return vmulq_f32(a.v, b.v);
+}
+
+inline NEONLane operator/(NEONLane a, NEONLane b) {
+  return vdivq_f32(a.v, b.v);
+}
+
+inline NEONLane operator-(NEONLane a) {
+  return vnegq_f32(a.v);
+}
+
+inline NEONMask operator<(NEONLane a, NEONLane b) {
+  return {vcltq_f32(a.v, b.v)};
+}
+
+inline NEONMask operator>(NEONLane a, NEONLane b) {
+  return {vcgtq_f32(a.v, b.v)};
+}
+
+inline NEONLane select(NEONMask mask, NEONLane a, NEONLane b) {
+  return vbslq_f32(mask.v, a.v, b.v);
+}
+
+inline NEONLane abs(NEONLane a) {
+  return vabsq_f32(a.v);
+}
+
+inline NEONLane floor(NEONLane a) {
+  return vrndmq_f32(a.v);
+}
+
+#endif
+
+// Function-local so that it doesn't matter which file gets initialised first
+const NoiseKernelTable *scalarNoiseKernels() {
+  static const NoiseKernelTable table = makeNoiseKernelTable<ScalarLane>();
+  return &table;
+}
+
+const NoiseKernelTable *sse2NoiseKernels() {
+#ifdef NOISE_USE_SSE2
+  static const NoiseKernelTable table = makeNoiseKernelTable<SSE2Lane>();
+  return &table;
+#else
+  return nullptr;
+#endif
+}
+
+const NoiseKernelTable *neonNoiseKernels() {
+#ifdef NOISE_USE_NEON
+  static const NoiseKernelTable table = makeNoiseKernelTable<NEONLane>();
+  return &table;
+#else
+  return nullptr;
+#endif
+}
+
+bool isAVX2SupportedByCPU() {
+#if defined(NOISE_X86) && defined(__GNUC__)
+  return __builtin_cpu_supports("avx2");
+#elif defined(NOISE_X86) && defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 1);
+
+  // The OS also needs to save the YMM registers
+  bool hasAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28));
+  if (!hasAVX || (_xgetbv(0) & 6) != 6) {
+    return false;
+  }
+
+  __cpuidex(info, 7, 0);
+  return info[1] & (1 << 5);
+#else
+  return false;
+#endif
+}
+
+const NoiseKernelTable *noiseKernels(NoiseISA isa) {
+  switch (isa) {
+  case NoiseISA::Scalar: return scalarNoiseKernels();
+  case NoiseISA::SSE2: return sse2NoiseKernels();
+  case NoiseISA::NEON: return neonNoiseKernels();
+  case NoiseISA::AVX2: {
+    return isAVX2SupportedByCPU() ? avx2NoiseKernels() : nullptr;
+  }
+  default: return nullptr;
+  }
+}
+
+std::atomic<NoiseISA> gNoiseISA{NoiseISA::Count};
+std::atomic<const NoiseKernelTable *> gNoiseKernels{nullptr};
+
+const NoiseKernelTable *currentNoiseKernels() {
+  const NoiseKernelTable *kernels = gNoiseKernels.load(
+    std::memory_order_acquire);
+
+  if (!kernels) {
+    // Widest first
+    static const NoiseISA ISAS[] = {
+      NoiseISA::AVX2, NoiseISA::SSE2, NoiseISA::NEON, NoiseISA::Scalar
+    };
+
+    for (NoiseISA isa : ISAS) {
+      if ((kernels = noiseKernels(isa))) {
+        gNoiseISA.store(isa, std::memory_order_relaxed);
+        gNoiseKernels.store(kernels, std::memory_order_release);
+        break;
+      }
+    }
+  }
+
+  return kernels;
+}
+
+template <bool IsRidged>
+void accumulateOctave(
+  float *result, const float *noise, float amplitude, uint32_t count) {
+  for (uint32_t i = 0; i < count; ++i) {
+    if (IsRidged) {
+      float ridge = 1.0f - fabsf(noise[i]);
+      result[i] += ridge * ridge * amplitude;
+    }
+    else {
+      result[i] += noise[i] * amplitude;
+    }
+  }
+}
+
+template <bool IsRidged>
+void fractal2D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y,
+  float *result, uint32_t count) {
+  NoiseProc2D proc = currentNoiseKernels()->noise2D[(int)fractal.type];
+
+  float scaledX[NOISE_BATCH_SIZE], scaledY[NOISE_BATCH_SIZE];
+  float noise[NOISE_BATCH_SIZE];
+
+  for (uint32_t first = 0; first < count; first += NOISE_BATCH_SIZE) {
+    uint32_t batchSize = MIN(NOISE_BATCH_SIZE, count - first);
+    float *batchResult = result + first;
+
+    memset(batchResult, 0, sizeof(float) * batchSize);
+
+    float frequency = fractal.frequency;
+    float amplitude = fractal.amplitude;
+
+    for (uint32_t o = 0; o < fractal.octaveCount; ++o) {
+      for (uint32_t i = 0; i < batchSize; ++i) {
+        scaledX[i] = x[first + i] * frequency;
+        scaledY[i] = y[first + i] * frequency;
+      }
+
+      proc(scaledX, scaledY, noise, batchSize);
+      accumulateOctave<IsRidged>(batchResult, noise, amplitude, batchSize);
+
+      frequency *= fractal.lacunarity;
+      amplitude *= fractal.gain;
+    }
+  }
+}
+
+template <bool IsRidged>
+void fractal3D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count) {
+  NoiseProc3D proc = currentNoiseKernels()->noise3D[(int)fractal.type];
+
+  float scaledX[NOISE_BATCH_SIZE], scaledY[NOISE_BATCH_SIZE];
+  float scaledZ[NOISE_BATCH_SIZE], noise[NOISE_BATCH_SIZE];
+
+  for (uint32_t first = 0; first < count; first += NOISE_BATCH_SIZE) {
+    uint32_t batchSize = MIN(NOISE_BATCH_SIZE, count - first);
+    float *batchResult = result + first;
+
+    memset(batchResult, 0, sizeof(float) * batchSize);
+
+    float frequency = fractal.frequency;
+    float amplitude = fractal.amplitude;
+
+    for (uint32_t o = 0; o < fractal.octaveCount; ++o) {
+      for (uint32_t i = 0; i < batchSize; ++i) {
+        scaledX[i] = x[first + i] * frequency;
+        scaledY[i] = y[first + i] * frequency;
+        scaledZ[i] = z[first + i] * frequency;
+      }
+
+      proc(scaledX, scaledY, scaledZ, noise, batchSize);
+      accumulateOctave<IsRidged>(batchResult, noise, amplitude, batchSize);
+
+      frequency *= fractal.lacunarity;
+      amplitude *= fractal.gain;
+    }
+  }
+}
+
+}
+
+void noise2D(
+  NoiseType type,
+  const float *x, const float *y,
+  float *result, uint32_t count) {
+  currentNoiseKernels()->noise2D[(int)type](x, y, result, count);
+}
+
+void noise3D(
+  NoiseType type,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count) {
+  currentNoiseKernels()->noise3D[(int)type](x, y, z, result, count);
+}
+
+void perlin2D(const float *x, const float *y, float *result, uint32_t count) {
+  noise2D(NoiseType::Perlin, x, y, result, count);
+}
+
+void fbm2D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y,
+  float *result, uint32_t count) {
+  fractal2D<false>(fractal, x, y, result, count);
+}
+
+void fbm3D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count) {
+  fractal3D<false>(fractal, x, y, z, result, count);
+}
+
+void ridged2D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y,
+  float *result, uint32_t count) {
+  fractal2D<true>(fractal, x, y, result, count);
+}
+
+void ridged3D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count) {
+  fractal3D<true>(fractal, x, y, z, result, count);
+}
+
+NoiseISA noiseISA() {
+  currentNoiseKernels();
+  return gNoiseISA.load(std::memory_order_relaxed);
+}
+
+bool setNoiseISA(NoiseISA isa) {
+  const NoiseKernelTable *kernels = noiseKernels(isa);
+
+  if (kernels) {
+    gNoiseISA.store(isa, std::memory_order_relaxed);
+    gNoiseKernels.store(kernels, std::memory_order_release);
+    return true;
+  }
+  else {
+    return false;
+  }
+}
+
+bool isNoiseISASupported(NoiseISA isa) {
+  return noiseKernels(isa) != nullptr;
+}
+
+const char *noiseISAName(NoiseISA isa) {
+  switch (isa) {
+  case NoiseISA::Scalar: return "Scalar";
+  case NoiseISA::SSE2: return "SSE2";
+  case NoiseISA::AVX2: return "AVX2";
+  case NoiseISA::NEON: return "NEON";
+  default: return "Unknown";
+  }
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace Ondine::Graphics {
+
+enum class NoiseType : uint8_t {
+  // Classic perlin - same as glm::perlin
+  Perlin,
+  // Same as glm::simplex
+  Simplex,
+  // Random values at the lattice points, smoothly interpolated
+  Value,
+  Count
+};
+
+// Which kernels run the noise
+enum class NoiseISA : uint8_t {
+  Scalar,
+  SSE2,
+  AVX2,
+  NEON,
+  Count
+};
+
+// Fractal noise goes through the kernels this many samples at a time
+constexpr uint32_t NOISE_BATCH_SIZE = 16;
+
+struct NoiseFractal {
+  NoiseType type;
+  uint32_t octaveCount;
+  float frequency;
+  float amplitude;
+  // Frequency / amplitude get multiplied by these every octave
+  float lacunarity;
+  float gain;
+};
+
+/*
+   All of these evaluate count samples at (x[i], y[i](, z[i])) and write
+   them to result[i]. Whichever kernels run, the results are exactly the
+   same (bit for bit) - they only differ in how many samples they do at
+   once (1, 4 or 8).
+*/
+void noise2D(
+  NoiseType type,
+  const float *x, const float *y,
+  float *result, uint32_t count);
+void noise3D(
+  NoiseType type,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count);
+
+void perlin2D(const float *x, const float *y, float *result, uint32_t count);
+
+// Sum of octaves of noise (not normalised)
+void fbm2D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y,
+  float *result, uint32_t count);
+void fbm3D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count);
+
+// Same as fbm but every octave is (1 - |noise|)^2 - sharp ridges
+void ridged2D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y,
+  float *result, uint32_t count);
+void ridged3D(
+  const NoiseFractal &fractal,
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count);
+
+/*
+   By default, the widest kernels which were compiled in and which the CPU
+   supports get used. Setting the ISA is mostly for benchmarks / comparing
+   kernels - returns false if it isn't supported.
+*/
+NoiseISA noiseISA();
+bool setNoiseISA(NoiseISA isa);
+bool isNoiseISASupported(NoiseISA isa);
+const char *noiseISAName(NoiseISA isa);
+
+}
@@ -0,0 +1,88 @@
+#include "NoiseKernels.hpp"
+
+/*
+   Gets compiled with AVX2 enabled (see CMakeLists.txt) - Noise.cpp only
+   uses these kernels if the CPU supports AVX2.
+*/
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace Ondine::Graphics {
+
+#ifdef __AVX2__
+
+namespace {
+
+struct AVX2Lane {
+  static constexpr uint32_t WIDTH = 8;
+
+  AVX2Lane(float value) : v(_mm256_set1_ps(value)) {}
+  AVX2Lane(__m256 value) : v(value) {}
+
+  static AVX2Lane load(const float *p) { return _mm256_loadu_ps(p); }
+  static void store(float *p, AVX2Lane a) { _mm256_storeu_ps(p, a.v); }
+
+  __m256 v;
+};
+
+struct AVX2Mask {
+  __m256 v;
+};
+
+inline AVX2Lane operator+(AVX2Lane a, AVX2Lane b) {
+  return _mm256_add_ps(a.v, b.v);
+}
+
+inline AVX2Lane operator-(AVX2Lane a, AVX2Lane b) {
+  return _mm256_sub_ps(a.v, b.v);
+}
+
+inline AVX2Lane operator*(AVX2Lane a, AVX2Lane b) {
+  return _mm256_mul_ps(a.v, b.v);
+}
+
+inline AVX2Lane operator/(AVX2Lane a, AVX2Lane b) {
+  return _mm256_div_ps(a.v, b.v);
+}
+
+inline AVX2Lane operator-(AVX2Lane a) {
+  return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f));
+}
+
+inline AVX2Mask operator<(AVX2Lane a, AVX2Lane b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ)};
+}
+
+inline AVX2Mask operator>(AVX2Lane a, AVX2Lane b) {
+  return {_mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ)};
+}
+
+inline AVX2Lane select(AVX2Mask mask, AVX2Lane a, AVX2Lane b) {
+  return _mm256_blendv_ps(b.v, a.v, mask.v);
+}
+
+inline AVX2Lane abs(AVX2Lane a) {
+  return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v);
+}
+
+inline AVX2Lane floor(AVX2Lane a) {
+  return _mm256_floor_ps(a.v);
+}
+
+}
+
+const NoiseKernelTable *avx2NoiseKernels() {
+  static const NoiseKernelTable table = makeNoiseKernelTable<AVX2Lane>();
+  return &table;
+}
+
+#else
+
+const NoiseKernelTable *avx2NoiseKernels() {
+  return nullptr;
+}
+
+#endif
+
+}
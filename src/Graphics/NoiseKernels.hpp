@@ -0,0 +1,464 @@
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+/*
+   Noise kernels written once against a "lane" type V which holds however
+   many floats the instruction set works on at once. Noise.cpp (scalar, SSE2,
+   NEON) and NoiseAVX2.cpp define their own lane types and instantiate the
+   kernels with them. V needs:
+   - V(float) which broadcasts the value to every lane
+   - + - * / and unary -, < and > returning a mask
+   - select(mask, a, b), floor(V), abs(V) - bit exact with the scalar ones
+   - V::WIDTH, V::load(const float *), V::store(float *, V)
+
+   The operations are the ones glm does (in the same order) so every lane
+   type gives the same results as glm::perlin / glm::simplex, bit for bit.
+   Everything is in an anonymous namespace: the AVX2 file is compiled with
+   different flags and none of this can end up shared between the two.
+*/
+
+// Results can't depend on whether the compiler fuses multiply-adds
+#if defined(__clang__)
+#pragma clang fp contract(off)
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#elif defined(_MSC_VER)
+#pragma fp_contract(off)
+#endif
+
+namespace Ondine::Graphics {
+
+using NoiseProc2D = void (*)(
+  const float *x, const float *y, float *result, uint32_t count);
+using NoiseProc3D = void (*)(
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count);
+
+struct NoiseKernelTable {
+  // Indexed by NoiseType
+  NoiseProc2D noise2D[3];
+  NoiseProc3D noise3D[3];
+};
+
+// Null if the AVX2 kernels weren't compiled in (NoiseAVX2.cpp)
+const NoiseKernelTable *avx2NoiseKernels();
+
+namespace {
+
+// glm's constants get converted from double
+constexpr float NOISE_INV_SQRT_A = (float)1.79284291400159;
+constexpr float NOISE_INV_SQRT_B = (float)0.85373472095314;
+
+template <typename V>
+inline V fract(V x) {
+  return x - floor(x);
+}
+
+// glm::mod(x, 289)
+template <typename V>
+inline V mod289Div(V x) {
+  return x - V(289.0f) * floor(x / V(289.0f));
+}
+
+// glm::detail::mod289 (multiplies by the reciprocal)
+template <typename V>
+inline V mod289(V x) {
+  return x - floor(x * V(1.0f / 289.0f)) * V(289.0f);
+}
+
+template <typename V>
+inline V permute(V x) {
+  return mod289(((x * V(34.0f)) + V(1.0f)) * x);
+}
+
+template <typename V>
+inline V taylorInvSqrt(V r) {
+  return V(NOISE_INV_SQRT_A) - V(NOISE_INV_SQRT_B) * r;
+}
+
+template <typename V>
+inline V fade(V t) {
+  return (t * t * t) * (t * (t * V(6.0f) - V(15.0f)) + V(10.0f));
+}
+
+template <typename V>
+inline V mix(V a, V b, V t) {
+  return a + t * (b - a);
+}
+
+// 0 if x < edge, 1 otherwise
+template <typename V>
+inline V step(V edge, V x) {
+  return select(x < edge, V(0.0f), V(1.0f));
+}
+
+template <typename V>
+inline V minLane(V a, V b) {
+  return select(b < a, b, a);
+}
+
+template <typename V>
+inline V maxLane(V a, V b) {
+  return select(a < b, b, a);
+}
+
+/* Classic perlin noise - glm::perlin(vec2) */
+template <typename V>
+inline V perlinGradient2D(V ix, V iy, V fx, V fy) {
+  V i = permute(permute(ix) + iy);
+
+  V gx = V(2.0f) * fract(i / V(41.0f)) - V(1.0f);
+  V gy = abs(gx) - V(0.5f);
+  V tx = floor(gx + V(0.5f));
+  gx = gx - tx;
+
+  V norm = taylorInvSqrt(gx * gx + gy * gy);
+  gx = gx * norm;
+  gy = gy * norm;
+
+  return gx * fx + gy * fy;
+}
+
+template <typename V>
+inline V perlin2D(V x, V y) {
+  V floorX = floor(x), floorY = floor(y);
+
+  V pix0 = mod289Div(floorX + V(0.0f));
+  V piy0 = mod289Div(floorY + V(0.0f));
+  V pix1 = mod289Div(floorX + V(1.0f));
+  V piy1 = mod289Div(floorY + V(1.0f));
+
+  V pfx0 = fract(x) - V(0.0f);
+  V pfy0 = fract(y) - V(0.0f);
+  V pfx1 = fract(x) - V(1.0f);
+  V pfy1 = fract(y) - V(1.0f);
+
+  V n00 = perlinGradient2D(pix0, piy0, pfx0, pfy0);
+  V n10 = perlinGradient2D(pix1, piy0, pfx1, pfy0);
+  V n01 = perlinGradient2D(pix0, piy1, pfx0, pfy1);
+  V n11 = perlinGradient2D(pix1, piy1, pfx1, pfy1);
+
+  V fadeX = fade(pfx0);
+  V fadeY = fade(pfy0);
+
+  V nx0 = mix(n00, n10, fadeX);
+  V nx1 = mix(n01, n11, fadeX);
+
+  return V(2.3f) * mix(nx0, nx1, fadeY);
+}
+
+/* Classic perlin noise - glm::perlin(vec3) */
+template <typename V>
+inline V perlinGradient3D(V ixyz, V fx, V fy, V fz) {
+  V gx = ixyz * V((float)(1.0 / 7.0));
+  V gy = fract(floor(gx) * V((float)(1.0 / 7.0))) - V(0.5f);
+  gx = fract(gx);
+  V gz = V(0.5f) - abs(gx) - abs(gy);
+  V sz = step(gz, V(0.0f));
+  gx = gx - sz * (step(V(0.0f), gx) - V(0.5f));
+  gy = gy - sz * (step(V(0.0f), gy) - V(0.5f));
+
+  V norm = taylorInvSqrt(gx * gx + gy * gy + gz * gz);
+  gx = gx * norm;
+  gy = gy * norm;
+  gz = gz * norm;
+
+  return gx * fx + gy * fy + gz * fz;
+}
+
+template <typename V>
+inline V perlin3D(V x, V y, V z) {
+  V pix0 = floor(x), piy0 = floor(y), piz0 = floor(z);
+  V pix1 = pix0 + V(1.0f), piy1 = piy0 + V(1.0f), piz1 = piz0 + V(1.0f);
+  pix0 = mod289(pix0);
+  piy0 = mod289(piy0);
+  piz0 = mod289(piz0);
+  pix1 = mod289(pix1);
+  piy1 = mod289(piy1);
+  piz1 = mod289(piz1);
+
+  V pfx0 = fract(x), pfy0 = fract(y), pfz0 = fract(z);
+  V pfx1 = pfx0 - V(1.0f), pfy1 = pfy0 - V(1.0f), pfz1 = pfz0 - V(1.0f);
+
+  V permX0 = permute(pix0), permX1 = permute(pix1);
+  V ixy00 = permute(permX0 + piy0);
+  V ixy10 = permute(permX1 + piy0);
+  V ixy01 = permute(permX0 + piy1);
+  V ixy11 = permute(permX1 + piy1);
+
+  V n000 = perlinGradient3D(permute(ixy00 + piz0), pfx0, pfy0, pfz0);
+  V n100 = perlinGradient3D(permute(ixy10 + piz0), pfx1, pfy0, pfz0);
+  V n010 = perlinGradient3D(permute(ixy01 + piz0), pfx0, pfy1, pfz0);
+  V n110 = perlinGradient3D(permute(ixy11 + piz0), pfx1, pfy1, pfz0);
+  V n001 = perlinGradient3D(permute(ixy00 + piz1), pfx0, pfy0, pfz1);
+  V n101 = perlinGradient3D(permute(ixy10 + piz1), pfx1, pfy0, pfz1);
+  V n011 = perlinGradient3D(permute(ixy01 + piz1), pfx0, pfy1, pfz1);
+  V n111 = perlinGradient3D(permute(ixy11 + piz1), pfx1, pfy1, pfz1);
+
+  V fadeX = fade(pfx0), fadeY = fade(pfy0), fadeZ = fade(pfz0);
+
+  V nz00 = mix(n000, n001, fadeZ);
+  V nz10 = mix(n100, n101, fadeZ);
+  V nz01 = mix(n010, n011, fadeZ);
+  V nz11 = mix(n110, n111, fadeZ);
+
+  V nyz0 = mix(nz00, nz01, fadeY);
+  V nyz1 = mix(nz10, nz11, fadeY);
+
+  return V(2.2f) * mix(nyz0, nyz1, fadeX);
+}
+
+/* Simplex noise - glm::simplex(vec2) */
+template <typename V>
+inline V simplexCorner2D(V p, V cx, V cy) {
+  V m = maxLane(V(0.5f) - (cx * cx + cy * cy), V(0.0f));
+  m = m * m;
+  m = m * m;
+
+  // 41 gradients over a line, mapped onto a diamond
+  V x = V(2.0f) * fract(p * V((float)0.024390243902439)) - V(1.0f);
+  V h = abs(x) - V(0.5f);
+  V a0 = x - floor(x + V(0.5f));
+
+  m = m * (V(NOISE_INV_SQRT_A) - V(NOISE_INV_SQRT_B) * (a0 * a0 + h * h));
+
+  return m * (a0 * cx + h * cy);
+}
+
+template <typename V>
+inline V simplex2D(V x, V y) {
+  const float c0 = (float)0.211324865405187;
+  const float c1 = (float)0.366025403784439;
+  const float c2 = (float)-0.577350269189626;
+
+  // First corner
+  V skew = x * V(c1) + y * V(c1);
+  V ix = floor(x + skew), iy = floor(y + skew);
+  V unskew = ix * V(c0) + iy * V(c0);
+  V x0 = x - ix + unskew, y0 = y - iy + unskew;
+
+  // Other corners
+  auto isLower = y0 < x0;
+  V i1x = select(isLower, V(1.0f), V(0.0f));
+  V i1y = select(isLower, V(0.0f), V(1.0f));
+
+  V x1 = x0 + V(c0) - i1x, y1 = y0 + V(c0) - i1y;
+  V x2 = x0 + V(c2), y2 = y0 + V(c2);
+
+  // Permutations
+  ix = mod289Div(ix);
+  iy = mod289Div(iy);
+
+  V p0 = permute(permute(iy + V(0.0f)) + ix + V(0.0f));
+  V p1 = permute(permute(iy + i1y) + ix + i1x);
+  V p2 = permute(permute(iy + V(1.0f)) + ix + V(1.0f));
+
+  V n0 = simplexCorner2D(p0, x0, y0);
+  V n1 = simplexCorner2D(p1, x1, y1);
+  V n2 = simplexCorner2D(p2, x2, y2);
+
+  return V(130.0f) * (n0 + n1 + n2);
+}
+
+/* Simplex noise - glm::simplex(vec3) */
+template <typename V>
+inline V simplexCorner3D(V p, V cx, V cy, V cz) {
+  // 7x7 gradients over a square, mapped onto an octahedron
+  const float n = (float)0.142857142857;
+  const float nsx = n * 2.0f - 0.0f;
+  const float nsy = n * 0.5f - 1.0f;
+  const float nsz = n * 1.0f - 0.0f;
+
+  V j = p - V(49.0f) * floor(p * V(nsz) * V(nsz));
+  V x_ = floor(j * V(nsz));
+  V y_ = floor(j - V(7.0f) * x_);
+
+  V x = x_ * V(nsx) + V(nsy);
+  V y = y_ * V(nsx) + V(nsy);
+  V h = V(1.0f) - abs(x) - abs(y);
+
+  V sx = floor(x) * V(2.0f) + V(1.0f);
+  V sy = floor(y) * V(2.0f) + V(1.0f);
+  V sh = -step(h, V(0.0f));
+
+  V gx = x + sx * sh;
+  V gy = y + sy * sh;
+  V gz = h;
+
+  V norm = taylorInvSqrt(gx * gx + gy * gy + gz * gz);
+  gx = gx * norm;
+  gy = gy * norm;
+  gz = gz * norm;
+
+  V m = maxLane(V(0.6f) - (cx * cx + cy * cy + cz * cz), V(0.0f));
+  m = m * m;
+
+  return (m * m) * (gx * cx + gy * cy + gz * cz);
+}
+
+template <typename V>
+inline V simplex3D(V x, V y, V z) {
+  const float cx = (float)(1.0 / 6.0);
+  const float cy = (float)(1.0 / 3.0);
+
+  // First corner
+  V skew = x * V(cy) + y * V(cy) + z * V(cy);
+  V ix = floor(x + skew), iy = floor(y + skew), iz = floor(z + skew);
+  V unskew = ix * V(cx) + iy * V(cx) + iz * V(cx);
+  V x0 = x - ix + unskew, y0 = y - iy + unskew, z0 = z - iz + unskew;
+
+  // Other corners
+  V gx = step(y0, x0), gy = step(z0, y0), gz = step(x0, z0);
+  V lx = V(1.0f) - gx, ly = V(1.0f) - gy, lz = V(1.0f) - gz;
+
+  V i1x = minLane(gx, lz), i1y = minLane(gy, lx), i1z = minLane(gz, ly);
+  V i2x = maxLane(gx, lz), i2y = maxLane(gy, lx), i2z = maxLane(gz, ly);
+
+  V x1 = x0 - i1x + V(cx), y1 = y0 - i1y + V(cx), z1 = z0 - i1z + V(cx);
+  V x2 = x0 - i2x + V(cy), y2 = y0 - i2y + V(cy), z2 = z0 - i2z + V(cy);
+  V x3 = x0 - V(0.5f), y3 = y0 - V(0.5f), z3 = z0 - V(0.5f);
+
+  // Permutations
+  ix = mod289(ix);
+  iy = mod289(iy);
+  iz = mod289(iz);
+
+  V p0 = permute(permute(permute(
+    iz + V(0.0f)) + iy + V(0.0f)) + ix + V(0.0f));
+  V p1 = permute(permute(permute(iz + i1z) + iy + i1y) + ix + i1x);
+  V p2 = permute(permute(permute(iz + i2z) + iy + i2y) + ix + i2x);
+  V p3 = permute(permute(permute(
+    iz + V(1.0f)) + iy + V(1.0f)) + ix + V(1.0f));
+
+  V n0 = simplexCorner3D(p0, x0, y0, z0);
+  V n1 = simplexCorner3D(p1, x1, y1, z1);
+  V n2 = simplexCorner3D(p2, x2, y2, z2);
+  V n3 = simplexCorner3D(p3, x3, y3, z3);
+
+  return V(42.0f) * ((n0 + n1) + (n2 + n3));
+}
+
+/*
+   Value noise - a random value in [-1, 1] at every lattice point, hashed
+   with the same permutation polynomial as the rest.
+*/
+template <typename V>
+inline V latticeValue(V hash) {
+  return hash * V(2.0f / 288.0f) - V(1.0f);
+}
+
+template <typename V>
+inline V value2D(V x, V y) {
+  V ix0 = mod289Div(floor(x)), iy0 = mod289Div(floor(y));
+  V ix1 = mod289Div(ix0 + V(1.0f)), iy1 = mod289Div(iy0 + V(1.0f));
+  V fx = fract(x), fy = fract(y);
+
+  V permX0 = permute(ix0), permX1 = permute(ix1);
+  V v00 = latticeValue(permute(permX0 + iy0));
+  V v10 = latticeValue(permute(permX1 + iy0));
+  V v01 = latticeValue(permute(permX0 + iy1));
+  V v11 = latticeValue(permute(permX1 + iy1));
+
+  V fadeX = fade(fx), fadeY = fade(fy);
+
+  return mix(mix(v00, v10, fadeX), mix(v01, v11, fadeX), fadeY);
+}
+
+template <typename V>
+inline V value3D(V x, V y, V z) {
+  V ix0 = mod289Div(floor(x)), iy0 = mod289Div(floor(y));
+  V iz0 = mod289Div(floor(z));
+  V ix1 = mod289Div(ix0 + V(1.0f)), iy1 = mod289Div(iy0 + V(1.0f));
+  V iz1 = mod289Div(iz0 + V(1.0f));
+  V fx = fract(x), fy = fract(y), fz = fract(z);
+
+  V permX0 = permute(ix0), permX1 = permute(ix1);
+  V ixy00 = permute(permX0 + iy0);
+  V ixy10 = permute(permX1 + iy0);
+  V ixy01 = permute(permX0 + iy1);
+  V ixy11 = permute(permX1 + iy1);
+
+  V fadeX = fade(fx), fadeY = fade(fy), fadeZ = fade(fz);
+
+  V v0 = mix(
+    mix(latticeValue(permute(ixy00 + iz0)),
+        latticeValue(permute(ixy10 + iz0)), fadeX),
+    mix(latticeValue(permute(ixy01 + iz0)),
+        latticeValue(permute(ixy11 + iz0)), fadeX),
+    fadeY);
+
+  V v1 = mix(
+    mix(latticeValue(permute(ixy00 + iz1)),
+        latticeValue(permute(ixy10 + iz1)), fadeX),
+    mix(latticeValue(permute(ixy01 + iz1)),
+        latticeValue(permute(ixy11 + iz1)), fadeX),
+    fadeY);
+
+  return mix(v0, v1, fadeZ);
+}
+
+/*
+   Runs a kernel over whole arrays, V::WIDTH samples at a time. The last few
+   samples go through a zero padded batch so they run the same code.
+*/
+template <typename V, V (*Kernel)(V, V)>
+void runNoise2D(const float *x, const float *y, float *result, uint32_t count) {
+  uint32_t i = 0;
+  for (; i + V::WIDTH <= count; i += V::WIDTH) {
+    V::store(result + i, Kernel(V::load(x + i), V::load(y + i)));
+  }
+
+  if (i < count) {
+    float tailX[V::WIDTH] = {}, tailY[V::WIDTH] = {}, tail[V::WIDTH];
+    memcpy(tailX, x + i, (count - i) * sizeof(float));
+    memcpy(tailY, y + i, (count - i) * sizeof(float));
+
+    V::store(tail, Kernel(V::load(tailX), V::load(tailY)));
+    memcpy(result + i, tail, (count - i) * sizeof(float));
+  }
+}
+
+template <typename V, V (*Kernel)(V, V, V)>
+void runNoise3D(
+  const float *x, const float *y, const float *z,
+  float *result, uint32_t count) {
+  uint32_t i = 0;
+  for (; i + V::WIDTH <= count; i += V::WIDTH) {
+    V::store(
+      result + i,
+      Kernel(V::load(x + i), V::load(y + i), V::load(z + i)));
+  }
+
+  if (i < count) {
+    float tailX[V::WIDTH] = {}, tailY[V::WIDTH] = {}, tailZ[V::WIDTH] = {};
+    float tail[V::WIDTH];
+    memcpy(tailX, x + i, (count - i) * sizeof(float));
+    memcpy(tailY, y + i, (count - i) * sizeof(float));
+    memcpy(tailZ, z + i, (count - i) * sizeof(float));
+
+    V::store(tail, Kernel(V::load(tailX), V::load(tailY), V::load(tailZ)));
+    memcpy(result + i, tail, (count - i) * sizeof(float));
+  }
+}
+
+template <typename V>
+NoiseKernelTable makeNoiseKernelTable() {
+  return {
+    {
+      runNoise2D<V, perlin2D<V>>,
+      runNoise2D<V, simplex2D<V>>,
+      runNoise2D<V, value2D<V>>
+    },
+    {
+      runNoise3D<V, perlin3D<V>>,
+      runNoise3D<V, simplex3D<V>>,
+      runNoise3D<V, value3D<V>>
+    }
+  };
+}
+
+}
+
+}
@@ -10,6 +10,7 @@ void Pixelater::init(
   VulkanContext &graphicsContext,
   const VkExtent2D &initialExtent) {
   pixelationStrength = 3.0f;
+  mIsPlaced = false;
 
   { // Set tracked resources
     addTrackedPath(PIXELATER_FRAG_SPV, &mPipeline);
@@ -34,31 +35,19 @@ void Pixelater::init(
   { // Create pipeline
     mPipeline.init(
       [] (VulkanPipeline &res, Pixelater &owner, VulkanContext &graphicsContext) {
-        Core::File vshFile = Core::gFileSystem->createFile(
-          (Core::MountPoint)Core::ApplicationMountPoints::Application,
-          "res/spv/TexturedQuad.vert.spv",
-          Core::FileOpenType::Binary | Core::FileOpenType::In);
-        Buffer vsh = vshFile.readBinary();
-
-        Core::File fshFile = Core::gFileSystem->createFile(
-          (Core::MountPoint)Core::ApplicationMountPoints::Application,
-          "res/spv/Pixelater.frag.spv",
-          Core::FileOpenType::Binary | Core::FileOpenType::In);
-        Buffer fsh = fshFile.readBinary();
-
         VulkanPipelineConfig pipelineConfig(
           {owner.mRenderPass, 0},
           VulkanShader(
-            graphicsContext.device(), vsh, VulkanShaderType::Vertex),
+            graphicsContext.device(), "res/spv/TexturedQuad.vert.spv"),
           VulkanShader(
-            graphicsContext.device(), fsh, VulkanShaderType::Fragment));
+            graphicsContext.device(), "res/spv/Pixelater.frag.spv"));
 
         pipelineConfig.configurePipelineLayout(
           sizeof(Pixelater::PushConstant),
           VulkanPipelineDescriptorLayout{
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
 
-        res.init(
+        res.initDeferred(
           graphicsContext.device(),
           graphicsContext.descriptorLayouts(),
           pipelineConfig);
@@ -107,6 +96,21 @@ void Pixelater::render(VulkanFrame &frame, const RenderStage &prev) {
 void Pixelater::resize(VulkanContext &vulkanContext, Resolution newResolution) {
   destroyTargets(vulkanContext);
   mExtent = {newResolution.width, newResolution.height};
+  // Placement was made for the old size
+  mIsPlaced = false;
+  initTargets(vulkanContext);
+}
+
+void Pixelater::placeTarget(
+  VulkanContext &vulkanContext,
+  const VulkanTexturePlacement *placement) {
+  destroyTargets(vulkanContext);
+
+  mIsPlaced = placement != nullptr;
+  if (mIsPlaced) {
+    mPlacement = *placement;
+  }
+
   initTargets(vulkanContext);
 }
 
@@ -130,7 +134,8 @@ void Pixelater::initTargets(VulkanContext &graphicsContext) {
   mTexture.init(
     graphicsContext.device(), TextureType::T2D | TextureType::Attachment,
     TextureContents::Color, VK_FORMAT_R16G16B16A16_SFLOAT, VK_FILTER_NEAREST,
-    {mExtent.width, mExtent.height, 1}, 1, 1);
+    {mExtent.width, mExtent.height, 1}, 1, 1,
+    mIsPlaced ? &mPlacement : nullptr);
 
   mOutput.init(
     graphicsContext.device(),
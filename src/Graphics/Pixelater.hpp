@@ -25,7 +25,11 @@ public:
   void init(VulkanContext &graphicsContext, const VkExtent2D &initialExtent);
 
   void render(VulkanFrame &frame, const RenderStage &prev);
+  // Resizing puts the target back in its own memory
   void resize(VulkanContext &vulkanContext, Resolution newResolution);
+  void placeTarget(
+    VulkanContext &vulkanContext,
+    const VulkanTexturePlacement *placement);
 
   // 1.0f = no pixelation - increase to increase pixelation effect
   void setPixelationStrength(float strength);
@@ -63,10 +67,13 @@ private:
   VulkanRenderPass mRenderPass;
   VulkanFramebuffer mFBO;
   VulkanTexture mTexture;
+  VulkanTexturePlacement mPlacement;
+  bool mIsPlaced;
   VkExtent2D mExtent;
 
   // Will only be relevant in DEV builds
   friend class View::EditorView;
+  friend class Renderer3D;
 };
 
 }
@@ -14,19 +14,17 @@ void PlanetRenderer::init(
   const RenderStage &renderStage,
   const PlanetProperties *properties) {
   { // Create pipeline
-    Core::File precomputeDummyVsh = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeDummyVsh = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/Planet.vert.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+      "res/spv/Planet.vert.spv");
 
-    Buffer precomputeVsh = precomputeDummyVsh.readBinary();
+    Buffer precomputeVsh = precomputeDummyVsh.view();
 
-    Core::File precomputeDummy = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeDummy = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/Planet.frag.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+      "res/spv/Planet.frag.spv");
 
-    Buffer fsh = precomputeDummy.readBinary();
+    Buffer fsh = precomputeDummy.view();
 
     VulkanPipelineConfig pipelineConfig(
       {renderStage.renderPass(), 0},
@@ -45,7 +43,7 @@ void PlanetRenderer::init(
 
     pipelineConfig.enableDepthTesting();
 
-    mPipeline.init(
+    mPipeline.initDeferred(
       graphicsContext.device(),
       graphicsContext.descriptorLayouts(),
       pipelineConfig);
@@ -55,7 +53,7 @@ void PlanetRenderer::init(
     mPlanetPropertiesBuffer.init(
       graphicsContext.device(),
       sizeof(PlanetProperties),
-      (int)VulkanBufferFlag::UniformBuffer);
+      VulkanBufferFlag::UniformBuffer | VulkanBufferFlag::UploadTarget);
 
     mPlanetPropertiesUniform.init(
       graphicsContext.device(),
@@ -66,7 +64,6 @@ void PlanetRenderer::init(
     if (properties) {
       mPlanetPropertiesBuffer.fillWithStaging(
         graphicsContext.device(),
-        graphicsContext.commandPool(),
         {(uint8_t *)properties, sizeof(PlanetProperties)});
     }
   }
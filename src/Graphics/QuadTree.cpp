@@ -24,10 +24,17 @@ void QuadTree::init(uint16_t maxLOD) {
   mDeepestNodes.init(mArea);
   mDeepestNodes.size = 0;
 
-  mDiffDelete.init(maxLOD * maxLOD);
-  mDiffAdd.init(maxLOD * maxLOD);
+  // Splits can happen around the predicted focal point too
+  mDiffDelete.init(2 * maxLOD * maxLOD);
+  mDiffAdd.init(2 * maxLOD * maxLOD);
 
   mDivisionCutoff = 1.0f;
+  mMergeHysteresis = 1.25f;
+  mLookahead = 2.0f;
+  mFocalPoint = glm::vec2(0.0f);
+  mFocalVelocity = glm::vec2(0.0f);
+  mPredictedFocalPoint = glm::vec2(0.0f);
+  mLODStats = {};
 }
 
 void QuadTree::setInitialState(uint16_t minLevel) {
@@ -43,8 +50,51 @@ void QuadTree::setFocalPoint(const glm::vec2 &position) {
   clearDiff();
   mDeepestNodes.size = 0;
 
+  glm::vec2 displacement = position - mFocalPoint;
+  // Only extrapolate when the focal point keeps going the same way
+  bool isConsistent = glm::dot(displacement, mFocalVelocity) > 0.0f;
+
+  if (!mLODStats.focalPointUpdateCount ||
+      glm::length(displacement) > (float)mDimensions / 4.0f) {
+    // First update or teleport - there's nothing to predict from
+    mFocalVelocity = glm::vec2(0.0f);
+  }
+  else if (glm::dot(displacement, mFocalVelocity) < 0.0f) {
+    // Going back and forth - predicting would just add churn
+    mFocalVelocity = glm::vec2(0.0f);
+  }
+  else {
+    mFocalVelocity = glm::mix(mFocalVelocity, displacement, 0.5f);
+  }
+
+  mFocalPoint = position;
+  mPredictedFocalPoint = position;
+
+  if (isConsistent) {
+    mPredictedFocalPoint += mFocalVelocity * mLookahead;
+  }
+
+  mLODStats.splitCount = 0;
+  mLODStats.mergeCount = 0;
+  ++mLODStats.focalPointUpdateCount;
+
   // Create the new nodes and push the modifications to the diff list
   populateDiff(mRoot, glm::vec2(0.0f), position);
+
+  mLODStats.totalSplitCount += mLODStats.splitCount;
+  mLODStats.totalMergeCount += mLODStats.mergeCount;
+}
+
+void QuadTree::setLODHysteresis(float hysteresis) {
+  mMergeHysteresis = glm::max(hysteresis, 1.0f);
+}
+
+void QuadTree::setLODLookahead(float updateCount) {
+  mLookahead = glm::max(updateCount, 0.0f);
+}
+
+const QuadTree::LODStats &QuadTree::lodStats() const {
+  return mLODStats;
 }
 
 void QuadTree::clearDiff() {
@@ -152,8 +202,7 @@ void QuadTree::populate(
 
     float half = scale * mDivisionCutoff;
     float maxDist2 = half * half * 2.0f;
-    glm::vec2 diff = position - center;
-    float dist2 = glm::dot(diff, diff);
+    float dist2 = getFocalDistance2(center, position);
 
     if (dist2 <= maxDist2) {
       // Split the node
@@ -183,12 +232,16 @@ void QuadTree::populateDiff(
 
     float half = scale * mDivisionCutoff;
     float maxDist2 = half * half * 2.0f;
-    glm::vec2 diff = position - center;
-    float dist2 = glm::dot(diff, diff);
+    float dist2 = getFocalDistance2(center, position);
 
-    if (dist2 <= maxDist2) {
+    // Nodes which are already split stay split within the hysteresis band
+    float mergeHalf = half * mMergeHysteresis;
+    float mergeDist2 = mergeHalf * mergeHalf * 2.0f;
+    bool isSplit = node->children[0];
+
+    if (dist2 <= maxDist2 || (isSplit && dist2 <= mergeDist2)) {
       // Does this node have children?
-      if (node->children[0]) {
+      if (isSplit) {
         // Don't add this to the list of diff
         for (int i = 0; i < 4; ++i) {
           glm::vec2 childOffset = offset + Node::INDEX_TO_OFFSET[i] * scale / 2.0f;
@@ -200,6 +253,7 @@ void QuadTree::populateDiff(
         mDiffAdd.push({DiffOpType::Add, node});
         mDiffDelete.push({DiffOpType::Delete, node});
         node->wasDiffed = 1;
+        ++mLODStats.splitCount;
 
         // Split the node
         for (int i = 0; i < 4; ++i) {
@@ -210,10 +264,11 @@ void QuadTree::populateDiff(
       }
     }
     else {
-      if (node->children[0]) {
+      if (isSplit) {
         mDiffDelete.push({DiffOpType::Delete, node});
         mDiffAdd.push({DiffOpType::Add, node});
         node->wasDiffed = 1;
+        ++mLODStats.mergeCount;
 
         for (int i = 0; i < 4; ++i) {
           freeNode(node->children[i]);
@@ -229,6 +284,15 @@ void QuadTree::populateDiff(
   }
 }
 
+float QuadTree::getFocalDistance2(
+  const glm::vec2 &center, const glm::vec2 &position) const {
+  glm::vec2 diff = position - center;
+  glm::vec2 predictedDiff = mPredictedFocalPoint - center;
+
+  return glm::min(
+    glm::dot(diff, diff), glm::dot(predictedDiff, predictedDiff));
+}
+
 QuadTree::Node *QuadTree::getDeepestNode(
   const glm::vec2 &position,
   glm::vec2 *offsetOut) const {
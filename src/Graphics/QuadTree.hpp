@@ -23,6 +23,32 @@ public:
   // This position needs to be in quadtree space
   void setFocalPoint(const glm::vec2 &position);
 
+  /*
+     Nodes split when the focal point gets within cutoff * their size but
+     only merge back once it's further than cutoff * hysteresis * their size
+     so that moving back and forth around a boundary doesn't re-mesh.
+  */
+  void setLODHysteresis(float hysteresis);
+  /*
+     Nodes also split around where the focal point is predicted to be in
+     this many focal point updates, so that the finer LODs are meshed by the
+     time the camera gets there. 0 disables the prediction.
+  */
+  void setLODLookahead(float updateCount);
+
+  // Split / merge churn
+  struct LODStats {
+    // Of the last setFocalPoint
+    uint32_t splitCount;
+    uint32_t mergeCount;
+    // Since init
+    uint32_t totalSplitCount;
+    uint32_t totalMergeCount;
+    uint32_t focalPointUpdateCount;
+  };
+
+  const LODStats &lodStats() const;
+
   struct NodeInfo {
     bool exists;
     bool wasDiffed;
@@ -87,6 +113,10 @@ private:
   void populateDiff(
     Node *node, const glm::vec2 &offset, const glm::vec2 &position);
 
+  // Squared distance from the closest of the focal point and its prediction
+  float getFocalDistance2(
+    const glm::vec2 &center, const glm::vec2 &position) const;
+
 private:
   Node *mRoot;
   uint32_t mArea;
@@ -98,8 +128,17 @@ private:
 
   // Factor of the side of the node
   float mDivisionCutoff;
+  // Factor of mDivisionCutoff after which nodes merge (>= 1)
+  float mMergeHysteresis;
+  float mLookahead;
+
+  // Last position given to setFocalPoint (quadtree space)
+  glm::vec2 mFocalPoint;
+  // Smoothed displacement of the focal point per update
+  glm::vec2 mFocalVelocity;
+  glm::vec2 mPredictedFocalPoint;
 
-  glm::ivec2 mFocalPoint;
+  LODStats mLODStats;
 
   // Diff
   Stack<DiffOp> mDiffDelete;
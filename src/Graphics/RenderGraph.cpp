@@ -0,0 +1,609 @@
+#include <assert.h>
+#include "Utils.hpp"
+#include "RenderGraph.hpp"
+
+namespace Ondine::Graphics {
+
+struct AccessInfo {
+  VkPipelineStageFlags stages;
+  VkAccessFlags access;
+  // Stages by which the writes are done and the access flags they use
+  VkPipelineStageFlags writeStages;
+  VkAccessFlags writeAccess;
+};
+
+static AccessInfo getAccessInfo(RenderGraphAccess type) {
+  switch (type) {
+  case RenderGraphAccess::ColorAttachment: return {
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_READ_BIT |
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+    };
+
+  case RenderGraphAccess::DepthAttachment: return {
+      VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT |
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+      VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT
+    };
+
+  default: return {
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      VK_ACCESS_SHADER_READ_BIT,
+      0, 0
+    };
+  }
+}
+
+static bool covers(
+  const RenderGraphSync &sync,
+  VkPipelineStageFlags srcStages, VkAccessFlags srcAccess,
+  VkPipelineStageFlags dstStages, VkAccessFlags dstAccess) {
+  return
+    (sync.srcStages & srcStages) == srcStages &&
+    (sync.srcAccess & srcAccess) == srcAccess &&
+    (sync.dstStages & dstStages) == dstStages &&
+    (sync.dstAccess & dstAccess) == dstAccess;
+}
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+RenderGraph::RenderGraph() {
+  reset();
+}
+
+void RenderGraph::reset() {
+  mPassCount = 0;
+  mResourceCount = 0;
+  mTransitionCount = 0;
+  mMemoryRequirements = {};
+  mStats = {};
+}
+
+RenderGraphResource RenderGraph::importResource(const char *name) {
+  assert(mResourceCount < MAX_RESOURCE_COUNT);
+
+  Resource &resource = mResources[mResourceCount];
+  resource = {};
+  resource.name = name;
+  resource.resolved = mResourceCount;
+
+  return mResourceCount++;
+}
+
+RenderGraphResource RenderGraph::addTransientResource(
+  const char *name, const VkMemoryRequirements &requirements) {
+  RenderGraphResource index = importResource(name);
+
+  mResources[index].requirements = requirements;
+  mResources[index].isTransient = true;
+
+  return index;
+}
+
+void RenderGraph::markOutput(RenderGraphResource resource) {
+  mResources[resource].isOutput = true;
+}
+
+RenderGraphPass RenderGraph::addPass(
+  const char *name,
+  const RenderGraphSync &entry,
+  const RenderGraphSync &exit) {
+  assert(mPassCount < MAX_PASS_COUNT);
+
+  Pass &pass = mPasses[mPassCount];
+  pass = {};
+  pass.name = name;
+  pass.entry = entry;
+  pass.exit = exit;
+  pass.forwardInput = INVALID_RESOURCE;
+  pass.forwardOutput = INVALID_RESOURCE;
+  pass.isEnabled = true;
+
+  return mPassCount++;
+}
+
+void RenderGraph::read(RenderGraphPass pass, RenderGraphResource resource) {
+  Pass &p = mPasses[pass];
+  assert(p.accessCount < MAX_ACCESS_COUNT);
+
+  p.accesses[p.accessCount++] = {
+    resource, RenderGraphAccess::Sampled,
+    VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_UNDEFINED
+  };
+}
+
+void RenderGraph::write(
+  RenderGraphPass pass, RenderGraphResource resource,
+  RenderGraphAccess access, VkImageLayout finalLayout,
+  VkImageLayout initialLayout) {
+  Pass &p = mPasses[pass];
+  assert(p.accessCount < MAX_ACCESS_COUNT);
+  assert(access != RenderGraphAccess::Sampled);
+
+  p.accesses[p.accessCount++] = {resource, access, initialLayout, finalLayout};
+}
+
+void RenderGraph::forward(
+  RenderGraphPass pass,
+  RenderGraphResource input, RenderGraphResource output) {
+  mPasses[pass].forwardInput = input;
+  mPasses[pass].forwardOutput = output;
+}
+
+void RenderGraph::setEnabled(RenderGraphPass pass, bool enabled) {
+  mPasses[pass].isEnabled = enabled;
+}
+
+void RenderGraph::compile() {
+  mStats = {};
+
+  resolveForwards();
+  cullPasses();
+  placeResources();
+  computeBarriers();
+}
+
+bool RenderGraph::isEnabled(RenderGraphPass pass) const {
+  return mPasses[pass].isEnabled;
+}
+
+bool RenderGraph::isCulled(RenderGraphPass pass) const {
+  return mPasses[pass].isCulled;
+}
+
+RenderGraphResource RenderGraph::resolve(RenderGraphResource resource) const {
+  return mResources[resource].resolved;
+}
+
+const RenderGraphBarrier &RenderGraph::barrier(RenderGraphPass pass) const {
+  return mBarriers[pass];
+}
+
+const RenderGraphTransition &RenderGraph::transition(uint32_t index) const {
+  return mTransitions[index];
+}
+
+bool RenderGraph::isPlaced(RenderGraphResource resource) const {
+  return mResources[resource].isPlaced;
+}
+
+VkDeviceSize RenderGraph::memoryOffset(RenderGraphResource resource) const {
+  return mResources[resource].offset;
+}
+
+const VkMemoryRequirements &RenderGraph::memoryRequirements() const {
+  return mMemoryRequirements;
+}
+
+const RenderGraphStats &RenderGraph::stats() const {
+  return mStats;
+}
+
+const char *RenderGraph::passName(RenderGraphPass pass) const {
+  return mPasses[pass].name;
+}
+
+uint32_t RenderGraph::passCount() const {
+  return mPassCount;
+}
+
+void RenderGraph::resolveForwards() {
+  for (int i = 0; i < mResourceCount; ++i) {
+    mResources[i].resolved = i;
+  }
+
+  // Passes only read what came before them so one walk is enough
+  for (int i = 0; i < mPassCount; ++i) {
+    const Pass &pass = mPasses[i];
+
+    if (!pass.isEnabled && pass.forwardOutput != INVALID_RESOURCE) {
+      mResources[pass.forwardOutput].resolved =
+        mResources[pass.forwardInput].resolved;
+    }
+  }
+}
+
+void RenderGraph::cullPasses() {
+  for (int i = 0; i < mResourceCount; ++i) {
+    mResources[i].refCount = 0;
+  }
+
+  for (int i = 0; i < mResourceCount; ++i) {
+    if (mResources[i].isOutput) {
+      ++mResources[resolve(i)].refCount;
+    }
+  }
+
+  // Passes count what they write, resources count who reads them
+  for (int i = 0; i < mPassCount; ++i) {
+    Pass &pass = mPasses[i];
+    pass.isCulled = !pass.isEnabled;
+    pass.refCount = 0;
+
+    if (pass.isCulled) {
+      continue;
+    }
+
+    for (int j = 0; j < pass.accessCount; ++j) {
+      const Access &access = pass.accesses[j];
+
+      if (access.type == RenderGraphAccess::Sampled) {
+        ++mResources[resolve(access.resource)].refCount;
+      }
+      else {
+        ++pass.refCount;
+      }
+    }
+  }
+
+  RenderGraphResource unused[MAX_RESOURCE_COUNT];
+  uint32_t unusedCount = 0;
+
+  for (int i = 0; i < mResourceCount; ++i) {
+    if (mResources[i].refCount == 0) {
+      unused[unusedCount++] = i;
+    }
+  }
+
+  // Passes which don't write anything the graph knows about stay
+  for (int i = 0; i < mPassCount; ++i) {
+    if (!mPasses[i].isCulled && mPasses[i].refCount == 0) {
+      mPasses[i].refCount = 1;
+    }
+  }
+
+  /*
+     Nobody reads the resources in the list - their writers lose a reference
+     and get culled once nothing they write gets read. The resources which
+     they read may then become unused as well.
+  */
+  while (unusedCount) {
+    RenderGraphResource resource = unused[--unusedCount];
+
+    for (int i = 0; i < mPassCount; ++i) {
+      Pass &pass = mPasses[i];
+      if (pass.isCulled) {
+        continue;
+      }
+
+      for (int j = 0; j < pass.accessCount; ++j) {
+        const Access &access = pass.accesses[j];
+
+        if (access.type == RenderGraphAccess::Sampled ||
+            access.resource != resource) {
+          continue;
+        }
+
+        if (--pass.refCount == 0) {
+          pass.isCulled = true;
+
+          for (int k = 0; k < pass.accessCount; ++k) {
+            const Access &input = pass.accesses[k];
+
+            if (input.type == RenderGraphAccess::Sampled) {
+              RenderGraphResource resolved = resolve(input.resource);
+              if (--mResources[resolved].refCount == 0) {
+                unused[unusedCount++] = resolved;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  for (int i = 0; i < mPassCount; ++i) {
+    mStats.culledPassCount += mPasses[i].isCulled;
+  }
+}
+
+void RenderGraph::placeResources() {
+  for (int i = 0; i < mResourceCount; ++i) {
+    mResources[i].firstUse = 0xFFFFFFFF;
+    mResources[i].lastUse = 0;
+    mResources[i].offset = 0;
+    mResources[i].isPlaced = false;
+  }
+
+  /*
+     Lifetimes cover every pass, enabled or not. Reading a forwarded resource
+     also keeps whatever it could get forwarded from alive.
+  */
+  for (int i = 0; i < mPassCount; ++i) {
+    const Pass &pass = mPasses[i];
+
+    for (int j = 0; j < pass.accessCount; ++j) {
+      RenderGraphResource resource = pass.accesses[j].resource;
+
+      while (resource != INVALID_RESOURCE) {
+        Resource &res = mResources[resource];
+        res.firstUse = MIN(res.firstUse, (uint32_t)i);
+        res.lastUse = MAX(res.lastUse, (uint32_t)i);
+
+        if (pass.accesses[j].type != RenderGraphAccess::Sampled) {
+          break;
+        }
+
+        RenderGraphResource source = INVALID_RESOURCE;
+        for (int k = 0; k < i; ++k) {
+          if (mPasses[k].forwardOutput == resource) {
+            source = mPasses[k].forwardInput;
+          }
+        }
+
+        resource = source;
+      }
+    }
+  }
+
+  // Biggest resources first
+  RenderGraphResource order[MAX_RESOURCE_COUNT];
+  uint32_t orderCount = 0;
+
+  for (int i = 0; i < mResourceCount; ++i) {
+    if (mResources[i].isTransient && mResources[i].firstUse != 0xFFFFFFFF) {
+      uint32_t slot = orderCount++;
+      VkDeviceSize size = mResources[i].requirements.size;
+
+      while (slot && mResources[order[slot - 1]].requirements.size < size) {
+        order[slot] = order[slot - 1];
+        --slot;
+      }
+
+      order[slot] = i;
+    }
+  }
+
+  mMemoryRequirements = {};
+  mMemoryRequirements.alignment = 1;
+  mMemoryRequirements.memoryTypeBits = 0xFFFFFFFF;
+
+  for (int i = 0; i < orderCount; ++i) {
+    Resource &resource = mResources[order[i]];
+    const VkMemoryRequirements &requirements = resource.requirements;
+
+    uint32_t memoryTypes =
+      mMemoryRequirements.memoryTypeBits & requirements.memoryTypeBits;
+
+    // Keeps its own memory
+    if (!memoryTypes) {
+      continue;
+    }
+
+    // Go past every range used by a resource alive at the same time
+    VkDeviceSize offset = 0;
+    for (bool moved = true; moved; ) {
+      moved = false;
+
+      for (int j = 0; j < i; ++j) {
+        const Resource &other = mResources[order[j]];
+
+        if (other.isPlaced &&
+            isOverlappingInTime(order[i], order[j]) &&
+            offset < other.offset + other.requirements.size &&
+            other.offset < offset + requirements.size) {
+          offset = alignUp(
+            other.offset + other.requirements.size, requirements.alignment);
+          moved = true;
+        }
+      }
+    }
+
+    resource.offset = offset;
+    resource.isPlaced = true;
+
+    mMemoryRequirements.size = MAX(
+      mMemoryRequirements.size, offset + requirements.size);
+    mMemoryRequirements.alignment = MAX(
+      mMemoryRequirements.alignment, requirements.alignment);
+    mMemoryRequirements.memoryTypeBits = memoryTypes;
+
+    mStats.transientBytes += requirements.size;
+  }
+
+  if (!mMemoryRequirements.size) {
+    mMemoryRequirements = {};
+  }
+
+  mStats.aliasedBytes = mMemoryRequirements.size;
+}
+
+void RenderGraph::computeBarriers() {
+  ResourceState states[MAX_RESOURCE_COUNT] = {};
+
+  // The first run leaves everything the way the previous frame would
+  simulateFrame(states, false);
+  simulateFrame(states, true);
+
+  for (int i = 0; i < mPassCount; ++i) {
+    mStats.barrierCount += mBarriers[i].srcStages != 0;
+  }
+
+  mStats.transitionCount = mTransitionCount;
+}
+
+void RenderGraph::simulateFrame(ResourceState *states, bool record) {
+  mTransitionCount = 0;
+
+  for (int i = 0; i < mResourceCount; ++i) {
+    states[i].isUsed = false;
+  }
+
+  for (int i = 0; i < mPassCount; ++i) {
+    const Pass &pass = mPasses[i];
+
+    RenderGraphBarrier barrier = {};
+    barrier.firstTransition = mTransitionCount;
+
+    if (pass.isCulled) {
+      mBarriers[i] = barrier;
+      continue;
+    }
+
+    for (int j = 0; j < pass.accessCount; ++j) {
+      const Access &access = pass.accesses[j];
+      bool isWrite = access.type != RenderGraphAccess::Sampled;
+
+      RenderGraphResource resource = isWrite ?
+        access.resource : resolve(access.resource);
+      ResourceState &state = states[resource];
+      const Resource &res = mResources[resource];
+
+      if (res.isTransient && !state.isUsed) {
+        // Contents don't survive between frames
+        state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        // Has to wait for whatever used the same memory before
+        for (int k = 0; k < mResourceCount; ++k) {
+          if (k != resource && isOverlappingInMemory(resource, k)) {
+            const ResourceState &previous = states[k];
+
+            if (previous.writeStages) {
+              state.visibleStages = state.writeStages ?
+                state.visibleStages & previous.visibleStages :
+                previous.visibleStages;
+            }
+
+            state.writeStages |= previous.writeStages;
+            state.writeAccess |= previous.writeAccess;
+            state.readStages |= previous.readStages;
+          }
+        }
+      }
+
+      state.isUsed = true;
+
+      AccessInfo info = getAccessInfo(access.type);
+      VkPipelineStageFlags srcStages = 0;
+      VkAccessFlags srcAccess = 0;
+
+      bool isWriteVisible =
+        (state.visibleStages & info.stages) == info.stages;
+
+      if (isWrite && state.readStages) {
+        // Write after read only needs the reads to be done
+        srcStages |= state.readStages;
+      }
+      else if (state.writeStages && !isWriteVisible) {
+        srcStages |= state.writeStages;
+        srcAccess |= state.writeAccess;
+      }
+
+      VkImageLayout layout = isWrite ?
+        access.initialLayout : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+      bool isTransition =
+        layout != VK_IMAGE_LAYOUT_UNDEFINED && layout != state.layout;
+
+      if (isTransition) {
+        srcStages |= state.writeStages | state.readStages;
+        srcAccess |= state.writeAccess;
+
+        if (!srcStages) {
+          srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        }
+
+        if (record) {
+          mTransitions[mTransitionCount] = {resource, state.layout, layout};
+        }
+
+        ++mTransitionCount;
+        ++barrier.transitionCount;
+
+        state.layout = layout;
+      }
+
+      // Only execution has to be ordered if nothing got written
+      VkAccessFlags dstAccess = srcAccess ? info.access : 0;
+
+      // The render pass may already take care of it
+      if (srcStages &&
+          (isTransition ||
+           !covers(pass.entry, srcStages, srcAccess, info.stages, dstAccess))) {
+        barrier.srcStages |= srcStages;
+        barrier.srcAccess |= srcAccess;
+        barrier.dstStages |= info.stages;
+        barrier.dstAccess |= dstAccess;
+      }
+    }
+
+    // Both the barrier and the render pass' entry dependency come first
+    if (barrier.srcStages) {
+      applySync(
+        states,
+        {barrier.srcStages, barrier.srcAccess,
+         barrier.dstStages, barrier.dstAccess});
+    }
+
+    applySync(states, pass.entry);
+
+    for (int j = 0; j < pass.accessCount; ++j) {
+      const Access &access = pass.accesses[j];
+      AccessInfo info = getAccessInfo(access.type);
+
+      if (access.type == RenderGraphAccess::Sampled) {
+        states[resolve(access.resource)].readStages |= info.stages;
+      }
+      else {
+        ResourceState &state = states[access.resource];
+        state.layout = access.finalLayout;
+        state.writeStages = info.writeStages;
+        state.writeAccess = info.writeAccess;
+        state.visibleStages = 0;
+        state.readStages = 0;
+      }
+    }
+
+    applySync(states, pass.exit);
+
+    mBarriers[i] = barrier;
+  }
+
+  // Outputs get sampled by whatever uses the results of the graph
+  for (int i = 0; i < mResourceCount; ++i) {
+    if (mResources[i].isOutput) {
+      states[resolve(i)].readStages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    }
+  }
+}
+
+void RenderGraph::applySync(
+  ResourceState *states, const RenderGraphSync &sync) const {
+  for (int i = 0; i < mResourceCount; ++i) {
+    ResourceState &state = states[i];
+
+    // Writes done in the source stages become visible to the destination ones
+    if (state.writeStages &&
+        (sync.srcStages & state.writeStages) == state.writeStages &&
+        (sync.srcAccess & state.writeAccess) == state.writeAccess) {
+      state.visibleStages |= sync.dstStages;
+    }
+  }
+}
+
+bool RenderGraph::isOverlappingInTime(
+  RenderGraphResource a, RenderGraphResource b) const {
+  return
+    mResources[a].firstUse <= mResources[b].lastUse &&
+    mResources[b].firstUse <= mResources[a].lastUse;
+}
+
+bool RenderGraph::isOverlappingInMemory(
+  RenderGraphResource a, RenderGraphResource b) const {
+  const Resource &resA = mResources[a];
+  const Resource &resB = mResources[b];
+
+  return
+    resA.isPlaced && resB.isPlaced &&
+    resA.offset < resB.offset + resB.requirements.size &&
+    resB.offset < resA.offset + resA.requirements.size;
+}
+
+}
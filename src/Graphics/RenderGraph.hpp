@@ -0,0 +1,201 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+namespace Ondine::Graphics {
+
+using RenderGraphPass = uint32_t;
+using RenderGraphResource = uint32_t;
+
+/*
+   Synchronisation a pass already does by itself - the external dependencies
+   of its render pass (entry: before the pass, exit: after the pass).
+*/
+struct RenderGraphSync {
+  VkPipelineStageFlags srcStages;
+  VkAccessFlags srcAccess;
+  VkPipelineStageFlags dstStages;
+  VkAccessFlags dstAccess;
+};
+
+enum class RenderGraphAccess : uint8_t {
+  // Sampled in the fragment shader
+  Sampled,
+  ColorAttachment,
+  DepthAttachment
+};
+
+/* Pipeline barrier which needs to get recorded right before a pass */
+struct RenderGraphBarrier {
+  VkPipelineStageFlags srcStages;
+  VkAccessFlags srcAccess;
+  VkPipelineStageFlags dstStages;
+  VkAccessFlags dstAccess;
+  uint32_t firstTransition;
+  uint32_t transitionCount;
+};
+
+struct RenderGraphTransition {
+  RenderGraphResource resource;
+  VkImageLayout oldLayout;
+  VkImageLayout newLayout;
+};
+
+struct RenderGraphStats {
+  uint32_t culledPassCount;
+  uint32_t barrierCount;
+  uint32_t transitionCount;
+  // What the placed transient resources would take without aliasing
+  VkDeviceSize transientBytes;
+  VkDeviceSize aliasedBytes;
+};
+
+/*
+   Passes declare which resources they read and write. Compiling the graph:
+   - Culls passes which are disabled or whose results nobody reads
+   - Works out which barriers and layout transitions are needed between the
+     passes on top of what their render passes already do
+   - Places the transient resources in a single block of memory, sharing
+     ranges between resources whose lifetimes don't overlap
+
+   Doesn't touch the GPU - the renderer records the barriers and binds the
+   resources to the memory.
+*/
+class RenderGraph {
+public:
+  static constexpr uint32_t MAX_PASS_COUNT = 16;
+  static constexpr uint32_t MAX_RESOURCE_COUNT = 32;
+  static constexpr uint32_t MAX_ACCESS_COUNT = 8;
+  static constexpr RenderGraphResource INVALID_RESOURCE = 0xFFFFFFFF;
+
+  RenderGraph();
+
+  void reset();
+
+  // Owned by something else / needs to survive the frame
+  RenderGraphResource importResource(const char *name);
+  // Transient resources may share memory with each other
+  RenderGraphResource addTransientResource(
+    const char *name, const VkMemoryRequirements &requirements);
+  // Whoever writes to an output never gets culled
+  void markOutput(RenderGraphResource resource);
+
+  // Passes execute in the order they were added
+  RenderGraphPass addPass(
+    const char *name,
+    const RenderGraphSync &entry,
+    const RenderGraphSync &exit);
+
+  void read(RenderGraphPass pass, RenderGraphResource resource);
+  // Final layout is the one the render pass leaves the attachment in
+  void write(
+    RenderGraphPass pass, RenderGraphResource resource,
+    RenderGraphAccess access, VkImageLayout finalLayout,
+    VkImageLayout initialLayout = VK_IMAGE_LAYOUT_UNDEFINED);
+  // If the pass is disabled, passes reading output will read input instead
+  void forward(
+    RenderGraphPass pass,
+    RenderGraphResource input, RenderGraphResource output);
+  void setEnabled(RenderGraphPass pass, bool enabled);
+
+  void compile();
+
+  // Results of compile()
+  bool isEnabled(RenderGraphPass pass) const;
+  bool isCulled(RenderGraphPass pass) const;
+  RenderGraphResource resolve(RenderGraphResource resource) const;
+  const RenderGraphBarrier &barrier(RenderGraphPass pass) const;
+  const RenderGraphTransition &transition(uint32_t index) const;
+
+  /*
+     Placement doesn't depend on which passes are enabled - toggling a pass
+     never requires the resources to move.
+  */
+  bool isPlaced(RenderGraphResource resource) const;
+  VkDeviceSize memoryOffset(RenderGraphResource resource) const;
+  // Size, alignment and memory types of the block holding the resources
+  const VkMemoryRequirements &memoryRequirements() const;
+
+  const RenderGraphStats &stats() const;
+  const char *passName(RenderGraphPass pass) const;
+  uint32_t passCount() const;
+
+private:
+  struct Access {
+    RenderGraphResource resource;
+    RenderGraphAccess type;
+    VkImageLayout initialLayout;
+    VkImageLayout finalLayout;
+  };
+
+  struct Pass {
+    const char *name;
+    RenderGraphSync entry;
+    RenderGraphSync exit;
+    Access accesses[MAX_ACCESS_COUNT];
+    uint32_t accessCount;
+    RenderGraphResource forwardInput;
+    RenderGraphResource forwardOutput;
+    uint32_t refCount;
+    bool isEnabled;
+    bool isCulled;
+  };
+
+  struct Resource {
+    const char *name;
+    VkMemoryRequirements requirements;
+    RenderGraphResource resolved;
+    VkDeviceSize offset;
+    uint32_t refCount;
+    // Passes between which the resource is alive
+    uint32_t firstUse;
+    uint32_t lastUse;
+    bool isTransient;
+    bool isOutput;
+    bool isPlaced;
+  };
+
+  // Tracked while walking through the passes
+  struct ResourceState {
+    VkImageLayout layout;
+    VkPipelineStageFlags writeStages;
+    VkAccessFlags writeAccess;
+    // Stages which the last write is visible to
+    VkPipelineStageFlags visibleStages;
+    // Stages which read the resource since the last write
+    VkPipelineStageFlags readStages;
+    bool isUsed;
+  };
+
+  void resolveForwards();
+  void cullPasses();
+  void placeResources();
+  void computeBarriers();
+
+  // Runs through the passes once - only records the barriers if asked to
+  void simulateFrame(ResourceState *states, bool record);
+  // Applies a dependency to every resource
+  void applySync(ResourceState *states, const RenderGraphSync &sync) const;
+
+  bool isOverlappingInTime(
+    RenderGraphResource a, RenderGraphResource b) const;
+  bool isOverlappingInMemory(
+    RenderGraphResource a, RenderGraphResource b) const;
+
+private:
+  Pass mPasses[MAX_PASS_COUNT];
+  uint32_t mPassCount;
+
+  Resource mResources[MAX_RESOURCE_COUNT];
+  uint32_t mResourceCount;
+
+  RenderGraphBarrier mBarriers[MAX_PASS_COUNT];
+  RenderGraphTransition mTransitions[MAX_PASS_COUNT * MAX_ACCESS_COUNT];
+  uint32_t mTransitionCount;
+
+  VkMemoryRequirements mMemoryRequirements;
+  RenderGraphStats mStats;
+};
+
+}
@@ -5,7 +5,8 @@ namespace Ondine::Graphics {
 RenderMethod::RenderMethod(
   const ModelManager &models,
   const RenderShaderEntries &entries)
-  : mShaderEntries(&entries),
+  : mIsInstanced(false),
+    mShaderEntries(&entries),
     mModelManager(&models) {
   
 }
@@ -21,9 +22,18 @@ void RenderMethod::init(
   mPushConstantProc = pushConstantProc;
 }
 
+void RenderMethod::initInstancing(const std::string &instancedShaderName) {
+  mInstancedShader = mShaderEntries->getHandle(instancedShaderName);
+  mIsInstanced = true;
+}
+
+bool RenderMethod::isInstanced() const {
+  return mIsInstanced;
+}
+
 void RenderMethod::bindShader(const VulkanFrame &frame) {
-  auto &shader = mShaderEntries->getEntry(mRenderShader);
-  frame.primaryCommandBuffer.bindPipeline(shader);
+  auto &renderShader = mShaderEntries->getEntry(shader());
+  frame.primaryCommandBuffer.bindPipeline(renderShader);
 }
 
 void RenderMethod::bindBuffers(const VulkanFrame &frame) {
@@ -51,4 +61,25 @@ void RenderMethod::submit(const VulkanFrame &frame) {
   model.submitForRenderIndexed(frame.primaryCommandBuffer);
 }
 
+void RenderMethod::bindInstanceBuffer(
+  const VulkanFrame &frame, const VulkanBuffer &instances) {
+  const auto &model = mModelManager->getModel(mModel);
+  model.bindInstanceBuffer(frame.primaryCommandBuffer, instances);
+}
+
+void RenderMethod::submitInstanced(
+  const VulkanFrame &frame, uint32_t instanceCount, uint32_t firstInstance) {
+  const auto &model = mModelManager->getModel(mModel);
+  model.submitForRenderIndexed(
+    frame.primaryCommandBuffer, instanceCount, firstInstance);
+}
+
+FastMapHandle RenderMethod::shader() const {
+  return mIsInstanced ? mInstancedShader : mRenderShader;
+}
+
+ModelHandle RenderMethod::model() const {
+  return mModel;
+}
+
 }
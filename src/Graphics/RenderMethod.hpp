@@ -43,6 +43,14 @@ public:
     RenderBindResourceProc bindResProc,
     RenderPushConstantProc pushConstantProc);
 
+  /*
+     Objects using this method then get drawn in one instanced draw, taking
+     their transform / color from a SceneInstance vertex binding (instead of
+     the push constant). The shader is used instead of the regular one.
+  */
+  void initInstancing(const std::string &instancedShaderName);
+  bool isInstanced() const;
+
   void bindShader(const VulkanFrame &frame);
 
   void bindBuffers(const VulkanFrame &frame);
@@ -56,9 +64,21 @@ public:
     const struct SceneObject &object);
 
   void submit(const VulkanFrame &frame);
+
+  // Instanced methods only
+  void bindInstanceBuffer(
+    const VulkanFrame &frame, const VulkanBuffer &instances);
+  void submitInstanced(
+    const VulkanFrame &frame, uint32_t instanceCount, uint32_t firstInstance);
+
+  // Used to sort draws so that state only gets bound when it changes
+  FastMapHandle shader() const;
+  ModelHandle model() const;
   
 private:
   FastMapHandle mRenderShader;
+  FastMapHandle mInstancedShader;
+  bool mIsInstanced;
   ModelHandle mModel;
   RenderBindResourceProc mBindResourceProc;
   RenderPushConstantProc mPushConstantProc;
@@ -1,6 +1,8 @@
 #include <iostream>
+#include <assert.h>
 #include "Buffer.hpp"
 #include "Renderer3D.hpp"
+#include "ThreadPool.hpp"
 #include "FileSystem.hpp"
 #include "RendererCache.hpp"
 #include "RendererDebug.hpp"
@@ -12,15 +14,24 @@
 namespace Ondine::Graphics {
 
 Renderer3D::Renderer3D(VulkanContext &graphicsContext)
-  : mGraphicsContext(graphicsContext) {
+  : mTargetMemory{},
+    mGraphicsContext(graphicsContext) {
   
 }
 
 void Renderer3D::init() {
+  Core::TimeStamp initStart = Core::getCurrentTime();
+
   if (!gAssimpImporter) {
     gAssimpImporter = flAlloc<Assimp::Importer>();
   }
 
+  /*
+     Shaders get loaded and pipelines get created on the job system until
+     endPipelineBuild, the render stages only configure them.
+  */
+  mGraphicsContext.beginPipelineBuild();
+
   auto properties = mGraphicsContext.getProperties();
   pipelineViewport = {
     properties.swapchainExtent.width, properties.swapchainExtent.height
@@ -121,7 +132,7 @@ void Renderer3D::init() {
 
       auto &baseModelShader = mShaderEntries.emplace("BaseModelShader");
       
-      baseModelShader.init(
+      baseModelShader.initDeferred(
         mGraphicsContext.device(),
         mGraphicsContext.descriptorLayouts(),
         pipelineConfig);
@@ -145,12 +156,58 @@ void Renderer3D::init() {
 
       auto &baseModelShader = mShaderEntries.emplace("GlowingModelShader");
       
-      baseModelShader.init(
+      baseModelShader.initDeferred(
         mGraphicsContext.device(),
         mGraphicsContext.descriptorLayouts(),
         pipelineConfig);
     }
 
+    /*
+       Instanced variants take the transform and color per instance instead
+       of through the push constant (same layout - resources stay bound).
+    */
+    bool isInstancingSupported = Core::gFileSystem->isPathValid(
+      (Core::MountPoint)Core::ApplicationMountPoints::Application,
+      "res/spv/BaseModelInstanced.vert.spv");
+
+    if (isInstancingSupported) {
+      const char *instancedShaders[][2] = {
+        {"BaseModelShaderInstanced", "res/spv/BaseModel.frag.spv"},
+        {"GlowingModelShaderInstanced", "res/spv/Glowing.frag.spv"}
+      };
+
+      for (auto &instancedShader : instancedShaders) {
+        VulkanPipelineConfig pipelineConfig(
+          {mGBuffer.renderPass(), 0},
+          VulkanShader{
+            mGraphicsContext.device(), "res/spv/BaseModelInstanced.vert.spv"},
+          VulkanShader{mGraphicsContext.device(), instancedShader[1]});
+
+        pipelineConfig.enableDepthTesting();
+        pipelineConfig.configurePipelineLayout(
+          sizeof(SceneObject::pushConstant),
+          VulkanPipelineDescriptorLayout{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
+          VulkanPipelineDescriptorLayout{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
+          VulkanPipelineDescriptorLayout{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1});
+
+        sphereModelConfig.configureVertexInput(
+          pipelineConfig, sizeof(SceneInstance));
+        pipelineConfig.setTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+        auto &shader = mShaderEntries.emplace(instancedShader[0]);
+
+        shader.initDeferred(
+          mGraphicsContext.device(),
+          mGraphicsContext.descriptorLayouts(),
+          pipelineConfig);
+      }
+    }
+    else {
+      LOG_WARNING(
+        "BaseModelInstanced.vert.spv is missing - "
+        "scene objects won't get instanced\n");
+    }
+
     /* Create render method */
     RenderMethod baseModelMethod(mModelManager, mShaderEntries);
     baseModelMethod.init(
@@ -163,6 +220,10 @@ void Renderer3D::init() {
         cmdbuf.pushConstants(sizeof(obj.pushConstant), &obj.pushConstant);
       });
 
+    if (isInstancingSupported) {
+      baseModelMethod.initInstancing("BaseModelShaderInstanced");
+    }
+
     mRenderMethods.insert("SphereModelRenderMethod", baseModelMethod);
 
     RenderMethod taurusModelMethod(mModelManager, mShaderEntries);
@@ -176,6 +237,10 @@ void Renderer3D::init() {
         cmdbuf.pushConstants(sizeof(obj.pushConstant), &obj.pushConstant);
       });
 
+    if (isInstancingSupported) {
+      taurusModelMethod.initInstancing("BaseModelShaderInstanced");
+    }
+
     mRenderMethods.insert("TaurusModelRenderMethod", taurusModelMethod);
 
     RenderMethod glowingModelMethod(mModelManager, mShaderEntries);
@@ -189,6 +254,10 @@ void Renderer3D::init() {
         cmdbuf.pushConstants(sizeof(obj.pushConstant), &obj.pushConstant);
       });
 
+    if (isInstancingSupported) {
+      glowingModelMethod.initInstancing("GlowingModelShaderInstanced");
+    }
+
     mRenderMethods.insert("GlowingTaurusRenderMethod", glowingModelMethod);
   }
 
@@ -201,6 +270,24 @@ void Renderer3D::init() {
   mBloomRenderer.init(
     mGraphicsContext,
     {pipelineViewport.width, pipelineViewport.height});
+
+  mRecorder.init(
+    mGraphicsContext.device(),
+    mGraphicsContext.framesInFlight(),
+    Core::gThreadPool->workerCount() + 1,
+    (uint32_t)RecordedStage::Count);
+
+  buildRenderGraph();
+
+  // Every pipeline needs to exist before the first frame
+  mGraphicsContext.endPipelineBuild();
+
+  mGraphicsContext.device().memoryAllocator().debugLogBudget();
+
+  // Mostly pipeline creation - should be a lot faster with a warm cache
+  LOG_INFOV(
+    "Initialised renderer in %.3fs\n",
+    Core::getTimeDifference(Core::getCurrentTime(), initStart));
 }
 
 void Renderer3D::shutdown() {
@@ -213,14 +300,23 @@ void Renderer3D::shutdown() {
   }
 
   mSkyRenderer.shutdown(mGraphicsContext);
+  mGraphicsContext.savePipelineCache();
+
+  mProfiler.destroy(mGraphicsContext.device());
 }
 
 void Renderer3D::tick(const Core::Tick &tick, Graphics::VulkanFrame &frame) {
+  mSkyRenderer.sync(mGraphicsContext);
+
+  mProfiler.beginFrame(mGraphicsContext.device(), frame);
+
   mTerrainRenderer.sync(
     mBoundScene->terrain,
     mBoundScene->camera,
     frame.primaryCommandBuffer);
 
+  mProfiler.endStage(frame, "TerrainSync");
+
   mBoundScene->lighting.tick(tick, mPlanetProperties);
   mBoundScene->camera.tick(
     {mGBuffer.mGBufferExtent.width, mGBuffer.mGBufferExtent.height});
@@ -240,29 +336,123 @@ void Renderer3D::tick(const Core::Tick &tick, Graphics::VulkanFrame &frame) {
   mWaterRenderer.updateLightingUBO(
     mBoundScene->lighting, frame.primaryCommandBuffer);
 
-  /* Rendering to water texture */
-  mWaterRenderer.tick(
-    frame, mPlanetRenderer, mSkyRenderer,
-    mStarRenderer, mTerrainRenderer, *mBoundScene);
-     
-  mGBuffer.beginRender(frame);
-  { // Render 3D scene
-    mBoundScene->submit(
-      mCamera, mPlanetRenderer, mClipping, mTerrainRenderer, frame);
-    mBoundScene->submitDebug(
-      mCamera, mPlanetRenderer, mClipping, mTerrainRenderer, frame);
-    mStarRenderer.render(3.0f, mCamera, frame);
+  mProfiler.endStage(frame, "Uniforms");
+
+  // Both the water and the GBuffer stages submit the sorted draws
+  const CameraProperties *views[] = {
+    &mBoundScene->camera, &mWaterRenderer.cameraProperties()
+  };
+
+  mBoundScene->prepareDrawList(frame.frameInFlight, views);
+
+  mProfiler.endStage(frame, "DrawList");
+
+  /*
+     Stages get recorded into secondary command buffers on the job system -
+     the primary command buffer just executes them in order.
+  */
+  // Pixelating with a strength of 1 or less doesn't change the image
+  RenderGraphPass pixelater = (RenderGraphPass)RecordedStage::Pixelater;
+  bool isPixelating = mPixelater.pixelationStrength > 1.0f;
+
+  if (isPixelating != mRenderGraph.isEnabled(pixelater)) {
+    mRenderGraph.setEnabled(pixelater, mPixelater.pixelationStrength > 1.0f);
+    mRenderGraph.compile();
   }
-  mGBuffer.endRender(frame);
 
-  mDeferredLighting.render(
-    frame, mGBuffer, mCamera, mPlanetRenderer, mWaterRenderer, mSkyRenderer);
+  mRecorder.beginFrame(mGraphicsContext.device(), frame.frameInFlight);
+
+  RecordJob job = {this, &frame};
+  Core::gThreadPool->parallelFor(
+    (uint32_t)RecordedStage::Count, runRecordJob, &job);
 
-  mPixelater.render(frame, mDeferredLighting);
+  static const char *RECORDED_STAGE_NAMES[] = {
+    "Water", "GBuffer", "DeferredLighting", "Pixelater", "Bloom", "ToneMapping"
+  };
 
-  mBloomRenderer.render(frame, mDeferredLighting);
+  for (uint32_t i = 0; i < (uint32_t)RecordedStage::Count; ++i) {
+    if (mRenderGraph.isCulled(i)) {
+      continue;
+    }
 
-  mToneMapping.render(frame, mBloomRenderer, mPixelater);
+    recordGraphBarrier(frame.primaryCommandBuffer, (RecordedStage)i);
+    mRecorder.execute(frame.primaryCommandBuffer, i);
+
+    mProfiler.endStage(
+      frame, RECORDED_STAGE_NAMES[i], mRecorder.recordTime(i));
+  }
+}
+
+void Renderer3D::runRecordJob(uint32_t index, void *data) {
+  auto *job = (RecordJob *)data;
+  Renderer3D *renderer = job->renderer;
+
+  if (renderer->mRenderGraph.isCulled(index)) {
+    return;
+  }
+
+  VulkanCommandBuffer &commandBuffer = renderer->mRecorder.beginStage(
+    renderer->mGraphicsContext.device(), index);
+
+  VulkanFrame frame = {
+    commandBuffer,
+    job->frame->imageIndex,
+    job->frame->frameInFlight,
+    job->frame->viewport,
+    job->frame->skipped
+  };
+
+  renderer->recordStage((RecordedStage)index, frame);
+
+  renderer->mRecorder.endStage(index);
+}
+
+void Renderer3D::recordStage(RecordedStage stage, VulkanFrame &frame) {
+  // Stages only read the scene and the state of the other stages
+  switch (stage) {
+  case RecordedStage::Water: {
+    /* Rendering to water texture */
+    mWaterRenderer.tick(
+      frame, mPlanetRenderer, mSkyRenderer,
+      mStarRenderer, mTerrainRenderer, *mBoundScene);
+  } break;
+
+  case RecordedStage::GBuffer: {
+    mGBuffer.beginRender(frame);
+    { // Render 3D scene
+      mBoundScene->submit(
+        mCamera, mPlanetRenderer, mClipping, mTerrainRenderer, frame,
+        SceneView::Main);
+      mBoundScene->submitDebug(
+        mCamera, mPlanetRenderer, mClipping, mTerrainRenderer, frame);
+      mStarRenderer.render(3.0f, mCamera, frame);
+    }
+    mGBuffer.endRender(frame);
+  } break;
+
+  case RecordedStage::DeferredLighting: {
+    mDeferredLighting.render(
+      frame, mGBuffer, mCamera, mPlanetRenderer, mWaterRenderer, mSkyRenderer);
+  } break;
+
+  case RecordedStage::Pixelater: {
+    mPixelater.render(frame, mDeferredLighting);
+  } break;
+
+  case RecordedStage::Bloom: {
+    mBloomRenderer.render(frame, mDeferredLighting);
+  } break;
+
+  case RecordedStage::ToneMapping: {
+    // Lighting goes straight to tone mapping if the pixelater got culled
+    RenderGraphResource scene = mRenderGraph.resolve(
+      (RenderGraphResource)GraphResource::Pixelated);
+
+    mToneMapping.render(frame, mBloomRenderer, *mGraphStages[scene]);
+  } break;
+
+  default: break;
+  }
 }
 
 void Renderer3D::resize(Resolution newResolution) {
@@ -285,6 +475,218 @@ void Renderer3D::resize(Resolution newResolution) {
   mBloomRenderer.resize(mGraphicsContext, newResolution);
 
   mToneMapping.resize(mGraphicsContext, newResolution);
+
+  // Resizing put every target back in its own memory
+  buildRenderGraph();
+}
+
+static RenderGraphSync makeGraphSync(const VkSubpassDependency &dependency) {
+  return {
+    dependency.srcStageMask, dependency.srcAccessMask,
+    dependency.dstStageMask, dependency.dstAccessMask
+  };
+}
+
+void Renderer3D::buildRenderGraph() {
+  const VulkanDevice &device = mGraphicsContext.device();
+
+  // Nothing is placed in there anymore
+  if (mTargetMemory.memory != VK_NULL_HANDLE) {
+    device.freeTargetMemory(mTargetMemory);
+    mTargetMemory = {};
+  }
+
+  mRenderGraph.reset();
+
+  { // Resources (same order as GraphResource)
+    const VulkanTexture *gbufferTextures = mGBuffer.mGBufferTextures;
+
+    mRenderGraph.importResource("WaterReflection");
+    mRenderGraph.addTransientResource(
+      "GBufferAlbedo",
+      gbufferTextures[GBuffer::Albedo].imageMemoryRequirements(device));
+    mRenderGraph.addTransientResource(
+      "GBufferNormal",
+      gbufferTextures[GBuffer::Normal].imageMemoryRequirements(device));
+    mRenderGraph.addTransientResource(
+      "GBufferPosition",
+      gbufferTextures[GBuffer::Position].imageMemoryRequirements(device));
+    mRenderGraph.addTransientResource(
+      "GBufferDepth",
+      gbufferTextures[GBuffer::Depth].imageMemoryRequirements(device));
+    mRenderGraph.importResource("Lighting");
+    mRenderGraph.addTransientResource(
+      "Pixelated", mPixelater.mTexture.imageMemoryRequirements(device));
+    mRenderGraph.importResource("Bloom");
+    mRenderGraph.importResource("ToneMapped");
+
+    // The views sample the final image
+    mRenderGraph.markOutput((RenderGraphResource)GraphResource::ToneMapped);
+
+    for (int i = 0; i < (int)GraphResource::Count; ++i) {
+      mGraphStages[i] = nullptr;
+      mGraphTextures[i] = nullptr;
+    }
+
+    mGraphStages[(int)GraphResource::WaterReflection] = &mWaterRenderer;
+    mGraphStages[(int)GraphResource::Lighting] = &mDeferredLighting;
+    mGraphStages[(int)GraphResource::Pixelated] = &mPixelater;
+    mGraphStages[(int)GraphResource::Bloom] = &mBloomRenderer;
+    mGraphStages[(int)GraphResource::ToneMapped] = &mToneMapping;
+
+    for (int i = 0; i < GBuffer::Count; ++i) {
+      mGraphStages[(int)GraphResource::GBufferAlbedo + i] = &mGBuffer;
+      mGraphTextures[(int)GraphResource::GBufferAlbedo + i] =
+        &gbufferTextures[i];
+    }
+
+    mGraphTextures[(int)GraphResource::Pixelated] = &mPixelater.mTexture;
+  }
+
+  auto color = RenderGraphAccess::ColorAttachment;
+  auto depth = RenderGraphAccess::DepthAttachment;
+  // Every render pass leaves its targets ready to get sampled
+  auto sampled = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+  auto resource = [] (GraphResource res) {
+    return (RenderGraphResource)res;
+  };
+
+  { // Passes (same order as RecordedStage)
+    RenderGraphPass water = mRenderGraph.addPass(
+      "Water",
+      makeGraphSync(mWaterRenderer.mGBuffer.renderPass().entryDependency()),
+      makeGraphSync(mWaterRenderer.mLighting.renderPass().exitDependency()));
+    mRenderGraph.write(
+      water, resource(GraphResource::WaterReflection), color, sampled);
+
+    RenderGraphPass gbuffer = mRenderGraph.addPass(
+      "GBuffer",
+      makeGraphSync(mGBuffer.renderPass().entryDependency()),
+      makeGraphSync(mGBuffer.renderPass().exitDependency()));
+    mRenderGraph.write(
+      gbuffer, resource(GraphResource::GBufferAlbedo), color, sampled);
+    mRenderGraph.write(
+      gbuffer, resource(GraphResource::GBufferNormal), color, sampled);
+    mRenderGraph.write(
+      gbuffer, resource(GraphResource::GBufferPosition), color, sampled);
+    mRenderGraph.write(
+      gbuffer, resource(GraphResource::GBufferDepth), depth, sampled);
+
+    RenderGraphPass lighting = mRenderGraph.addPass(
+      "DeferredLighting",
+      makeGraphSync(mDeferredLighting.renderPass().entryDependency()),
+      makeGraphSync(mDeferredLighting.renderPass().exitDependency()));
+    mRenderGraph.read(lighting, resource(GraphResource::GBufferAlbedo));
+    mRenderGraph.read(lighting, resource(GraphResource::GBufferNormal));
+    mRenderGraph.read(lighting, resource(GraphResource::GBufferPosition));
+    mRenderGraph.read(lighting, resource(GraphResource::GBufferDepth));
+    mRenderGraph.read(lighting, resource(GraphResource::WaterReflection));
+    mRenderGraph.write(
+      lighting, resource(GraphResource::Lighting), color, sampled);
+
+    RenderGraphPass pixelater = mRenderGraph.addPass(
+      "Pixelater",
+      makeGraphSync(mPixelater.renderPass().entryDependency()),
+      makeGraphSync(mPixelater.renderPass().exitDependency()));
+    mRenderGraph.read(pixelater, resource(GraphResource::Lighting));
+    mRenderGraph.write(
+      pixelater, resource(GraphResource::Pixelated), color, sampled);
+    mRenderGraph.forward(
+      pixelater,
+      resource(GraphResource::Lighting), resource(GraphResource::Pixelated));
+    mRenderGraph.setEnabled(pixelater, mPixelater.pixelationStrength > 1.0f);
+
+    RenderGraphPass bloom = mRenderGraph.addPass(
+      "Bloom",
+      makeGraphSync(mBloomRenderer.renderPass().entryDependency()),
+      makeGraphSync(mBloomRenderer.renderPass().exitDependency()));
+    mRenderGraph.read(bloom, resource(GraphResource::Lighting));
+    mRenderGraph.write(bloom, resource(GraphResource::Bloom), color, sampled);
+
+    RenderGraphPass toneMapping = mRenderGraph.addPass(
+      "ToneMapping",
+      makeGraphSync(mToneMapping.renderPass().entryDependency()),
+      makeGraphSync(mToneMapping.renderPass().exitDependency()));
+    mRenderGraph.read(toneMapping, resource(GraphResource::Bloom));
+    mRenderGraph.read(toneMapping, resource(GraphResource::Pixelated));
+    mRenderGraph.write(
+      toneMapping, resource(GraphResource::ToneMapped), color, sampled);
+
+    assert(toneMapping == (RenderGraphPass)RecordedStage::ToneMapping);
+  }
+
+  mRenderGraph.compile();
+
+  const VkMemoryRequirements &requirements = mRenderGraph.memoryRequirements();
+  if (requirements.size) {
+    mTargetMemory = device.allocateTargetMemory(requirements);
+
+    // The GBuffer targets only get placed all together
+    bool isGBufferPlaced = true;
+    VulkanTexturePlacement gbufferPlacements[GBuffer::Count];
+
+    for (int i = 0; i < GBuffer::Count; ++i) {
+      auto target = (GraphResource)((int)GraphResource::GBufferAlbedo + i);
+      isGBufferPlaced &= mRenderGraph.isPlaced(resource(target));
+      gbufferPlacements[i] = targetPlacement(target);
+    }
+
+    if (isGBufferPlaced) {
+      mGBuffer.placeTargets(mGraphicsContext, gbufferPlacements);
+    }
+
+    if (mRenderGraph.isPlaced(resource(GraphResource::Pixelated))) {
+      VulkanTexturePlacement placement =
+        targetPlacement(GraphResource::Pixelated);
+      mPixelater.placeTarget(mGraphicsContext, &placement);
+    }
+  }
+
+  const RenderGraphStats &stats = mRenderGraph.stats();
+  LOG_INFOV(
+    "Render graph: %u culled passes, %u barriers, transient targets take "
+    "%.2fMB instead of %.2fMB\n",
+    stats.culledPassCount, stats.barrierCount,
+    (float)stats.aliasedBytes / (1024.0f * 1024.0f),
+    (float)stats.transientBytes / (1024.0f * 1024.0f));
+}
+
+void Renderer3D::recordGraphBarrier(
+  VulkanCommandBuffer &commandBuffer, RecordedStage stage) const {
+  const RenderGraphBarrier &barrier = mRenderGraph.barrier(
+    (RenderGraphPass)stage);
+
+  // The render passes' own dependencies cover most of the stages
+  if (!barrier.srcStages) {
+    return;
+  }
+
+  VkImageMemoryBarrier transitions[RenderGraph::MAX_ACCESS_COUNT];
+  for (int i = 0; i < barrier.transitionCount; ++i) {
+    const RenderGraphTransition &transition =
+      mRenderGraph.transition(barrier.firstTransition + i);
+
+    const VulkanTexture *texture = mGraphTextures[transition.resource];
+    assert(texture);
+
+    transitions[i] = texture->makeBarrier(
+      transition.oldLayout, transition.newLayout);
+  }
+
+  commandBuffer.pipelineBarrier(
+    barrier.srcStages, barrier.srcAccess,
+    barrier.dstStages, barrier.dstAccess,
+    transitions, barrier.transitionCount);
+}
+
+VulkanTexturePlacement Renderer3D::targetPlacement(
+  GraphResource resource) const {
+  return {
+    mTargetMemory.memory,
+    mTargetMemory.offset +
+      mRenderGraph.memoryOffset((RenderGraphResource)resource)
+  };
 }
 
 void Renderer3D::trackPath(Core::TrackPathID id, const char *path) {
@@ -301,12 +703,23 @@ void Renderer3D::trackPath(Core::TrackPathID id, const char *path) {
   for (int i = 0; i < sizeof(trackers) / sizeof(trackers[0]); ++i) {
     trackers[i]->trackPath(mGraphicsContext, id, path);
   }
+
+  // Reloaded pipelines are in the cache now
+  mGraphicsContext.savePipelineCache();
 }
 
 const RenderStage &Renderer3D::mainRenderStage() const {
   return mToneMapping;
 }
 
+void Renderer3D::enableProfiling() {
+  mProfiler.init(mGraphicsContext.device(), mGraphicsContext.framesInFlight());
+}
+
+FrameProfiler &Renderer3D::profiler() {
+  return mProfiler;
+}
+
 Scene *Renderer3D::createScene() {
   Scene *ret = new Scene(mModelManager, mRenderMethods);
   ret->init(mGBuffer, mGraphicsContext);
@@ -322,4 +735,8 @@ void Renderer3D::bindScene(Scene *scene) {
   mBoundScene = scene;
 }
 
+Scene *Renderer3D::boundScene() {
+  return mBoundScene;
+}
+
 }
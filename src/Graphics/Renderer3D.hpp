@@ -10,6 +10,7 @@
 #include "Delegate.hpp"
 #include "Clipping.hpp"
 #include "Pixelater.hpp"
+#include "RenderGraph.hpp"
 #include "SkyRenderer.hpp"
 #include "ToneMapping.hpp"
 #include "RenderStage.hpp"
@@ -17,12 +18,14 @@
 #include "RenderMethod.hpp"
 #include "StarRenderer.hpp"
 #include "BloomRenderer.hpp"
+#include "FrameProfiler.hpp"
 #include "WaterRenderer.hpp"
 #include "VulkanContext.hpp"
 #include "TerrainRenderer.hpp"
 #include "AnimationManager.hpp"
 #include "DeferredLighting.hpp"
 #include "VulkanArenaAllocator.hpp"
+#include "VulkanCommandRecorder.hpp"
 
 namespace Ondine::View {
 
@@ -46,9 +49,14 @@ public:
   void trackPath(Core::TrackPathID id, const char *path);
   const RenderStage &mainRenderStage() const;
 
+  /* Times every stage of tick() on the CPU and GPU from now on */
+  void enableProfiling();
+  FrameProfiler &profiler();
+
 public:
   Scene *createScene();
   void bindScene(Scene *scene);
+  Scene *boundScene();
 
   inline PlanetProperties &planet() {
     return mPlanetProperties;
@@ -57,6 +65,50 @@ public:
 public:
   Resolution pipelineViewport;
 
+private:
+  /* Stages which get recorded on the job system, in execution order */
+  enum class RecordedStage {
+    Water,
+    GBuffer,
+    DeferredLighting,
+    Pixelater,
+    Bloom,
+    ToneMapping,
+    Count
+  };
+
+  /* What the recorded stages read and write - declared to the render graph */
+  enum class GraphResource {
+    WaterReflection,
+    GBufferAlbedo,
+    GBufferNormal,
+    GBufferPosition,
+    GBufferDepth,
+    Lighting,
+    Pixelated,
+    Bloom,
+    ToneMapped,
+    Count
+  };
+
+  struct RecordJob {
+    Renderer3D *renderer;
+    VulkanFrame *frame;
+  };
+
+  static void runRecordJob(uint32_t index, void *data);
+  void recordStage(RecordedStage stage, VulkanFrame &frame);
+
+  /*
+     Declares the recorded stages (graph passes have the same indices) and
+     places the transient targets in shared memory. Stages need to have their
+     targets in their own memory when this gets called.
+  */
+  void buildRenderGraph();
+  void recordGraphBarrier(
+    VulkanCommandBuffer &commandBuffer, RecordedStage stage) const;
+  VulkanTexturePlacement targetPlacement(GraphResource resource) const;
+
 private:
   /* 
      Contains all the info about the 3D scene currently being rendered 
@@ -97,6 +149,15 @@ private:
   ModelManager mModelManager;
   AnimationManager mAnimationManager;
 
+  FrameProfiler mProfiler;
+  VulkanCommandRecorder mRecorder;
+
+  RenderGraph mRenderGraph;
+  // Stage which outputs each resource and the texture (if it is accessible)
+  const RenderStage *mGraphStages[(uint32_t)GraphResource::Count];
+  const VulkanTexture *mGraphTextures[(uint32_t)GraphResource::Count];
+  // Holds the transient targets which the render graph placed
+  VulkanMemoryAllocation mTargetMemory;
 
   VulkanContext &mGraphicsContext;
 
@@ -9,5 +9,6 @@ const char *const SKY_TRANSMITTANCE_CACHE_FILENAME = "transmittance.cache";
 const char *const SKY_SCATTERING_CACHE_FILENAME = "scattering.cache";
 const char *const SKY_MIE_SCATTERING_CACHE_FILENAME = "mie.cache";
 const char *const SKY_IRRADIANCE_CACHE_FILENAME = "irradiance.cache";
+const char *const PIPELINE_CACHE_FILENAME = "pipelines.cache";
 
 }
@@ -11,5 +11,6 @@ extern const char *const SKY_TRANSMITTANCE_CACHE_FILENAME;
 extern const char *const SKY_SCATTERING_CACHE_FILENAME;
 extern const char *const SKY_MIE_SCATTERING_CACHE_FILENAME;
 extern const char *const SKY_IRRADIANCE_CACHE_FILENAME;
+extern const char *const PIPELINE_CACHE_FILENAME;
  
 }
@@ -7,15 +7,83 @@ namespace Ondine::Graphics {
 Scene::Scene(ModelManager &modelManager, RenderMethodEntries &renderMethods)
   : mModelManager(modelManager),
     mRenderMethods(renderMethods),
-    mSceneObjects(MAX_SCENE_OBJECTS_COUNT) {
+    mSceneObjects(MAX_SCENE_OBJECTS_COUNT),
+    mObjectCount(0),
+    mObjectProxies(MAX_SCENE_OBJECTS_COUNT),
+    mMovedObjects(MAX_SCENE_OBJECTS_COUNT),
+    mCurrentInstances(nullptr) {
   memset(&lighting, 0, sizeof(lighting));
   memset(&camera, 0, sizeof(camera));
+
+  transforms.init(MAX_SCENE_OBJECTS_COUNT);
+  mBVH.init(MAX_SCENE_OBJECTS_COUNT);
+
+  mObjectProxies.size = MAX_SCENE_OBJECTS_COUNT;
+  for (int i = 0; i < mObjectProxies.size; ++i) {
+    mObjectProxies[i] = SceneBVH::INVALID_PROXY;
+  }
+
+  for (auto &list : mDrawLists) {
+    list.keys.init(MAX_SCENE_OBJECTS_COUNT);
+    list.scratch.init(MAX_SCENE_OBJECTS_COUNT);
+    list.sorted = list.keys.data;
+    list.count = 0;
+    list.batches.init(MAX_SCENE_OBJECTS_COUNT);
+    list.batchCount = 0;
+    list.stats = {};
+  }
 }
 
 void Scene::init(
   const GBuffer &gbuffer,
   VulkanContext &graphicsContext) {
+  uint32_t framesInFlight = graphicsContext.framesInFlight();
+  size_t size = sizeof(SceneInstance) *
+    MAX_SCENE_OBJECTS_COUNT * (int)SceneView::Count;
+
+  mInstanceBuffers.init(framesInFlight);
+  mInstanceBuffers.size = framesInFlight;
+  mMappedInstances.init(framesInFlight);
+  mMappedInstances.size = framesInFlight;
+
+  for (int i = 0; i < framesInFlight; ++i) {
+    mInstanceBuffers[i].init(
+      graphicsContext.device(), size,
+      VulkanBufferFlag::VertexBuffer | VulkanBufferFlag::Mappable);
+
+    mMappedInstances[i] = (SceneInstance *)mInstanceBuffers[i].map(size, 0);
+  }
+}
+
+void Scene::prepareDrawList(
+  uint32_t frameInFlight, const CameraProperties *const *views) {
+  uint32_t transformUpdates = updateTransforms();
+
+  Frustum frustums[(int)SceneView::Count];
+  for (int i = 0; i < (int)SceneView::Count; ++i) {
+    frustums[i].init(views[i]->viewProjection());
+    mDrawLists[i].count = 0;
+  }
+
+  // Culled objects never make it into the draw lists
+  mBVH.query(frustums, (int)SceneView::Count, addVisibleObject, this);
+
+  SceneInstance *instances = mMappedInstances[frameInFlight];
+  mCurrentInstances = &mInstanceBuffers[frameInFlight];
+
+  for (int i = 0; i < (int)SceneView::Count; ++i) {
+    DrawList &list = mDrawLists[i];
+    uint32_t firstInstance = i * MAX_SCENE_OBJECTS_COUNT;
+
+    buildDrawBatches(list, instances + firstInstance, firstInstance);
+
+    list.stats.culledCount = mObjectCount - list.count;
+    list.stats.transformUpdates = transformUpdates;
+  }
+}
 
+const SceneDrawStats &Scene::drawStats(SceneView view) const {
+  return mDrawLists[(int)view].stats;
 }
 
 void Scene::submit(
@@ -23,8 +91,10 @@ void Scene::submit(
   const PlanetRenderer &planet,
   const Clipping &clipping,
   TerrainRenderer &terrainRenderer,
-  VulkanFrame &frame) {
+  VulkanFrame &frame,
+  SceneView view) {
   auto &commandBuffer = frame.primaryCommandBuffer;
+  const DrawList &list = mDrawLists[(int)view];
 
   commandBuffer.setViewport();
   commandBuffer.setScissor();
@@ -33,16 +103,45 @@ void Scene::submit(
     camera, planet, clipping
   };
 
-  // Need to sort this to remove the need to repeat calls to binding resources
-  for (int i = 0; i < mSceneObjects.size(); ++i) {
-    auto &sceneObj = mSceneObjects[i];
-    auto &renderMethod = mRenderMethods.getEntry(sceneObj.renderMethod);
+  // Draws are sorted (prepareDrawList) - only bind what changed
+  uint64_t previous = ~0ull;
+  for (uint32_t i = 0; i < list.batchCount; ++i) {
+    const DrawBatch &batch = list.batches[i];
+    DrawStateChange change = compareDrawKeys(batch.key, previous);
+
+    RenderMethodHandle method =
+      (batch.key >> DRAW_KEY_FIELD_BITS) & DRAW_KEY_FIELD_MASK;
+    auto &renderMethod = mRenderMethods.getEntry(method);
+
+    if (change.shader) {
+      renderMethod.bindShader(frame);
+    }
+
+    if (change.model) {
+      renderMethod.bindBuffers(frame);
+    }
+
+    if (renderMethod.isInstanced() && (change.model || change.renderMethod)) {
+      renderMethod.bindInstanceBuffer(frame, *mCurrentInstances);
+    }
+
+    // A new pipeline might not have a compatible layout - rebind the sets
+    if (change.shader || change.renderMethod) {
+      renderMethod.bindResources(frame, RESOURCES);
+    }
+
+    if (batch.instanceCount) {
+      renderMethod.submitInstanced(
+        frame, batch.instanceCount, batch.firstInstance);
+    }
+    else {
+      const auto &sceneObj = mSceneObjects[batch.key & DRAW_KEY_FIELD_MASK];
 
-    renderMethod.bindShader(frame);
-    renderMethod.bindBuffers(frame);
-    renderMethod.bindResources(frame, RESOURCES);
-    renderMethod.pushConstant(frame, sceneObj);
-    renderMethod.submit(frame);
+      renderMethod.pushConstant(frame, sceneObj);
+      renderMethod.submit(frame);
+    }
+
+    previous = batch.key;
   }
 
   if (debug.wireframeTerrain) {
@@ -76,6 +175,9 @@ SceneObjectHandle Scene::createSceneObject(const char *renderMethod) {
   auto handle = (SceneObjectHandle)mSceneObjects.add();
   mSceneObjects[handle].isInitialised = true;
   mSceneObjects[handle].renderMethod = mRenderMethods.getHandle(renderMethod);
+  // Gets into the BVH once its transform gets built
+  transforms.reset(handle);
+  ++mObjectCount;
   return handle;
 }
 
@@ -83,6 +185,12 @@ void Scene::destroySceneObject(SceneObjectHandle handle) {
   assert(handle != SCENE_OBJECT_HANDLE_INVALID);
   mSceneObjects[handle].isInitialised = false;
   mSceneObjects.remove(handle);
+  --mObjectCount;
+
+  if (mObjectProxies[handle] != SceneBVH::INVALID_PROXY) {
+    mBVH.destroyProxy(mObjectProxies[handle]);
+    mObjectProxies[handle] = SceneBVH::INVALID_PROXY;
+  }
 }
 
 SceneObject &Scene::getSceneObject(SceneObjectHandle handle) {
@@ -90,4 +198,149 @@ SceneObject &Scene::getSceneObject(SceneObjectHandle handle) {
   return mSceneObjects[handle];
 }
 
+uint32_t Scene::sceneObjectCount() const {
+  return mSceneObjects.size();
+}
+
+uint64_t Scene::makeDrawKey(
+  FastMapHandle shader, ModelHandle model,
+  RenderMethodHandle renderMethod, uint32_t object) {
+  assert(shader <= DRAW_KEY_FIELD_MASK && model <= DRAW_KEY_FIELD_MASK);
+  assert(renderMethod <= DRAW_KEY_FIELD_MASK);
+  assert(object <= DRAW_KEY_FIELD_MASK);
+
+  return ((uint64_t)shader << (DRAW_KEY_FIELD_BITS * 3)) |
+    ((uint64_t)model << (DRAW_KEY_FIELD_BITS * 2)) |
+    ((uint64_t)renderMethod << DRAW_KEY_FIELD_BITS) |
+    (uint64_t)object;
+}
+
+Scene::DrawStateChange Scene::compareDrawKeys(
+  uint64_t key, uint64_t previous) {
+  uint64_t changed = key ^ previous;
+
+  DrawStateChange change;
+  change.shader = (changed >> (DRAW_KEY_FIELD_BITS * 3)) != 0;
+  change.model = (changed >> (DRAW_KEY_FIELD_BITS * 2)) & DRAW_KEY_FIELD_MASK;
+  change.renderMethod = (changed >> DRAW_KEY_FIELD_BITS) & DRAW_KEY_FIELD_MASK;
+
+  return change;
+}
+
+void Scene::addVisibleObject(
+  uint32_t object, uint32_t viewMask, void *data) {
+  auto *scene = (Scene *)data;
+  const auto &sceneObj = scene->mSceneObjects[object];
+  const auto &renderMethod =
+    scene->mRenderMethods.getEntry(sceneObj.renderMethod);
+
+  uint64_t key = makeDrawKey(
+    renderMethod.shader(), renderMethod.model(), sceneObj.renderMethod, object);
+
+  while (viewMask) {
+    DrawList &list = scene->mDrawLists[lowestBit64(viewMask)];
+    list.keys[list.count++] = key;
+
+    viewMask &= viewMask - 1;
+  }
+}
+
+uint32_t Scene::updateTransforms() {
+  // Objects whose transform changes need their bounds refit afterwards
+  const uint64_t *dirty = transforms.dirtyBits();
+  mMovedObjects.size = 0;
+
+  for (uint32_t word = 0; word < transforms.dirtyWordCount(); ++word) {
+    for (uint64_t bits = dirty[word]; bits; bits &= bits - 1) {
+      mMovedObjects[mMovedObjects.size++] = word * 64 + lowestBit64(bits);
+    }
+  }
+
+  // Straight into the push constants (which the instance data comes from)
+  uint32_t updateCount = transforms.update(
+    &mSceneObjects[0].pushConstant.transform, sizeof(SceneObject));
+
+  for (int i = 0; i < mMovedObjects.size; ++i) {
+    uint32_t object = mMovedObjects[i];
+    const auto &sceneObj = mSceneObjects[object];
+
+    // Destroyed objects stay in the array until their slot gets reused
+    if (!sceneObj.isInitialised) {
+      continue;
+    }
+
+    const auto &renderMethod = mRenderMethods.getEntry(sceneObj.renderMethod);
+    const auto &model = mModelManager.getModel(renderMethod.model());
+    BoundingBox box = model.bounds().transform(sceneObj.pushConstant.transform);
+
+    if (mObjectProxies[object] == SceneBVH::INVALID_PROXY) {
+      mObjectProxies[object] = mBVH.createProxy(box, object);
+    }
+    else {
+      mBVH.moveProxy(mObjectProxies[object], box);
+    }
+  }
+
+  return updateCount;
+}
+
+void Scene::buildDrawBatches(
+  DrawList &list, SceneInstance *instances, uint32_t firstInstance) {
+  // Keys get added in BVH order - the object bits don't need sorting
+  list.sorted = radixSort(
+    list.keys.data, list.scratch.data, list.count,
+    DRAW_KEY_FIELD_BITS, 64);
+
+  /*
+     The instance data of a batch is where its objects are in the sorted
+     draws, so that every batch is contiguous in the instance buffer.
+  */
+  list.batchCount = 0;
+
+  for (uint32_t i = 0; i < list.count;) {
+    uint64_t key = list.sorted[i];
+    RenderMethodHandle method =
+      (key >> DRAW_KEY_FIELD_BITS) & DRAW_KEY_FIELD_MASK;
+
+    DrawBatch &batch = list.batches[list.batchCount++];
+    batch.key = key;
+    batch.firstInstance = firstInstance + i;
+    batch.instanceCount = 0;
+
+    if (!mRenderMethods.getEntry(method).isInstanced()) {
+      ++i;
+      continue;
+    }
+
+    uint64_t state = key >> DRAW_KEY_FIELD_BITS;
+    uint32_t first = i;
+
+    for (; i < list.count && list.sorted[i] >> DRAW_KEY_FIELD_BITS == state;
+         ++i) {
+      uint32_t object = list.sorted[i] & DRAW_KEY_FIELD_MASK;
+      const auto &sceneObj = mSceneObjects[object];
+
+      instances[i].transform = sceneObj.pushConstant.transform;
+      instances[i].color = glm::vec4(sceneObj.pushConstant.color, 1.0f);
+    }
+
+    batch.instanceCount = i - first;
+  }
+
+  list.stats = {};
+  list.stats.objectCount = list.count;
+  list.stats.drawCalls = list.batchCount;
+
+  uint64_t previous = ~0ull;
+  for (uint32_t i = 0; i < list.batchCount; ++i) {
+    DrawStateChange change = compareDrawKeys(list.batches[i].key, previous);
+
+    list.stats.shaderBinds += change.shader;
+    list.stats.bufferBinds += change.model;
+    list.stats.resourceBinds += change.shader || change.renderMethod;
+
+    previous = list.batches[i].key;
+  }
+}
+
 }
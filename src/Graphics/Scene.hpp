@@ -4,7 +4,9 @@
 #include "GBuffer.hpp"
 #include "Terrain.hpp"
 #include "Clipping.hpp"
+#include "SceneBVH.hpp"
 #include "SceneObject.hpp"
+#include "SceneTransforms.hpp"
 #include "DynamicArray.hpp"
 #include "ModelManager.hpp"
 #include "PlanetRenderer.hpp"
@@ -16,6 +18,24 @@ namespace Ondine::Graphics {
 using SceneObjectHandle = int32_t;
 constexpr SceneObjectHandle SCENE_OBJECT_HANDLE_INVALID = 0xFFFFFFFF;
 
+// Views the scene objects get culled for (each gets its own draw list)
+enum class SceneView {
+  Main,
+  WaterReflection,
+  Count
+};
+
+/* State changes needed to submit the last draw list of a view */
+struct SceneDrawStats {
+  uint32_t objectCount;
+  uint32_t culledCount;
+  uint32_t drawCalls;
+  uint32_t shaderBinds;
+  uint32_t bufferBinds;
+  uint32_t resourceBinds;
+  uint32_t transformUpdates;
+};
+
 struct SceneDebug {
   uint32_t renderChunkOutlines : 1;
   uint32_t renderQuadTree: 1;
@@ -25,18 +45,36 @@ struct SceneDebug {
 
 class Scene {
 public:
+  static constexpr uint32_t MAX_SCENE_OBJECTS_COUNT = 5000;
+
   Scene(ModelManager &modelManager, RenderMethodEntries &renderMethods);
 
   void init(
     const GBuffer &gbuffer,
     VulkanContext &graphicsContext);
 
+  /*
+     Rebuilds the transforms which changed (refitting their bounds in the
+     BVH) and culls the scene objects against every view in one go. The
+     visible objects of each view get sorted by shader, model and render
+     method so that submit only binds state when it changes. Objects of
+     instanced render methods get packed into the frame's instance buffer
+     and drawn in one call per render method / model. Needs to be called
+     once a frame before the scene gets submitted (which may then happen on
+     several threads at once).
+     Views holds a camera for each SceneView.
+  */
+  void prepareDrawList(
+    uint32_t frameInFlight, const CameraProperties *const *views);
+  const SceneDrawStats &drawStats(SceneView view = SceneView::Main) const;
+
   void submit(
     const Camera &camera,
     const PlanetRenderer &planet,
     const Clipping &clipping,
     TerrainRenderer &terrainRenderer,
-    VulkanFrame &frame);
+    VulkanFrame &frame,
+    SceneView view);
 
   void submitDebug(
     const Camera &camera,
@@ -49,18 +87,77 @@ public:
   void destroySceneObject(SceneObjectHandle handle);
 
   SceneObject &getSceneObject(SceneObjectHandle handle);
+  uint32_t sceneObjectCount() const;
 
 public:
   CameraProperties camera;
   LightingProperties lighting;
   Terrain terrain;
   SceneDebug debug;
+  // Indexed by scene object handle
+  SceneTransforms transforms;
 
 private:
-  static constexpr uint32_t MAX_SCENE_OBJECTS_COUNT = 5000;
+  /*
+     Draw key layout (from the most significant bits): shader, model,
+     render method, scene object index - 16 bits each.
+  */
+  static constexpr uint32_t DRAW_KEY_FIELD_BITS = 16;
+  static constexpr uint64_t DRAW_KEY_FIELD_MASK = 0xFFFF;
+
+  struct DrawStateChange {
+    bool shader;
+    bool model;
+    bool renderMethod;
+  };
 
+  // Consecutive draw keys with the same state make up an instanced batch
+  struct DrawBatch {
+    uint64_t key;
+    uint32_t firstInstance;
+    // 0 if the object gets drawn on its own (with the push constant)
+    uint32_t instanceCount;
+  };
+
+  struct DrawList {
+    Array<uint64_t> keys;
+    Array<uint64_t> scratch;
+    // Points into either of the above (wherever the sort left the keys)
+    uint64_t *sorted;
+    uint32_t count;
+    Array<DrawBatch> batches;
+    uint32_t batchCount;
+    SceneDrawStats stats;
+  };
+
+  static uint64_t makeDrawKey(
+    FastMapHandle shader, ModelHandle model,
+    RenderMethodHandle renderMethod, uint32_t object);
+  static DrawStateChange compareDrawKeys(uint64_t key, uint64_t previous);
+  static void addVisibleObject(uint32_t object, uint32_t viewMask, void *data);
+
+  // Returns the number of transforms which got rebuilt
+  uint32_t updateTransforms();
+  void buildDrawBatches(
+    DrawList &list, SceneInstance *instances, uint32_t firstInstance);
+
+private:
   DynamicArray<SceneObject> mSceneObjects;
 
+  uint32_t mObjectCount;
+
+  SceneBVH mBVH;
+  // Leaf of each scene object (indexed by handle)
+  Array<int32_t> mObjectProxies;
+  Array<uint32_t> mMovedObjects;
+
+  DrawList mDrawLists[(int)SceneView::Count];
+
+  // One per frame in flight, with a range for each view (persistently mapped)
+  Array<VulkanBuffer> mInstanceBuffers;
+  Array<SceneInstance *> mMappedInstances;
+  const VulkanBuffer *mCurrentInstances;
+
   ModelManager &mModelManager;
   RenderMethodEntries &mRenderMethods;
 };
@@ -0,0 +1,394 @@
+#include <assert.h>
+#include "Utils.hpp"
+#include "SceneBVH.hpp"
+
+namespace Ondine::Graphics {
+
+BoundingBox BoundingBox::transform(const glm::mat4 &transform) const {
+  glm::vec3 center = (min + max) * 0.5f;
+  glm::vec3 extent = (max - min) * 0.5f;
+
+  glm::vec3 newCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+  glm::vec3 newExtent = glm::vec3(0.0f);
+
+  // Each axis of the new box gets the absolute contribution of the old ones
+  for (int i = 0; i < 3; ++i) {
+    newExtent += glm::abs(glm::vec3(transform[i])) * extent[i];
+  }
+
+  return {newCenter - newExtent, newCenter + newExtent};
+}
+
+float BoundingBox::surfaceArea() const {
+  glm::vec3 size = max - min;
+  return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+bool BoundingBox::contains(const BoundingBox &other) const {
+  return
+    glm::all(glm::lessThanEqual(min, other.min)) &&
+    glm::all(glm::greaterThanEqual(max, other.max));
+}
+
+BoundingBox BoundingBox::merge(const BoundingBox &a, const BoundingBox &b) {
+  return {glm::min(a.min, b.min), glm::max(a.max, b.max)};
+}
+
+void Frustum::init(const glm::mat4 &viewProjection) {
+  glm::vec4 rows[4];
+  for (int i = 0; i < 4; ++i) {
+    rows[i] = glm::vec4(
+      viewProjection[0][i], viewProjection[1][i],
+      viewProjection[2][i], viewProjection[3][i]);
+  }
+
+  // Near plane assumes -w < z (also conservative for 0 < z)
+  planes[0] = rows[3] + rows[0];
+  planes[1] = rows[3] - rows[0];
+  planes[2] = rows[3] + rows[1];
+  planes[3] = rows[3] - rows[1];
+  planes[4] = rows[3] + rows[2];
+  planes[5] = rows[3] - rows[2];
+}
+
+enum class FrustumTest {
+  Outside,
+  Intersecting,
+  Inside
+};
+
+static FrustumTest testBox(const Frustum &frustum, const BoundingBox &box) {
+  FrustumTest result = FrustumTest::Inside;
+
+  for (int i = 0; i < 6; ++i) {
+    const glm::vec4 &plane = frustum.planes[i];
+    glm::vec3 normal = glm::vec3(plane);
+
+    // Corners furthest along / against the normal
+    glm::vec3 positive = glm::mix(
+      box.min, box.max, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+    glm::vec3 negative = glm::mix(
+      box.max, box.min, glm::greaterThanEqual(normal, glm::vec3(0.0f)));
+
+    if (glm::dot(normal, positive) + plane.w < 0.0f) {
+      return FrustumTest::Outside;
+    }
+
+    if (glm::dot(normal, negative) + plane.w < 0.0f) {
+      result = FrustumTest::Intersecting;
+    }
+  }
+
+  return result;
+}
+
+SceneBVH::SceneBVH()
+  : mRoot(INVALID_PROXY),
+    mFreeList(INVALID_PROXY) {
+
+}
+
+void SceneBVH::init(uint32_t maxObjectCount) {
+  // Leaves and the nodes above them
+  mNodes.init(maxObjectCount * 2);
+  mNodes.size = mNodes.capacity;
+
+  for (int i = 0; i < mNodes.size; ++i) {
+    mNodes[i].parent = i + 1 < mNodes.size ? i + 1 : INVALID_PROXY;
+    mNodes[i].height = -1;
+  }
+
+  mRoot = INVALID_PROXY;
+  mFreeList = 0;
+}
+
+int32_t SceneBVH::createProxy(const BoundingBox &box, uint32_t object) {
+  int32_t proxy = allocateNode();
+  Node &node = mNodes[proxy];
+
+  glm::vec3 margin = (box.max - box.min) * FAT_MARGIN;
+  node.box = {box.min - margin, box.max + margin};
+  node.object = object;
+  node.height = 0;
+
+  insertLeaf(proxy);
+
+  return proxy;
+}
+
+void SceneBVH::destroyProxy(int32_t proxy) {
+  assert(mNodes[proxy].isLeaf());
+
+  removeLeaf(proxy);
+  freeNode(proxy);
+}
+
+bool SceneBVH::moveProxy(int32_t proxy, const BoundingBox &box) {
+  assert(mNodes[proxy].isLeaf());
+
+  if (mNodes[proxy].box.contains(box)) {
+    return false;
+  }
+
+  removeLeaf(proxy);
+
+  glm::vec3 margin = (box.max - box.min) * FAT_MARGIN;
+  mNodes[proxy].box = {box.min - margin, box.max + margin};
+
+  insertLeaf(proxy);
+
+  return true;
+}
+
+void SceneBVH::query(
+  const Frustum *views, uint32_t viewCount,
+  BVHQueryProc proc, void *data) const {
+  assert(viewCount <= MAX_VIEW_COUNT);
+
+  if (mRoot == INVALID_PROXY) {
+    return;
+  }
+
+  struct StackEntry {
+    int32_t node;
+    // Views which can see (part of) the node
+    uint32_t viewMask;
+    // Views which see the node entirely - no need to test the children
+    uint32_t insideMask;
+  };
+
+  StackEntry stack[MAX_QUERY_DEPTH];
+  uint32_t stackSize = 0;
+
+  stack[stackSize++] = {mRoot, (1u << viewCount) - 1, 0};
+
+  while (stackSize) {
+    StackEntry entry = stack[--stackSize];
+    const Node &node = mNodes[entry.node];
+
+    uint32_t untested = entry.viewMask & ~entry.insideMask;
+    while (untested) {
+      uint32_t view = lowestBit64(untested);
+      untested &= untested - 1;
+
+      switch (testBox(views[view], node.box)) {
+      case FrustumTest::Outside: {
+        entry.viewMask &= ~(1u << view);
+      } break;
+
+      case FrustumTest::Inside: {
+        entry.insideMask |= 1u << view;
+      } break;
+
+      default: break;
+      }
+    }
+
+    if (!entry.viewMask) {
+      continue;
+    }
+
+    if (node.isLeaf()) {
+      proc(node.object, entry.viewMask, data);
+    }
+    else {
+      assert(stackSize + 2 <= MAX_QUERY_DEPTH);
+
+      stack[stackSize++] = {node.children[0], entry.viewMask, entry.insideMask};
+      stack[stackSize++] = {node.children[1], entry.viewMask, entry.insideMask};
+    }
+  }
+}
+
+uint32_t SceneBVH::height() const {
+  return mRoot == INVALID_PROXY ? 0 : mNodes[mRoot].height;
+}
+
+int32_t SceneBVH::allocateNode() {
+  assert(mFreeList != INVALID_PROXY);
+
+  int32_t node = mFreeList;
+  mFreeList = mNodes[node].parent;
+
+  mNodes[node].parent = INVALID_PROXY;
+  mNodes[node].children[0] = INVALID_PROXY;
+  mNodes[node].children[1] = INVALID_PROXY;
+  mNodes[node].height = 0;
+
+  return node;
+}
+
+void SceneBVH::freeNode(int32_t node) {
+  mNodes[node].parent = mFreeList;
+  mNodes[node].height = -1;
+  mFreeList = node;
+}
+
+void SceneBVH::insertLeaf(int32_t leaf) {
+  if (mRoot == INVALID_PROXY) {
+    mRoot = leaf;
+    mNodes[leaf].parent = INVALID_PROXY;
+    return;
+  }
+
+  const BoundingBox &box = mNodes[leaf].box;
+
+  // Find the sibling which makes the tree's surface area grow the least
+  int32_t index = mRoot;
+  while (!mNodes[index].isLeaf()) {
+    const Node &node = mNodes[index];
+
+    float area = node.box.surfaceArea();
+    float combinedArea = BoundingBox::merge(node.box, box).surfaceArea();
+
+    // Making a new parent for this node and the leaf
+    float cost = 2.0f * combinedArea;
+    // Every ancestor grows if the leaf goes further down
+    float inheritedCost = 2.0f * (combinedArea - area);
+
+    float childCosts[2];
+    for (int i = 0; i < 2; ++i) {
+      const Node &child = mNodes[node.children[i]];
+      float mergedArea = BoundingBox::merge(child.box, box).surfaceArea();
+
+      childCosts[i] = inheritedCost +
+        (child.isLeaf() ? mergedArea : mergedArea - child.box.surfaceArea());
+    }
+
+    if (cost < childCosts[0] && cost < childCosts[1]) {
+      break;
+    }
+
+    index = childCosts[0] < childCosts[1] ?
+      node.children[0] : node.children[1];
+  }
+
+  int32_t sibling = index;
+  int32_t oldParent = mNodes[sibling].parent;
+  int32_t newParent = allocateNode();
+
+  mNodes[newParent].parent = oldParent;
+  mNodes[newParent].box = BoundingBox::merge(box, mNodes[sibling].box);
+  mNodes[newParent].height = mNodes[sibling].height + 1;
+  mNodes[newParent].children[0] = sibling;
+  mNodes[newParent].children[1] = leaf;
+
+  if (oldParent != INVALID_PROXY) {
+    Node &parent = mNodes[oldParent];
+    parent.children[parent.children[0] == sibling ? 0 : 1] = newParent;
+  }
+  else {
+    mRoot = newParent;
+  }
+
+  mNodes[sibling].parent = newParent;
+  mNodes[leaf].parent = newParent;
+
+  refit(oldParent);
+}
+
+void SceneBVH::removeLeaf(int32_t leaf) {
+  if (leaf == mRoot) {
+    mRoot = INVALID_PROXY;
+    return;
+  }
+
+  int32_t parent = mNodes[leaf].parent;
+  int32_t grandParent = mNodes[parent].parent;
+  int32_t sibling = mNodes[parent].children[0] == leaf ?
+    mNodes[parent].children[1] : mNodes[parent].children[0];
+
+  // The sibling takes the parent's place
+  if (grandParent != INVALID_PROXY) {
+    Node &node = mNodes[grandParent];
+    node.children[node.children[0] == parent ? 0 : 1] = sibling;
+    mNodes[sibling].parent = grandParent;
+  }
+  else {
+    mRoot = sibling;
+    mNodes[sibling].parent = INVALID_PROXY;
+  }
+
+  freeNode(parent);
+  refit(grandParent);
+}
+
+void SceneBVH::refit(int32_t index) {
+  while (index != INVALID_PROXY) {
+    index = balance(index);
+
+    Node &node = mNodes[index];
+    const Node &child0 = mNodes[node.children[0]];
+    const Node &child1 = mNodes[node.children[1]];
+
+    node.height = 1 + MAX(child0.height, child1.height);
+    node.box = BoundingBox::merge(child0.box, child1.box);
+
+    index = node.parent;
+  }
+}
+
+int32_t SceneBVH::balance(int32_t a) {
+  Node &nodeA = mNodes[a];
+  if (nodeA.isLeaf() || nodeA.height < 2) {
+    return a;
+  }
+
+  int32_t b = nodeA.children[0];
+  int32_t c = nodeA.children[1];
+  Node &nodeB = mNodes[b];
+  Node &nodeC = mNodes[c];
+
+  int32_t difference = nodeC.height - nodeB.height;
+
+  /*
+     The heavier child (up) takes A's place, A takes the lighter grandchild's
+     place and the heavier grandchild stays under up.
+  */
+  if (difference > 1 || difference < -1) {
+    int32_t up = difference > 1 ? c : b;
+    int32_t stay = difference > 1 ? b : c;
+    // Index in A of the child which moves up
+    int upSlot = difference > 1 ? 1 : 0;
+
+    Node &nodeUp = mNodes[up];
+    int32_t f = nodeUp.children[0];
+    int32_t g = nodeUp.children[1];
+
+    nodeUp.children[0] = a;
+    nodeUp.parent = nodeA.parent;
+    nodeA.parent = up;
+
+    if (nodeUp.parent != INVALID_PROXY) {
+      Node &parent = mNodes[nodeUp.parent];
+      parent.children[parent.children[0] == a ? 0 : 1] = up;
+    }
+    else {
+      mRoot = up;
+    }
+
+    // Heavier grandchild stays with up, the other one goes to A
+    if (mNodes[f].height < mNodes[g].height) {
+      int32_t swap = f;
+      f = g;
+      g = swap;
+    }
+
+    nodeUp.children[1] = f;
+    nodeA.children[upSlot] = g;
+    mNodes[g].parent = a;
+
+    const Node &nodeStay = mNodes[stay];
+    nodeA.box = BoundingBox::merge(nodeStay.box, mNodes[g].box);
+    nodeA.height = 1 + MAX(nodeStay.height, mNodes[g].height);
+
+    nodeUp.box = BoundingBox::merge(nodeA.box, mNodes[f].box);
+    nodeUp.height = 1 + MAX(nodeA.height, mNodes[f].height);
+
+    return up;
+  }
+
+  return a;
+}
+
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <stdint.h>
+#include "Buffer.hpp"
+#include <glm/glm.hpp>
+
+namespace Ondine::Graphics {
+
+struct BoundingBox {
+  glm::vec3 min;
+  glm::vec3 max;
+
+  // Box around this box after getting transformed
+  BoundingBox transform(const glm::mat4 &transform) const;
+  float surfaceArea() const;
+  bool contains(const BoundingBox &other) const;
+
+  static BoundingBox merge(const BoundingBox &a, const BoundingBox &b);
+};
+
+/* Planes get extracted from the view projection (normals point inwards) */
+struct Frustum {
+  glm::vec4 planes[6];
+
+  void init(const glm::mat4 &viewProjection);
+};
+
+/*
+   Gets called once for each object which at least one view can see.
+   Bit i of viewMask is set if view i can see the object.
+*/
+using BVHQueryProc = void (*)(uint32_t object, uint32_t viewMask, void *data);
+
+/*
+   Dynamic bounding volume hierarchy over the scene objects. Leaves hold a
+   slightly bigger box than the object so that small movements don't change
+   the tree - the leaf only gets reinserted once the object leaves it.
+   Inserting picks the sibling which increases the surface area the least and
+   rotations keep the tree balanced.
+*/
+class SceneBVH {
+public:
+  static constexpr int32_t INVALID_PROXY = -1;
+  static constexpr uint32_t MAX_VIEW_COUNT = 8;
+
+  SceneBVH();
+
+  void init(uint32_t maxObjectCount);
+
+  int32_t createProxy(const BoundingBox &box, uint32_t object);
+  void destroyProxy(int32_t proxy);
+  // Returns true if the leaf had to get reinserted
+  bool moveProxy(int32_t proxy, const BoundingBox &box);
+
+  /*
+     Culls against all the views in a single traversal. Views for which a
+     node is completely inside the frustum don't get tested further down.
+  */
+  void query(
+    const Frustum *views, uint32_t viewCount,
+    BVHQueryProc proc, void *data) const;
+
+  uint32_t height() const;
+
+private:
+  struct Node {
+    BoundingBox box;
+    // Next free node if the node is free
+    int32_t parent;
+    int32_t children[2];
+    // Leaves are 0, free nodes -1
+    int32_t height;
+    uint32_t object;
+
+    inline bool isLeaf() const {
+      return children[0] == INVALID_PROXY;
+    }
+  };
+
+  int32_t allocateNode();
+  void freeNode(int32_t node);
+  void insertLeaf(int32_t leaf);
+  void removeLeaf(int32_t leaf);
+  // Walks up from node, balancing and refitting the ancestors
+  void refit(int32_t node);
+  int32_t balance(int32_t node);
+
+private:
+  // Fraction of the object's size which gets added on each side
+  static constexpr float FAT_MARGIN = 0.1f;
+  static constexpr uint32_t MAX_QUERY_DEPTH = 64;
+
+  Array<Node> mNodes;
+  int32_t mRoot;
+  int32_t mFreeList;
+};
+
+}
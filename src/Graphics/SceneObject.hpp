@@ -12,6 +12,12 @@ using SceneObjectPushConstantProc = void (*)(
   const VulkanFrame &frame,
   struct SceneObject *obj);
 
+/* Vertex data of objects drawn with an instanced render method */
+struct SceneInstance {
+  glm::mat4 transform;
+  glm::vec4 color;
+};
+
 struct SceneObject {
   union {
     uint32_t flagBits;
@@ -20,23 +26,14 @@ struct SceneObject {
     };
   };
 
-  glm::vec3 position;
-  glm::quat rotation;
-  glm::vec3 scale;
-
   // Named for push constant
   struct {
+    // Written by SceneTransforms::update (set the transform through the scene)
     glm::mat4 transform;
     glm::vec3 color;
   } pushConstant;
 
   RenderMethodHandle renderMethod;
-
-  inline void constructTransform() {
-    pushConstant.transform = glm::translate(position) *
-      glm::mat4_cast(rotation) *
-      glm::scale(scale);
-  }
 };
 
 }
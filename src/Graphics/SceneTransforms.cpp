@@ -0,0 +1,275 @@
+#include <assert.h>
+#include "Utils.hpp"
+#include "ThreadPool.hpp"
+#include "SceneTransforms.hpp"
+#include <glm/gtx/transform.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define TRANSFORMS_USE_SSE
+#endif
+
+namespace Ondine::Graphics {
+
+SceneTransforms::SceneTransforms()
+  : mCapacity(0),
+    mHighWater(0) {
+
+}
+
+void SceneTransforms::init(uint32_t capacity) {
+  mCapacity = capacity;
+  mHighWater = 0;
+
+  uint32_t wordCount = (capacity + 63) / 64;
+
+  for (int i = 0; i < StreamCount; ++i) {
+    mStreams[i].init(wordCount * 64);
+    mStreams[i].size = wordCount * 64;
+    mStreams[i].zero();
+  }
+
+  mDirty.init(wordCount);
+  mDirty.size = wordCount;
+  mDirty.zero();
+}
+
+void SceneTransforms::reset(uint32_t handle) {
+  set(
+    handle, glm::vec3(0.0f),
+    glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f));
+}
+
+void SceneTransforms::set(
+  uint32_t handle,
+  const glm::vec3 &position,
+  const glm::quat &rotation,
+  const glm::vec3 &scale) {
+  setPosition(handle, position);
+  setRotation(handle, rotation);
+  setScale(handle, scale);
+}
+
+void SceneTransforms::setPosition(
+  uint32_t handle, const glm::vec3 &position) {
+  mStreams[PositionX][handle] = position.x;
+  mStreams[PositionY][handle] = position.y;
+  mStreams[PositionZ][handle] = position.z;
+  markDirty(handle);
+}
+
+void SceneTransforms::setRotation(
+  uint32_t handle, const glm::quat &rotation) {
+  mStreams[RotationX][handle] = rotation.x;
+  mStreams[RotationY][handle] = rotation.y;
+  mStreams[RotationZ][handle] = rotation.z;
+  mStreams[RotationW][handle] = rotation.w;
+  markDirty(handle);
+}
+
+void SceneTransforms::setScale(uint32_t handle, const glm::vec3 &scale) {
+  mStreams[ScaleX][handle] = scale.x;
+  mStreams[ScaleY][handle] = scale.y;
+  mStreams[ScaleZ][handle] = scale.z;
+  markDirty(handle);
+}
+
+glm::vec3 SceneTransforms::position(uint32_t handle) const {
+  return glm::vec3(
+    mStreams[PositionX][handle],
+    mStreams[PositionY][handle],
+    mStreams[PositionZ][handle]);
+}
+
+glm::quat SceneTransforms::rotation(uint32_t handle) const {
+  return glm::quat(
+    mStreams[RotationW][handle],
+    mStreams[RotationX][handle],
+    mStreams[RotationY][handle],
+    mStreams[RotationZ][handle]);
+}
+
+glm::vec3 SceneTransforms::scale(uint32_t handle) const {
+  return glm::vec3(
+    mStreams[ScaleX][handle],
+    mStreams[ScaleY][handle],
+    mStreams[ScaleZ][handle]);
+}
+
+bool SceneTransforms::isDirty(uint32_t handle) const {
+  return (mDirty[handle / 64] >> (handle % 64)) & 1;
+}
+
+const uint64_t *SceneTransforms::dirtyBits() const {
+  return mDirty.data;
+}
+
+uint32_t SceneTransforms::dirtyWordCount() const {
+  return (mHighWater + 63) / 64;
+}
+
+uint32_t SceneTransforms::update(glm::mat4 *transforms, size_t stride) {
+  uint32_t wordCount = dirtyWordCount();
+
+  if (wordCount <= WORDS_PER_JOB) {
+    return updateWords(0, wordCount, (uint8_t *)transforms, stride);
+  }
+
+  UpdateJob job;
+  job.transforms = this;
+  job.output = (uint8_t *)transforms;
+  job.stride = stride;
+  job.wordCount = wordCount;
+  job.updatedCount = 0;
+
+  Core::gThreadPool->parallelFor(
+    (wordCount + WORDS_PER_JOB - 1) / WORDS_PER_JOB, runUpdateJob, &job);
+
+  return job.updatedCount;
+}
+
+void SceneTransforms::runUpdateJob(uint32_t index, void *data) {
+  auto *job = (UpdateJob *)data;
+
+  uint32_t firstWord = index * WORDS_PER_JOB;
+  uint32_t endWord = MIN(firstWord + WORDS_PER_JOB, job->wordCount);
+
+  uint32_t updatedCount = job->transforms->updateWords(
+    firstWord, endWord, job->output, job->stride);
+
+  job->updatedCount += updatedCount;
+}
+
+uint32_t SceneTransforms::updateWords(
+  uint32_t firstWord, uint32_t endWord, uint8_t *output, size_t stride) {
+  float *streams[StreamCount];
+  for (int i = 0; i < StreamCount; ++i) {
+    streams[i] = mStreams[i].data;
+  }
+
+  uint32_t updatedCount = 0;
+
+  // Jobs never share words - no need for atomics on the bitset
+  for (uint32_t word = firstWord; word < endWord; ++word) {
+    uint64_t bits = mDirty[word];
+    if (!bits) {
+      continue;
+    }
+
+    mDirty[word] = 0;
+    updatedCount += popCount64(bits);
+
+    while (bits) {
+      // Groups of 4 lanes (aligned, so they never straddle words)
+      uint32_t lane = lowestBit64(bits) & ~3u;
+      uint32_t lanes = (bits >> lane) & 0xF;
+
+      buildTransforms(streams, word * 64 + lane, lanes, output, stride);
+
+      bits &= ~(0xFull << lane);
+    }
+  }
+
+  return updatedCount;
+}
+
+void SceneTransforms::buildTransforms(
+  float *const *streams, uint32_t base, uint32_t lanes,
+  uint8_t *output, size_t stride) {
+#ifdef TRANSFORMS_USE_SSE
+  __m128 x = _mm_loadu_ps(streams[RotationX] + base);
+  __m128 y = _mm_loadu_ps(streams[RotationY] + base);
+  __m128 z = _mm_loadu_ps(streams[RotationZ] + base);
+  __m128 w = _mm_loadu_ps(streams[RotationW] + base);
+
+  __m128 one = _mm_set1_ps(1.0f);
+  __m128 two = _mm_set1_ps(2.0f);
+
+  __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+  __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+  __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+  __m128 sx = _mm_loadu_ps(streams[ScaleX] + base);
+  __m128 sy = _mm_loadu_ps(streams[ScaleY] + base);
+  __m128 sz = _mm_loadu_ps(streams[ScaleZ] + base);
+
+  // Same as glm::mat4_cast, each column scaled
+  __m128 columns[4][4];
+
+  columns[0][0] = _mm_mul_ps(
+    _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+  columns[0][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+  columns[0][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+  columns[0][3] = _mm_setzero_ps();
+
+  columns[1][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+  columns[1][1] = _mm_mul_ps(
+    _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+  columns[1][2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+  columns[1][3] = _mm_setzero_ps();
+
+  columns[2][0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+  columns[2][1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+  columns[2][2] = _mm_mul_ps(
+    _mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+  columns[2][3] = _mm_setzero_ps();
+
+  columns[3][0] = _mm_loadu_ps(streams[PositionX] + base);
+  columns[3][1] = _mm_loadu_ps(streams[PositionY] + base);
+  columns[3][2] = _mm_loadu_ps(streams[PositionZ] + base);
+  columns[3][3] = one;
+
+  // Lane i of every column now holds the column of object base + i
+  for (int i = 0; i < 4; ++i) {
+    _MM_TRANSPOSE4_PS(
+      columns[i][0], columns[i][1], columns[i][2], columns[i][3]);
+  }
+
+  for (int i = 0; i < 4; ++i) {
+    if (lanes & (1 << i)) {
+      float *transform = (float *)(output + (base + i) * stride);
+
+      _mm_storeu_ps(transform, columns[0][i]);
+      _mm_storeu_ps(transform + 4, columns[1][i]);
+      _mm_storeu_ps(transform + 8, columns[2][i]);
+      _mm_storeu_ps(transform + 12, columns[3][i]);
+    }
+  }
+#else
+  for (int i = 0; i < 4; ++i) {
+    if (lanes & (1 << i)) {
+      uint32_t index = base + i;
+
+      glm::vec3 position = {
+        streams[PositionX][index],
+        streams[PositionY][index],
+        streams[PositionZ][index]
+      };
+
+      glm::quat rotation = glm::quat(
+        streams[RotationW][index], streams[RotationX][index],
+        streams[RotationY][index], streams[RotationZ][index]);
+
+      glm::vec3 scale = {
+        streams[ScaleX][index],
+        streams[ScaleY][index],
+        streams[ScaleZ][index]
+      };
+
+      *(glm::mat4 *)(output + index * stride) =
+        glm::translate(position) *
+        glm::mat4_cast(rotation) *
+        glm::scale(scale);
+    }
+  }
+#endif
+}
+
+void SceneTransforms::markDirty(uint32_t handle) {
+  assert(handle < mCapacity);
+
+  mDirty[handle / 64] |= 1ull << (handle % 64);
+  mHighWater = MAX(mHighWater, handle + 1);
+}
+
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include "Buffer.hpp"
+#include <glm/glm.hpp>
+#include <glm/gtx/quaternion.hpp>
+
+namespace Ondine::Graphics {
+
+/*
+   Position, rotation and scale of the scene objects, stored as separate
+   float streams and indexed by scene object handle. Setting any of them
+   marks the object dirty - update then only rebuilds the transforms
+   (translate * rotate * scale) of the dirty objects, 4 at a time with SSE
+   and spread over the job system when there are enough of them.
+*/
+class SceneTransforms {
+public:
+  SceneTransforms();
+
+  void init(uint32_t capacity);
+
+  // Identity transform, marked dirty
+  void reset(uint32_t handle);
+
+  void set(
+    uint32_t handle,
+    const glm::vec3 &position,
+    const glm::quat &rotation,
+    const glm::vec3 &scale);
+  void setPosition(uint32_t handle, const glm::vec3 &position);
+  void setRotation(uint32_t handle, const glm::quat &rotation);
+  void setScale(uint32_t handle, const glm::vec3 &scale);
+
+  glm::vec3 position(uint32_t handle) const;
+  glm::quat rotation(uint32_t handle) const;
+  glm::vec3 scale(uint32_t handle) const;
+  bool isDirty(uint32_t handle) const;
+  // Bit i of word i / 64 is set if object i is dirty
+  const uint64_t *dirtyBits() const;
+  uint32_t dirtyWordCount() const;
+
+  /*
+     Writes the transform of every dirty object to
+     (uint8_t *)transforms + handle * stride (so it can go straight into an
+     array of structs) and clears the dirty bits. Returns the number of
+     transforms which got rebuilt.
+  */
+  uint32_t update(glm::mat4 *transforms, size_t stride = sizeof(glm::mat4));
+
+private:
+  enum Stream {
+    PositionX, PositionY, PositionZ,
+    RotationX, RotationY, RotationZ, RotationW,
+    ScaleX, ScaleY, ScaleZ,
+    StreamCount
+  };
+
+  struct UpdateJob {
+    SceneTransforms *transforms;
+    uint8_t *output;
+    size_t stride;
+    uint32_t wordCount;
+    std::atomic<uint32_t> updatedCount;
+  };
+
+  static void runUpdateJob(uint32_t index, void *data);
+  /*
+     Rebuilds the transforms of the 4 objects starting at base. Only the
+     lanes which are set get written.
+  */
+  static void buildTransforms(
+    float *const *streams, uint32_t base, uint32_t lanes,
+    uint8_t *output, size_t stride);
+
+  uint32_t updateWords(
+    uint32_t firstWord, uint32_t endWord, uint8_t *output, size_t stride);
+  void markDirty(uint32_t handle);
+
+private:
+  // Each job takes care of 1024 objects
+  static constexpr uint32_t WORDS_PER_JOB = 16;
+
+  uint32_t mCapacity;
+  // One past the highest handle which was ever used
+  uint32_t mHighWater;
+  // Capacity gets rounded up to 64 so the kernel can always load 4 lanes
+  Array<float> mStreams[StreamCount];
+  Array<uint64_t> mDirty;
+};
+
+}
@@ -1,4 +1,5 @@
 #include <math.h>
+#include "AsyncIO.hpp"
 #include "FileSystem.hpp"
 #include "SkyRenderer.hpp"
 #include "VulkanContext.hpp"
@@ -10,7 +11,12 @@ namespace Ondine::Graphics {
 void SkyRenderer::init(
   VulkanContext &graphicsContext,
   const RenderStage &renderStage) {
-  mCache = false;
+  mIsCacheLoadFailed = false;
+  mGraphicsContext = &graphicsContext;
+
+  for (auto &transfer : mCacheTransfers) {
+    transfer.state = CacheTransferState::None;
+  }
 
   initSkyProperties(graphicsContext);
 
@@ -22,6 +28,12 @@ void SkyRenderer::init(
 
     preparePrecompute(graphicsContext);
     precompute(graphicsContext);
+
+    // Gets written out in the background
+    if (graphicsContext.device().deviceType() != DeviceType::DiscreteGPU) {
+      LOG_INFO("Saving sky precomputations into cache\n");
+      saveToCache(graphicsContext);
+    }
   }
   else {
     LOG_INFO("Found cached sky precomputations\n");
@@ -39,19 +51,29 @@ void SkyRenderer::init(
 }
 
 void SkyRenderer::shutdown(VulkanContext &graphicsContext) {
-  if (!Core::gFileSystem->isPathValid(
-        (Core::MountPoint)Core::ApplicationMountPoints::Application,
-        SKY_CACHE_DIRECTORY)) {
-    Core::gFileSystem->makeDirectory(
-      (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      SKY_CACHE_DIRECTORY);
-  }
+  // Cache writes which are still going need to get to the disk
+  finishCacheTransfers(true);
+}
 
-  if (mCache) {
-    LOG_INFO("Did sky precomputations during session - saving into cache\n");
+void SkyRenderer::sync(VulkanContext &graphicsContext) {
+  /*
+     Cache reads which haven't completed yet get waited on - the textures
+     are needed for this frame. Normally, the reads are done way before
+     initialisation finishes.
+  */
+  finishCacheTransfers(false);
+
+  if (mIsCacheLoadFailed) {
+    finishCacheTransfers(true);
+    mIsCacheLoadFailed = false;
+
+    LOG_WARNING("Couldn't load sky cache - precomputing sky textures\n");
+    preparePrecompute(graphicsContext);
+    precompute(graphicsContext);
 
-    if (graphicsContext.device().deviceType() != DeviceType::DiscreteGPU)
+    if (graphicsContext.device().deviceType() != DeviceType::DiscreteGPU) {
       saveToCache(graphicsContext);
+    }
   }
 }
 
@@ -100,11 +122,10 @@ void SkyRenderer::initSkyProperties(VulkanContext &graphicsContext) {
   mSkyPropertiesBuffer.init(
     graphicsContext.device(),
     sizeof(PlanetProperties),
-    (int)VulkanBufferFlag::UniformBuffer);
+    VulkanBufferFlag::UniformBuffer | VulkanBufferFlag::UploadTarget);
 
   mSkyPropertiesBuffer.fillWithStaging(
     graphicsContext.device(),
-    graphicsContext.commandPool(),
     {(uint8_t *)&mSkyProperties, sizeof(mSkyProperties)});
 
   mSkyPropertiesUniform.init(
@@ -173,18 +194,16 @@ void SkyRenderer::initTemporaryPrecomputeTextures(
 }
 
 void SkyRenderer::preparePrecompute(VulkanContext &graphicsContext) {
-  Core::File precomputeVshFile = Core::gFileSystem->createFile(
+  Core::FileMapping precomputeVshFile = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/SkyPrecompute.vert.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/SkyPrecompute.vert.spv");
 
-  Core::File precomputeGshFile = Core::gFileSystem->createFile(
+  Core::FileMapping precomputeGshFile = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/SkyPrecompute.geom.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/SkyPrecompute.geom.spv");
 
-  Buffer quadVsh = precomputeVshFile.readBinary();
-  Buffer quadGsh = precomputeGshFile.readBinary();
+  Buffer quadVsh = precomputeVshFile.view();
+  Buffer quadGsh = precomputeGshFile.view();
 
   initTemporaryPrecomputeTextures(graphicsContext);
 
@@ -216,12 +235,11 @@ void SkyRenderer::prepareTransmittancePrecompute(
   }
 
   { // Create pipeline
-    Core::File precomputeTransmittance = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeTransmittance = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/SkyTransmittance.frag.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+      "res/spv/SkyTransmittance.frag.spv");
 
-    Buffer fsh = precomputeTransmittance.readBinary();
+    Buffer fsh = precomputeTransmittance.view();
 
     VulkanPipelineConfig pipelineConfig(
       {mPrecomputeTransmittanceRenderPass, 0},
@@ -233,7 +251,7 @@ void SkyRenderer::prepareTransmittancePrecompute(
     pipelineConfig.configurePipelineLayout(
       0, VulkanPipelineDescriptorLayout{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1});
 
-    mPrecomputeTransmittancePipeline.init(
+    mPrecomputeTransmittancePipeline.initDeferred(
       graphicsContext.device(),
       graphicsContext.descriptorLayouts(),
       pipelineConfig);
@@ -280,12 +298,11 @@ void SkyRenderer::prepareSingleScatteringPrecompute(
   }
   
   { // Create pipeline
-    Core::File precomputeSingleScattering = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeSingleScattering = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/SkySingleScattering.frag.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+      "res/spv/SkySingleScattering.frag.spv");
 
-    Buffer fsh = precomputeSingleScattering.readBinary();
+    Buffer fsh = precomputeSingleScattering.view();
 
     VulkanPipelineConfig pipelineConfig(
       {mPrecomputeSingleScatteringRenderPass, 0},
@@ -303,7 +320,7 @@ void SkyRenderer::prepareSingleScatteringPrecompute(
       VulkanPipelineDescriptorLayout{
         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
 
-    mPrecomputeSingleScatteringPipeline.init(
+    mPrecomputeSingleScatteringPipeline.initDeferred(
       graphicsContext.device(),
       graphicsContext.descriptorLayouts(),
       pipelineConfig);
@@ -345,12 +362,11 @@ void SkyRenderer::prepareDirectIrradiancePrecompute(
   }
 
   { // Create pipeline (direct irradiance)
-    Core::File precomputeDirectIrradiance = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeDirectIrradiance = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/SkyDirectIrradiance.frag.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+      "res/spv/SkyDirectIrradiance.frag.spv");
 
-    Buffer fsh = precomputeDirectIrradiance.readBinary();
+    Buffer fsh = precomputeDirectIrradiance.view();
 
     VulkanPipelineConfig pipelineConfig(
       {mPrecomputeDirectIrradianceRenderPass, 0},
@@ -365,19 +381,18 @@ void SkyRenderer::prepareDirectIrradiancePrecompute(
       VulkanPipelineDescriptorLayout{
         VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
 
-    mPrecomputeDirectIrradiancePipeline.init(
+    mPrecomputeDirectIrradiancePipeline.initDeferred(
       graphicsContext.device(),
       graphicsContext.descriptorLayouts(),
       pipelineConfig);
   }
 
   { // Create pipeline (indirect irradiance)
-    Core::File precomputeIndirectIrradiance = Core::gFileSystem->createFile(
+    Core::FileMapping precomputeIndirectIrradiance = Core::gFileSystem->mapFile(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      "res/spv/SkyIndirectIrradiance.frag.spv",
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+      "res/spv/SkyIndirectIrradiance.frag.spv");
 
-    Buffer fsh = precomputeIndirectIrradiance.readBinary();
+    Buffer fsh = precomputeIndirectIrradiance.view();
 
     VulkanPipelineConfig pipelineConfig(
       {mPrecomputeDirectIrradianceRenderPass, 0},
@@ -398,7 +413,7 @@ void SkyRenderer::prepareDirectIrradiancePrecompute(
       VulkanPipelineDescriptorLayout{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
       textureUL, textureUL, textureUL);
 
-    mPrecomputeIndirectIrradiancePipeline.init(
+    mPrecomputeIndirectIrradiancePipeline.initDeferred(
       graphicsContext.device(),
       graphicsContext.descriptorLayouts(),
       pipelineConfig);
@@ -417,12 +432,11 @@ void SkyRenderer::prepareScatteringDensityPrecompute(
   const Buffer &precomputeVsh,
   const Buffer &precomputeGsh,
   VulkanContext &graphicsContext) {
-  Core::File precomputeScatteringDensity = Core::gFileSystem->createFile(
+  Core::FileMapping precomputeScatteringDensity = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/SkyScatteringDensity.frag.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/SkyScatteringDensity.frag.spv");
 
-  Buffer fsh = precomputeScatteringDensity.readBinary();
+  Buffer fsh = precomputeScatteringDensity.view();
 
   VkExtent3D extent = {
     SCATTERING_TEXTURE_WIDTH,
@@ -472,7 +486,7 @@ void SkyRenderer::prepareScatteringDensityPrecompute(
             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
           textureUL, textureUL, textureUL, textureUL, textureUL);
 
-        dstPipeline.init(
+        dstPipeline.initDeferred(
           graphicsContext.device(),
           graphicsContext.descriptorLayouts(),
           pipelineConfig);
@@ -493,12 +507,11 @@ void SkyRenderer::prepareMultipleScatteringPrecompute(
   const Buffer &precomputeVsh,
   const Buffer &precomputeGsh,
   VulkanContext &graphicsContext) {
-  Core::File precomputeMultipleScattering = Core::gFileSystem->createFile(
+  Core::FileMapping precomputeMultipleScattering = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/SkyMultipleScattering.frag.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/SkyMultipleScattering.frag.spv");
 
-  Buffer fsh = precomputeMultipleScattering.readBinary();
+  Buffer fsh = precomputeMultipleScattering.view();
 
   VkExtent3D extent = {
     SCATTERING_TEXTURE_WIDTH,
@@ -557,7 +570,7 @@ void SkyRenderer::prepareMultipleScatteringPrecompute(
             VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1},
           textureUL, textureUL);
 
-        dstPipeline.init(
+        dstPipeline.initDeferred(
           graphicsContext.device(),
           graphicsContext.descriptorLayouts(),
           pipelineConfig);
@@ -576,6 +589,9 @@ void SkyRenderer::prepareMultipleScatteringPrecompute(
 }
 
 void SkyRenderer::precompute(VulkanContext &graphicsContext) {
+  // The precomputation pipelines are needed straight away
+  graphicsContext.flushPipelineBuild();
+
   const auto &commandPool = graphicsContext.commandPool();
   const auto &device = graphicsContext.device();
   const auto &queue = device.graphicsQueue();
@@ -695,7 +711,6 @@ void SkyRenderer::precompute(VulkanContext &graphicsContext) {
       VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VulkanFence());
   }
 
-  mCache = true;
 }
 
 void SkyRenderer::precomputeTransmittance(
@@ -942,19 +957,17 @@ void SkyRenderer::make2DTextureAndUniform(
 void SkyRenderer::initDemoPipeline(
   VulkanContext &graphicsContext,
   const RenderStage &renderStage) {
-  Core::File precomputeDummyVsh = Core::gFileSystem->createFile(
+  Core::FileMapping precomputeDummyVsh = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/SkyDemo.vert.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/SkyDemo.vert.spv");
 
-  Buffer precomputeVsh = precomputeDummyVsh.readBinary();
+  Buffer precomputeVsh = precomputeDummyVsh.view();
 
-  Core::File precomputeDummy = Core::gFileSystem->createFile(
+  Core::FileMapping precomputeDummy = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/SkyDemo.frag.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/SkyDemo.frag.spv");
 
-  Buffer fsh = precomputeDummy.readBinary();
+  Buffer fsh = precomputeDummy.view();
 
   VulkanPipelineConfig pipelineConfig(
     {renderStage.renderPass(), 0},
@@ -1004,14 +1017,7 @@ bool SkyRenderer::isPrecomputationNeeded(const VulkanContext &context) const {
   return (context.device().deviceType() == DeviceType::DiscreteGPU);
 }
 
-void SkyRenderer::loadFromCache(VulkanContext &graphicsContext) {
-  const char *const names[4] = {
-    SKY_TRANSMITTANCE_CACHE_FILENAME,
-    SKY_SCATTERING_CACHE_FILENAME,
-    SKY_MIE_SCATTERING_CACHE_FILENAME,
-    SKY_IRRADIANCE_CACHE_FILENAME,
-  };
-
+void SkyRenderer::initCacheTransfers(VulkanContext &graphicsContext) {
   VulkanTexture *textures[4] = {
     &mPrecomputedTransmittance,
     &mPrecomputedScattering,
@@ -1019,107 +1025,90 @@ void SkyRenderer::loadFromCache(VulkanContext &graphicsContext) {
     &mPrecomputedIrradiance
   };
 
-  VulkanCommandBuffer cmdbufs[4] = {};
-  VulkanBuffer staging[4] = {};
-  VulkanTexture linearTextures[4] = {};
-
-  VkExtent3D scatteringExtent = {
-    SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH
-  };
-  VkExtent3D irradianceExtent = {
-    IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1
+  VkExtent3D extents[4] = {
+    {TRANSMITTANCE_WIDTH, TRANSMITTANCE_HEIGHT, 1},
+    {
+      SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT,
+      SCATTERING_TEXTURE_DEPTH
+    },
+    {
+      SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT,
+      SCATTERING_TEXTURE_DEPTH
+    },
+    {IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1}
   };
 
-  linearTextures[0].init(
-    graphicsContext.device(),
-    TextureType::T2D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    {TRANSMITTANCE_WIDTH, TRANSMITTANCE_HEIGHT, 1}, 1, 1);
-
-  linearTextures[1].init(
-    graphicsContext.device(),
-    TextureType::T3D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    scatteringExtent, 1, 1);
-
-  linearTextures[2].init(
-    graphicsContext.device(),
-    TextureType::T3D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    scatteringExtent, 1, 1);
-
-  linearTextures[3].init(
-    graphicsContext.device(),
-    TextureType::T2D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    irradianceExtent, 1, 1);
+  TextureTypeBits types[4] = {
+    TextureType::T2D, TextureType::T3D, TextureType::T3D, TextureType::T2D
+  };
 
   auto &commandPool = graphicsContext.commandPool();
 
   for (int i = 0; i < 4; ++i) {
-    Core::File file = Core::gFileSystem->createFile(
-      (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      std::string(SKY_CACHE_DIRECTORY) + names[i],
-      Core::FileOpenType::Binary | Core::FileOpenType::In);
+    CacheTransfer &transfer = mCacheTransfers[i];
+    transfer.sky = this;
+    transfer.texture = textures[i];
 
-    Buffer bin = file.readBinary();
-
-    VulkanBuffer &buffer = staging[i];
-    buffer.init(
-      graphicsContext.device(), bin.size,
-      VulkanBufferFlag::Mappable | VulkanBufferFlag::TransferSource);
+    transfer.linearTexture.init(
+      graphicsContext.device(),
+      types[i] | TextureType::LinearTiling | TextureType::TransferSource,
+      TextureContents::Color,
+      VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
+      extents[i], 1, 1);
 
-    memcpy(
-      buffer.map(graphicsContext.device(), bin.size, 0),
-      bin.data,
-      bin.size);
+    // The cache files are straight copies of the linear textures
+    transfer.size = transfer.linearTexture.memoryRequirement();
 
-    buffer.unmap(graphicsContext.device());
+    transfer.staging.init(
+      graphicsContext.device(), transfer.size,
+      VulkanBufferFlag::Mappable | VulkanBufferFlag::TransferSource);
 
-    // Copy to image
-    VulkanCommandBuffer &commandBuffer = cmdbufs[i];
-    commandBuffer = commandPool.makeCommandBuffer(
+    transfer.commandBuffer = commandPool.makeCommandBuffer(
       graphicsContext.device(), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 
-    commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
-
-    commandBuffer.copyBufferToImage(
-      linearTextures[i],
-      0, 1, 0,
-      buffer, 0, bin.size);
+    transfer.fence.init(graphicsContext.device(), 0);
+  }
+}
 
-    commandBuffer.blitImage(
-      *textures[i], VK_IMAGE_LAYOUT_UNDEFINED,
-      linearTextures[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, 1,
-      VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
-      VK_PIPELINE_STAGE_TRANSFER_BIT);
+void SkyRenderer::loadFromCache(VulkanContext &graphicsContext) {
+  const char *const names[4] = {
+    SKY_TRANSMITTANCE_CACHE_FILENAME,
+    SKY_SCATTERING_CACHE_FILENAME,
+    SKY_MIE_SCATTERING_CACHE_FILENAME,
+    SKY_IRRADIANCE_CACHE_FILENAME,
+  };
 
-    commandBuffer.transitionImageLayout(
-      *textures[i],
-      VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-      VK_PIPELINE_STAGE_TRANSFER_BIT,
-      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+  initCacheTransfers(graphicsContext);
 
-    commandBuffer.end();
+  /*
+     The files get read straight into the staging memory on the I/O thread
+     while the rest of the renderer initialises. The uploads get kicked off
+     as the reads complete (see onCacheTransferDone).
+  */
+  Core::IORequest requests[4] = {};
+  Core::IORequestID requestIDs[4] = {};
 
-    graphicsContext.device().graphicsQueue().submitCommandBuffer(
-      commandBuffer,
-      makeArray<VulkanSemaphore, AllocationType::Linear>(),
-      makeArray<VulkanSemaphore, AllocationType::Linear>(),
-      0, VulkanFence());
+  for (int i = 0; i < 4; ++i) {
+    CacheTransfer &transfer = mCacheTransfers[i];
+
+    requests[i].operation = Core::IOOperation::Read;
+    requests[i].mountPoint =
+      (Core::MountPoint)Core::ApplicationMountPoints::Application;
+    requests[i].path = std::string(SKY_CACHE_DIRECTORY) + names[i];
+    requests[i].buffer.data =
+      (uint8_t *)transfer.staging.map(transfer.size, 0);
+    requests[i].buffer.size = transfer.size;
+    requests[i].priority = Core::IOPriority::High;
+    requests[i].onComplete = onCacheTransferDone;
+    requests[i].userData = &transfer;
+
+    transfer.state = CacheTransferState::Reading;
   }
 
-  graphicsContext.device().idle();
+  Core::gAsyncIO->submit(requests, 4, requestIDs);
 
   for (int i = 0; i < 4; ++i) {
-    commandPool.freeCommandBuffer(graphicsContext.device(), cmdbufs[i]);
-    staging[i].destroy(graphicsContext.device());
-    linearTextures[i].destroy(graphicsContext.device());
+    mCacheTransfers[i].request = requestIDs[i];
   }
 }
 
@@ -1131,88 +1120,37 @@ void SkyRenderer::saveToCache(VulkanContext &graphicsContext) {
     SKY_IRRADIANCE_CACHE_FILENAME,
   };
 
-  VulkanTexture *textures[4] = {
-    &mPrecomputedTransmittance,
-    &mPrecomputedScattering,
-    &mDeltaMieScatteringTexture,
-    &mPrecomputedIrradiance
-  };
-
-  VulkanCommandBuffer cmdbufs[4] = {};
-  VulkanBuffer staging[4] = {};
-  VulkanTexture linearTextures[4] = {};
-
-  VkExtent3D scatteringExtent = {
-    SCATTERING_TEXTURE_WIDTH, SCATTERING_TEXTURE_HEIGHT, SCATTERING_TEXTURE_DEPTH
-  };
-  VkExtent3D irradianceExtent = {
-    IRRADIANCE_TEXTURE_WIDTH, IRRADIANCE_TEXTURE_HEIGHT, 1
-  };
-
-  linearTextures[0].init(
-    graphicsContext.device(),
-    TextureType::T2D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    {TRANSMITTANCE_WIDTH, TRANSMITTANCE_HEIGHT, 1}, 1, 1);
-
-  linearTextures[1].init(
-    graphicsContext.device(),
-    TextureType::T3D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    scatteringExtent, 1, 1);
-
-  linearTextures[2].init(
-    graphicsContext.device(),
-    TextureType::T3D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    scatteringExtent, 1, 1);
-
-  linearTextures[3].init(
-    graphicsContext.device(),
-    TextureType::T2D | TextureType::LinearTiling | TextureType::TransferSource,
-    TextureContents::Color,
-    VK_FORMAT_R32G32B32A32_SFLOAT, VK_FILTER_NEAREST,
-    irradianceExtent, 1, 1);
-
-  auto &commandPool = graphicsContext.commandPool();
-
-  for (int i = 0; i < 4; ++i) {
-    Core::File file = Core::gFileSystem->createFile(
+  if (!Core::gFileSystem->isPathValid(
+        (Core::MountPoint)Core::ApplicationMountPoints::Application,
+        SKY_CACHE_DIRECTORY)) {
+    Core::gFileSystem->makeDirectory(
       (Core::MountPoint)Core::ApplicationMountPoints::Application,
-      std::string(SKY_CACHE_DIRECTORY) + names[i],
-      Core::FileOpenType::Binary | Core::FileOpenType::Out);
+      SKY_CACHE_DIRECTORY);
+  }
 
-    size_t size = linearTextures[i].memoryRequirement();
+  initCacheTransfers(graphicsContext);
 
-    VulkanBuffer &buffer = staging[i];
-    buffer.init(
-      graphicsContext.device(), size,
-      (VulkanBufferFlagBits)VulkanBufferFlag::Mappable);
+  for (int i = 0; i < 4; ++i) {
+    CacheTransfer &transfer = mCacheTransfers[i];
 
     // Copy to buffer
-    VulkanCommandBuffer &commandBuffer = cmdbufs[i];
-    commandBuffer = commandPool.makeCommandBuffer(
-      graphicsContext.device(), VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
+    VulkanCommandBuffer &commandBuffer = transfer.commandBuffer;
     commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
 
     commandBuffer.transitionImageLayout(
-      linearTextures[i], VK_IMAGE_LAYOUT_UNDEFINED,
+      transfer.linearTexture, VK_IMAGE_LAYOUT_UNDEFINED,
       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
       VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
 
     commandBuffer.blitImage(
-      linearTextures[i], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-      *textures[i], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, 1,
+      transfer.linearTexture, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+      *transfer.texture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, 1,
       VK_PIPELINE_STAGE_TRANSFER_BIT,
       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
     
     commandBuffer.copyImageToBuffer(
-      buffer, 0, size,
-      linearTextures[i],
+      transfer.staging, 0, transfer.size,
+      transfer.linearTexture,
       0, 1, 0);
 
     commandBuffer.end();
@@ -1222,17 +1160,140 @@ void SkyRenderer::saveToCache(VulkanContext &graphicsContext) {
       makeArray<VulkanSemaphore, AllocationType::Linear>(),
       makeArray<VulkanSemaphore, AllocationType::Linear>(),
       0, VulkanFence());
+  }
 
-    graphicsContext.device().idle();
+  // Only happens right after the precomputations (during initialisation)
+  graphicsContext.device().idle();
 
-    void *data = buffer.map(graphicsContext.device(), size, 0);
-    file.write(data, size);
-    buffer.unmap(graphicsContext.device());
+  /*
+     The files get written straight from the staging memory on the I/O
+     thread. The staging resources get freed once the writes complete.
+  */
+  Core::IORequest requests[4] = {};
+  Core::IORequestID requestIDs[4] = {};
+
+  for (int i = 0; i < 4; ++i) {
+    CacheTransfer &transfer = mCacheTransfers[i];
+
+    requests[i].operation = Core::IOOperation::Write;
+    requests[i].mountPoint =
+      (Core::MountPoint)Core::ApplicationMountPoints::Application;
+    requests[i].path = std::string(SKY_CACHE_DIRECTORY) + names[i];
+    requests[i].buffer.data =
+      (uint8_t *)transfer.staging.map(transfer.size, 0);
+    requests[i].buffer.size = transfer.size;
+    requests[i].priority = Core::IOPriority::Low;
+    requests[i].onComplete = onCacheTransferDone;
+    requests[i].userData = &transfer;
+
+    transfer.state = CacheTransferState::Writing;
   }
 
+  Core::gAsyncIO->submit(requests, 4, requestIDs);
+
   for (int i = 0; i < 4; ++i) {
-    commandPool.freeCommandBuffer(graphicsContext.device(), cmdbufs[i]);
-    staging[i].destroy(graphicsContext.device());
+    mCacheTransfers[i].request = requestIDs[i];
+  }
+}
+
+void SkyRenderer::onCacheTransferDone(const Core::IOCompletion &completion) {
+  CacheTransfer &transfer = *(CacheTransfer *)completion.userData;
+  transfer.sky->finishCacheTransfer(transfer, completion);
+}
+
+void SkyRenderer::finishCacheTransfer(
+  CacheTransfer &transfer, const Core::IOCompletion &completion) {
+  VulkanContext &graphicsContext = *mGraphicsContext;
+
+  if (completion.status != Core::IOStatus::Completed) {
+    LOG_ERRORV(
+      "Sky cache transfer failed (%zu bytes out of %zu)\n",
+      completion.bytesTransferred, transfer.size);
+
+    if (transfer.state == CacheTransferState::Reading) {
+      // The textures will need to be precomputed after all (see sync)
+      mIsCacheLoadFailed = true;
+    }
+
+    releaseCacheTransfer(transfer);
+    return;
+  }
+
+  if (transfer.state == CacheTransferState::Writing) {
+    releaseCacheTransfer(transfer);
+    return;
+  }
+
+  // Copy to image
+  VulkanCommandBuffer &commandBuffer = transfer.commandBuffer;
+  commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
+
+  commandBuffer.copyBufferToImage(
+    transfer.linearTexture,
+    0, 1, 0,
+    transfer.staging, 0, transfer.size);
+
+  commandBuffer.blitImage(
+    *transfer.texture, VK_IMAGE_LAYOUT_UNDEFINED,
+    transfer.linearTexture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 0, 1,
+    VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+    VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  commandBuffer.transitionImageLayout(
+    *transfer.texture,
+    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    VK_PIPELINE_STAGE_TRANSFER_BIT,
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+  commandBuffer.end();
+
+  // Frames get submitted after this so they see the texture
+  graphicsContext.device().graphicsQueue().submitCommandBuffer(
+    commandBuffer,
+    makeArray<VulkanSemaphore, AllocationType::Linear>(),
+    makeArray<VulkanSemaphore, AllocationType::Linear>(),
+    0, transfer.fence);
+
+  transfer.state = CacheTransferState::Uploading;
+}
+
+void SkyRenderer::releaseCacheTransfer(CacheTransfer &transfer) {
+  VulkanContext &graphicsContext = *mGraphicsContext;
+
+  transfer.staging.destroy(graphicsContext.device());
+  transfer.linearTexture.destroy(graphicsContext.device());
+  transfer.fence.destroy(graphicsContext.device());
+
+  graphicsContext.commandPool().freeCommandBuffer(
+    graphicsContext.device(), transfer.commandBuffer);
+
+  transfer.state = CacheTransferState::None;
+}
+
+void SkyRenderer::finishCacheTransfers(bool wait) {
+  VulkanContext &graphicsContext = *mGraphicsContext;
+
+  for (auto &transfer : mCacheTransfers) {
+    bool isOnIOThread =
+      transfer.state == CacheTransferState::Reading ||
+      (transfer.state == CacheTransferState::Writing && wait);
+
+    if (isOnIOThread) {
+      // Won't get dispatched by AsyncIO::tick anymore
+      Core::IOCompletion completion = Core::gAsyncIO->wait(transfer.request);
+      finishCacheTransfer(transfer, completion);
+    }
+
+    if (transfer.state == CacheTransferState::Uploading) {
+      if (wait) {
+        transfer.fence.wait(graphicsContext.device());
+      }
+
+      if (transfer.fence.isSignaled(graphicsContext.device())) {
+        releaseCacheTransfer(transfer);
+      }
+    }
   }
 }
 
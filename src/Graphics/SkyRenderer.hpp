@@ -2,14 +2,17 @@
 
 #include "Tick.hpp"
 #include "Camera.hpp"
+#include "AsyncIO.hpp"
 #include "VulkanFrame.hpp"
 #include "RenderStage.hpp"
 #include "VulkanBuffer.hpp"
+#include "VulkanTexture.hpp"
 #include "VulkanUniform.hpp"
 #include "PlanetRenderer.hpp"
 #include "VulkanPipeline.hpp"
 #include "VulkanRenderPass.hpp"
 #include "VulkanFramebuffer.hpp"
+#include "VulkanCommandBuffer.hpp"
 
 namespace Ondine::View {
 
@@ -29,6 +32,9 @@ public:
 
   void shutdown(VulkanContext &graphicsContext);
 
+  // Finishes the sky cache transfers which are in flight (every frame)
+  void sync(VulkanContext &graphicsContext);
+
   const VulkanUniform &uniform() const;
 
 private:
@@ -99,9 +105,39 @@ private:
 
   bool isPrecomputationNeeded(const VulkanContext &context) const;
 
+  enum class CacheTransferState : uint8_t {
+    None,
+    Reading,
+    Writing,
+    Uploading
+  };
+
+  // Moves one of the precomputed textures between the disk and the GPU
+  struct CacheTransfer {
+    // For the I/O completion callback
+    SkyRenderer *sky;
+    CacheTransferState state;
+    Core::IORequestID request;
+    VulkanTexture *texture;
+    size_t size;
+    VulkanBuffer staging;
+    VulkanTexture linearTexture;
+    VulkanCommandBuffer commandBuffer;
+    // Signals once the upload is done
+    VulkanFence fence;
+  };
+
+  void initCacheTransfers(VulkanContext &graphicsContext);
   void loadFromCache(VulkanContext &graphicsContext);
   void saveToCache(VulkanContext &graphicsContext);
 
+  static void onCacheTransferDone(const Core::IOCompletion &completion);
+  void finishCacheTransfer(
+    CacheTransfer &transfer, const Core::IOCompletion &completion);
+  void releaseCacheTransfer(CacheTransfer &transfer);
+  // If wait is false, only waits for reads which haven't completed
+  void finishCacheTransfers(bool wait);
+
 private:
   static constexpr size_t NUM_SCATTERING_ORDERS = 4;
   static constexpr size_t TRANSMITTANCE_WIDTH = 256;
@@ -213,8 +249,11 @@ private:
   /* For now, contain the demo shader */
   VulkanPipeline mDemo;
 
-  /* Should we save precomputation textures to cache? */
-  bool mCache;
+  /* Sky cache gets read / written in the background */
+  CacheTransfer mCacheTransfers[4];
+  bool mIsCacheLoadFailed;
+  // For the cache transfers which complete in AsyncIO::tick
+  VulkanContext *mGraphicsContext;
 
   float mViewDistanceMeters = 9000.000000;
   float mViewZenithAngleRadians = 1.470000;
@@ -43,23 +43,10 @@ void StarRenderer::init(
         VulkanPipeline &res,
         StarRenderer &owner,
         VulkanContext &graphicsContext) {
-        Core::File vshFile = Core::gFileSystem->createFile(
-          (Core::MountPoint)Core::ApplicationMountPoints::Application,
-          STARS_VERT_SPV,
-          Core::FileOpenType::Binary | Core::FileOpenType::In);
-
-        Core::File fshFile = Core::gFileSystem->createFile(
-          (Core::MountPoint)Core::ApplicationMountPoints::Application,
-          STARS_FRAG_SPV,
-          Core::FileOpenType::Binary | Core::FileOpenType::In);
-
-        Buffer vsh = vshFile.readBinary();
-        Buffer fsh = fshFile.readBinary();
-
         VulkanPipelineConfig pipelineConfig(
           {owner.mGBuffer->renderPass(), 0},
-          VulkanShader{graphicsContext.device(), vsh, VulkanShaderType::Vertex},
-          VulkanShader{graphicsContext.device(), fsh, VulkanShaderType::Fragment});
+          VulkanShader{graphicsContext.device(), STARS_VERT_SPV},
+          VulkanShader{graphicsContext.device(), STARS_FRAG_SPV});
 
         pipelineConfig.enableDepthTesting();
         pipelineConfig.setTopology(VK_PRIMITIVE_TOPOLOGY_POINT_LIST);
@@ -71,7 +58,7 @@ void StarRenderer::init(
 
         owner.mPipelineModelConfig.configureVertexInput(pipelineConfig);
       
-        owner.mPipeline.res.init(
+        owner.mPipeline.res.initDeferred(
           graphicsContext.device(),
           graphicsContext.descriptorLayouts(),
           pipelineConfig);
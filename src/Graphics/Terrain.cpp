@@ -1,8 +1,14 @@
+#include <assert.h>
+#include <thread>
+#include <algorithm>
 #include "Math.hpp"
+#include "Time.hpp"
+#include "Noise.hpp"
 #include "Camera.hpp"
 #include "Terrain.hpp"
 #include "Clipping.hpp"
 #include "ThreadPool.hpp"
+#include "GraphicsEvent.hpp"
 #include <glm/gtc/noise.hpp>
 #include "VulkanContext.hpp"
 #include "PlanetRenderer.hpp"
@@ -18,14 +24,26 @@ void Terrain::init() {
   mFlatChunkIndices.init();
   mLoadedChunks.init(MAX_CHUNKS);
   mUpdatedChunks.init(MAX_CHUNKS);
-  mNullChunk = flAlloc<Chunk>();
-  memset(mNullChunk, 0, sizeof(Chunk));
+  mMeshedChunks.init(MAX_CHUNKS);
+  mNullVoxels = flAlloc<ChunkVoxels>();
+  memset(mNullVoxels, 0, sizeof(ChunkVoxels));
+
+  // Epoch 0 marks free reader slots
+  mEpoch.store(1);
+  for (uint32_t i = 0; i < MAX_READERS; ++i) {
+    mReaderEpochs[i].store(0);
+  }
 
   mMaxVoxelDensity = (float)0xFFFF;
+  mMipReduction = DensityMipReduction::Average;
   mUpdated = false;
 
-  mModificationJob = Core::gThreadPool->createJob(runTerrainModification);
-  mModificationParams = new TerrainModificationParams;
+  mModificationJob = Core::gThreadPool->createJob(runTerrainModifications);
+  mModificationQueue.init();
+
+  mIslandJob = Core::gThreadPool->createJob(runIslandGeneration);
+  mIslandParams = nullptr;
+  mHandedOffColumnCount = 0;
 }
 
 Chunk *Terrain::getChunk(const glm::ivec3 &coord) {
@@ -37,21 +55,31 @@ Chunk *Terrain::getChunk(const glm::ivec3 &coord) {
     return mLoadedChunks[*index];
   }
   else {
-    uint32_t i = mLoadedChunks.size++;
-    Chunk *&chunk = mLoadedChunks[i];
-    chunk = flAlloc<Chunk>();
-
-    memset(chunk, 0, sizeof(Chunk));
+    // Value-initialised (zeroed) - Chunk holds an atomic, so no memset
+    Chunk *chunk = flAlloc<Chunk>();
+    chunk->voxels.store(mNullVoxels, std::memory_order_relaxed);
+    chunk->pending = nullptr;
     chunk->chunkCoord = coord;
-    chunk->chunkStackIndex = i;
 
-    mChunkIndices.insert(hash, i);
-    addToFlatChunkIndices(chunk);
+    insertChunk(chunk);
 
     return chunk;
   }
 }
 
+void Terrain::insertChunk(Chunk *chunk) {
+  assert(mLoadedChunks.size < mLoadedChunks.capacity);
+
+  std::unique_lock<std::shared_mutex> lock(mChunkMapMutex);
+
+  uint32_t i = mLoadedChunks.size++;
+  mLoadedChunks[i] = chunk;
+  chunk->chunkStackIndex = i;
+
+  mChunkIndices.insert(hashChunkCoord(chunk->chunkCoord), i);
+  addToFlatChunkIndices(chunk);
+}
+
 Chunk *Terrain::at(const glm::ivec3 &coord) {
   uint32_t hash = hashChunkCoord(coord);
   uint32_t *index = mChunkIndices.get(hash);
@@ -88,134 +116,137 @@ glm::vec3 Terrain::chunkCoordToWorld(const glm::ivec3 &chunkCoord) const {
 }
 
 void Terrain::makeSphere(float radius, glm::vec3 center, float intensity) {
-  radius /= mTerrainScale;
-  center /= mTerrainScale;
-
-  glm::ivec3 start = (glm::ivec3)center - glm::ivec3((int32_t)radius);
-  float radius2 = radius * radius;
-  int32_t diameter = (int32_t)radius * 2 + 1;
+  TerrainModification modification;
+  modification.type = TerrainModificationType::AddSphere;
+  modification.as.centre = center;
+  modification.as.radius = radius;
+  modification.as.intensity = intensity;
 
-  glm::ivec3 currentChunkCoord = worldToChunkCoord(center);
-  Chunk *currentChunk = getChunk(currentChunkCoord);
-  markChunkForUpdate(currentChunk);
-
-  for (int32_t z = start.z; z < start.z + diameter; ++z) {
-    for (int32_t y = start.y; y < start.y + diameter; ++y) {
-      for (int32_t x = start.x; x < start.x + diameter; ++x) {
-        glm::ivec3 position = glm::ivec3(x, y, z);
-        glm::vec3 posFloat = (glm::vec3)position;
-        glm::vec3 diff = posFloat - center;
+  applyModifications(&modification, 1);
+}
 
-        float distance2 = glm::dot(diff, diff);
+void Terrain::makePlane(float radius, glm::vec3 center, float intensity) {
+  TerrainModification modification;
+  modification.type = TerrainModificationType::AddPlane;
+  modification.ap.centre = center;
+  modification.ap.radius = radius;
+  modification.ap.intensity = intensity;
 
-        if (distance2 <= radius2) {
-          glm::ivec3 chunkOriginDiff = position -
-            currentChunkCoord * (int32_t)CHUNK_DIM;
+  applyModifications(&modification, 1);
+}
 
-          if (chunkOriginDiff.x >= 0 && chunkOriginDiff.x < CHUNK_DIM &&
-              chunkOriginDiff.y >= 0 && chunkOriginDiff.y < CHUNK_DIM &&
-              chunkOriginDiff.z >= 0 && chunkOriginDiff.z < CHUNK_DIM) {
-            // Is within current chunk boundaries
-            float proportion = (1.0f - (distance2 / radius2)) * intensity;
+void Terrain::makeIslands(
+  float seaLevel, uint32_t octaveCount,
+  float persistance, float lacunarity,
+  float baseAmplitude, float baseFrequency,
+  glm::vec2 s, glm::vec2 e) {
+  Core::TimeStamp generationStart = Core::getCurrentTime();
 
-            glm::ivec3 voxelCoord = chunkOriginDiff;
+  IslandParams params;
+  if (!initIslandParams(
+        params, seaLevel, octaveCount, persistance, lacunarity,
+        baseAmplitude, baseFrequency, s, e)) {
+    return;
+  }
 
-            Voxel *v = &currentChunk->voxels[getVoxelIndex(voxelCoord)];
-            int32_t addedValue = (int32_t)((proportion) * mMaxVoxelDensity);
-            int32_t finalValue = addedValue + (int32_t)v->density;
-            finalValue = glm::clamp(finalValue, 0, (int32_t)MAX_DENSITY);
-            v->density = finalValue;
-          }
-          else {
-            glm::ivec3 c = worldToChunkCoord(position);
+  // Each task only writes to its own column's (private) chunks
+  Core::gThreadPool->parallelFor(
+    params.columnCount, runIslandColumnTask, &params);
 
-            currentChunk = getChunk(c);
-            currentChunkCoord = c;
-            markChunkForUpdate(currentChunk);
+  // Chunk column order - same chunk indices every time
+  uint32_t newChunkCount = 0;
+  for (uint32_t i = 0; i < params.columnCount; ++i) {
+    newChunkCount += handOffIslandColumn(params.columns[i]);
+  }
 
-            float proportion = (1.0f - (distance2 / radius2)) * intensity;
+  publishChunkWrites();
 
-            glm::ivec3 voxelCoord = position -
-              currentChunkCoord * (int32_t)CHUNK_DIM;
+  flFreev(params.columns);
 
-            Voxel *v = &currentChunk->voxels[getVoxelIndex(voxelCoord)];
-            int32_t addedValue = (int32_t)((proportion) * mMaxVoxelDensity);
-            int32_t finalValue = addedValue + (int32_t)v->density;
-            finalValue = glm::clamp(finalValue, 0, (int32_t)MAX_DENSITY);
-            v->density = finalValue;
-          }
-        }
-      }
-    }
-  }
+  LOG_INFOV(
+    "Generated islands: %d chunk columns, %d new chunks in %f ms\n",
+    (int)params.columnCount, (int)newChunkCount,
+    Core::getTimeDifference(Core::getCurrentTime(), generationStart) * 1000.0f);
 }
 
-void Terrain::makePlane(float radius, glm::vec3 center, float intensity) {
-  radius /= mTerrainScale;
-  center /= mTerrainScale;
-
-  glm::ivec3 start = (glm::ivec3)center - glm::ivec3((int32_t)radius);
-  float radius2 = radius * radius;
-  int32_t diameter = (int32_t)radius * 2 + 1;
+void Terrain::queueIslands(
+  float seaLevel, uint32_t octaveCount,
+  float persistance, float lacunarity,
+  float baseAmplitude, float baseFrequency,
+  glm::vec2 s, glm::vec2 e,
+  const glm::vec3 &wFocus,
+  Core::OnEventProc onProgress) {
+  if (mIslandParams) {
+    LOG_WARNING("Terrain is already being generated\n");
+    return;
+  }
 
-  glm::ivec3 currentChunkCoord = worldToChunkCoord(center);
-  Chunk *currentChunk = getChunk(currentChunkCoord);
-  markChunkForUpdate(currentChunk);
+  IslandParams *params = flAlloc<IslandParams>();
+  if (!initIslandParams(
+        *params, seaLevel, octaveCount, persistance, lacunarity,
+        baseAmplitude, baseFrequency, s, e)) {
+    flFree(params);
+    return;
+  }
 
-  int32_t y = (int)center.y;
+  // Whatever is closest to the camera shows up first
+  glm::vec2 focus = glm::vec2(wFocus.x, wFocus.z) / (float)mTerrainScale;
+  auto focusDistance = [focus](const IslandColumn &column) {
+    glm::vec2 centre = ((glm::vec2)column.chunkCoord + glm::vec2(0.5f)) *
+      (float)CHUNK_DIM;
+    glm::vec2 diff = centre - focus;
+    return glm::dot(diff, diff);
+  };
 
-  for (int32_t z = start.z; z < start.z + diameter; ++z) {
-    for (int32_t x = start.x; x < start.x + diameter; ++x) {
-      glm::ivec3 position = glm::ivec3(x, y, z);
-      glm::vec3 posFloat = (glm::vec3)position;
-      glm::vec3 diff = posFloat - center;
+  std::stable_sort(
+    params->columns, params->columns + params->columnCount,
+    [&focusDistance](const IslandColumn &a, const IslandColumn &b) {
+      return focusDistance(a) < focusDistance(b);
+    });
 
-      float distance2 = glm::dot(diff, diff);
+  mIslandParams = params;
+  mHandedOffColumnCount = 0;
+  mOnGenerationProgress = onProgress;
 
-      if (distance2 <= radius2) {
-        glm::ivec3 chunkOriginDiff = position -
-          currentChunkCoord * (int32_t)CHUNK_DIM;
+  Core::gThreadPool->startJob(mIslandJob, params);
+}
 
-        if (chunkOriginDiff.x >= 0 && chunkOriginDiff.x < CHUNK_DIM &&
-            chunkOriginDiff.y >= 0 && chunkOriginDiff.y < CHUNK_DIM &&
-            chunkOriginDiff.z >= 0 && chunkOriginDiff.z < CHUNK_DIM) {
-          // Is within current chunk boundaries
-          float proportion = (1.0f - (distance2 / radius2)) * intensity;
+void Terrain::handOffGeneratedChunks() {
+  if (!mIslandParams) {
+    return;
+  }
 
-          glm::ivec3 voxelCoord = chunkOriginDiff;
+  IslandParams &params = *mIslandParams;
+  uint32_t finishedColumnCount = params.finishedColumnCount.load(
+    std::memory_order_acquire);
 
-          Voxel *v = &currentChunk->voxels[getVoxelIndex(voxelCoord)];
-          uint16_t addedValue = (uint32_t)((proportion) * mMaxVoxelDensity);
+  if (finishedColumnCount == mHandedOffColumnCount) {
+    return;
+  }
 
-          uint32_t finalValue = (uint32_t)addedValue + (uint32_t)v->density;
-          finalValue = glm::min(finalValue, MAX_DENSITY);
-            
-          v->density = finalValue;
-        }
-        else {
-          glm::ivec3 c = worldToChunkCoord(position);
+  for (uint32_t i = mHandedOffColumnCount; i < finishedColumnCount; ++i) {
+    handOffIslandColumn(params.columns[i]);
+  }
 
-          currentChunk = getChunk(c);
-          currentChunkCoord = c;
-          markChunkForUpdate(currentChunk);
+  mHandedOffColumnCount = finishedColumnCount;
 
-          float proportion = (1.0f - (distance2 / radius2)) * intensity;
+  publishChunkWrites();
 
-          glm::ivec3 voxelCoord = position -
-            currentChunkCoord * (int32_t)CHUNK_DIM;
+  auto *progressEvent = lnEmplaceAlloc<Core::EventTerrainGenerationProgress>();
+  progressEvent->finishedColumnCount = finishedColumnCount;
+  progressEvent->columnCount = params.columnCount;
+  mOnGenerationProgress(progressEvent);
 
-          Voxel *v = &currentChunk->voxels[getVoxelIndex(voxelCoord)];
-          uint16_t addedValue = (uint32_t)((proportion) * mMaxVoxelDensity);
-          uint32_t finalValue = (uint32_t)addedValue + (uint32_t)v->density;
-          finalValue = glm::min(finalValue, MAX_DENSITY);
-          v->density = finalValue;
-        }
-      }
-    }
+  if (finishedColumnCount == params.columnCount) {
+    // The job doesn't touch the params after publishing the last column
+    flFreev(params.columns);
+    flFree(mIslandParams);
+    mIslandParams = nullptr;
   }
 }
 
-void Terrain::makeIslands(
+bool Terrain::initIslandParams(
+  IslandParams &params,
   float seaLevel, uint32_t octaveCount,
   float persistance, float lacunarity,
   float baseAmplitude, float baseFrequency,
@@ -224,108 +255,293 @@ void Terrain::makeIslands(
   s /= mTerrainScale;
   e /= mTerrainScale;
 
-  glm::ivec2 start = (glm::ivec2)s;
-  glm::ivec2 end = (glm::ivec2)e;
+  params.terrain = this;
+  params.seaLevel = seaLevel;
+  params.octaveCount = octaveCount;
+  params.persistance = persistance;
+  params.lacunarity = lacunarity;
+  params.baseAmplitude = baseAmplitude;
+  params.baseFrequency = baseFrequency;
+  params.start = (glm::ivec2)s;
+  params.end = (glm::ivec2)e;
+  params.middle = (params.start + params.end) / 2;
+  params.maxDist = glm::length(
+    (glm::vec2)params.middle - (glm::vec2)params.start);
+  params.range = (glm::vec2)(params.end - params.start);
+  params.minHeight = (int32_t)seaLevel - 2;
+  params.columns = nullptr;
+  params.columnCount = 0;
+  params.finishedColumnCount.store(0, std::memory_order_relaxed);
+
+  Chunk *firstChunk = getChunk(worldToChunkCoord(
+    glm::vec3(params.start.x, seaLevel, params.start.y)));
+  markChunkForUpdate(firstChunk);
+  mUpdated = true;
 
-  glm::ivec2 middle = (start + end) / 2;
-  float maxDist = glm::length((glm::vec2)middle - (glm::vec2)start);
+  if (params.end.x <= params.start.x || params.end.y <= params.start.y) {
+    return false;
+  }
 
-  glm::vec2 range = (glm::vec2)(end - start);
+  glm::ivec3 firstColumn = worldToChunkCoord(
+    glm::vec3(params.start.x, 0.0f, params.start.y));
+  glm::ivec3 lastColumn = worldToChunkCoord(
+    glm::vec3(params.end.x - 1, 0.0f, params.end.y - 1));
+
+  uint32_t columnCountX = lastColumn.x - firstColumn.x + 1;
+  uint32_t columnCountZ = lastColumn.z - firstColumn.z + 1;
+  params.columnCount = columnCountX * columnCountZ;
+
+  params.columns = flAllocv<IslandColumn>(params.columnCount);
+  for (uint32_t i = 0; i < params.columnCount; ++i) {
+    params.columns[i].chunkCoord = glm::ivec2(
+      firstColumn.x + (int32_t)(i % columnCountX),
+      firstColumn.z + (int32_t)(i / columnCountX));
+    params.columns[i].chunks = nullptr;
+    params.columns[i].chunkCount = 0;
+  }
 
-  glm::ivec3 currentChunkCoord = worldToChunkCoord(
-    glm::vec3(start.x, seaLevel, start.y));
-  Chunk *currentChunk = getChunk(currentChunkCoord);
-  markChunkForUpdate(currentChunk);
+  return true;
+}
 
-  int32_t minHeight = (int32_t)seaLevel - 2;
+void Terrain::runIslandColumnTask(uint32_t index, void *data) {
+  auto *params = (IslandParams *)data;
+  params->terrain->makeIslandColumn(*params, params->columns[index]);
+}
 
-  for (int32_t z = start.y; z < end.y; ++z) {
-    for (int32_t x = start.x; x < end.x; ++x) {
-      float dist = glm::length(glm::vec2(x, z) - (glm::vec2)middle) / maxDist;
+int Terrain::runIslandGeneration(void *data) {
+  auto *params = (IslandParams *)data;
+  // The params get freed as soon as the last column is published
+  uint32_t columnCount = params->columnCount;
+
+  /*
+     One column after the other on a single worker: the rest of the pool
+     stays free for the meshing / modification jobs in the meantime.
+  */
+  for (uint32_t i = 0; i < columnCount; ++i) {
+    params->terrain->makeIslandColumn(*params, params->columns[i]);
+    params->finishedColumnCount.store(i + 1, std::memory_order_release);
+  }
+
+  return 0;
+}
 
-      float height = seaLevel;
-      float freq = baseFrequency;
-      float amp = baseAmplitude;
+uint32_t Terrain::handOffIslandColumn(IslandColumn &column) {
+  uint32_t newChunkCount = 0;
 
-      for (int i = 0; i < octaveCount; ++i) {
-        glm::vec2 perlinCoord = glm::vec2(
-          float(x - start.x) / (float)range.x,
-          float(z - start.y) / (float)range.y) * freq;
+  for (uint32_t c = 0; c < column.chunkCount; ++c) {
+    Chunk *generated = column.chunks[c];
+    Chunk *chunk = at(generated->chunkCoord);
 
-        float noise = glm::perlin(perlinCoord + glm::vec2(10));
-        height += (noise * amp);
+    if (chunk) {
+      ChunkVoxels *voxels = beginChunkWrite(chunk);
 
-        amp += persistance;
-        freq *= lacunarity;
+      // Only the voxels the islands reached get overwritten
+      for (uint32_t v = 0; v < CHUNK_VOLUME; ++v) {
+        if (generated->pending->voxels[v].density) {
+          voxels->voxels[v].density = generated->pending->voxels[v].density;
+        }
       }
 
-      height = fmax(height, minHeight) * (1.0f - dist);
+      flFree(generated->pending);
+      flFree(generated);
+    }
+    else {
+      // The generated voxels become the chunk's first version
+      chunk = generated;
+      insertChunk(chunk);
+      mPendingChunks.push_back(chunk);
+      ++newChunkCount;
+    }
+
+    markDirty(chunk, glm::ivec3(0), glm::ivec3(CHUNK_DIM));
 
-      for (int32_t y = (int32_t)minHeight; y < (int32_t)height; ++y) {
-        glm::ivec3 position = glm::ivec3(x, y, z);
-        glm::ivec3 chunkOriginDiff = position -
-          currentChunkCoord * (int32_t)CHUNK_DIM;
+    markChunkForUpdate(chunk);
+  }
 
-        float proportion = 1.0f - (y - minHeight) / (height - minHeight);
-        proportion *= 0.8f;
+  if (column.chunks) {
+    flFreev(column.chunks);
+    column.chunks = nullptr;
+  }
 
-        if (chunkOriginDiff.x >= 0 && chunkOriginDiff.x < CHUNK_DIM &&
-            chunkOriginDiff.y >= 0 && chunkOriginDiff.y < CHUNK_DIM &&
-            chunkOriginDiff.z >= 0 && chunkOriginDiff.z < CHUNK_DIM) {
-          currentChunk->voxels[getVoxelIndex(chunkOriginDiff)].density = 
-            (uint16_t)(mMaxVoxelDensity) * proportion;
+  mUpdated = true;
 
-          /*
-          if (y < seaLevel + 4) {
-            currentChunk->voxels[getVoxelIndex(chunkOriginDiff)].color =
-              v3ColorToB8(glm::vec3(242.0f, 209.0f, 107.0f) / 255.0f);
-          }
-          else {
-            currentChunk->voxels[getVoxelIndex(chunkOriginDiff)].color =
-              v3ColorToB8(glm::vec3(0.2f, 0.9f, 0.3f));
-          }
-          */
-        }
-        else {
-          glm::ivec3 c = worldToChunkCoord(position);
+  return newChunkCount;
+}
+
+void Terrain::makeIslandColumn(
+  const IslandParams &params, IslandColumn &column) {
+  int32_t chunkX = column.chunkCoord.x * (int32_t)CHUNK_DIM;
+  int32_t chunkZ = column.chunkCoord.y * (int32_t)CHUNK_DIM;
+
+  int32_t startX = MAX(chunkX, params.start.x);
+  int32_t startZ = MAX(chunkZ, params.start.y);
+  int32_t endX = MIN(chunkX + (int32_t)CHUNK_DIM, params.end.x);
+  int32_t endZ = MIN(chunkZ + (int32_t)CHUNK_DIM, params.end.y);
+  uint32_t rowLength = endX - startX;
+
+  int32_t minHeight = params.minHeight;
+  int32_t maxHeight = minHeight;
+
+  float heights[CHUNK_DIM][CHUNK_DIM];
+
+  // Whole rows of the chunk column go through the noise at once
+  float noiseX[CHUNK_DIM], noiseY[CHUNK_DIM], noise[CHUNK_DIM];
+
+  for (int32_t z = startZ; z < endZ; ++z) {
+    float *row = heights[z - startZ];
+
+    for (uint32_t i = 0; i < rowLength; ++i) {
+      row[i] = params.seaLevel;
+    }
+
+    float freq = params.baseFrequency;
+    float amp = params.baseAmplitude;
+
+    for (int o = 0; o < params.octaveCount; ++o) {
+      float y = float(z - params.start.y) / (float)params.range.y * freq;
+
+      for (uint32_t i = 0; i < rowLength; ++i) {
+        int32_t x = startX + (int32_t)i;
+        noiseX[i] = float(x - params.start.x) / (float)params.range.x * freq;
+        noiseX[i] += 10.0f;
+        noiseY[i] = y + 10.0f;
+      }
+
+      perlin2D(noiseX, noiseY, noise, rowLength);
+
+      for (uint32_t i = 0; i < rowLength; ++i) {
+        row[i] += (noise[i] * amp);
+      }
+
+      amp += params.persistance;
+      freq *= params.lacunarity;
+    }
+
+    for (uint32_t i = 0; i < rowLength; ++i) {
+      int32_t x = startX + (int32_t)i;
+      float dist = glm::length(
+        glm::vec2(x, z) - (glm::vec2)params.middle) / params.maxDist;
+
+      row[i] = fmax(row[i], minHeight) * (1.0f - dist);
+      maxHeight = MAX(maxHeight, (int32_t)row[i]);
+    }
+  }
+
+  if (maxHeight <= minHeight) {
+    return;
+  }
+
+  // All the chunks the column needs get allocated in one go
+  int32_t firstChunkY = worldToChunkCoord(glm::vec3(0, minHeight, 0)).y;
+  int32_t lastChunkY = worldToChunkCoord(glm::vec3(0, maxHeight - 1, 0)).y;
+
+  column.chunkCount = lastChunkY - firstChunkY + 1;
+  column.chunks = flAllocv<Chunk *>(column.chunkCount);
+
+  for (uint32_t c = 0; c < column.chunkCount; ++c) {
+    Chunk *chunk = flAlloc<Chunk>();
+    chunk->voxels.store(mNullVoxels, std::memory_order_relaxed);
+    chunk->pending = flAlloc<ChunkVoxels>();
+    memset(chunk->pending, 0, sizeof(ChunkVoxels));
+    chunk->chunkCoord = glm::ivec3(
+      column.chunkCoord.x, firstChunkY + (int32_t)c, column.chunkCoord.y);
+
+    column.chunks[c] = chunk;
+  }
+
+  for (uint32_t c = 0; c < column.chunkCount; ++c) {
+    Chunk *chunk = column.chunks[c];
+    int32_t chunkY = (firstChunkY + (int32_t)c) * (int32_t)CHUNK_DIM;
 
-          currentChunk = getChunk(c);
-          currentChunkCoord = c;
+    for (int32_t z = startZ; z < endZ; ++z) {
+      for (int32_t x = startX; x < endX; ++x) {
+        float height = heights[z - startZ][x - startX];
 
-          markChunkForUpdate(currentChunk);
+        int32_t bottom = MAX(minHeight, chunkY);
+        int32_t top = MIN((int32_t)height, chunkY + (int32_t)CHUNK_DIM);
 
-          chunkOriginDiff = position -
-            currentChunkCoord * (int32_t)CHUNK_DIM;
+        for (int32_t y = bottom; y < top; ++y) {
+          float proportion = 1.0f - (y - minHeight) / (height - minHeight);
+          proportion *= 0.8f;
 
-          currentChunk->voxels[getVoxelIndex(chunkOriginDiff)].density = 
+          glm::ivec3 voxelCoord = glm::ivec3(
+            x - chunkX, y - chunkY, z - chunkZ);
+          chunk->pending->voxels[getVoxelIndex(voxelCoord)].density =
             (uint16_t)(mMaxVoxelDensity) * proportion;
         }
       }
     }
   }
+}
 
-  mUpdated = true;
+bool Terrain::queueModification(const TerrainModification &modification) {
+  if (!mModificationQueue.push(modification)) {
+    LOG_WARNING("Terrain modification queue is full\n");
+    return false;
+  }
+
+  return true;
 }
 
-void Terrain::queuePaint(
+bool Terrain::queuePaint(
   glm::vec3 position,
   glm::vec3 direction,
   float radius,
   float strength) {
-  // position /= (float)mTerrainScale;
+  TerrainModification modification;
+  modification.type = TerrainModificationType::DensityPaint;
+  modification.dp.rayStart = position;
+  modification.dp.rayDirection = direction;
+  modification.dp.radius = radius;
+  modification.dp.strength = strength;
+
+  return queueModification(modification);
+}
 
-  // For now, only allow 1 action to be queued
-  if (!mLockedActionQueue &&
-      Core::gThreadPool->isJobFinished(mModificationJob)) {
-    mModificationParams->terrain = this;
-    mModificationParams->type = TerrainModificationType::DensityPaint;
-    mModificationParams->dp.rayStart = position;
-    mModificationParams->dp.rayDirection = direction;
-    mModificationParams->dp.radius = radius;
-    mModificationParams->dp.strength = strength;
+bool Terrain::queuePaintColor(
+  glm::vec3 position,
+  glm::vec3 direction,
+  float radius,
+  const glm::vec3 &color) {
+  TerrainModification modification;
+  modification.type = TerrainModificationType::ColorPaint;
+  modification.cp.rayStart = position;
+  modification.cp.rayDirection = direction;
+  modification.cp.radius = radius;
+  modification.cp.color = color;
+
+  return queueModification(modification);
+}
+
+bool Terrain::queueSphere(float radius, glm::vec3 center, float intensity) {
+  TerrainModification modification;
+  modification.type = TerrainModificationType::AddSphere;
+  modification.as.centre = center;
+  modification.as.radius = radius;
+  modification.as.intensity = intensity;
 
-    Core::gThreadPool->startJob(mModificationJob, mModificationParams);
+  return queueModification(modification);
+}
+
+bool Terrain::queuePlane(float radius, glm::vec3 center, float intensity) {
+  TerrainModification modification;
+  modification.type = TerrainModificationType::AddPlane;
+  modification.ap.centre = center;
+  modification.ap.radius = radius;
+  modification.ap.intensity = intensity;
+
+  return queueModification(modification);
+}
+
+bool Terrain::startQueuedModifications() {
+  if (mModificationQueue.isEmpty() ||
+      !Core::gThreadPool->isJobFinished(mModificationJob)) {
+    return false;
   }
+
+  Core::gThreadPool->startJob(mModificationJob, this);
+
+  return true;
 }
 
 void Terrain::paint(
@@ -333,56 +549,262 @@ void Terrain::paint(
   glm::vec3 direction,
   float radius,
   float strength) {
-  position /= (float)mTerrainScale;
-
-  glm::vec3 step = glm::normalize(direction) / 2.0f;
+  TerrainModification modification;
+  modification.type = TerrainModificationType::DensityPaint;
+  modification.dp.rayStart = position;
+  modification.dp.rayDirection = direction;
+  modification.dp.radius = radius;
+  modification.dp.strength = strength;
+
+  applyModifications(&modification, 1);
+}
 
-  const uint32_t MAX_STEP_COUNT = 50;
+void Terrain::paintColor(
+  glm::vec3 position,
+  glm::vec3 direction,
+  float radius,
+  const glm::vec3 &color) {
+  TerrainModification modification;
+  modification.type = TerrainModificationType::ColorPaint;
+  modification.cp.rayStart = position;
+  modification.cp.rayDirection = direction;
+  modification.cp.radius = radius;
+  modification.cp.color = color;
+
+  applyModifications(&modification, 1);
+}
 
-  bool outside = true;
+void Terrain::applyModifications(
+  const TerrainModification *modifications, uint32_t count) {
+  float scale = (float)mTerrainScale;
+
+  // Brushes get placed against the terrain as it was before the batch
+  std::vector<TerrainRay> rays;
+  std::vector<uint32_t> rayModifications;
+
+  for (uint32_t i = 0; i < count; ++i) {
+    const TerrainModification &modification = modifications[i];
+
+    if (modification.type == TerrainModificationType::DensityPaint ||
+        modification.type == TerrainModificationType::ColorPaint) {
+      // dp and cp start with the same ray
+      rays.push_back({
+          modification.dp.rayStart,
+          modification.dp.rayDirection,
+          MAX_PAINT_VOXEL_DISTANCE * scale});
+      rayModifications.push_back(i);
+    }
+  }
 
-  for (int i = 0; i < MAX_STEP_COUNT; ++i) {
-    position += step;
-    glm::ivec3 chunkCoord = worldToChunkCoord(position);
-    Chunk *c = at(chunkCoord);
+  std::vector<TerrainRayHit> hits(rays.size());
+  raycast(rays.data(), hits.data(), (uint32_t)rays.size());
 
-    if (c) {
-      glm::ivec3 chunkOriginDiff = (glm::ivec3)position -
-        c->chunkCoord * (int32_t)CHUNK_DIM;
-      uint32_t voxelIndex = getVoxelIndex(chunkOriginDiff);
+  std::vector<ResolvedModification> resolved;
+  resolved.reserve(count);
 
-      if (c->voxels[voxelIndex].density > SURFACE_DENSITY && outside) {
-        step /= -2.0f;
-        outside = false;
+  for (uint32_t i = 0, ray = 0; i < count; ++i) {
+    const TerrainModification &modification = modifications[i];
 
-        break;
+    switch (modification.type) {
+    case TerrainModificationType::DensityPaint: {
+      const TerrainRayHit &hit = hits[ray++];
+      if (hit.isHit) {
+        resolved.push_back({
+            TerrainModificationType::AddSphere,
+            hit.wPosition / scale,
+            modification.dp.radius / scale,
+            modification.dp.strength});
       }
-      else if (c->voxels[voxelIndex].density < SURFACE_DENSITY && !outside) {
-        step /= -2.0f;
-        outside = true;
+    } break;
+
+    case TerrainModificationType::ColorPaint: {
+      // Voxels don't store any colour yet
+      ++ray;
+    } break;
+
+    case TerrainModificationType::AddSphere: {
+      resolved.push_back({
+          TerrainModificationType::AddSphere,
+          modification.as.centre / scale,
+          modification.as.radius / scale,
+          modification.as.intensity});
+    } break;
+
+    case TerrainModificationType::AddPlane: {
+      resolved.push_back({
+          TerrainModificationType::AddPlane,
+          modification.ap.centre / scale,
+          modification.ap.radius / scale,
+          modification.ap.intensity});
+    } break;
+    }
+  }
+
+  /*
+     Every modification gets paired with all the chunks it touches. The
+     chunk maps can only be modified from here, so chunks get created /
+     marked / copied before any of the tasks start.
+  */
+  std::vector<ChunkModification> chunkModifications;
+
+  for (uint32_t i = 0; i < resolved.size(); ++i) {
+    const ResolvedModification &modification = resolved[i];
+
+    glm::ivec3 start, end;
+    getModificationBounds(modification, start, end);
+
+    glm::ivec3 firstChunk = worldToChunkCoord(start);
+    glm::ivec3 lastChunk = worldToChunkCoord(end - 1);
+    float radius2 = modification.radius * modification.radius;
+
+    for (int32_t z = firstChunk.z; z <= lastChunk.z; ++z) {
+      for (int32_t y = firstChunk.y; y <= lastChunk.y; ++y) {
+        for (int32_t x = firstChunk.x; x <= lastChunk.x; ++x) {
+          glm::ivec3 chunkCoord = glm::ivec3(x, y, z);
+          glm::ivec3 chunkOrigin = chunkCoord * (int32_t)CHUNK_DIM;
+
+          // Closest voxel of the chunk which the modification may touch
+          glm::ivec3 closest = glm::clamp(
+            (glm::ivec3)glm::round(modification.centre),
+            glm::max(chunkOrigin, start),
+            glm::min(chunkOrigin + (int32_t)CHUNK_DIM, end) - 1);
+          glm::vec3 diff = (glm::vec3)closest - modification.centre;
+
+          if (glm::dot(diff, diff) > radius2) {
+            continue;
+          }
+
+          Chunk *chunk = getChunk(chunkCoord);
+          markChunkForUpdate(chunk);
+          beginChunkWrite(chunk);
+
+          chunkModifications.push_back({chunk->chunkStackIndex, i});
+        }
       }
     }
   }
 
-  if (!outside) {
-    makeSphere(radius, position * (float)mTerrainScale, strength);
+  if (chunkModifications.empty()) {
+    return;
+  }
+
+  // Each chunk's modifications end up next to each other, still in order
+  std::sort(
+    chunkModifications.begin(), chunkModifications.end(),
+    [](const ChunkModification &a, const ChunkModification &b) {
+      return a.chunkIndex < b.chunkIndex ||
+        (a.chunkIndex == b.chunkIndex &&
+         a.modificationIndex < b.modificationIndex);
+    });
+
+  std::vector<uint32_t> chunkStarts;
+  for (uint32_t i = 0; i < chunkModifications.size(); ++i) {
+    if (i == 0 || chunkModifications[i].chunkIndex !=
+        chunkModifications[i - 1].chunkIndex) {
+      chunkStarts.push_back(i);
+    }
   }
+
+  chunkStarts.push_back((uint32_t)chunkModifications.size());
+
+  ModificationParams params = {
+    this,
+    resolved.data(),
+    chunkModifications.data(),
+    chunkStarts.data()
+  };
+
+  Core::gThreadPool->parallelFor(
+    (uint32_t)chunkStarts.size() - 1, runChunkModificationTask, &params);
+
+  publishChunkWrites();
 }
 
-void Terrain::paintColor(
-  glm::vec3 position,
-  glm::vec3 direction,
-  float radius,
-  const glm::vec3 &color) {
-  
+void Terrain::getModificationBounds(
+  const ResolvedModification &modification,
+  glm::ivec3 &start, glm::ivec3 &end) const {
+  int32_t radius = (int32_t)modification.radius;
+  int32_t diameter = radius * 2 + 1;
+
+  start = (glm::ivec3)modification.centre - glm::ivec3(radius);
+  end = start + glm::ivec3(diameter);
+
+  if (modification.type == TerrainModificationType::AddPlane) {
+    start.y = (int32_t)modification.centre.y;
+    end.y = start.y + 1;
+  }
+}
+
+void Terrain::runChunkModificationTask(uint32_t index, void *data) {
+  auto *params = (ModificationParams *)data;
+  Terrain *terrain = params->terrain;
+
+  uint32_t first = params->chunkStarts[index];
+  uint32_t last = params->chunkStarts[index + 1];
+  Chunk *chunk = terrain->mLoadedChunks[
+    params->chunkModifications[first].chunkIndex];
+
+  for (uint32_t i = first; i < last; ++i) {
+    const ResolvedModification &modification = params->modifications[
+      params->chunkModifications[i].modificationIndex];
+
+    terrain->applyModification(chunk, modification);
+  }
+}
+
+void Terrain::applyModification(
+  Chunk *chunk, const ResolvedModification &modification) {
+  glm::ivec3 start, end;
+  getModificationBounds(modification, start, end);
+
+  glm::ivec3 chunkOrigin = chunk->chunkCoord * (int32_t)CHUNK_DIM;
+  glm::ivec3 first = glm::max(start, chunkOrigin);
+  glm::ivec3 last = glm::min(end, chunkOrigin + (int32_t)CHUNK_DIM);
+
+  float radius2 = modification.radius * modification.radius;
+
+  markDirty(chunk, first - chunkOrigin, last - chunkOrigin);
+
+  for (int32_t z = first.z; z < last.z; ++z) {
+    for (int32_t y = first.y; y < last.y; ++y) {
+      for (int32_t x = first.x; x < last.x; ++x) {
+        glm::ivec3 position = glm::ivec3(x, y, z);
+        glm::vec3 diff = (glm::vec3)position - modification.centre;
+
+        float distance2 = glm::dot(diff, diff);
+
+        if (distance2 > radius2) {
+          continue;
+        }
+
+        float proportion =
+          (1.0f - (distance2 / radius2)) * modification.intensity;
+        Voxel *v = &chunk->pending->voxels[
+          getVoxelIndex(position - chunkOrigin)];
+
+        if (modification.type == TerrainModificationType::AddSphere) {
+          int32_t addedValue = (int32_t)((proportion) * mMaxVoxelDensity);
+          int32_t finalValue = addedValue + (int32_t)v->density;
+          finalValue = glm::clamp(finalValue, 0, (int32_t)MAX_DENSITY);
+          v->density = finalValue;
+        }
+        else {
+          uint16_t addedValue = (uint32_t)((proportion) * mMaxVoxelDensity);
+          uint32_t finalValue = (uint32_t)addedValue + (uint32_t)v->density;
+          finalValue = glm::min(finalValue, MAX_DENSITY);
+          v->density = finalValue;
+        }
+      }
+    }
+  }
 }
 
 void Terrain::generateChunkFaceNormals(
-  Chunk *chunk,
-  Chunk *p, Chunk *n,
+  ChunkVoxels *voxels,
+  const ChunkVoxels *p, const ChunkVoxels *n,
   uint32_t dimension) {
-  auto density = [chunk, this](const glm::ivec3 &coord) {
-    return chunk->voxels[getVoxelIndex(coord)].density;
+  auto density = [voxels](const glm::ivec3 &coord) {
+    return voxels->voxels[getVoxelIndex(coord)].density;
   };
 
   glm::ivec3 diff[3] = {
@@ -393,7 +815,7 @@ void Terrain::generateChunkFaceNormals(
 
   apply2D(
     1, CHUNK_DIM - 1,
-    [this, chunk, density, diff, p, n, dimension](
+    [this, voxels, density, diff, p, n, dimension](
       const glm::ivec2 &voxelCoordXY) {
       // One pass for when z == CHUNK_DIM, one for when z == 0
       glm::ivec3 voxelCoord;
@@ -420,7 +842,7 @@ void Terrain::generateChunkFaceNormals(
             density(voxelCoord - diff[i]);
       }
 
-      setVoxelNormal(chunk, voxelCoord, grad);
+      setVoxelNormal(voxels, voxelCoord, grad);
 
       for (int i = 0, j = 0; i < 3; ++i) {
         if (i == dimension) {
@@ -442,142 +864,135 @@ void Terrain::generateChunkFaceNormals(
             density(voxelCoord - diff[i]);
       }
 
-      setVoxelNormal(chunk, voxelCoord, grad);
+      setVoxelNormal(voxels, voxelCoord, grad);
     });
 }
 
 void Terrain::setVoxelNormal(
-  Chunk *chunk,
+  ChunkVoxels *voxels,
   const glm::ivec3 &voxelCoord,
   const glm::vec3 &grad) {
   if (glm::dot(grad, grad) == 0.0f) {
-    chunk->voxels[getVoxelIndex(voxelCoord)].normalX = 0;
-    chunk->voxels[getVoxelIndex(voxelCoord)].normalY = 0;
-    chunk->voxels[getVoxelIndex(voxelCoord)].normalZ = 0;
+    voxels->voxels[getVoxelIndex(voxelCoord)].normalX = 0;
+    voxels->voxels[getVoxelIndex(voxelCoord)].normalY = 0;
+    voxels->voxels[getVoxelIndex(voxelCoord)].normalZ = 0;
   }
   else {
     glm::vec3 normal = -glm::normalize(grad);
 
-    chunk->voxels[getVoxelIndex(voxelCoord)].normalX =
+    voxels->voxels[getVoxelIndex(voxelCoord)].normalX =
       (int)(normal.x * 1000.0f);
-    chunk->voxels[getVoxelIndex(voxelCoord)].normalY =
+    voxels->voxels[getVoxelIndex(voxelCoord)].normalY =
       (int)(normal.y * 1000.0f);
-    chunk->voxels[getVoxelIndex(voxelCoord)].normalZ =
+    voxels->voxels[getVoxelIndex(voxelCoord)].normalZ =
       (int)(normal.z * 1000.0f);
   }
 }
 
-void Terrain::generateVoxelNormals() {
-  for (int i = 0; i < mUpdatedChunks.size; ++i) {
-    uint32_t chunkIndex = mUpdatedChunks[i];
-    Chunk *chunk = mLoadedChunks[chunkIndex];
+void Terrain::generateVoxelNormals(Chunk *chunk) {
+  ChunkVoxels *voxels = chunk->pending;
 
-    auto density = [chunk, this](const glm::ivec3 &coord) {
-      return chunk->voxels[getVoxelIndex(coord)].density;
-    };
+  auto density = [voxels](const glm::ivec3 &coord) {
+    return voxels->voxels[getVoxelIndex(coord)].density;
+  };
 
-    glm::ivec3 diff[3] = {
-      glm::ivec3(1, 0, 0),
-      glm::ivec3(0, 1, 0),
-      glm::ivec3(0, 0, 1)
-    };
+  glm::ivec3 diff[3] = {
+    glm::ivec3(1, 0, 0),
+    glm::ivec3(0, 1, 0),
+    glm::ivec3(0, 0, 1)
+  };
 
-    apply3D(
-      1, CHUNK_DIM - 1,
-      [this, chunk, density, diff](const glm::ivec3 &voxelCoord) {
-        glm::vec3 grad;
-        grad.x = density(voxelCoord + diff[0]) - density(voxelCoord - diff[0]);
-        grad.y = density(voxelCoord + diff[1]) - density(voxelCoord - diff[1]);
-        grad.z = density(voxelCoord + diff[2]) - density(voxelCoord - diff[2]);
-        setVoxelNormal(chunk, voxelCoord, grad);
-      });
-
-    Chunk *px = at(chunk->chunkCoord + glm::ivec3(1, 0, 0));
-    if (!px) px = mNullChunk;
-    Chunk *nx = at(chunk->chunkCoord - glm::ivec3(1, 0, 0));
-    if (!nx) nx = mNullChunk;
-    Chunk *py = at(chunk->chunkCoord + glm::ivec3(0, 1, 0));
-    if (!py) py = mNullChunk;
-    Chunk *ny = at(chunk->chunkCoord - glm::ivec3(0, 1, 0));
-    if (!ny) ny = mNullChunk;
-    Chunk *pz = at(chunk->chunkCoord + glm::ivec3(0, 0, 1));
-    if (!pz) pz = mNullChunk;
-    Chunk *nz = at(chunk->chunkCoord - glm::ivec3(0, 0, 1));
-    if (!nz) nz = mNullChunk;
-
-    generateChunkFaceNormals(chunk, px, nx, 0);
-    generateChunkFaceNormals(chunk, py, ny, 1);
-    generateChunkFaceNormals(chunk, pz, nz, 2);
-
-    auto densitym = [chunk, this](const glm::ivec3 &coord) {
-      glm::ivec3 chunkCoordOffset = glm::ivec3(0);
-      glm::ivec3 voxelCoord = coord;
-      for (int i = 0; i < 3; ++i) {
-        if (coord[i] > (int)CHUNK_DIM - 1) {
-          chunkCoordOffset[i] = 1;
-          voxelCoord[i] = 0;
-        }
-        else if (coord[i] < 0) {
-          chunkCoordOffset[i] = -1; 
-          voxelCoord[i] = (int)CHUNK_DIM - 1;
-        }
+  apply3D(
+    1, CHUNK_DIM - 1,
+    [this, voxels, density, diff](const glm::ivec3 &voxelCoord) {
+      glm::vec3 grad;
+      grad.x = density(voxelCoord + diff[0]) - density(voxelCoord - diff[0]);
+      grad.y = density(voxelCoord + diff[1]) - density(voxelCoord - diff[1]);
+      grad.z = density(voxelCoord + diff[2]) - density(voxelCoord - diff[2]);
+      setVoxelNormal(voxels, voxelCoord, grad);
+    });
+
+  // Neighbours which are also being written to use their new voxels
+  glm::ivec3 chunkCoord = chunk->chunkCoord;
+  const ChunkVoxels *px = latestVoxels(chunkCoord + glm::ivec3(1, 0, 0));
+  const ChunkVoxels *nx = latestVoxels(chunkCoord - glm::ivec3(1, 0, 0));
+  const ChunkVoxels *py = latestVoxels(chunkCoord + glm::ivec3(0, 1, 0));
+  const ChunkVoxels *ny = latestVoxels(chunkCoord - glm::ivec3(0, 1, 0));
+  const ChunkVoxels *pz = latestVoxels(chunkCoord + glm::ivec3(0, 0, 1));
+  const ChunkVoxels *nz = latestVoxels(chunkCoord - glm::ivec3(0, 0, 1));
+
+  generateChunkFaceNormals(voxels, px, nx, 0);
+  generateChunkFaceNormals(voxels, py, ny, 1);
+  generateChunkFaceNormals(voxels, pz, nz, 2);
+
+  auto densitym = [chunk, this](const glm::ivec3 &coord) {
+    glm::ivec3 chunkCoordOffset = glm::ivec3(0);
+    glm::ivec3 voxelCoord = coord;
+    for (int i = 0; i < 3; ++i) {
+      if (coord[i] > (int)CHUNK_DIM - 1) {
+        chunkCoordOffset[i] = 1;
+        voxelCoord[i] = 0;
+      }
+      else if (coord[i] < 0) {
+        chunkCoordOffset[i] = -1; 
+        voxelCoord[i] = (int)CHUNK_DIM - 1;
       }
+    }
 
-      Chunk *actualChunk = at(chunk->chunkCoord + chunkCoordOffset);
-      if (!actualChunk) actualChunk = mNullChunk;
+    const ChunkVoxels *actualVoxels = latestVoxels(
+      chunk->chunkCoord + chunkCoordOffset);
 
-      return actualChunk->voxels[getVoxelIndex(voxelCoord)].density;
-    };
+    return actualVoxels->voxels[getVoxelIndex(voxelCoord)].density;
+  };
+
+  glm::ivec3 corners[] = {
+    glm::ivec3(0, 0, 0) * int(CHUNK_DIM - 1),
+    glm::ivec3(0, 0, 1) * int(CHUNK_DIM - 1),
+    glm::ivec3(0, 1, 0) * int(CHUNK_DIM - 1),
+    glm::ivec3(0, 1, 1) * int(CHUNK_DIM - 1),
+
+    glm::ivec3(1, 0, 0) * int(CHUNK_DIM - 1),
+    glm::ivec3(1, 0, 1) * int(CHUNK_DIM - 1),
+    glm::ivec3(1, 1, 0) * int(CHUNK_DIM - 1),
+    glm::ivec3(1, 1, 1) * int(CHUNK_DIM - 1),
+  };
 
-    glm::ivec3 corners[] = {
-      glm::ivec3(0, 0, 0) * int(CHUNK_DIM - 1),
-      glm::ivec3(0, 0, 1) * int(CHUNK_DIM - 1),
-      glm::ivec3(0, 1, 0) * int(CHUNK_DIM - 1),
-      glm::ivec3(0, 1, 1) * int(CHUNK_DIM - 1),
+  for (int i = 0; i < 8; ++i) {
+    const glm::ivec3 &voxelCoord = corners[i];
+    glm::vec3 grad;
+    grad.x = densitym(voxelCoord + diff[0]) - densitym(voxelCoord - diff[0]);
+    grad.y = densitym(voxelCoord + diff[1]) - densitym(voxelCoord - diff[1]);
+    grad.z = densitym(voxelCoord + diff[2]) - densitym(voxelCoord - diff[2]);
+    setVoxelNormal(voxels, voxelCoord, grad);
+  }
 
-      glm::ivec3(1, 0, 0) * int(CHUNK_DIM - 1),
-      glm::ivec3(1, 0, 1) * int(CHUNK_DIM - 1),
-      glm::ivec3(1, 1, 0) * int(CHUNK_DIM - 1),
-      glm::ivec3(1, 1, 1) * int(CHUNK_DIM - 1),
+  // Edges
+  for (int dim = 0; dim < 3; ++dim) {
+    const glm::ivec2 PERMUTATIONS_2D[4] = {
+      glm::ivec2(0, 0),
+      glm::ivec2(0, 1),
+      glm::ivec2(1, 0),
+      glm::ivec2(1, 1)
     };
 
-    for (int i = 0; i < 8; ++i) {
-      const glm::ivec3 &voxelCoord = corners[i];
-      glm::vec3 grad;
-      grad.x = densitym(voxelCoord + diff[0]) - densitym(voxelCoord - diff[0]);
-      grad.y = densitym(voxelCoord + diff[1]) - densitym(voxelCoord - diff[1]);
-      grad.z = densitym(voxelCoord + diff[2]) - densitym(voxelCoord - diff[2]);
-      setVoxelNormal(chunk, voxelCoord, grad);
-    }
+    glm::ivec3 permutations[4];
+    for (int p = 0; p < 4; ++p) {
+      permutations[p][dim] = 0;
 
-    // Edges
-    for (int dim = 0; dim < 3; ++dim) {
-      const glm::ivec2 PERMUTATIONS_2D[4] = {
-        glm::ivec2(0, 0),
-        glm::ivec2(0, 1),
-        glm::ivec2(1, 0),
-        glm::ivec2(1, 1)
-      };
-
-      glm::ivec3 permutations[4];
-      for (int p = 0; p < 4; ++p) {
-        permutations[p][dim] = 0;
-
-        for (int i = 1; i < 3; ++i) {
-          permutations[p][(dim + i) % 3] =
-            PERMUTATIONS_2D[p][i - 1] * (CHUNK_DIM - 1);
-        }
+      for (int i = 1; i < 3; ++i) {
+        permutations[p][(dim + i) % 3] =
+          PERMUTATIONS_2D[p][i - 1] * (CHUNK_DIM - 1);
+      }
 
-        for (int component = 1; component < CHUNK_DIM - 1; ++component) {
-          glm::ivec3 voxelCoord = permutations[p];
-          voxelCoord[dim] = component;
+      for (int component = 1; component < CHUNK_DIM - 1; ++component) {
+        glm::ivec3 voxelCoord = permutations[p];
+        voxelCoord[dim] = component;
 
-          glm::vec3 grad;
-          grad.x = densitym(voxelCoord + diff[0])-densitym(voxelCoord - diff[0]);
-          grad.y = densitym(voxelCoord + diff[1])-densitym(voxelCoord - diff[1]);
-          grad.z = densitym(voxelCoord + diff[2])-densitym(voxelCoord - diff[2]);
-          setVoxelNormal(chunk, voxelCoord, grad);
-        }
+        glm::vec3 grad;
+        grad.x = densitym(voxelCoord + diff[0])-densitym(voxelCoord - diff[0]);
+        grad.y = densitym(voxelCoord + diff[1])-densitym(voxelCoord - diff[1]);
+        grad.z = densitym(voxelCoord + diff[2])-densitym(voxelCoord - diff[2]);
+        setVoxelNormal(voxels, voxelCoord, grad);
       }
     }
   }
@@ -591,13 +1006,235 @@ void Terrain::markChunkForUpdate(Chunk *chunk) {
   }
 }
 
-void Terrain::clearUpdatedChunks() {
+void Terrain::takeUpdatedChunks() {
   for (int i = 0; i < mUpdatedChunks.size; ++i) {
-    Chunk *chunk = mLoadedChunks[mUpdatedChunks[i]];
-    chunk->needsUpdating = false;
+    uint32_t chunkIndex = mUpdatedChunks[i];
+    mLoadedChunks[chunkIndex]->needsUpdating = false;
+    mMeshedChunks[i] = chunkIndex;
   }
 
+  mMeshedChunks.size = mUpdatedChunks.size;
   mUpdatedChunks.size = 0;
+
+  reclaimChunkVoxels();
+}
+
+void Terrain::clearUpdatedChunks() {
+  mMeshedChunks.size = 0;
+}
+
+ChunkVoxels *Terrain::beginChunkWrite(Chunk *chunk) {
+  if (!chunk->pending) {
+    ChunkVoxels *voxels = allocateChunkVoxels();
+    memcpy(voxels, chunk->read(), sizeof(ChunkVoxels));
+
+    chunk->pending = voxels;
+    chunk->dirtyStart = glm::ivec3(CHUNK_DIM);
+    chunk->dirtyEnd = glm::ivec3(0);
+    mPendingChunks.push_back(chunk);
+  }
+
+  return chunk->pending;
+}
+
+void Terrain::markDirty(
+  Chunk *chunk, const glm::ivec3 &start, const glm::ivec3 &end) {
+  chunk->dirtyStart = glm::min(chunk->dirtyStart, start);
+  chunk->dirtyEnd = glm::max(chunk->dirtyEnd, end);
+}
+
+void Terrain::updateDensityMips(Chunk *chunk) {
+  ChunkVoxels *voxels = chunk->pending;
+
+  // Normals within a voxel of what was written to changed as well
+  glm::ivec3 start = glm::max(chunk->dirtyStart - 1, glm::ivec3(0));
+  glm::ivec3 end = glm::min(chunk->dirtyEnd + 1, glm::ivec3(CHUNK_DIM));
+
+  if (glm::any(glm::greaterThanEqual(start, end))) {
+    return;
+  }
+
+  for (uint32_t level = 1; level < CHUNK_MIP_LEVEL_COUNT; ++level) {
+    const Voxel *src = voxels->mipLevel(level - 1);
+    Voxel *dst = voxels->mipLevel(level);
+
+    start = start / 2;
+    end = (end + 1) / 2;
+
+    for (int32_t z = start.z; z < end.z; ++z) {
+      for (int32_t y = start.y; y < end.y; ++y) {
+        for (int32_t x = start.x; x < end.x; ++x) {
+          glm::ivec3 coord = glm::ivec3(x, y, z);
+
+          uint32_t minDensity = MAX_DENSITY, maxDensity = 0, sum = 0;
+          glm::ivec3 normal = glm::ivec3(0);
+
+          for (int i = 0; i < 8; ++i) {
+            glm::ivec3 child = coord * 2 +
+              glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+            const Voxel &v = src[getMipVoxelIndex(child, level - 1)];
+
+            minDensity = MIN(minDensity, v.density);
+            maxDensity = MAX(maxDensity, v.density);
+            sum += v.density;
+            normal += glm::ivec3(v.normalX, v.normalY, v.normalZ);
+          }
+
+          Voxel &result = dst[getMipVoxelIndex(coord, level)];
+
+          switch (mMipReduction) {
+          case DensityMipReduction::Min: result.density = minDensity; break;
+          case DensityMipReduction::Max: result.density = maxDensity; break;
+          case DensityMipReduction::Average: result.density = sum / 8; break;
+          }
+
+          normal /= 8;
+          result.normalX = normal.x;
+          result.normalY = normal.y;
+          result.normalZ = normal.z;
+        }
+      }
+    }
+  }
+}
+
+bool Terrain::setDensityMipReduction(DensityMipReduction reduction) {
+  if (!Core::gThreadPool->isJobFinished(mModificationJob)) {
+    return false;
+  }
+
+  mMipReduction = reduction;
+
+  for (int i = 0; i < mLoadedChunks.size; ++i) {
+    Chunk *chunk = mLoadedChunks[i];
+
+    beginChunkWrite(chunk);
+    markDirty(chunk, glm::ivec3(0), glm::ivec3(CHUNK_DIM));
+    markChunkForUpdate(chunk);
+  }
+
+  publishChunkWrites();
+
+  return true;
+}
+
+DensityMipReduction Terrain::densityMipReduction() const {
+  return mMipReduction;
+}
+
+const ChunkVoxels *Terrain::latestVoxels(const glm::ivec3 &chunkCoord) {
+  Chunk *chunk = at(chunkCoord);
+
+  if (!chunk) {
+    return mNullVoxels;
+  }
+  else if (chunk->pending) {
+    return chunk->pending;
+  }
+  else {
+    return chunk->read();
+  }
+}
+
+void Terrain::runPublishTask(uint32_t index, void *data) {
+  auto *terrain = (Terrain *)data;
+  Chunk *chunk = terrain->mPendingChunks[index];
+
+  terrain->generateVoxelNormals(chunk);
+  terrain->updateDensityMips(chunk);
+  terrain->updateDensityBounds(chunk->pending);
+}
+
+void Terrain::publishChunkWrites() {
+  if (mPendingChunks.empty()) {
+    return;
+  }
+
+  // Tasks only write to their own chunk's pending voxels
+  Core::gThreadPool->parallelFor(
+    (uint32_t)mPendingChunks.size(), runPublishTask, this);
+
+  // Readers which started before this may still be looking at old versions
+  uint64_t epoch = mEpoch.load();
+
+  for (Chunk *chunk : mPendingChunks) {
+    ChunkVoxels *old = chunk->voxels.exchange(
+      chunk->pending, std::memory_order_acq_rel);
+    chunk->pending = nullptr;
+
+    if (old != mNullVoxels) {
+      mRetiredVoxels.push_back({old, epoch});
+    }
+  }
+
+  mEpoch.fetch_add(1);
+  mPendingChunks.clear();
+
+  reclaimChunkVoxels();
+}
+
+ChunkVoxels *Terrain::allocateChunkVoxels() {
+  if (mFreeVoxels.empty()) {
+    return flAlloc<ChunkVoxels>();
+  }
+  else {
+    ChunkVoxels *voxels = mFreeVoxels.back();
+    mFreeVoxels.pop_back();
+    return voxels;
+  }
+}
+
+void Terrain::reclaimChunkVoxels() {
+  uint64_t oldestReader = UINT64_MAX;
+  for (uint32_t i = 0; i < MAX_READERS; ++i) {
+    uint64_t epoch = mReaderEpochs[i].load();
+    if (epoch) {
+      oldestReader = MIN(oldestReader, epoch);
+    }
+  }
+
+  // Versions retired in an epoch all readers started after can be reused
+  uint32_t kept = 0;
+  for (uint32_t i = 0; i < mRetiredVoxels.size(); ++i) {
+    if (mRetiredVoxels[i].epoch < oldestReader) {
+      mFreeVoxels.push_back(mRetiredVoxels[i].voxels);
+    }
+    else {
+      mRetiredVoxels[kept++] = mRetiredVoxels[i];
+    }
+  }
+
+  mRetiredVoxels.resize(kept);
+}
+
+uint32_t Terrain::beginReading() {
+  mChunkMapMutex.lock_shared();
+
+  for (;;) {
+    for (uint32_t i = 0; i < MAX_READERS; ++i) {
+      uint64_t freeSlot = 0;
+      uint64_t epoch = mEpoch.load();
+
+      if (mReaderEpochs[i].compare_exchange_strong(freeSlot, epoch)) {
+        // The writer may have retired versions before it saw the slot
+        uint64_t current = mEpoch.load();
+        while (current != epoch) {
+          epoch = current;
+          mReaderEpochs[i].store(epoch);
+          current = mEpoch.load();
+        }
+
+        return i;
+      }
+    }
+
+    std::this_thread::yield();
+  }
+}
+
+void Terrain::endReading(uint32_t reader) {
+  mReaderEpochs[reader].store(0);
+  mChunkMapMutex.unlock_shared();
 }
 
 void Terrain::addToFlatChunkIndices(Chunk *chunk) {
@@ -637,7 +1274,7 @@ const Voxel &Terrain::getVoxel(const glm::vec3 &position) const {
   const Chunk *chunk = at(chunkCoord);
 
   if (chunk) {
-    return chunk->voxels[getVoxelIndex(iposition)];
+    return chunk->read()->voxels[getVoxelIndex(iposition)];
   }
   else {
     static Voxel nullVoxel = {};
@@ -645,17 +1282,337 @@ const Voxel &Terrain::getVoxel(const glm::vec3 &position) const {
   }
 }
 
-int Terrain::runTerrainModification(void *data) {
-  auto *params = (TerrainModificationParams *)data;
-  Terrain *terrain = params->terrain;
+const Voxel &Terrain::getVoxel(
+  const glm::ivec3 &voxelCoord, uint32_t mipLevel) const {
+  glm::ivec3 chunkCoord = (glm::ivec3)glm::floor(
+    (glm::vec3)voxelCoord / (float)CHUNK_DIM);
+  const Chunk *chunk = at(chunkCoord);
+
+  if (chunk) {
+    mipLevel = MIN(mipLevel, CHUNK_MIP_LEVEL_COUNT - 1);
+    glm::ivec3 coord = (voxelCoord - chunkCoord * (int32_t)CHUNK_DIM) >>
+      (int32_t)mipLevel;
+
+    return chunk->read()->mipLevel(mipLevel)[getMipVoxelIndex(coord, mipLevel)];
+  }
+  else {
+    static Voxel nullVoxel = {};
+    return nullVoxel;
+  }
+}
+
+/*
+   Amanatides & Woo: steps from one grid cell to the next one the ray
+   enters, along whichever axis has the closest boundary.
+*/
+struct GridTraversal {
+  glm::ivec3 cell;
+  glm::ivec3 step;
+  // Ray parameter at which the next boundary along each axis gets crossed
+  glm::vec3 tNext;
+  glm::vec3 tDelta;
+  float t;
+  // Axis of the last step (-1 before the first one)
+  int axis;
+
+  void init(
+    const glm::vec3 &origin, const glm::vec3 &direction,
+    float cellSize, float tStart) {
+    glm::vec3 position = origin + direction * tStart;
+
+    cell = (glm::ivec3)glm::floor(position / cellSize);
+    t = tStart;
+    axis = -1;
+
+    for (int i = 0; i < 3; ++i) {
+      if (direction[i] > 0.0f) {
+        step[i] = 1;
+        tNext[i] = tStart +
+          ((float)(cell[i] + 1) * cellSize - position[i]) / direction[i];
+        tDelta[i] = cellSize / direction[i];
+      }
+      else if (direction[i] < 0.0f) {
+        step[i] = -1;
+        tNext[i] = tStart +
+          ((float)cell[i] * cellSize - position[i]) / direction[i];
+        tDelta[i] = -cellSize / direction[i];
+      }
+      else {
+        step[i] = 0;
+        tNext[i] = INFINITY;
+        tDelta[i] = INFINITY;
+      }
+    }
+  }
+
+  float exitT() const {
+    return glm::min(tNext.x, glm::min(tNext.y, tNext.z));
+  }
+
+  void advance() {
+    axis = 0;
+    if (tNext.y < tNext[axis]) axis = 1;
+    if (tNext.z < tNext[axis]) axis = 2;
+
+    t = tNext[axis];
+    cell[axis] += step[axis];
+    tNext[axis] += tDelta[axis];
+  }
+};
+
+TerrainRayHit Terrain::raycast(const TerrainRay &ray) {
+  uint32_t reader = beginReading();
+  TerrainRayHit hit = traceRay(ray);
+  endReading(reader);
+
+  return hit;
+}
+
+TerrainRayHit Terrain::traceRay(const TerrainRay &ray) {
+  TerrainRayHit hit = {};
+
+  float scale = (float)mTerrainScale;
+  glm::vec3 origin = ray.wStart / scale;
+  glm::vec3 direction = glm::normalize(ray.wDirection);
+  float maxT = ray.maxDistance / scale;
+
+  auto isOverSurface = [this, &origin, &direction](float t) {
+    return sampleDensity(origin + direction * t) > SURFACE_DENSITY;
+  };
+
+  auto fillHit = [&](float t, Chunk *chunk, const glm::ivec3 &voxelCoord) {
+    glm::vec3 position = origin + direction * t;
+
+    glm::vec3 gradient = glm::vec3(
+      sampleDensity(position + glm::vec3(0.5f, 0.0f, 0.0f)) -
+      sampleDensity(position - glm::vec3(0.5f, 0.0f, 0.0f)),
+      sampleDensity(position + glm::vec3(0.0f, 0.5f, 0.0f)) -
+      sampleDensity(position - glm::vec3(0.0f, 0.5f, 0.0f)),
+      sampleDensity(position + glm::vec3(0.0f, 0.0f, 0.5f)) -
+      sampleDensity(position - glm::vec3(0.0f, 0.0f, 0.5f)));
+
+    // Density increases going into the terrain
+    hit.wNormal = glm::dot(gradient, gradient) > 0.0f ?
+      -glm::normalize(gradient) : -direction;
+
+    hit.isHit = true;
+    hit.distance = t * scale;
+    hit.wPosition = position * scale;
+    hit.chunk = chunk;
+    hit.voxelCoord = voxelCoord;
+  };
+
+  if (isOverSurface(0.0f)) {
+    // Started inside the terrain
+    glm::ivec3 voxel = (glm::ivec3)glm::floor(origin);
+    glm::ivec3 chunkCoord = worldToChunkCoord(origin);
+    fillHit(0.0f, at(chunkCoord), voxel - chunkCoord * (int32_t)CHUNK_DIM);
+
+    return hit;
+  }
+
+  // Last point on the ray which is known to be under the surface density
+  float tOutside = 0.0f;
+
+  GridTraversal chunks;
+  chunks.init(origin, direction, (float)CHUNK_DIM, 0.0f);
+
+  while (chunks.t < maxT) {
+    float chunkExitT = glm::min(chunks.exitT(), maxT);
+
+    if (!canContainSurface(chunks.cell)) {
+      tOutside = chunkExitT;
+      chunks.advance();
+      continue;
+    }
+
+    Chunk *chunk = at(chunks.cell);
+    if (chunk && chunk->chunkCoord != chunks.cell) {
+      chunk = nullptr;
+    }
+
+    const ChunkVoxels *chunkVoxels = chunk ? chunk->read() : nullptr;
+
+    glm::ivec3 chunkOrigin = chunks.cell * (int32_t)CHUNK_DIM;
+
+    GridTraversal voxels;
+    voxels.init(origin, direction, 1.0f, chunks.t);
+    // Rounding can put the first voxel just across the chunk boundary
+    voxels.cell = glm::clamp(
+      voxels.cell, chunkOrigin, chunkOrigin + (int32_t)CHUNK_DIM - 1);
+
+    while (voxels.t < chunkExitT) {
+      glm::ivec3 voxelCoord = voxels.cell - chunkOrigin;
+
+      if (glm::any(glm::lessThan(voxelCoord, glm::ivec3(0))) ||
+          glm::any(glm::greaterThanEqual(
+            voxelCoord, glm::ivec3(CHUNK_DIM)))) {
+        break;
+      }
+
+      // The cell's densities get interpolated between its 8 corners
+      uint16_t maxCorner = 0;
+      bool isInterior = chunk &&
+        glm::all(glm::lessThan(voxelCoord, glm::ivec3(CHUNK_DIM - 1)));
+
+      for (int i = 0; i < 8; ++i) {
+        glm::ivec3 corner = glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+        uint16_t density = isInterior ?
+          chunkVoxels->voxels[getVoxelIndex(voxelCoord + corner)].density :
+          voxelDensity(voxels.cell + corner);
+
+        maxCorner = MAX(maxCorner, density);
+      }
+
+      float cellExitT = glm::min(voxels.exitT(), maxT);
+
+      if (maxCorner > SURFACE_DENSITY) {
+        for (uint32_t i = 1; i <= RAYCAST_CELL_SAMPLE_COUNT; ++i) {
+          float t = voxels.t + (cellExitT - voxels.t) *
+            (float)i / (float)RAYCAST_CELL_SAMPLE_COUNT;
+
+          if (isOverSurface(t)) {
+            // Narrow down where exactly the surface gets crossed
+            float a = tOutside, b = t;
+            for (uint32_t j = 0; j < RAYCAST_REFINE_COUNT; ++j) {
+              float middle = (a + b) * 0.5f;
+
+              if (isOverSurface(middle)) {
+                b = middle;
+              }
+              else {
+                a = middle;
+              }
+            }
+
+            fillHit(b, chunk, voxelCoord);
+
+            return hit;
+          }
+
+          tOutside = t;
+        }
+      }
+
+      tOutside = cellExitT;
+      voxels.advance();
+    }
+
+    chunks.advance();
+  }
+
+  return hit;
+}
+
+void Terrain::raycast(
+  const TerrainRay *rays, TerrainRayHit *hits, uint32_t count) {
+  // The tasks all read under this one
+  uint32_t reader = beginReading();
+
+  if (count <= RAYCAST_BATCH_SIZE) {
+    for (uint32_t i = 0; i < count; ++i) {
+      hits[i] = traceRay(rays[i]);
+    }
+  }
+  else {
+    RaycastParams params = {this, rays, hits, count};
+    uint32_t batchCount = (count + RAYCAST_BATCH_SIZE - 1) / RAYCAST_BATCH_SIZE;
+
+    Core::gThreadPool->parallelFor(batchCount, runRaycastTask, &params);
+  }
+
+  endReading(reader);
+}
+
+void Terrain::runRaycastTask(uint32_t index, void *data) {
+  auto *params = (RaycastParams *)data;
+
+  uint32_t start = index * RAYCAST_BATCH_SIZE;
+  uint32_t end = MIN(start + RAYCAST_BATCH_SIZE, params->count);
+
+  for (uint32_t i = start; i < end; ++i) {
+    params->hits[i] = params->terrain->traceRay(params->rays[i]);
+  }
+}
+
+float Terrain::sampleDensity(const glm::vec3 &position) {
+  glm::vec3 base = glm::floor(position);
+  glm::vec3 f = position - base;
+  glm::ivec3 b = (glm::ivec3)base;
+
+  float c000 = voxelDensity(b);
+  float c100 = voxelDensity(b + glm::ivec3(1, 0, 0));
+  float c010 = voxelDensity(b + glm::ivec3(0, 1, 0));
+  float c110 = voxelDensity(b + glm::ivec3(1, 1, 0));
+  float c001 = voxelDensity(b + glm::ivec3(0, 0, 1));
+  float c101 = voxelDensity(b + glm::ivec3(1, 0, 1));
+  float c011 = voxelDensity(b + glm::ivec3(0, 1, 1));
+  float c111 = voxelDensity(b + glm::ivec3(1, 1, 1));
+
+  float c00 = glm::mix(c000, c100, f.x);
+  float c10 = glm::mix(c010, c110, f.x);
+  float c01 = glm::mix(c001, c101, f.x);
+  float c11 = glm::mix(c011, c111, f.x);
+
+  return glm::mix(glm::mix(c00, c10, f.y), glm::mix(c01, c11, f.y), f.z);
+}
+
+bool Terrain::canContainSurface(const glm::ivec3 &chunkCoord) {
+  // Cells on the chunk's far faces also use the neighbouring chunks' voxels
+  for (int i = 0; i < 8; ++i) {
+    glm::ivec3 coord = chunkCoord + glm::ivec3(i & 1, (i >> 1) & 1, i >> 2);
+    Chunk *chunk = at(coord);
+
+    // Chunk coords wrap around in the hash so make sure it's the right one
+    if (chunk && chunk->chunkCoord == coord &&
+        chunk->read()->maxDensity > SURFACE_DENSITY) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint16_t Terrain::voxelDensity(const glm::ivec3 &voxelCoord) {
+  glm::ivec3 chunkCoord = (glm::ivec3)glm::floor(
+    (glm::vec3)voxelCoord / (float)CHUNK_DIM);
+  Chunk *chunk = at(chunkCoord);
+
+  if (chunk && chunk->chunkCoord == chunkCoord) {
+    return chunk->read()->voxels[
+      getVoxelIndex(voxelCoord - chunkCoord * (int32_t)CHUNK_DIM)].density;
+  }
+  else {
+    return 0;
+  }
+}
+
+void Terrain::updateDensityBounds(ChunkVoxels *voxels) {
+  uint16_t minDensity = MAX_DENSITY, maxDensity = 0;
+
+  for (uint32_t i = 0; i < CHUNK_VOLUME; ++i) {
+    minDensity = MIN(minDensity, voxels->voxels[i].density);
+    maxDensity = MAX(maxDensity, voxels->voxels[i].density);
+  }
+
+  voxels->minDensity = minDensity;
+  voxels->maxDensity = maxDensity;
+}
+
+int Terrain::runTerrainModifications(void *data) {
+  auto *terrain = (Terrain *)data;
+
+  // Everything that was queued up to now goes in one batch
+  terrain->mModificationBatch.clear();
+
+  TerrainModification modification;
+  while (terrain->mModificationQueue.pop(modification)) {
+    terrain->mModificationBatch.push_back(modification);
+  }
 
-  // TODD: Add support for different types of operations
-  
-  terrain->paint(
-    params->dp.rayStart,
-    params->dp.rayDirection,
-    params->dp.radius,
-    params->dp.strength);
+  terrain->applyModifications(
+    terrain->mModificationBatch.data(),
+    (uint32_t)terrain->mModificationBatch.size());
 
   return 0;
 }
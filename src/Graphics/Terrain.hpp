@@ -1,10 +1,15 @@
 #pragma once
 
+#include <atomic>
+#include <vector>
+#include <shared_mutex>
 #include "Chunk.hpp"
+#include "Event.hpp"
 #include "Buffer.hpp"
 #include "Worker.hpp"
 #include "FastMap.hpp"
 #include "QuadTree.hpp"
+#include "TerrainModificationQueue.hpp"
 #include "VulkanArenaAllocator.hpp"
 
 /* 
@@ -19,6 +24,24 @@ class PlanetRenderer;
 class Clipping;
 struct VulkanFrame;
 
+// Positions / distances are in world space (not divided by the terrain scale)
+struct TerrainRay {
+  glm::vec3 wStart;
+  glm::vec3 wDirection;
+  float maxDistance;
+};
+
+struct TerrainRayHit {
+  bool isHit;
+  float distance;
+  // Where the ray crosses the (interpolated) surface
+  glm::vec3 wPosition;
+  glm::vec3 wNormal;
+  // Voxel cell in which the surface was hit (chunk is null if not loaded)
+  Chunk *chunk;
+  glm::ivec3 voxelCoord;
+};
+
 class Terrain {
 public:
   Terrain() = default;
@@ -31,8 +54,22 @@ public:
     float persistance, float lacunarity,
     float baseAmplitude, float baseFrequency,
     glm::vec2 s, glm::vec2 e);
+  /*
+     Same islands as makeIslands but they get generated by a background job,
+     chunk columns closest to wFocus first. Chunks get handed to the terrain
+     as they're done (see handOffGeneratedChunks) and onProgress receives an
+     EventTerrainGenerationProgress every time that happens.
+  */
+  void queueIslands(
+    float seaLevel, uint32_t octaveCount,
+    float persistance, float lacunarity,
+    float baseAmplitude, float baseFrequency,
+    glm::vec2 s, glm::vec2 e,
+    const glm::vec3 &wFocus,
+    Core::OnEventProc onProgress);
   void makePlane(float radius, glm::vec3 center, float intensity = 1.0f);
 
+  // These apply the modification straight away
   void paint(
     glm::vec3 position,
     glm::vec3 direction,
@@ -45,12 +82,43 @@ public:
     float radius,
     const glm::vec3 &color);
 
-  void queuePaint(
+  /*
+     Any thread can queue modifications. They get applied in batches by the
+     modification job, in between meshing passes (see TerrainRenderer::sync).
+     These only return false if the queue is full.
+  */
+  bool queueModification(const TerrainModification &modification);
+
+  bool queuePaint(
     glm::vec3 position,
     glm::vec3 direction,
     float radius,
     float strength);
 
+  bool queuePaintColor(
+    glm::vec3 position,
+    glm::vec3 direction,
+    float radius,
+    const glm::vec3 &color);
+
+  bool queueSphere(float radius, glm::vec3 center, float intensity = 1.0f);
+  bool queuePlane(float radius, glm::vec3 center, float intensity = 1.0f);
+
+  /*
+     Starts the modification job if anything was queued. It can run at the
+     same time as the meshing job - it only ever publishes new versions of
+     the chunks.
+  */
+  bool startQueuedModifications();
+
+  /*
+     Brushes get placed with a batch of raycasts, then every chunk which
+     gets touched has all of its modifications applied (in order) by one
+     task - the chunks are spread across the workers.
+  */
+  void applyModifications(
+    const TerrainModification *modifications, uint32_t count);
+
   // Creates a chunk if it doesn't exist
   Chunk *getChunk(const glm::ivec3 &coord);
   // Doesn't create a chunk if it doesn't exist
@@ -62,11 +130,51 @@ public:
 
   // position isn't scaled by mTerrainScale
   const Voxel &getVoxel(const glm::vec3 &position) const;
+  // Voxel of the chunk's mip level which covers voxelCoord (level 0 voxels)
+  const Voxel &getVoxel(const glm::ivec3 &voxelCoord, uint32_t mipLevel) const;
+
+  /*
+     Rebuilds the mip pyramids of all the chunks (marks them for update).
+     Can't overlap the modification job - returns false (and changes
+     nothing) while one is running.
+  */
+  bool setDensityMipReduction(DensityMipReduction reduction);
+  DensityMipReduction densityMipReduction() const;
+
+  /*
+     Walks the voxel cells along the ray (skipping chunks which can't
+     contain the surface) until the interpolated density goes over the
+     surface density.
+     Can run on any thread, even while the terrain gets modified. The
+     batched version spreads the rays across the workers.
+  */
+  TerrainRayHit raycast(const TerrainRay &ray);
+  void raycast(const TerrainRay *rays, TerrainRayHit *hits, uint32_t count);
 
-  void generateVoxelNormals();
+  /*
+     Readers of the chunks which run alongside the modification job (i.e.
+     meshing) need to be inside one of these: the chunk versions they see
+     don't get reclaimed and no chunks get added in the meantime.
+  */
+  uint32_t beginReading();
+  void endReading(uint32_t reader);
 
+  /*
+     The chunks which were updated so far become the ones the next meshing
+     pass looks at (mMeshedChunks). Main thread, while no modification job
+     is running.
+  */
+  void takeUpdatedChunks();
+  // Called by the meshing job once it is done with mMeshedChunks
   void clearUpdatedChunks();
 
+  /*
+     Adds the chunks which were generated in the background since the last
+     call and marks them for update. Only call this when nothing else is
+     touching the terrain (no meshing / modification job running).
+  */
+  void handOffGeneratedChunks();
+
 private:
   template <typename Proc>
   void apply3D(int start, int end, Proc applyProc) {
@@ -88,76 +196,208 @@ private:
     }
   }
 
+  // Generates the normals of the chunk's pending voxels
+  void generateVoxelNormals(Chunk *chunk);
+
   void generateChunkFaceNormals(
-    Chunk *chunk,
-    Chunk *p, Chunk *n,
+    ChunkVoxels *voxels,
+    const ChunkVoxels *p, const ChunkVoxels *n,
     uint32_t dimension);
 
   void setVoxelNormal(
-    Chunk *chunk,
+    ChunkVoxels *voxels,
     const glm::ivec3 &voxelCoord,
     const glm::vec3 &grad);
 
+  /*
+     Copy on write: the first call for a chunk makes a copy of its published
+     voxels which gets written to instead (chunk->pending). Only one writer
+     at a time: the modification job, or the main thread while it's idle.
+  */
+  ChunkVoxels *beginChunkWrite(Chunk *chunk);
+  /*
+     Generates normals / density bounds of all the pending copies, swaps them
+     in and retires the previous versions.
+  */
+  void publishChunkWrites();
+  // Pending voxels of the chunk if it's being written to, the published ones
+  // otherwise (only for the writer)
+  const ChunkVoxels *latestVoxels(const glm::ivec3 &chunkCoord);
+  ChunkVoxels *allocateChunkVoxels();
+  // Frees retired versions which no reader can still be looking at
+  void reclaimChunkVoxels();
+
+  static void runPublishTask(uint32_t index, void *data);
+
+  // Grows the region of the chunk's pending voxels which was written to
+  void markDirty(Chunk *chunk, const glm::ivec3 &start, const glm::ivec3 &end);
+  // Only the part of the pyramid above the dirty region gets rebuilt
+  void updateDensityMips(Chunk *chunk);
+
+  // Trilinear interpolation of the densities (voxel space)
+  float sampleDensity(const glm::vec3 &position);
+  uint16_t voxelDensity(const glm::ivec3 &voxelCoord);
+  bool canContainSurface(const glm::ivec3 &chunkCoord);
+  void updateDensityBounds(ChunkVoxels *voxels);
+
+  struct RaycastParams {
+    Terrain *terrain;
+    const TerrainRay *rays;
+    TerrainRayHit *hits;
+    uint32_t count;
+  };
+
+  // raycast without beginReading / endReading
+  TerrainRayHit traceRay(const TerrainRay &ray);
+  static void runRaycastTask(uint32_t index, void *data);
+
+  // Gives the chunk an index and adds it to the chunk maps
+  void insertChunk(Chunk *chunk);
   void markChunkForUpdate(Chunk *chunk);
   void addToFlatChunkIndices(Chunk *chunk);
   Chunk *getFirstFlatChunk(glm::ivec2 flatCoord) const;
 
-  enum TerrainModificationType {
-    DensityPaint,
-    ColorPaint,
-    AddSphere
-    /* ... */
+  // Modification in voxel space, once brushes have been placed
+  struct ResolvedModification {
+    TerrainModificationType type;
+    glm::vec3 centre;
+    float radius;
+    float intensity;
+  };
+
+  struct ChunkModification {
+    uint32_t chunkIndex;
+    uint32_t modificationIndex;
   };
 
-  struct TerrainModificationParams {
+  struct ModificationParams {
     Terrain *terrain;
-    TerrainModificationType type;
+    const ResolvedModification *modifications;
+    // Sorted by chunk, chunkStarts[i] is where chunk i's modifications start
+    const ChunkModification *chunkModifications;
+    const uint32_t *chunkStarts;
+  };
+
+  static int runTerrainModifications(void *data);
+  static void runChunkModificationTask(uint32_t index, void *data);
+
+  // Voxels [start, end) which the modification may touch
+  void getModificationBounds(
+    const ResolvedModification &modification,
+    glm::ivec3 &start, glm::ivec3 &end) const;
+  // Only writes to the voxels within the chunk
+  void applyModification(
+    Chunk *chunk, const ResolvedModification &modification);
+
+  // makeIslands runs a task for every chunk column (16x16 voxel columns)
+  struct IslandColumn {
+    glm::ivec2 chunkCoord;
+    // Chunks the column wrote to, from the lowest one up
+    Chunk **chunks;
+    uint32_t chunkCount;
+  };
 
-    union {
-      struct {
-        glm::vec3 rayStart;
-        glm::vec3 rayDirection;
-        float radius;
-        float strength;
-      } dp;
-
-      struct {
-        glm::vec3 rayStart;
-        glm::vec3 rayDirection;
-      } cp;
-
-      struct {
-        glm::vec3 centre;
-        float radius;
-        // Color information
-      } as;
-    };
+  struct IslandParams {
+    Terrain *terrain;
+    float seaLevel;
+    uint32_t octaveCount;
+    float persistance;
+    float lacunarity;
+    float baseAmplitude;
+    float baseFrequency;
+    glm::ivec2 start;
+    glm::ivec2 end;
+    glm::ivec2 middle;
+    float maxDist;
+    glm::vec2 range;
+    int32_t minHeight;
+    IslandColumn *columns;
+    uint32_t columnCount;
+    // Columns [0, finishedColumnCount) can be handed off (queueIslands)
+    std::atomic<uint32_t> finishedColumnCount;
   };
 
-  static int runTerrainModification(void *data);
+  // Fills in everything but the columns' chunks - returns false if empty
+  bool initIslandParams(
+    IslandParams &params,
+    float seaLevel, uint32_t octaveCount,
+    float persistance, float lacunarity,
+    float baseAmplitude, float baseFrequency,
+    glm::vec2 s, glm::vec2 e);
+
+  static void runIslandColumnTask(uint32_t index, void *data);
+  static int runIslandGeneration(void *data);
+  /*
+     Heights of the column come from whole rows of noise at a time. The
+     column's chunks are always freshly allocated and never touch the chunk
+     maps so this can run on any thread - handOffIslandColumn adds them.
+  */
+  void makeIslandColumn(const IslandParams &params, IslandColumn &column);
+  // Returns how many of the column's chunks are new to the terrain
+  uint32_t handOffIslandColumn(IslandColumn &column);
 
 private:
   static constexpr uint32_t MAX_DENSITY = 0xFFFF;
   static constexpr uint32_t MAX_CHUNKS = 3000;
   static constexpr uint32_t SURFACE_DENSITY = 30000;
+  // Rays per task in batched raycasts
+  static constexpr uint32_t RAYCAST_BATCH_SIZE = 32;
+  // Samples per voxel cell and bisection steps to find the surface
+  static constexpr uint32_t RAYCAST_CELL_SAMPLE_COUNT = 4;
+  static constexpr uint32_t RAYCAST_REFINE_COUNT = 8;
+  static constexpr float MAX_PAINT_VOXEL_DISTANCE = 512.0f;
+  static constexpr uint32_t MAX_READERS = 8;
 
   int mTerrainScale;
   float mChunkWidth;
   float mMaxVoxelDensity;
-  Chunk *mNullChunk;
+  DensityMipReduction mMipReduction;
+  // Published voxels of new chunks (empty) - never retired
+  ChunkVoxels *mNullVoxels;
   Array<Chunk *> mLoadedChunks;
+  // Written to by the writer
   Array<uint32_t> mUpdatedChunks;
+  // Read by the meshing job
+  Array<uint32_t> mMeshedChunks;
   // Maps 3-D chunk coord to the chunk's index in the mLoadedChunks array
   FastMap<uint32_t, MAX_CHUNKS, 30, 10> mChunkIndices;
   // Points to a linked list of chunks all of which are at a certain x-z
   FastMap<uint32_t, MAX_CHUNKS, 30, 10> mFlatChunkIndices;
 
   Core::JobID mModificationJob;
-  TerrainModificationParams *mModificationParams;
+  TerrainModificationQueue mModificationQueue;
+  // Modifications which the job popped off the queue
+  std::vector<TerrainModification> mModificationBatch;
+
+  // Chunks which have pending voxels
+  std::vector<Chunk *> mPendingChunks;
+
+  struct RetiredVoxels {
+    ChunkVoxels *voxels;
+    // Value of mEpoch just before the voxels stopped being published
+    uint64_t epoch;
+  };
+
+  /*
+     Epoch based reclamation: readers announce the epoch they started in,
+     retired versions get reused once every active reader started after
+     they were retired.
+  */
+  std::atomic<uint64_t> mEpoch;
+  // 0 when the slot is free
+  std::atomic<uint64_t> mReaderEpochs[MAX_READERS];
+  std::vector<RetiredVoxels> mRetiredVoxels;
+  std::vector<ChunkVoxels *> mFreeVoxels;
+  // Adding chunks to the maps waits for readers to be done
+  std::shared_mutex mChunkMapMutex;
+
+  // Background island generation (queueIslands), null when there is none
+  Core::JobID mIslandJob;
+  IslandParams *mIslandParams;
+  uint32_t mHandedOffColumnCount;
+  Core::OnEventProc mOnGenerationProgress;
 
   bool mUpdated;
-  // The terrain renderer may toggle this if it decides to update isogroups
-  bool mLockedActionQueue;
 
   friend class TerrainRenderer;
   friend class Isosurface;
@@ -0,0 +1,72 @@
+#include "Memory.hpp"
+#include "TerrainModificationQueue.hpp"
+
+namespace Ondine::Graphics {
+
+void TerrainModificationQueue::init() {
+  mSlots = flAllocv<Slot>(CAPACITY);
+
+  for (uint32_t i = 0; i < CAPACITY; ++i) {
+    mSlots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  mHead.store(0, std::memory_order_relaxed);
+  mTail.store(0, std::memory_order_relaxed);
+}
+
+/*
+   A slot with sequence == position can be written to by whichever producer
+   claims position, sequence == position + 1 means it can be read.
+*/
+bool TerrainModificationQueue::push(const TerrainModification &modification) {
+  uint32_t position = mHead.load(std::memory_order_relaxed);
+
+  for (;;) {
+    Slot &slot = mSlots[position % CAPACITY];
+    uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+    int32_t difference = (int32_t)(sequence - position);
+
+    if (difference == 0) {
+      if (mHead.compare_exchange_weak(
+            position, position + 1, std::memory_order_relaxed)) {
+        slot.modification = modification;
+        slot.sequence.store(position + 1, std::memory_order_release);
+
+        return true;
+      }
+    }
+    else if (difference < 0) {
+      // The consumer hasn't caught up
+      return false;
+    }
+    else {
+      position = mHead.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+bool TerrainModificationQueue::pop(TerrainModification &modification) {
+  uint32_t position = mTail.load(std::memory_order_relaxed);
+  Slot &slot = mSlots[position % CAPACITY];
+  uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+  if (sequence != position + 1) {
+    return false;
+  }
+
+  modification = slot.modification;
+  slot.sequence.store(position + CAPACITY, std::memory_order_release);
+  mTail.store(position + 1, std::memory_order_relaxed);
+
+  return true;
+}
+
+bool TerrainModificationQueue::isEmpty() const {
+  uint32_t position = mTail.load(std::memory_order_relaxed);
+  uint32_t sequence = mSlots[position % CAPACITY].sequence.load(
+    std::memory_order_acquire);
+
+  return sequence != position + 1;
+}
+
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <stdint.h>
+#include <glm/glm.hpp>
+
+namespace Ondine::Graphics {
+
+enum class TerrainModificationType : uint8_t {
+  DensityPaint,
+  ColorPaint,
+  AddSphere,
+  AddPlane
+};
+
+// Positions and radii are in world space (not divided by the terrain scale)
+struct TerrainModification {
+  TerrainModificationType type;
+
+  union {
+    // Brushes find where to apply themselves with a raycast
+    struct {
+      glm::vec3 rayStart;
+      glm::vec3 rayDirection;
+      float radius;
+      float strength;
+    } dp;
+
+    struct {
+      glm::vec3 rayStart;
+      glm::vec3 rayDirection;
+      float radius;
+      glm::vec3 color;
+    } cp;
+
+    struct {
+      glm::vec3 centre;
+      float radius;
+      float intensity;
+    } as;
+
+    struct {
+      glm::vec3 centre;
+      float radius;
+      float intensity;
+    } ap;
+  };
+};
+
+/*
+   Lock-free ring of terrain modifications. Any thread can push (the game /
+   editor queue brush strokes on the main thread), a single consumer pops
+   them off in order before applying them to the terrain.
+*/
+class TerrainModificationQueue {
+public:
+  void init();
+
+  // Returns false if the ring is full
+  bool push(const TerrainModification &modification);
+  // Only one thread may pop at any time
+  bool pop(TerrainModification &modification);
+
+  bool isEmpty() const;
+
+private:
+  static constexpr uint32_t CAPACITY = 4096;
+
+  struct Slot {
+    // Tells whether the slot is ready to be written to or read from
+    std::atomic<uint32_t> sequence;
+    TerrainModification modification;
+  };
+
+  Slot *mSlots;
+
+  alignas(64) std::atomic<uint32_t> mHead;
+  alignas(64) std::atomic<uint32_t> mTail;
+};
+
+}
@@ -36,14 +36,14 @@ void TerrainRenderer::init(
 
   pipelineConfig.setTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
 
-  mPipeline.init(
+  mPipeline.initDeferred(
     graphicsContext.device(),
     graphicsContext.descriptorLayouts(),
     pipelineConfig);
 
   pipelineConfig.setToWireframe();
 
-  mPipelineWireframe.init(
+  mPipelineWireframe.initDeferred(
     graphicsContext.device(),
     graphicsContext.descriptorLayouts(),
     pipelineConfig);
@@ -59,7 +59,7 @@ void TerrainRenderer::init(
     VulkanPipelineDescriptorLayout{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1});
   lineConfig.setTopology(VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
 
-  mRenderLine.init(
+  mRenderLine.initDeferred(
     graphicsContext.device(),
     graphicsContext.descriptorLayouts(),
     lineConfig);
@@ -401,8 +401,7 @@ void TerrainRenderer::sync(
     mQuadTree,
     glm::vec2(camera.wPosition.x, camera.wPosition.z));
 
-  if (Core::gThreadPool->isJobFinished(mGenerationJob) &&
-      Core::gThreadPool->isJobFinished(terrain.mModificationJob)) {
+  if (Core::gThreadPool->isJobFinished(mGenerationJob)) {
     /*
        If we were waiting on a new snapshot of chunk groups, we need to make
        sure to update the snapshots.
@@ -412,28 +411,37 @@ void TerrainRenderer::sync(
       updateChunkGroupsSnapshots(commandBuffer);
     }
 
-    /* 
-       If the job has been finished, and we need to update the quad tree
-       queue the job again.
+    /*
+       The modification job writes to the updated chunks list - the next
+       meshing pass waits for the current batch to be published.
     */
-    /* if (mUpdateQuadTree) */ {
+    if (Core::gThreadPool->isJobFinished(terrain.mModificationJob)) {
+      // Chunks generated in the background since last time get meshed now
+      terrain.handOffGeneratedChunks();
+
+      /* 
+         If the job has been finished, and we need to update the quad tree
+         queue the job again.
+      */
       mQuadTree.setFocalPoint(pos);
 
-      if (mQuadTree.mDiffAdd.size() || terrain.mUpdatedChunks.size) {
+      // Groups which didn't fit in the last pass's budget still need meshing
+      if (mQuadTree.mDiffAdd.size() || terrain.mUpdatedChunks.size ||
+          mIsosurface.hasPendingUpdates()) {
+        terrain.takeUpdatedChunks();
+
         mUpdateQuadTree = false;
         mIsWaitingForSnapshots = true;
         mParams->terrainRenderer = this;
         mParams->terrain = &terrain;
         mParams->quadTree = &mQuadTree;
         Core::gThreadPool->startJob(mGenerationJob, mParams);
-
-        terrain.mLockedActionQueue = true;
-      }
-      else {
-        terrain.mLockedActionQueue = false;
       }
     }
   }
+
+  // Edits get applied to copies of the chunks, even while meshing runs
+  terrain.startQueuedModifications();
 }
 
 void TerrainRenderer::forceFullUpdate() {
@@ -461,7 +469,10 @@ int TerrainRenderer::runIsosurfaceExtraction(void *data) {
   QuadTree *quadTree = params->quadTree;
   Terrain *terrain = params->terrain;
 
+  // Modifications can get published in the meantime
+  uint32_t reader = terrain->beginReading();
   terrainRenderer->mIsosurface.prepareForUpdate(*quadTree, *terrain);
+  terrain->endReading(reader);
 
   return 0;
 }
@@ -46,7 +46,8 @@ void ToneMapping::init(
           VulkanPipelineDescriptorLayout{
             VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1});
 
-        res.init(context.device(), context.descriptorLayouts(), pipelineConfig);
+        res.initDeferred(
+          context.device(), context.descriptorLayouts(), pipelineConfig);
       },
       *this,
       graphicsContext);
@@ -37,6 +37,7 @@ void VulkanBuffer::init(
   }
 
   mSize = size;
+  mIsUploadTarget = type & VulkanBufferFlag::UploadTarget;
 
   VkBufferCreateInfo bufferInfo = {};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -44,59 +45,37 @@ void VulkanBuffer::init(
   bufferInfo.usage = mUsage;
   bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+  uint32_t queueFamilies[] = {
+    (uint32_t)device.mQueueFamilies.graphicsFamily,
+    (uint32_t)device.mQueueFamilies.transferFamily
+  };
+
+  if (mIsUploadTarget && device.mUploader.isDedicated()) {
+    // Avoids ownership transfers between the transfer and graphics queues
+    bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+    bufferInfo.queueFamilyIndexCount = 2;
+    bufferInfo.pQueueFamilyIndices = queueFamilies;
+  }
+
   VK_CHECK(vkCreateBuffer(device.mLogicalDevice, &bufferInfo, NULL, &mBuffer));
 
   mMemory = device.allocateBufferMemory(mBuffer, memoryFlags);
 }
 
 void VulkanBuffer::destroy(const VulkanDevice &device) {
-  vkFreeMemory(device.mLogicalDevice, mMemory, nullptr);
   vkDestroyBuffer(device.mLogicalDevice, mBuffer, nullptr);
+  device.freeMemory(mMemory);
 }
 
 void VulkanBuffer::fillWithStaging(
-  const VulkanDevice &device,
-  const VulkanCommandPool &commandPool,
-  const Buffer &data) {
-  VulkanBuffer stagingBuffer;
-  stagingBuffer.init(
-    device, data.size,
-    VulkanBufferFlag::Mappable | VulkanBufferFlag::TransferSource);
-
-  void *mappedMemory = stagingBuffer.map(device, data.size, 0);
-  memcpy(mappedMemory, data.data, data.size);
-  stagingBuffer.unmap(device);
-
-  VulkanCommandBuffer commandBuffer = commandPool.makeCommandBuffer(
-    device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
-
-  commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
-  commandBuffer.copyBuffer(
-    *this, 0, stagingBuffer, 0, data.size);
-  commandBuffer.end();
-
-  device.mGraphicsQueue.submitCommandBuffer(
-    commandBuffer,
-    makeArray<VulkanSemaphore, AllocationType::Linear>(),
-    makeArray<VulkanSemaphore, AllocationType::Linear>(),
-    0, VulkanFence());
-
-  device.mGraphicsQueue.idle();
-
-  commandPool.freeCommandBuffer(device, commandBuffer);
-
-  stagingBuffer.destroy(device);
-}
-
-void *VulkanBuffer::map(
-  const VulkanDevice &device, size_t size, size_t offset) const {
-  void *ptr;
-  vkMapMemory(device.mLogicalDevice, mMemory, offset, size, 0, &ptr);
-  return ptr;
+  const VulkanDevice &device, const Buffer &data) {
+  assert(mIsUploadTarget);
+  device.mUploader.upload(*this, 0, data);
 }
 
-void VulkanBuffer::unmap(const VulkanDevice &device) const {
-  vkUnmapMemory(device.mLogicalDevice, mMemory);
+void *VulkanBuffer::map(size_t size, size_t offset) const {
+  assert(mMemory.mapped && offset + size <= mSize);
+  return mMemory.mapped + offset;
 }
 
 VkBufferMemoryBarrier VulkanBuffer::makeBarrier(
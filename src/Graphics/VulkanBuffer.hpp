@@ -3,6 +3,7 @@
 #include "Utils.hpp"
 #include "Buffer.hpp"
 #include <vulkan/vulkan.h>
+#include "VulkanMemoryAllocator.hpp"
 
 namespace Ondine::Graphics {
 
@@ -15,6 +16,11 @@ enum class VulkanBufferFlag {
   UniformBuffer = BIT(2),
   Mappable = BIT(3),
   TransferSource = BIT(4),
+  /*
+     Gets filled through the uploader (fillWithStaging) - shared with the
+     dedicated transfer queue if there is one
+  */
+  UploadTarget = BIT(5),
   // By default, all buffers are transfer dst
 };
 
@@ -30,13 +36,17 @@ public:
 
   void destroy(const VulkanDevice &device);
 
-  void fillWithStaging(
-    const VulkanDevice &device,
-    const VulkanCommandPool &commandPool,
-    const Buffer &data);
+  /*
+     Goes through the device's uploader: doesn't wait for anything, the data
+     is there for all graphics work submitted after this call.
+  */
+  void fillWithStaging(const VulkanDevice &device, const Buffer &data);
 
-  void *map(const VulkanDevice &device, size_t size, size_t offset) const;
-  void unmap(const VulkanDevice &device) const;
+  /*
+     Mappable buffers are sub-allocated from blocks which stay persistently
+     mapped, so there is nothing to unmap.
+  */
+  void *map(size_t size, size_t offset) const;
 
   VkBufferMemoryBarrier makeBarrier(
     VkPipelineStageFlags src,
@@ -46,13 +56,15 @@ public:
 private:
   VkBuffer mBuffer;
   size_t mSize;
-  VkDeviceMemory mMemory;
+  VulkanMemoryAllocation mMemory;
   VkBufferUsageFlags mUsage;
   VkPipelineStageFlags mUsedAtEarliest;
   VkPipelineStageFlags mUsedAtLatest;
+  bool mIsUploadTarget;
 
   friend class VulkanCommandBuffer;
   friend class VulkanUniform;
+  friend class VulkanUploader;
   friend class Model;
 };
 
@@ -3,10 +3,12 @@
 #include "Utils.hpp"
 #include "VulkanBuffer.hpp"
 #include "VulkanPipeline.hpp"
+#include "VulkanQueryPool.hpp"
 #include "VulkanArenaSlot.hpp"
 #include "VulkanRenderPass.hpp"
 #include "VulkanFramebuffer.hpp"
 #include "VulkanCommandBuffer.hpp"
+#include "VulkanCommandRecorder.hpp"
 
 namespace Ondine::Graphics {
 
@@ -16,6 +18,7 @@ void VulkanCommandBuffer::init(
   mViewportCount = 0;
   mCommandBuffer = handle;
   mLevel = level;
+  mRecording = nullptr;
 
   switch (level) {
   case VK_COMMAND_BUFFER_LEVEL_PRIMARY: {
@@ -51,6 +54,11 @@ void VulkanCommandBuffer::beginRenderPass(
   const VkExtent2D &extent) {
   pushViewport(extent);
 
+  if (mRecording) {
+    mRecording->beginRenderPass(*this, renderPass, framebuffer, offset, extent);
+    return;
+  }
+
   VkRect2D renderArea = {};
   renderArea.offset = offset;
   renderArea.extent = extent;
@@ -68,6 +76,41 @@ void VulkanCommandBuffer::beginRenderPass(
 
 void VulkanCommandBuffer::endRenderPass() {
   popViewport();
+
+  if (mRecording) {
+    mRecording->endRenderPass(*this);
+  }
+  else {
+    vkCmdEndRenderPass(mCommandBuffer);
+  }
+}
+
+void VulkanCommandBuffer::executeRenderPass(
+  const VulkanRenderPass &renderPass,
+  const VulkanFramebuffer &framebuffer,
+  const VkOffset2D &offset,
+  const VkExtent2D &extent,
+  VkCommandBuffer contents) const {
+  assert(mLevel == VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+  VkRect2D renderArea = {};
+  renderArea.offset = offset;
+  renderArea.extent = extent;
+
+  VkRenderPassBeginInfo renderPassBeginInfo = {};
+  renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+  renderPassBeginInfo.framebuffer = framebuffer.mFramebuffer;
+  renderPassBeginInfo.renderPass = renderPass.mRenderPass;
+  renderPassBeginInfo.clearValueCount = renderPass.mClearValues.size;
+  renderPassBeginInfo.pClearValues = renderPass.mClearValues.data;
+  renderPassBeginInfo.renderArea = renderArea;
+
+  vkCmdBeginRenderPass(
+    mCommandBuffer, &renderPassBeginInfo,
+    VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+  vkCmdExecuteCommands(mCommandBuffer, 1, &contents);
+
   vkCmdEndRenderPass(mCommandBuffer);
 }
 
@@ -277,6 +320,37 @@ void VulkanCommandBuffer::transitionImageLayout(
     1, &barrier);
 }
 
+void VulkanCommandBuffer::pipelineBarrier(
+  VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+  VkPipelineStageFlags dstStage, VkAccessFlags dstAccess,
+  const VkImageMemoryBarrier *imageBarriers,
+  uint32_t imageBarrierCount) const {
+  VkMemoryBarrier barrier = {};
+  barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+  barrier.srcAccessMask = srcAccess;
+  barrier.dstAccessMask = dstAccess;
+
+  vkCmdPipelineBarrier(
+    mCommandBuffer,
+    srcStage,
+    dstStage,
+    0,
+    1, &barrier,
+    0, NULL,
+    imageBarrierCount, imageBarriers);
+}
+
+void VulkanCommandBuffer::resetQueries(
+  const VulkanQueryPool &pool, uint32_t first, uint32_t count) const {
+  vkCmdResetQueryPool(mCommandBuffer, pool.mQueryPool, first, count);
+}
+
+void VulkanCommandBuffer::writeTimestamp(
+  const VulkanQueryPool &pool, uint32_t query,
+  VkPipelineStageFlagBits stage) const {
+  vkCmdWriteTimestamp(mCommandBuffer, stage, pool.mQueryPool, query);
+}
+
 void VulkanCommandBuffer::copyBufferToImage(
   const VulkanTexture &dst,
   uint32_t baseLayer, uint32_t layerCount, uint32_t mipLevel,
@@ -455,7 +529,11 @@ void VulkanCommandBuffer::blitImage(
 void VulkanCommandBuffer::dbgBeginRegion(
   const char *name,
   const glm::vec4 &color) {
-  if (vkCmdDebugMarkerBegin) {
+  if (mRecording && mCommandBuffer == VK_NULL_HANDLE) {
+    // Outside of a render pass - gets replayed on the primary
+    mRecording->dbgBeginRegion(name, color);
+  }
+  else if (vkCmdDebugMarkerBegin) {
     VkDebugMarkerMarkerInfoEXT marker_info = {};
     marker_info.sType = VK_STRUCTURE_TYPE_DEBUG_MARKER_MARKER_INFO_EXT;
     memcpy(marker_info.color, &color[0], sizeof(float) * 4);
@@ -467,7 +545,10 @@ void VulkanCommandBuffer::dbgBeginRegion(
 void VulkanCommandBuffer::dbgInsertMarker(
   const char *name,
   const glm::vec4 &color) {
-  if (vkCmdDebugMarkerInsert) {
+  if (mRecording && mCommandBuffer == VK_NULL_HANDLE) {
+    mRecording->dbgInsertMarker(name, color);
+  }
+  else if (vkCmdDebugMarkerInsert) {
     VkDebugMarkerMarkerInfoEXT marker_info = {};
     marker_info.sType = VK_STRUCTURE_TYPE_DEBUG_MARKER_MARKER_INFO_EXT;
     memcpy(marker_info.color, &color[0], sizeof(float) * 4);
@@ -477,7 +558,10 @@ void VulkanCommandBuffer::dbgInsertMarker(
 }
 
 void VulkanCommandBuffer::dbgEndRegion() {
-  if (vkCmdDebugMarkerEnd) {
+  if (mRecording && mCommandBuffer == VK_NULL_HANDLE) {
+    mRecording->dbgEndRegion();
+  }
+  else if (vkCmdDebugMarkerEnd) {
     vkCmdDebugMarkerEnd(mCommandBuffer);
   }
 }
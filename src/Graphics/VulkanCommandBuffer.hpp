@@ -13,6 +13,8 @@ class VulkanBuffer;
 class VulkanCommandBuffer;
 class VulkanTexture;
 class VulkanArenaSlot;
+class VulkanQueryPool;
+class VulkanRecordedStage;
 
 class VulkanCommandBuffer {
 public:
@@ -52,12 +54,11 @@ public:
   template <typename ...T>
   void bindUniforms(const T &...uniforms) const {
     size_t count = sizeof...(T);
-    auto pred = [](const VulkanUniform &uniform) -> VkDescriptorSet {
-      return uniform.mDescriptorSet;
-    };
 
-    Array<VkDescriptorSet, AllocationType::Linear> sets =
-      makeArrayPred<VkDescriptorSet, AllocationType::Linear>(pred, uniforms...);
+    // Not on the linear allocator: stages get recorded on worker threads
+    VkDescriptorSet sets[] = {
+      static_cast<const VulkanUniform &>(uniforms).mDescriptorSet...
+    };
 
     vkCmdBindDescriptorSets(
         mCommandBuffer,
@@ -65,7 +66,7 @@ public:
         mCurrentPipelineLayout,
         0,
         count,
-        sets.data,
+        sets,
         0,
         NULL);
   }
@@ -110,6 +111,20 @@ public:
     VkImageLayout src, VkImageLayout dst,
     VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) const;
 
+  // Global memory barrier along with some layout transitions
+  void pipelineBarrier(
+    VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess,
+    const VkImageMemoryBarrier *imageBarriers,
+    uint32_t imageBarrierCount) const;
+
+  void resetQueries(
+    const VulkanQueryPool &pool, uint32_t first, uint32_t count) const;
+
+  void writeTimestamp(
+    const VulkanQueryPool &pool, uint32_t query,
+    VkPipelineStageFlagBits stage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT) const;
+
 #ifdef NDEBUG
   inline void dbgBeginRegion(
     const char *name,
@@ -141,6 +156,14 @@ public:
 private:
   void init(VkCommandBuffer handle, VkCommandBufferLevel level);
 
+  // Primary only - runs the contents of a render pass recorded elsewhere
+  void executeRenderPass(
+    const VulkanRenderPass &renderPass,
+    const VulkanFramebuffer &framebuffer,
+    const VkOffset2D &offset,
+    const VkExtent2D &extent,
+    VkCommandBuffer contents) const;
+
   /* Avoids the need for creating a copy */
   void bindVertexBuffers(
     uint32_t firstBinding, uint32_t bindingCount,
@@ -156,10 +179,18 @@ private:
   size_t mViewportCount;
   VkPipeline mCurrentPipeline;
   VkPipelineLayout mCurrentPipelineLayout;
+  /*
+     Set if this command buffer records a stage for VulkanCommandRecorder.
+     Render passes and debug regions go through the recorded stage.
+  */
+  VulkanRecordedStage *mRecording;
 
   friend class VulkanCommandPool;
   friend class VulkanQueue;
   friend class VulkanImgui;
+  friend class VulkanUploader;
+  friend class VulkanRecordedStage;
+  friend class VulkanCommandRecorder;
   friend class Model;
 };
 
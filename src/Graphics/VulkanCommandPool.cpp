@@ -5,9 +5,14 @@
 namespace Ondine::Graphics {
 
 void VulkanCommandPool::init(const VulkanDevice &device) {
+  init(device, device.mQueueFamilies.graphicsFamily);
+}
+
+void VulkanCommandPool::init(
+  const VulkanDevice &device, uint32_t queueFamily) {
   VkCommandPoolCreateInfo commandPoolInfo = {};
   commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-  commandPoolInfo.queueFamilyIndex = device.mQueueFamilies.graphicsFamily;
+  commandPoolInfo.queueFamilyIndex = queueFamily;
   commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
   VK_CHECK(
@@ -18,6 +23,11 @@ void VulkanCommandPool::init(const VulkanDevice &device) {
       &mCommandPool));
 }
 
+void VulkanCommandPool::destroy(const VulkanDevice &device) {
+  vkDestroyCommandPool(device.mLogicalDevice, mCommandPool, NULL);
+  mCommandPool = VK_NULL_HANDLE;
+}
+
 VulkanCommandBuffer VulkanCommandPool::makeCommandBuffer(
   const VulkanDevice &device,
   VkCommandBufferLevel level) const {
@@ -52,4 +62,8 @@ void VulkanCommandPool::freeCommandBuffer(
     device.mLogicalDevice, mCommandPool, 1, &commandBuffer.mCommandBuffer);
 }
 
+void VulkanCommandPool::reset(const VulkanDevice &device) const {
+  VK_CHECK(vkResetCommandPool(device.mLogicalDevice, mCommandPool, 0));
+}
+
 }
@@ -11,7 +11,11 @@ class VulkanDevice;
 
 class VulkanCommandPool {
 public:
+  // Graphics queue family by default
   void init(const VulkanDevice &device);
+  void init(const VulkanDevice &device, uint32_t queueFamily);
+  // Frees the command buffers allocated from it as well
+  void destroy(const VulkanDevice &device);
 
   VulkanCommandBuffer makeCommandBuffer(
     const VulkanDevice &device,
@@ -40,6 +44,9 @@ public:
     const VulkanDevice &device,
     const VulkanCommandBuffer &commandBuffer) const;
 
+  // Resets every command buffer allocated from this pool at once
+  void reset(const VulkanDevice &device) const;
+
 private:
   void makeCommandBuffers(
     const VulkanDevice &device,
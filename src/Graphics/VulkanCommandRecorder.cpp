@@ -0,0 +1,193 @@
+#include <assert.h>
+#include <string.h>
+#include "Vulkan.hpp"
+#include "ThreadPool.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanRenderPass.hpp"
+#include "VulkanFramebuffer.hpp"
+#include "VulkanCommandRecorder.hpp"
+
+namespace Ondine::Graphics {
+
+VulkanRecordedStage::VulkanRecordedStage()
+  : mRecorder(nullptr),
+    mDevice(nullptr),
+    mRecordTime(0.0f) {
+
+}
+
+void VulkanRecordedStage::beginRenderPass(
+  VulkanCommandBuffer &commandBuffer,
+  const VulkanRenderPass &renderPass,
+  const VulkanFramebuffer &framebuffer,
+  const VkOffset2D &offset,
+  const VkExtent2D &extent) {
+  assert(commandBuffer.mCommandBuffer == VK_NULL_HANDLE);
+
+  VkCommandBuffer contents = mRecorder->acquireSecondary(*mDevice);
+
+  // All the render passes in the renderer have a single subpass
+  VkCommandBufferInheritanceInfo inheritance = {};
+  inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+  inheritance.renderPass = renderPass.mRenderPass;
+  inheritance.subpass = 0;
+  inheritance.framebuffer = framebuffer.mFramebuffer;
+
+  commandBuffer.mCommandBuffer = contents;
+  commandBuffer.begin(
+    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+    VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+    &inheritance);
+
+  Op op = {};
+  op.type = OpType::RenderPass;
+  op.renderPass = &renderPass;
+  op.framebuffer = &framebuffer;
+  op.offset = offset;
+  op.extent = extent;
+  op.contents = contents;
+
+  mOps.push_back(op);
+}
+
+void VulkanRecordedStage::endRenderPass(VulkanCommandBuffer &commandBuffer) {
+  commandBuffer.end();
+  commandBuffer.mCommandBuffer = VK_NULL_HANDLE;
+}
+
+void VulkanRecordedStage::dbgBeginRegion(
+  const char *name, const glm::vec4 &color) {
+  Op op = {};
+  op.type = OpType::BeginRegion;
+  strncpy(op.name, name, sizeof(op.name) - 1);
+  op.color = color;
+
+  mOps.push_back(op);
+}
+
+void VulkanRecordedStage::dbgInsertMarker(
+  const char *name, const glm::vec4 &color) {
+  Op op = {};
+  op.type = OpType::InsertMarker;
+  strncpy(op.name, name, sizeof(op.name) - 1);
+  op.color = color;
+
+  mOps.push_back(op);
+}
+
+void VulkanRecordedStage::dbgEndRegion() {
+  Op op = {};
+  op.type = OpType::EndRegion;
+
+  mOps.push_back(op);
+}
+
+void VulkanCommandRecorder::init(
+  const VulkanDevice &device,
+  uint32_t framesInFlight,
+  uint32_t threadCount,
+  uint32_t stageCount) {
+  mThreadCount = threadCount;
+  mCurrentFrame = 0;
+
+  mPools.init(framesInFlight * threadCount);
+  mPools.size = mPools.capacity;
+
+  for (int i = 0; i < mPools.size; ++i) {
+    mPools[i].pool.init(device);
+    mPools[i].usedCount = 0;
+  }
+
+  mStages.init(stageCount);
+  mStages.size = stageCount;
+
+  for (int i = 0; i < mStages.size; ++i) {
+    mStages[i].mRecorder = this;
+  }
+}
+
+void VulkanCommandRecorder::beginFrame(
+  const VulkanDevice &device, uint32_t frameInFlight) {
+  mCurrentFrame = frameInFlight;
+
+  // Whatever was recorded the last time around is done executing
+  for (int i = 0; i < mThreadCount; ++i) {
+    ThreadCommands &commands = mPools[mCurrentFrame * mThreadCount + i];
+    if (commands.usedCount) {
+      commands.pool.reset(device);
+      commands.usedCount = 0;
+    }
+  }
+}
+
+VulkanCommandBuffer &VulkanCommandRecorder::beginStage(
+  const VulkanDevice &device, uint32_t stage) {
+  VulkanRecordedStage &recorded = mStages[stage];
+  recorded.mDevice = &device;
+  recorded.mOps.clear();
+  recorded.mRecordStart = Core::getCurrentTime();
+
+  // Only gets a handle once a render pass begins
+  recorded.mCommandBuffer.init(
+    VK_NULL_HANDLE, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+  recorded.mCommandBuffer.mRecording = &recorded;
+
+  return recorded.mCommandBuffer;
+}
+
+void VulkanCommandRecorder::endStage(uint32_t stage) {
+  VulkanRecordedStage &recorded = mStages[stage];
+  assert(recorded.mCommandBuffer.mCommandBuffer == VK_NULL_HANDLE);
+
+  recorded.mRecordTime = Core::getTimeDifference(
+    Core::getCurrentTime(), recorded.mRecordStart) * 1000.0f;
+}
+
+float VulkanCommandRecorder::recordTime(uint32_t stage) const {
+  return mStages[stage].mRecordTime;
+}
+
+void VulkanCommandRecorder::execute(
+  VulkanCommandBuffer &commandBuffer, uint32_t stage) const {
+  for (const auto &op : mStages[stage].mOps) {
+    switch (op.type) {
+    case VulkanRecordedStage::OpType::RenderPass: {
+      commandBuffer.executeRenderPass(
+        *op.renderPass, *op.framebuffer, op.offset, op.extent, op.contents);
+    } break;
+
+    case VulkanRecordedStage::OpType::BeginRegion: {
+      commandBuffer.dbgBeginRegion(op.name, op.color);
+    } break;
+
+    case VulkanRecordedStage::OpType::InsertMarker: {
+      commandBuffer.dbgInsertMarker(op.name, op.color);
+    } break;
+
+    case VulkanRecordedStage::OpType::EndRegion: {
+      commandBuffer.dbgEndRegion();
+    } break;
+    }
+  }
+}
+
+VkCommandBuffer VulkanCommandRecorder::acquireSecondary(
+  const VulkanDevice &device) {
+  uint32_t threadIndex = Core::gThreadPool->threadIndex();
+  assert(threadIndex < mThreadCount);
+
+  // Only ever touched by this thread during the recording
+  ThreadCommands &commands =
+    mPools[mCurrentFrame * mThreadCount + threadIndex];
+
+  if (commands.usedCount == commands.secondaries.size()) {
+    VulkanCommandBuffer secondary = commands.pool.makeCommandBuffer(
+      device, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+    commands.secondaries.push_back(secondary.mCommandBuffer);
+  }
+
+  return commands.secondaries[commands.usedCount++];
+}
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <vector>
+#include "Time.hpp"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include "VulkanCommandPool.hpp"
+#include "VulkanCommandBuffer.hpp"
+
+namespace Ondine::Graphics {
+
+class VulkanDevice;
+class VulkanCommandRecorder;
+
+/*
+   Commands of a render stage which was recorded on some thread. Render
+   passes can only get begun in primary command buffers so every render pass
+   of the stage gets its own secondary command buffer (which continues the
+   render pass). Debug regions outside of render passes get replayed on the
+   primary along with the render passes.
+   Stages can't record anything outside of a render pass apart from debug
+   regions / markers.
+*/
+class VulkanRecordedStage {
+public:
+  VulkanRecordedStage();
+
+private:
+  void beginRenderPass(
+    VulkanCommandBuffer &commandBuffer,
+    const VulkanRenderPass &renderPass,
+    const VulkanFramebuffer &framebuffer,
+    const VkOffset2D &offset,
+    const VkExtent2D &extent);
+  void endRenderPass(VulkanCommandBuffer &commandBuffer);
+
+  void dbgBeginRegion(const char *name, const glm::vec4 &color);
+  void dbgInsertMarker(const char *name, const glm::vec4 &color);
+  void dbgEndRegion();
+
+private:
+  enum class OpType {
+    RenderPass,
+    BeginRegion,
+    InsertMarker,
+    EndRegion
+  };
+
+  struct Op {
+    OpType type;
+
+    // Render pass
+    const VulkanRenderPass *renderPass;
+    const VulkanFramebuffer *framebuffer;
+    VkOffset2D offset;
+    VkExtent2D extent;
+    VkCommandBuffer contents;
+
+    // Debug regions (names can be on the stack of the stage)
+    char name[32];
+    glm::vec4 color;
+  };
+
+  VulkanCommandRecorder *mRecorder;
+  const VulkanDevice *mDevice;
+  // Given to the stage as frame.primaryCommandBuffer
+  VulkanCommandBuffer mCommandBuffer;
+  // Keeps its capacity from frame to frame
+  std::vector<Op> mOps;
+  Core::TimeStamp mRecordStart;
+  float mRecordTime;
+
+  friend class VulkanCommandBuffer;
+  friend class VulkanCommandRecorder;
+};
+
+/*
+   Lets render stages get recorded on worker threads. Each thread records
+   into secondary command buffers from its own command pool (one per frame
+   in flight - pools get reset once the fence of the frame was waited on).
+   The primary command buffer then only executes the stages in order.
+*/
+class VulkanCommandRecorder {
+public:
+  void init(
+    const VulkanDevice &device,
+    uint32_t framesInFlight,
+    uint32_t threadCount,
+    uint32_t stageCount);
+
+  // Needs to be called after the fence of the frame in flight was waited on
+  void beginFrame(const VulkanDevice &device, uint32_t frameInFlight);
+
+  /*
+     Can be called from any thread, as long as each stage only gets recorded
+     by one thread at a time. The stage records into the returned command
+     buffer until endStage.
+  */
+  VulkanCommandBuffer &beginStage(const VulkanDevice &device, uint32_t stage);
+  void endStage(uint32_t stage);
+
+  // Time spent recording the stage in milliseconds
+  float recordTime(uint32_t stage) const;
+
+  // On the main thread, after all the stages were recorded
+  void execute(VulkanCommandBuffer &primary, uint32_t stage) const;
+
+private:
+  struct ThreadCommands {
+    VulkanCommandPool pool;
+    std::vector<VkCommandBuffer> secondaries;
+    uint32_t usedCount;
+  };
+
+  VkCommandBuffer acquireSecondary(const VulkanDevice &device);
+
+private:
+  uint32_t mThreadCount;
+  uint32_t mCurrentFrame;
+  Array<ThreadCommands> mPools;
+  Array<VulkanRecordedStage> mStages;
+
+  friend class VulkanRecordedStage;
+};
+
+}
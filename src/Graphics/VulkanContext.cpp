@@ -1,3 +1,5 @@
+#include <assert.h>
+#include <string.h>
 #include "RendererDebug.hpp"
 #include "VulkanContext.hpp"
 
@@ -15,13 +17,15 @@ VulkanContext::VulkanContext()
   : mInstance(ENABLE_VALIDATION),
     mFramesInFlight(FRAMES_IN_FLIGHT),
     mSkipFrame(false),
-    mCurrentFrame(0) {
+    mCurrentFrame(0),
+    mIsHeadless(false) {
   
 }
 
-void VulkanContext::initInstance() {
+void VulkanContext::initInstance(bool isHeadless) {
   /* Just instance */
-  mInstance.init();
+  mIsHeadless = isHeadless;
+  mInstance.init(!isHeadless);
 }
 
 void VulkanContext::initContext(const Core::WindowContextInfo &surfaceInfo) {
@@ -34,7 +38,10 @@ void VulkanContext::initContext(const Core::WindowContextInfo &surfaceInfo) {
   requiredFeatures.features.geometryShader = VK_TRUE;
   requiredFeatures.features.independentBlend = VK_TRUE;
   requiredFeatures.features.fillModeNonSolid = VK_TRUE;
-  mDevice.init(DeviceType::Any, mInstance, mSurface, requiredFeatures);
+  mDevice.init(DeviceType::Any, mInstance, &mSurface, requiredFeatures);
+
+  // Pipeline cache from the previous run (if it's still valid)
+  mDevice.mPipelineCache.init(mDevice);
 
   // Swapchain
   mSwapchain.init(mDevice, mSurface, surfaceInfo.resolution);
@@ -54,11 +61,61 @@ void VulkanContext::initContext(const Core::WindowContextInfo &surfaceInfo) {
   // Final framebuffers
   mFinalFramebuffers = mSwapchain.makeFramebuffers(mDevice, mFinalRenderPass);
 
+  initFrameResources(mSwapchain.mImages.size);
+}
+
+void VulkanContext::initHeadlessContext(const Resolution &resolution) {
+  assert(mIsHeadless);
+
+  // Device (software implementations like lavapipe will do)
+  DeviceRequestedFeatures requiredFeatures = {};
+  requiredFeatures.count = 1;
+  requiredFeatures.features.geometryShader = VK_TRUE;
+  requiredFeatures.features.independentBlend = VK_TRUE;
+  requiredFeatures.features.fillModeNonSolid = VK_TRUE;
+  mDevice.init(DeviceType::Any, mInstance, nullptr, requiredFeatures);
+
+  mDevice.mPipelineCache.init(mDevice);
+
+  // Offscreen target which stands in for the swapchain image
+  mHeadlessExtent = {resolution.width, resolution.height};
+  mHeadlessOutput.init(
+    mDevice,
+    TextureType::T2D | TextureType::Attachment | TextureType::TransferSource,
+    TextureContents::Color,
+    HEADLESS_OUTPUT_FORMAT, VK_FILTER_NEAREST,
+    {resolution.width, resolution.height, 1}, 1, 1);
+
+  // Final render pass
+  VulkanRenderPassConfig finalRenderPassConfig (1, 1);
+  finalRenderPassConfig.addAttachment(
+    LoadAndStoreOp::ClearThenStore, LoadAndStoreOp::DontCareThenDontCare,
+    OutputUsage::FragmentShaderRead, AttachmentType::Color,
+    HEADLESS_OUTPUT_FORMAT);
+  finalRenderPassConfig.addSubpass(
+    makeArray<uint32_t, AllocationType::Linear>(0U),
+    makeArray<uint32_t, AllocationType::Linear>(),
+    false);
+  mFinalRenderPass.init(mDevice, finalRenderPassConfig);
+
+  // Final framebuffer
+  VulkanFramebufferConfig framebufferConfig(1, mFinalRenderPass);
+  framebufferConfig.addAttachment(mHeadlessOutput);
+
+  mFinalFramebuffers.init(1);
+  mFinalFramebuffers[0].init(mDevice, framebufferConfig);
+  mFinalFramebuffers.size = 1;
+
+  // One primary command buffer per frame in flight (no swapchain images)
+  initFrameResources(mFramesInFlight);
+}
+
+void VulkanContext::initFrameResources(uint32_t primaryCommandBufferCount) {
   // Command pool
   mCommandPool.init(mDevice);
 
   // Primary command buffers
-  mPrimaryCommandBuffers.init(mSwapchain.mImages.size);
+  mPrimaryCommandBuffers.init(primaryCommandBufferCount);
   mCommandPool.makeCommandBuffers(
     mDevice,
     VK_COMMAND_BUFFER_LEVEL_PRIMARY,
@@ -118,6 +175,26 @@ VulkanFrame VulkanContext::beginFrame() {
 
     return frame;
   }
+  else if (mIsHeadless) {
+    // Nothing to acquire - just wait for the frame in flight to be done
+    mFences[mCurrentFrame].wait(mDevice);
+    mFences[mCurrentFrame].reset(mDevice);
+
+    VulkanCommandBuffer &currentCommandBuffer =
+      mPrimaryCommandBuffers[mCurrentFrame];
+
+    currentCommandBuffer.begin(0, nullptr);
+
+    VulkanFrame frame {
+      currentCommandBuffer,
+      0,
+      mCurrentFrame,
+      {mHeadlessExtent.width, mHeadlessExtent.height},
+      false
+    };
+
+    return frame;
+  }
   else {
     uint32_t imageIndex = mSwapchain.acquireNextImage(
       mDevice, mImageReadySemaphores[mCurrentFrame]);
@@ -146,6 +223,19 @@ VulkanFrame VulkanContext::beginFrame() {
 void VulkanContext::endFrame(const VulkanFrame &frame) {
   frame.primaryCommandBuffer.end();
 
+  if (mIsHeadless) {
+    mDevice.mGraphicsQueue.submitCommandBuffer(
+      frame.primaryCommandBuffer,
+      makeArray<VulkanSemaphore, AllocationType::Linear>(),
+      makeArray<VulkanSemaphore, AllocationType::Linear>(),
+      0,
+      mFences[mCurrentFrame]);
+
+    mCurrentFrame = (mCurrentFrame + 1) % mFramesInFlight;
+
+    return;
+  }
+
   const VulkanSemaphore &imageReady = mImageReadySemaphores[mCurrentFrame];
   const VulkanSemaphore &renderDone = mRenderFinishedSemaphores[mCurrentFrame];
 
@@ -172,7 +262,7 @@ void VulkanContext::beginSwapchainRender(const VulkanFrame &frame) {
     mFinalRenderPass,
     mFinalFramebuffers[frame.imageIndex],
     {0, 0},
-    mSwapchain.mExtent);
+    mIsHeadless ? mHeadlessExtent : mSwapchain.mExtent);
 }
 
 void VulkanContext::endSwapchainRender(const VulkanFrame &frame) {
@@ -181,7 +271,19 @@ void VulkanContext::endSwapchainRender(const VulkanFrame &frame) {
   frame.primaryCommandBuffer.dbgEndRegion();
 }
 
+void VulkanContext::shutdown() {
+  // The renderer has saved the cache out by now
+  mDevice.idle();
+  mDevice.mPipelineCache.destroy(mDevice);
+  mDevice.destroy();
+}
+
 void VulkanContext::resize(const Resolution &newResolution) {
+  if (mIsHeadless) {
+    // Headless output has a fixed resolution
+    return;
+  }
+
   mDevice.idle();
 
   mSwapchain.destroy(mDevice);
@@ -215,6 +317,88 @@ void VulkanContext::skipFrame() {
   mSkipFrame = true;
 }
 
+void VulkanContext::savePipelineCache() {
+  mDevice.mPipelineCache.save(mDevice);
+}
+
+void VulkanContext::beginPipelineBuild() {
+  mDevice.mPipelineBuilder.begin(mDevice, SHADER_DIRECTORY);
+}
+
+void VulkanContext::flushPipelineBuild() {
+  if (mDevice.mPipelineBuilder.isBuilding()) {
+    mDevice.mPipelineBuilder.flush(mDevice);
+  }
+}
+
+void VulkanContext::endPipelineBuild() {
+  mDevice.mPipelineBuilder.end(mDevice);
+}
+
+Buffer VulkanContext::captureHeadlessOutput() {
+  assert(mIsHeadless);
+
+  uint32_t width = mHeadlessExtent.width, height = mHeadlessExtent.height;
+  size_t size = (size_t)width * (size_t)height * 4;
+
+  // Same as with the sky cache - go through a linear image
+  VulkanTexture linearTexture;
+  linearTexture.init(
+    mDevice,
+    TextureType::T2D | TextureType::LinearTiling | TextureType::TransferSource,
+    TextureContents::Color,
+    HEADLESS_OUTPUT_FORMAT, VK_FILTER_NEAREST,
+    {width, height, 1}, 1, 1);
+
+  VulkanBuffer staging;
+  staging.init(mDevice, size, (VulkanBufferFlagBits)VulkanBufferFlag::Mappable);
+
+  VulkanCommandBuffer commandBuffer = mCommandPool.makeCommandBuffer(
+    mDevice, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+
+  commandBuffer.begin(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
+
+  commandBuffer.transitionImageLayout(
+    linearTexture, VK_IMAGE_LAYOUT_UNDEFINED,
+    VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+    VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+  commandBuffer.blitImage(
+    linearTexture, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+    mHeadlessOutput, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, 0, 1,
+    VK_PIPELINE_STAGE_TRANSFER_BIT,
+    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+  commandBuffer.copyImageToBuffer(staging, 0, size, linearTexture, 0, 1, 0);
+
+  commandBuffer.end();
+
+  mDevice.mGraphicsQueue.submitCommandBuffer(
+    commandBuffer,
+    makeArray<VulkanSemaphore, AllocationType::Linear>(),
+    makeArray<VulkanSemaphore, AllocationType::Linear>(),
+    0, VulkanFence());
+
+  mDevice.mGraphicsQueue.idle();
+
+  Buffer pixels = {flAllocv<uint8_t>(size), size};
+  memcpy(pixels.data, staging.map(size, 0), size);
+
+  staging.destroy(mDevice);
+  linearTexture.destroy(mDevice);
+  mCommandPool.freeCommandBuffer(mDevice, commandBuffer);
+
+  return pixels;
+}
+
+bool VulkanContext::isHeadless() const {
+  return mIsHeadless;
+}
+
+uint32_t VulkanContext::framesInFlight() const {
+  return mFramesInFlight;
+}
+
 const VulkanDevice &VulkanContext::device() const {
   return mDevice;
 }
@@ -237,8 +421,15 @@ const VulkanRenderPass &VulkanContext::finalRenderPass() const {
 
 VulkanContextProperties VulkanContext::getProperties() const {
   VulkanContextProperties properties = {};
-  properties.swapchainFormat = mSwapchain.mFormat;
-  properties.swapchainExtent = mSwapchain.mExtent;
+  if (mIsHeadless) {
+    properties.swapchainFormat = HEADLESS_OUTPUT_FORMAT;
+    properties.swapchainExtent = mHeadlessExtent;
+  }
+  else {
+    properties.swapchainFormat = mSwapchain.mFormat;
+    properties.swapchainExtent = mSwapchain.mExtent;
+  }
+
   properties.depthFormat = mDevice.mDepthFormat;
   return properties;
 }
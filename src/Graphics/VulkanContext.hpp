@@ -6,6 +6,7 @@
 #include "VulkanFrame.hpp"
 #include "VulkanDevice.hpp"
 #include "VulkanSurface.hpp"
+#include "VulkanTexture.hpp"
 #include "VulkanInstance.hpp"
 #include "VulkanSwapchain.hpp"
 #include "VulkanDescriptor.hpp"
@@ -25,8 +26,13 @@ class VulkanContext {
 public:
   VulkanContext();
 
-  void initInstance();
+  void initInstance(bool isHeadless = false);
   void initContext(const Core::WindowContextInfo &surfaceInfo);
+  /* 
+     No surface / swapchain - the final render pass renders to an offscreen
+     texture of the given resolution instead.
+  */
+  void initHeadlessContext(const Resolution &resolution);
   void initImgui(
     const Core::WindowContextInfo &surfaceInfo,
     const VulkanRenderPass &renderPass);
@@ -42,9 +48,30 @@ public:
   void endSwapchainRender(const VulkanFrame &frame);
 
   void resize(const Resolution &newResolution);
+  void shutdown();
 
   void skipFrame();
 
+  /* Writes the pipeline cache to the draw cache directory */
+  void savePipelineCache();
+
+  /*
+     Between begin and end, pipelines created with initDeferred get built on
+     the job system. Flush creates everything which has been queued so far.
+  */
+  void beginPipelineBuild();
+  void flushPipelineBuild();
+  void endPipelineBuild();
+
+  /* 
+     Copies the offscreen output of a headless context into a tightly packed
+     RGBA8 buffer (owned by caller - flFreev). Device needs to be idle.
+  */
+  Buffer captureHeadlessOutput();
+
+  bool isHeadless() const;
+  uint32_t framesInFlight() const;
+
   const VulkanDevice &device() const;
   VulkanDescriptorSetLayoutMaker &descriptorLayouts();
   const VulkanCommandPool &commandPool() const;
@@ -54,6 +81,13 @@ public:
   const VulkanImgui &imgui() const;
 
 private:
+  void initFrameResources(uint32_t primaryCommandBufferCount);
+
+private:
+  static constexpr VkFormat HEADLESS_OUTPUT_FORMAT = VK_FORMAT_R8G8B8A8_UNORM;
+  // Everything in here gets preloaded at the start of a pipeline build
+  static constexpr const char *SHADER_DIRECTORY = "res/spv/";
+
   VulkanInstance mInstance;
   VulkanSurface mSurface;
   VulkanDevice mDevice;
@@ -71,6 +105,10 @@ private:
   VulkanDescriptorSetLayoutMaker mDescriptorSetLayouts;
   VulkanImgui mImgui;
   bool mSkipFrame;
+
+  bool mIsHeadless;
+  VulkanTexture mHeadlessOutput;
+  VkExtent2D mHeadlessExtent;
 };
 
 }
@@ -11,7 +11,7 @@ namespace Ondine::Graphics {
 void VulkanDevice::init(
   DeviceType requestedType,
   const VulkanInstance &instance,
-  const VulkanSurface &surface,
+  const VulkanSurface *surface,
   const DeviceRequestedFeatures &requiredFeatures) {
   enum {
     SwapchainExtIndex,
@@ -30,7 +30,9 @@ void VulkanDevice::init(
   DeviceExtensions requestedExt = {};
   requestedExt.count = sizeof(requestedExtNames) / sizeof(requestedExtNames[0]);
   requestedExt.names = requestedExtNames;
-  requestedExt.setNeeded(SwapchainExtIndex);
+  if (surface) {
+    requestedExt.setNeeded(SwapchainExtIndex);
+  }
 
   uint32_t deviceCount = 0;
   vkEnumeratePhysicalDevices(instance.mInstance, &deviceCount, NULL);
@@ -82,6 +84,7 @@ void VulkanDevice::init(
   uint32_t uniqueQueueFamilyFinder = 0;
   uniqueQueueFamilyFinder |= 1 << mQueueFamilies.graphicsFamily;
   uniqueQueueFamilyFinder |= 1 << mQueueFamilies.presentFamily;
+  uniqueQueueFamilyFinder |= 1 << mQueueFamilies.transferFamily;
   uint32_t uniqueQueueFamilyCount = popCount(uniqueQueueFamilyFinder);
 
   uint32_t *uniqueFamilyIndices = STACK_ALLOC(
@@ -133,6 +136,31 @@ void VulkanDevice::init(
     mLogicalDevice, mQueueFamilies.graphicsFamily, 0, &mGraphicsQueue.mQueue);
   vkGetDeviceQueue(
     mLogicalDevice, mQueueFamilies.presentFamily, 0, &mPresentQueue.mQueue);
+  vkGetDeviceQueue(
+    mLogicalDevice, mQueueFamilies.transferFamily, 0, &mTransferQueue.mQueue);
+
+  // Queues which are the same VkQueue need to share their mutex
+  VulkanQueue *queues[] = {&mGraphicsQueue, &mPresentQueue, &mTransferQueue};
+  for (int i = 0; i < 3; ++i) {
+    queues[i]->mSubmitMutex = &mQueueMutexes[i];
+
+    for (int j = 0; j < i; ++j) {
+      if (queues[j]->mQueue == queues[i]->mQueue) {
+        queues[i]->mSubmitMutex = queues[j]->mSubmitMutex;
+        break;
+      }
+    }
+  }
+
+  mMemoryAllocator.init(
+    mLogicalDevice, mPhysicalDeviceMemoryInfo, mPhysicalDeviceInfo.limits);
+
+  // Every graphics submission waits on the uploads which came before it
+  bool isTransferDedicated =
+    mQueueFamilies.transferFamily != mQueueFamilies.graphicsFamily;
+  mUploader.init(
+    *this, mTransferQueue, mQueueFamilies.transferFamily, isTransferDedicated);
+  mGraphicsQueue.mUploader = &mUploader;
 
   if (result == VK_SUCCESS) {
     LOG_INFO("Created Vulkan logical device:\n");
@@ -171,6 +199,13 @@ void VulkanDevice::initDebugExtProcs() {
   }
 }
 
+void VulkanDevice::destroy() {
+  idle();
+  // Its buffers still need the allocator
+  mUploader.destroy(*this);
+  mMemoryAllocator.destroy();
+}
+
 void VulkanDevice::idle() const {
   vkDeviceWaitIdle(mLogicalDevice);
 }
@@ -182,7 +217,7 @@ void VulkanDevice::updateSurfaceCapabilities(const VulkanSurface &surface) {
 
 bool VulkanDevice::verifyHardwareMeetsRequirements(
   DeviceType requestedType,
-  const VulkanSurface &surface,
+  const VulkanSurface *surface,
   const DeviceRequestedFeatures &requiredFeatures,
   const DeviceExtensions &requestedExtensions,
   DeviceExtensions &usedExtensions) {
@@ -203,12 +238,18 @@ bool VulkanDevice::verifyHardwareMeetsRequirements(
       mQueueFamilies.graphicsFamily = i;
     }
 
-    VkBool32 presentSupport = 0;
-    vkGetPhysicalDeviceSurfaceSupportKHR(
-      mPhysicalDevice, i, surface.mSurface, &presentSupport);
+    if (surface) {
+      VkBool32 presentSupport = 0;
+      vkGetPhysicalDeviceSurfaceSupportKHR(
+        mPhysicalDevice, i, surface->mSurface, &presentSupport);
 
-    if (queueProperties[i].queueCount > 0 && presentSupport) {
-      mQueueFamilies.presentFamily = i;
+      if (queueProperties[i].queueCount > 0 && presentSupport) {
+        mQueueFamilies.presentFamily = i;
+      }
+    }
+    else {
+      // Nothing gets presented - just alias the graphics queue
+      mQueueFamilies.presentFamily = mQueueFamilies.graphicsFamily;
     }
 
     if (mQueueFamilies.isComplete()) {
@@ -216,6 +257,30 @@ bool VulkanDevice::verifyHardwareMeetsRequirements(
     }
   }
 
+  /*
+     Uploads go on a dedicated transfer queue (DMA engine on discrete GPUs)
+     if there's one - preferably one which can't do compute either.
+  */
+  mQueueFamilies.transferFamily = mQueueFamilies.graphicsFamily;
+  int transferOnlyFamily = -1;
+  for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+    VkQueueFlags flags = queueProperties[i].queueFlags;
+    if (queueProperties[i].queueCount > 0 &&
+        flags & VK_QUEUE_TRANSFER_BIT &&
+        !(flags & VK_QUEUE_GRAPHICS_BIT)) {
+      if (!(flags & VK_QUEUE_COMPUTE_BIT) && transferOnlyFamily < 0) {
+        transferOnlyFamily = i;
+      }
+      else if (mQueueFamilies.transferFamily == mQueueFamilies.graphicsFamily) {
+        mQueueFamilies.transferFamily = i;
+      }
+    }
+  }
+
+  if (transferOnlyFamily >= 0) {
+    mQueueFamilies.transferFamily = transferOnlyFamily;
+  }
+
   uint32_t availableExtensionCount;
   vkEnumerateDeviceExtensionProperties(
     mPhysicalDevice, NULL, &availableExtensionCount, NULL);
@@ -278,14 +343,15 @@ bool VulkanDevice::verifyHardwareMeetsRequirements(
   VkPhysicalDeviceFeatures deviceFeatures;
   vkGetPhysicalDeviceFeatures(mPhysicalDevice, &deviceFeatures);
 
-  bool isSwapchainUsable = 0;
-  if (isSwapchainSupported) {
+  // Headless devices don't need to be able to present at all
+  bool isSwapchainUsable = !surface;
+  if (isSwapchainSupported && surface) {
     vkGetPhysicalDeviceSurfaceCapabilitiesKHR(
-      mPhysicalDevice, surface.mSurface, &mSwapchainSupport.capabilities);
+      mPhysicalDevice, surface->mSurface, &mSwapchainSupport.capabilities);
         
     vkGetPhysicalDeviceSurfaceFormatsKHR(
       mPhysicalDevice,
-      surface.mSurface,
+      surface->mSurface,
       &mSwapchainSupport.availableFormatsCount,
       NULL);
 
@@ -295,13 +361,13 @@ bool VulkanDevice::verifyHardwareMeetsRequirements(
 
       vkGetPhysicalDeviceSurfaceFormatsKHR(
         mPhysicalDevice,
-        surface.mSurface,
+        surface->mSurface,
         &mSwapchainSupport.availableFormatsCount,
         mSwapchainSupport.availableFormats);
     }
 
     vkGetPhysicalDeviceSurfacePresentModesKHR(
-      mPhysicalDevice, surface.mSurface,
+      mPhysicalDevice, surface->mSurface,
       &mSwapchainSupport.availablePresentModesCount, NULL);
 
     if (mSwapchainSupport.availablePresentModesCount != 0) {
@@ -309,7 +375,7 @@ bool VulkanDevice::verifyHardwareMeetsRequirements(
         mSwapchainSupport.availablePresentModesCount);
 
       vkGetPhysicalDeviceSurfacePresentModesKHR(
-        mPhysicalDevice, surface.mSurface,
+        mPhysicalDevice, surface->mSurface,
         &mSwapchainSupport.availablePresentModesCount,
         mSwapchainSupport.availablePresentModes);
     }
@@ -413,43 +479,53 @@ uint32_t VulkanDevice::findMemoryType(
   return 0;
 }
 
-VkDeviceMemory VulkanDevice::allocateImageMemory(
-  VkImage image, VkMemoryPropertyFlags properties, size_t *size) const {
+VulkanMemoryAllocation VulkanDevice::allocateImageMemory(
+  VkImage image, VkMemoryPropertyFlags properties,
+  VulkanResourceTiling tiling, bool dedicated) const {
   VkMemoryRequirements requirements = {};
   vkGetImageMemoryRequirements(mLogicalDevice, image, &requirements);
 
-  VkMemoryAllocateInfo allocInfo = {};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = requirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(properties, requirements);
-
-  VkDeviceMemory memory;
-  vkAllocateMemory(mLogicalDevice, &allocInfo, nullptr, &memory);
-
-  vkBindImageMemory(mLogicalDevice, image, memory, 0);
+  VulkanMemoryAllocation allocation = mMemoryAllocator.allocate(
+    requirements, findMemoryType(properties, requirements),
+    tiling, dedicated);
 
-  if (size)
-    *size = requirements.size;
+  vkBindImageMemory(
+    mLogicalDevice, image, allocation.memory, allocation.offset);
 
-  return memory;
+  return allocation;
 }
 
-VkDeviceMemory VulkanDevice::allocateBufferMemory(
+VulkanMemoryAllocation VulkanDevice::allocateBufferMemory(
   VkBuffer buffer, VkMemoryPropertyFlags properties) const {
   VkMemoryRequirements requirements = {};
   vkGetBufferMemoryRequirements(mLogicalDevice, buffer, &requirements);
 
-  VkMemoryAllocateInfo allocInfo = {};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = requirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(properties, requirements);
+  VulkanMemoryAllocation allocation = mMemoryAllocator.allocate(
+    requirements, findMemoryType(properties, requirements),
+    VulkanResourceTiling::Linear, false);
 
-  VkDeviceMemory memory;
-  vkAllocateMemory(mLogicalDevice, &allocInfo, nullptr, &memory);
+  vkBindBufferMemory(
+    mLogicalDevice, buffer, allocation.memory, allocation.offset);
 
-  vkBindBufferMemory(mLogicalDevice, buffer, memory, 0);
+  return allocation;
+}
 
-  return memory;
+void VulkanDevice::freeMemory(VulkanMemoryAllocation &allocation) const {
+  mMemoryAllocator.free(allocation);
+}
+
+VulkanMemoryAllocation VulkanDevice::allocateTargetMemory(
+  const VkMemoryRequirements &requirements) const {
+  VkMemoryRequirements blockRequirements = requirements;
+
+  return mMemoryAllocator.allocate(
+    blockRequirements,
+    findMemoryType(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, blockRequirements),
+    VulkanResourceTiling::Optimal, true);
+}
+
+void VulkanDevice::freeTargetMemory(VulkanMemoryAllocation &allocation) const {
+  mMemoryAllocator.free(allocation);
 }
 
 const VulkanQueue &VulkanDevice::graphicsQueue() const {
@@ -464,4 +540,20 @@ DeviceType VulkanDevice::deviceType() const {
   return mDeviceType;
 }
 
+float VulkanDevice::timestampPeriod() const {
+  if (!mPhysicalDeviceInfo.limits.timestampComputeAndGraphics) {
+    return 0.0f;
+  }
+
+  return mPhysicalDeviceInfo.limits.timestampPeriod;
+}
+
+const VulkanMemoryAllocator &VulkanDevice::memoryAllocator() const {
+  return mMemoryAllocator;
+}
+
+VulkanUploader &VulkanDevice::uploader() const {
+  return mUploader;
+}
+
 }
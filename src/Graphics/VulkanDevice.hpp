@@ -4,6 +4,10 @@
 #include <glm/glm.hpp>
 #include <vulkan/vulkan.h>
 #include "VulkanQueue.hpp"
+#include "VulkanUploader.hpp"
+#include "VulkanPipelineCache.hpp"
+#include "VulkanPipelineBuilder.hpp"
+#include "VulkanMemoryAllocator.hpp"
 
 namespace Ondine::Graphics {
 
@@ -16,6 +20,8 @@ enum DeviceType {
 struct QueueFamilies {
   int graphicsFamily;
   int presentFamily;
+  // Same as the graphics family if there isn't a dedicated one
+  int transferFamily;
 
   inline bool isComplete() {
     return graphicsFamily >= 0 && presentFamily >= 0;
@@ -59,12 +65,16 @@ class VulkanDevice {
 public:
   VulkanDevice() = default;
 
+  /* Surface is null when running headless (no presentation support needed) */
   void init(
     DeviceType requestedType,
     const VulkanInstance &instance,
-    const VulkanSurface &surface,
+    const VulkanSurface *surface,
     const DeviceRequestedFeatures &features);
 
+  // Frees the memory blocks - nothing can use the device's memory after
+  void destroy();
+
   void idle() const;
   void updateSurfaceCapabilities(const VulkanSurface &surface);
 
@@ -74,12 +84,23 @@ public:
 
   DeviceType deviceType() const;
 
+  // Nanoseconds per timestamp tick (0 if timestamps aren't supported)
+  float timestampPeriod() const;
+
+  const VulkanMemoryAllocator &memoryAllocator() const;
+  VulkanUploader &uploader() const;
+
+  /* Device local block which several render targets get placed in */
+  VulkanMemoryAllocation allocateTargetMemory(
+    const VkMemoryRequirements &requirements) const;
+  void freeTargetMemory(VulkanMemoryAllocation &allocation) const;
+
 private:
   void initDebugExtProcs();
 
   bool verifyHardwareMeetsRequirements(
     DeviceType requestedType,
-    const VulkanSurface &surface,
+    const VulkanSurface *surface,
     const DeviceRequestedFeatures &requiredFeatures,
     const DeviceExtensions &requestedExtensions,
     DeviceExtensions &availableExtensions);
@@ -98,13 +119,16 @@ private:
     VkMemoryPropertyFlags properties,
     VkMemoryRequirements &memoryRequirements) const;
 
-  VkDeviceMemory allocateImageMemory(
+  /* Render targets and the like should be dedicated */
+  VulkanMemoryAllocation allocateImageMemory(
     VkImage image, VkMemoryPropertyFlags properties,
-    size_t *size = nullptr) const;
+    VulkanResourceTiling tiling, bool dedicated) const;
 
-  VkDeviceMemory allocateBufferMemory(
+  VulkanMemoryAllocation allocateBufferMemory(
     VkBuffer buffer, VkMemoryPropertyFlags properties) const;
 
+  void freeMemory(VulkanMemoryAllocation &allocation) const;
+
 private:
   VkDevice mLogicalDevice;
   VkPhysicalDevice mPhysicalDevice;
@@ -115,7 +139,17 @@ private:
   VkFormat mDepthFormat;
   VulkanQueue mGraphicsQueue;
   VulkanQueue mPresentQueue;
+  VulkanQueue mTransferQueue;
+  // One per distinct VkQueue at most (see VulkanQueue::mSubmitMutex)
+  std::mutex mQueueMutexes[3];
   DeviceType mDeviceType;
+  // Resources get created / destroyed through const references to the device
+  mutable VulkanMemoryAllocator mMemoryAllocator;
+  mutable VulkanUploader mUploader;
+  // Gets loaded / saved by the context, used by every pipeline creation
+  VulkanPipelineCache mPipelineCache;
+  // Pipelines get queued on it through const references too
+  mutable VulkanPipelineBuilder mPipelineBuilder;
 
   friend class VulkanContext;
   friend class VulkanSwapchain;
@@ -135,6 +169,10 @@ private:
   friend class VulkanBuffer;
   friend class VulkanUniform;
   friend class VulkanCommandBuffer;
+  friend class VulkanQueryPool;
+  friend class VulkanPipelineCache;
+  friend class VulkanPipelineBuilder;
+  friend class VulkanUploader;
 };
 
 }
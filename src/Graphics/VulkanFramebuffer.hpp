@@ -44,6 +44,7 @@ private:
 
   friend class VulkanSwapchain;
   friend class VulkanCommandBuffer;
+  friend class VulkanRecordedStage;
   friend class VulkanContext;
 };
 
@@ -11,7 +11,7 @@ VulkanInstance::VulkanInstance(bool enableValidation)
 
 }
 
-void VulkanInstance::init() {
+void VulkanInstance::init(bool enableSurface) {
   if (mIsValidationEnabled) {
     static const char *VALIDATION_LAYERS[] = {
       "VK_LAYER_KHRONOS_validation"
@@ -29,22 +29,26 @@ void VulkanInstance::init() {
     mLayers.init(nullptr, 0);
   }
 
-  /* Required extensions */
-  uint32_t extensionCount = 4;
-  const char *extensions[] = {
+  /* Required extensions - no surface extensions when running headless */
+  uint32_t extensionCount = 0;
+  const char *extensions[4] = {};
+
+  if (enableSurface) {
+    extensions[extensionCount++] =
 #if defined(_WIN32)
-    "VK_KHR_win32_surface",
+      "VK_KHR_win32_surface";
 #elif defined(__ANDROID__)
-    "VK_KHR_android_surface"
+      "VK_KHR_android_surface";
 #else
-    "VK_KHR_xcb_surface",
+      "VK_KHR_xcb_surface";
 #endif
-    "VK_KHR_surface",
+    extensions[extensionCount++] = "VK_KHR_surface";
+  }
+
 #ifndef NDEBUG
-    "VK_EXT_debug_utils",
-    "VK_EXT_debug_report"
+  extensions[extensionCount++] = "VK_EXT_debug_utils";
+  extensions[extensionCount++] = "VK_EXT_debug_report";
 #endif
-  };
 
   VkApplicationInfo applicationInfo = {};
   applicationInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
@@ -10,7 +10,8 @@ class VulkanInstance {
 public:
   VulkanInstance(bool enableValidation);
 
-  void init();
+  // Surface extensions aren't needed when rendering offscreen
+  void init(bool enableSurface = true);
 
 private:
   void verifyValidationSupport(
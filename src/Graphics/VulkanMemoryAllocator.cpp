@@ -0,0 +1,305 @@
+#include "Log.hpp"
+#include "Utils.hpp"
+#include "Vulkan.hpp"
+#include "VulkanMemoryAllocator.hpp"
+
+namespace Ondine::Graphics {
+
+void VulkanMemoryAllocator::init(
+  VkDevice device,
+  const VkPhysicalDeviceMemoryProperties &memoryProperties,
+  const VkPhysicalDeviceLimits &limits) {
+  mDevice = device;
+  mMemoryProperties = memoryProperties;
+  mBufferImageGranularity = limits.bufferImageGranularity;
+
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    auto &type = mMemoryProperties.memoryTypes[i];
+    VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[type.heapIndex].size;
+
+    // Small heaps (like the 256MB BAR heap) get smaller blocks
+    mTypes[i].blockSize = MIN(MAX_BLOCK_SIZE, heapSize / 8);
+    mTypes[i].dedicatedCount = 0;
+    mTypes[i].dedicatedBytes = 0;
+  }
+}
+
+void VulkanMemoryAllocator::destroy() {
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    for (auto &block : mTypes[i].blocks) {
+      if (block.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(mDevice, block.memory, nullptr);
+      }
+    }
+
+    mTypes[i].blocks.clear();
+  }
+}
+
+VulkanMemoryAllocation VulkanMemoryAllocator::allocate(
+  const VkMemoryRequirements &requirements,
+  uint32_t memoryType,
+  VulkanResourceTiling tiling,
+  bool dedicated) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  MemoryType &type = mTypes[memoryType];
+
+  VulkanMemoryAllocation allocation = {};
+  allocation.memoryType = memoryType;
+  allocation.size = requirements.size;
+
+  if (dedicated ||
+      requirements.size > type.blockSize / DEDICATED_THRESHOLD_DIVISOR) {
+    allocation.memory = allocateDeviceMemory(
+      requirements.size, memoryType, &allocation.mapped);
+    allocation.offset = 0;
+    allocation.blockIndex = -1;
+
+    ++type.dedicatedCount;
+    type.dedicatedBytes += requirements.size;
+
+    return allocation;
+  }
+
+  // No need to keep the two apart if the granularity doesn't matter
+  if (mBufferImageGranularity <= 1) {
+    tiling = VulkanResourceTiling::Linear;
+  }
+
+  int32_t freeSlot = -1;
+  for (int32_t i = 0; i < (int32_t)type.blocks.size(); ++i) {
+    Block &block = type.blocks[i];
+
+    if (block.memory == VK_NULL_HANDLE) {
+      freeSlot = i;
+      continue;
+    }
+
+    if (block.tiling == tiling &&
+        block.size - block.used >= requirements.size &&
+        allocateFromBlock(
+          block, requirements.size, requirements.alignment,
+          &allocation.offset)) {
+      allocation.memory = block.memory;
+      allocation.blockIndex = i;
+      allocation.mapped = block.mapped ?
+        block.mapped + allocation.offset : nullptr;
+
+      return allocation;
+    }
+  }
+
+  // Need a new block
+  Block newBlock = {};
+  newBlock.size = type.blockSize;
+  newBlock.tiling = tiling;
+  newBlock.freeRanges.push_back({0, newBlock.size});
+  newBlock.memory = allocateDeviceMemory(
+    newBlock.size, memoryType, &newBlock.mapped);
+
+  if (freeSlot == -1) {
+    freeSlot = type.blocks.size();
+    type.blocks.push_back(std::move(newBlock));
+  }
+  else {
+    type.blocks[freeSlot] = std::move(newBlock);
+  }
+
+  Block &block = type.blocks[freeSlot];
+  allocateFromBlock(
+    block, requirements.size, requirements.alignment, &allocation.offset);
+
+  allocation.memory = block.memory;
+  allocation.blockIndex = freeSlot;
+  allocation.mapped = block.mapped ? block.mapped + allocation.offset : nullptr;
+
+  return allocation;
+}
+
+void VulkanMemoryAllocator::free(VulkanMemoryAllocation &allocation) {
+  if (allocation.memory == VK_NULL_HANDLE) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  MemoryType &type = mTypes[allocation.memoryType];
+
+  if (allocation.blockIndex < 0) {
+    vkFreeMemory(mDevice, allocation.memory, nullptr);
+
+    --type.dedicatedCount;
+    type.dedicatedBytes -= allocation.size;
+  }
+  else {
+    Block &block = type.blocks[allocation.blockIndex];
+    freeInBlock(block, allocation.offset, allocation.size);
+
+    if (block.allocationCount == 0) {
+      // Keep one empty block around to avoid allocating / freeing every time
+      uint32_t liveBlockCount = 0;
+      for (auto &other : type.blocks) {
+        liveBlockCount += (other.memory != VK_NULL_HANDLE);
+      }
+
+      if (liveBlockCount > 1) {
+        vkFreeMemory(mDevice, block.memory, nullptr);
+        block.memory = VK_NULL_HANDLE;
+        block.mapped = nullptr;
+        block.freeRanges.clear();
+      }
+    }
+  }
+
+  allocation = {};
+}
+
+VulkanMemoryBudget VulkanMemoryAllocator::getBudget(uint32_t memoryType) const {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  const MemoryType &type = mTypes[memoryType];
+
+  VulkanMemoryBudget budget = {};
+  budget.dedicatedCount = type.dedicatedCount;
+  budget.dedicatedBytes = type.dedicatedBytes;
+
+  for (auto &block : type.blocks) {
+    if (block.memory != VK_NULL_HANDLE) {
+      ++budget.blockCount;
+      budget.blockBytes += block.size;
+      budget.usedBytes += block.used;
+      budget.allocationCount += block.allocationCount;
+    }
+  }
+
+  return budget;
+}
+
+void VulkanMemoryAllocator::debugLogBudget() const {
+  LOG_INFOV(
+    "Device memory (bufferImageGranularity = %d):\n",
+    (int)mBufferImageGranularity);
+
+  for (uint32_t i = 0; i < mMemoryProperties.memoryTypeCount; ++i) {
+    VulkanMemoryBudget budget = getBudget(i);
+    if (!budget.blockCount && !budget.dedicatedCount) {
+      continue;
+    }
+
+    auto &type = mMemoryProperties.memoryTypes[i];
+    VkDeviceSize heapSize = mMemoryProperties.memoryHeaps[type.heapIndex].size;
+
+    LOG_INFOV(
+      "\t* Type %d (heap %d, %.1fMB, flags 0x%x):\n",
+      (int)i, (int)type.heapIndex, (float)heapSize / (1024.0f * 1024.0f),
+      (uint32_t)type.propertyFlags);
+    LOG_INFOV(
+      "\t\t- %d blocks: %.2fMB used out of %.2fMB in %d allocations\n",
+      (int)budget.blockCount,
+      (float)budget.usedBytes / (1024.0f * 1024.0f),
+      (float)budget.blockBytes / (1024.0f * 1024.0f),
+      (int)budget.allocationCount);
+    LOG_INFOV(
+      "\t\t- %d dedicated allocations: %.2fMB\n",
+      (int)budget.dedicatedCount,
+      (float)budget.dedicatedBytes / (1024.0f * 1024.0f));
+  }
+}
+
+VkDeviceMemory VulkanMemoryAllocator::allocateDeviceMemory(
+  VkDeviceSize size, uint32_t memoryType, uint8_t **mapped) {
+  VkMemoryAllocateInfo allocInfo = {};
+  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+  allocInfo.allocationSize = size;
+  allocInfo.memoryTypeIndex = memoryType;
+
+  VkDeviceMemory memory;
+  VK_CHECK(vkAllocateMemory(mDevice, &allocInfo, nullptr, &memory));
+
+  *mapped = nullptr;
+
+  auto flags = mMemoryProperties.memoryTypes[memoryType].propertyFlags;
+  if (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+    // Host visible memory stays mapped for as long as it lives
+    VK_CHECK(vkMapMemory(mDevice, memory, 0, size, 0, (void **)mapped));
+  }
+
+  return memory;
+}
+
+bool VulkanMemoryAllocator::allocateFromBlock(
+  Block &block, VkDeviceSize size, VkDeviceSize alignment,
+  VkDeviceSize *offset) {
+  // First fit
+  for (uint32_t i = 0; i < block.freeRanges.size(); ++i) {
+    FreeRange &range = block.freeRanges[i];
+
+    VkDeviceSize alignedOffset =
+      (range.offset + alignment - 1) / alignment * alignment;
+    VkDeviceSize padding = alignedOffset - range.offset;
+
+    if (range.size < size + padding) {
+      continue;
+    }
+
+    VkDeviceSize end = alignedOffset + size;
+    VkDeviceSize rangeEnd = range.offset + range.size;
+
+    if (padding) {
+      // Padding stays free in front of the allocation
+      range.size = padding;
+
+      if (end < rangeEnd) {
+        block.freeRanges.insert(
+          block.freeRanges.begin() + i + 1, {end, rangeEnd - end});
+      }
+    }
+    else if (end < rangeEnd) {
+      range.offset = end;
+      range.size = rangeEnd - end;
+    }
+    else {
+      block.freeRanges.erase(block.freeRanges.begin() + i);
+    }
+
+    block.used += size;
+    ++block.allocationCount;
+    *offset = alignedOffset;
+
+    return true;
+  }
+
+  return false;
+}
+
+void VulkanMemoryAllocator::freeInBlock(
+  Block &block, VkDeviceSize offset, VkDeviceSize size) {
+  auto &ranges = block.freeRanges;
+
+  uint32_t index = 0;
+  while (index < ranges.size() && ranges[index].offset < offset) {
+    ++index;
+  }
+
+  ranges.insert(ranges.begin() + index, {offset, size});
+
+  // Merge with the next range
+  if (index + 1 < ranges.size() &&
+      ranges[index].offset + ranges[index].size == ranges[index + 1].offset) {
+    ranges[index].size += ranges[index + 1].size;
+    ranges.erase(ranges.begin() + index + 1);
+  }
+
+  // Merge with the previous range
+  if (index > 0 &&
+      ranges[index - 1].offset + ranges[index - 1].size == ranges[index].offset) {
+    ranges[index - 1].size += ranges[index].size;
+    ranges.erase(ranges.begin() + index);
+  }
+
+  block.used -= size;
+  --block.allocationCount;
+}
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+namespace Ondine::Graphics {
+
+/* Buffers and linear images vs. optimally tiled images */
+enum class VulkanResourceTiling : uint8_t {
+  Linear,
+  Optimal
+};
+
+struct VulkanMemoryAllocation {
+  VkDeviceMemory memory;
+  VkDeviceSize offset;
+  VkDeviceSize size;
+  // Non-null if the memory is host visible (blocks stay mapped)
+  uint8_t *mapped;
+  uint32_t memoryType;
+  // Index of the block in the memory type (-1 if dedicated)
+  int32_t blockIndex;
+};
+
+struct VulkanMemoryBudget {
+  uint32_t blockCount;
+  VkDeviceSize blockBytes;
+  VkDeviceSize usedBytes;
+  uint32_t allocationCount;
+  uint32_t dedicatedCount;
+  VkDeviceSize dedicatedBytes;
+};
+
+/*
+  Reserves big blocks of device memory per memory type and hands out ranges
+  of them. Anything big (render targets, etc...) gets its own allocation.
+*/
+class VulkanMemoryAllocator {
+public:
+  void init(
+    VkDevice device,
+    const VkPhysicalDeviceMemoryProperties &memoryProperties,
+    const VkPhysicalDeviceLimits &limits);
+
+  void destroy();
+
+  VulkanMemoryAllocation allocate(
+    const VkMemoryRequirements &requirements,
+    uint32_t memoryType,
+    VulkanResourceTiling tiling,
+    bool dedicated);
+
+  void free(VulkanMemoryAllocation &allocation);
+
+  VulkanMemoryBudget getBudget(uint32_t memoryType) const;
+  void debugLogBudget() const;
+
+private:
+  struct FreeRange {
+    VkDeviceSize offset;
+    VkDeviceSize size;
+  };
+
+  struct Block {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    VkDeviceSize used;
+    uint8_t *mapped;
+    /*
+      Blocks only ever hold one kind of resource - this way buffers and
+      optimal images never end up on the same bufferImageGranularity page
+    */
+    VulkanResourceTiling tiling;
+    uint32_t allocationCount;
+    // Sorted by offset
+    std::vector<FreeRange> freeRanges;
+  };
+
+  struct MemoryType {
+    std::vector<Block> blocks;
+    VkDeviceSize blockSize;
+    uint32_t dedicatedCount;
+    VkDeviceSize dedicatedBytes;
+  };
+
+  VkDeviceMemory allocateDeviceMemory(
+    VkDeviceSize size, uint32_t memoryType, uint8_t **mapped);
+
+  bool allocateFromBlock(
+    Block &block, VkDeviceSize size, VkDeviceSize alignment,
+    VkDeviceSize *offset);
+
+  void freeInBlock(Block &block, VkDeviceSize offset, VkDeviceSize size);
+
+private:
+  static constexpr VkDeviceSize MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+  // Anything above this fraction of a block gets its own allocation
+  static constexpr VkDeviceSize DEDICATED_THRESHOLD_DIVISOR = 2;
+
+  VkDevice mDevice;
+  VkPhysicalDeviceMemoryProperties mMemoryProperties;
+  VkDeviceSize mBufferImageGranularity;
+  MemoryType mTypes[VK_MAX_MEMORY_TYPES];
+  mutable std::mutex mMutex;
+};
+
+}
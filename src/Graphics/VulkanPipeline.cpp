@@ -41,12 +41,17 @@ VulkanShader::VulkanShader(const VulkanDevice &device, const char *path) {
     PANIC_AND_EXIT();
   }
 
-  Core::File file = Core::gFileSystem->createFile(
+  // Shaders get preloaded in parallel at the start of a pipeline build
+  mModule = device.mPipelineBuilder.findShaderModule(path);
+  if (mModule != VK_NULL_HANDLE) {
+    return;
+  }
+
+  Core::FileMapping file = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    path,
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    path);
 
-  Buffer data = file.readBinary();
+  Buffer data = file.view();
 
   VkShaderModuleCreateInfo shaderInfo = {};
   shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
@@ -268,6 +273,10 @@ void VulkanPipelineConfig::finishConfiguration(
       NULL,
       &mPipelineLayout));
 
+  // The config may have been copied since the defaults were set
+  mViewportInfo.pViewports = &mViewport;
+  mViewportInfo.pScissors = &mRect;
+
   mCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
   mCreateInfo.stageCount = mShaderStages.size;
   mCreateInfo.pStages = mShaderStages.data;
@@ -291,11 +300,27 @@ void VulkanPipeline::init(
   VulkanDescriptorSetLayoutMaker &layouts,
   VulkanPipelineConfig &config) {
   config.finishConfiguration(device, layouts);
+  create(device, config);
+}
+
+void VulkanPipeline::initDeferred(
+  const VulkanDevice &device,
+  VulkanDescriptorSetLayoutMaker &layouts,
+  VulkanPipelineConfig &config) {
+  if (device.mPipelineBuilder.isBuilding()) {
+    device.mPipelineBuilder.queue(device, layouts, *this, config);
+  }
+  else {
+    init(device, layouts, config);
+  }
+}
 
+void VulkanPipeline::create(
+  const VulkanDevice &device, const VulkanPipelineConfig &config) {
   VK_CHECK(
     vkCreateGraphicsPipelines(
       device.mLogicalDevice,
-      VK_NULL_HANDLE,
+      device.mPipelineCache.mPipelineCache,
       1,
       &config.mCreateInfo,
       NULL,
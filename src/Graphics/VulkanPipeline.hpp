@@ -130,6 +130,7 @@ private:
   VkPipelineLayout mPipelineLayout;
 
   friend class VulkanPipeline;
+  friend class VulkanPipelineBuilder;
 };
 
 /* 
@@ -144,13 +145,28 @@ public:
     VulkanDescriptorSetLayoutMaker &layouts,
     VulkanPipelineConfig &config);
 
+  /*
+     If a pipeline build is going on, the pipeline gets created on the job
+     system and can't be used before the build gets flushed. Otherwise, the
+     same as init. Config can go out of scope straight after.
+  */
+  void initDeferred(
+    const VulkanDevice &device,
+    VulkanDescriptorSetLayoutMaker &layouts,
+    VulkanPipelineConfig &config);
+
   void destroy(const VulkanDevice &device);
 
+private:
+  // Config needs to have been finished
+  void create(const VulkanDevice &device, const VulkanPipelineConfig &config);
+
 private:
   VkPipeline mPipeline;
   VkPipelineLayout mPipelineLayout;
 
   friend class VulkanCommandBuffer;
+  friend class VulkanPipelineBuilder;
 };
 
 }
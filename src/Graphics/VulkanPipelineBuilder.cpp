@@ -0,0 +1,166 @@
+#include <assert.h>
+#include <filesystem>
+#include "Log.hpp"
+#include "Time.hpp"
+#include "Memory.hpp"
+#include "Vulkan.hpp"
+#include "FileSystem.hpp"
+#include "ThreadPool.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanPipelineBuilder.hpp"
+
+namespace Ondine::Graphics {
+
+VulkanPipelineBuilder::VulkanPipelineBuilder()
+  : mIsBuilding(false) {
+
+}
+
+void VulkanPipelineBuilder::begin(
+  const VulkanDevice &device, const char *shaderDirectory) {
+  assert(!mIsBuilding);
+
+  mIsBuilding = true;
+  mPipelineCount = 0;
+  mPipelineTime = 0.0f;
+
+  Core::TimeStamp start = Core::getCurrentTime();
+
+  std::string directory = shaderDirectory;
+  if (directory.back() != '/') {
+    directory += '/';
+  }
+
+  std::string fullDirectory = Core::gFileSystem->getFullPath(
+    (Core::MountPoint)Core::ApplicationMountPoints::Application,
+    directory);
+
+  std::error_code error;
+  for (auto &entry :
+         std::filesystem::directory_iterator(fullDirectory, error)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".spv") {
+      mShaders.push_back(
+        {directory + entry.path().filename().string(), VK_NULL_HANDLE});
+    }
+  }
+
+  if (error) {
+    LOG_WARNINGV(
+      "Couldn't list shader directory %s: %s\n",
+      fullDirectory.c_str(), error.message().c_str());
+  }
+
+  ParallelBuild build = {&device, this};
+  Core::gThreadPool->parallelFor(mShaders.size(), preloadShader, &build);
+
+  for (auto &shader : mShaders) {
+    mShaderModules[shader.path] = shader.module;
+  }
+
+  mPreloadTime = Core::getTimeDifference(Core::getCurrentTime(), start);
+}
+
+void VulkanPipelineBuilder::flush(const VulkanDevice &device) {
+  if (mQueued.empty()) {
+    return;
+  }
+
+  Core::TimeStamp start = Core::getCurrentTime();
+
+  ParallelBuild build = {&device, this};
+  Core::gThreadPool->parallelFor(mQueued.size(), createPipeline, &build);
+
+  mPipelineTime += Core::getTimeDifference(Core::getCurrentTime(), start);
+  mPipelineCount += mQueued.size();
+
+  for (auto *queued : mQueued) {
+    flFree(queued);
+  }
+
+  mQueued.clear();
+}
+
+void VulkanPipelineBuilder::end(const VulkanDevice &device) {
+  assert(mIsBuilding);
+
+  flush(device);
+
+  // Pipelines don't reference their shader modules after creation
+  for (auto &shader : mShaders) {
+    vkDestroyShaderModule(device.mLogicalDevice, shader.module, NULL);
+  }
+
+  LOG_INFOV(
+    "Built %d pipelines from %d shaders on %d threads "
+    "(shaders %.3fs, pipelines %.3fs)\n",
+    (int)mPipelineCount, (int)mShaders.size(),
+    Core::gThreadPool->workerCount() + 1,
+    mPreloadTime, mPipelineTime);
+
+  mShaders.clear();
+  mShaderModules.clear();
+  mIsBuilding = false;
+}
+
+bool VulkanPipelineBuilder::isBuilding() const {
+  return mIsBuilding;
+}
+
+VkShaderModule VulkanPipelineBuilder::findShaderModule(const char *path) const {
+  if (!mIsBuilding) {
+    return VK_NULL_HANDLE;
+  }
+
+  auto module = mShaderModules.find(path);
+  if (module == mShaderModules.end()) {
+    return VK_NULL_HANDLE;
+  }
+  else {
+    return module->second;
+  }
+}
+
+void VulkanPipelineBuilder::queue(
+  const VulkanDevice &device,
+  VulkanDescriptorSetLayoutMaker &layouts,
+  VulkanPipeline &pipeline,
+  const VulkanPipelineConfig &config) {
+  assert(mIsBuilding);
+
+  auto *queued = flAlloc<QueuedPipeline>(QueuedPipeline{&pipeline, config});
+  queued->config.finishConfiguration(device, layouts);
+
+  mQueued.push_back(queued);
+}
+
+void VulkanPipelineBuilder::preloadShader(uint32_t index, void *data) {
+  auto *build = (ParallelBuild *)data;
+  PreloadedShader &shader = build->builder->mShaders[index];
+
+  Core::FileMapping file = Core::gFileSystem->mapFile(
+    (Core::MountPoint)Core::ApplicationMountPoints::Application,
+    shader.path);
+
+  Buffer source = file.view();
+
+  VkShaderModuleCreateInfo shaderInfo = {};
+  shaderInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+  shaderInfo.codeSize = source.size;
+  shaderInfo.pCode = (uint32_t *)source.data;
+
+  VK_CHECK(
+    vkCreateShaderModule(
+      build->device->mLogicalDevice,
+      &shaderInfo,
+      NULL,
+      &shader.module));
+}
+
+void VulkanPipelineBuilder::createPipeline(uint32_t index, void *data) {
+  auto *build = (ParallelBuild *)data;
+  QueuedPipeline *queued = build->builder->mQueued[index];
+
+  queued->pipeline->create(*build->device, queued->config);
+}
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include <unordered_map>
+#include "VulkanPipeline.hpp"
+
+namespace Ondine::Graphics {
+
+class VulkanDevice;
+
+/*
+   Builds the pipelines of all the render stages on the job system. A build
+   goes through two phases:
+   - begin: every SPIR-V file in the shader directory gets loaded and turned
+     into a shader module in parallel. VulkanShader(device, path) picks up
+     these modules instead of reading from disk.
+   - initDeferred / flush: pipelines get configured on the main thread (the
+     descriptor set layout maker and linear allocator aren't thread safe)
+     but their creation gets queued. flush creates everything which is
+     queued in parallel (the VkPipelineCache is internally synchronised).
+   end flushes and destroys the shader modules - the pipelines don't need
+   them anymore.
+*/
+class VulkanPipelineBuilder {
+public:
+  VulkanPipelineBuilder();
+
+  // Path of the shader directory relative to the application mount point
+  void begin(const VulkanDevice &device, const char *shaderDirectory);
+  void flush(const VulkanDevice &device);
+  void end(const VulkanDevice &device);
+
+  bool isBuilding() const;
+
+  // VK_NULL_HANDLE if the shader wasn't preloaded
+  VkShaderModule findShaderModule(const char *path) const;
+
+  // The pipeline handle is only valid after the next flush
+  void queue(
+    const VulkanDevice &device,
+    VulkanDescriptorSetLayoutMaker &layouts,
+    VulkanPipeline &pipeline,
+    const VulkanPipelineConfig &config);
+
+private:
+  struct PreloadedShader {
+    std::string path;
+    VkShaderModule module;
+  };
+
+  struct QueuedPipeline {
+    VulkanPipeline *pipeline;
+    // Copy so that the original can go out of scope / keep getting modified
+    VulkanPipelineConfig config;
+  };
+
+  struct ParallelBuild {
+    const VulkanDevice *device;
+    VulkanPipelineBuilder *builder;
+  };
+
+  static void preloadShader(uint32_t index, void *data);
+  static void createPipeline(uint32_t index, void *data);
+
+private:
+  bool mIsBuilding;
+  std::vector<PreloadedShader> mShaders;
+  std::unordered_map<std::string, VkShaderModule> mShaderModules;
+  std::vector<QueuedPipeline *> mQueued;
+
+  // Stats for the log at the end of the build
+  uint32_t mPipelineCount;
+  float mPreloadTime;
+  float mPipelineTime;
+};
+
+}
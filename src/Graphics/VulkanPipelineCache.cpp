@@ -0,0 +1,166 @@
+#include <string.h>
+#include "Log.hpp"
+#include "Utils.hpp"
+#include "Vulkan.hpp"
+#include "FileSystem.hpp"
+#include "VulkanDevice.hpp"
+#include "RendererCache.hpp"
+#include "VulkanPipelineCache.hpp"
+
+namespace Ondine::Graphics {
+
+VulkanPipelineCache::VulkanPipelineCache()
+  : mPipelineCache(VK_NULL_HANDLE) {
+
+}
+
+void VulkanPipelineCache::init(const VulkanDevice &device) {
+  std::string path =
+    std::string(DRAW_CACHE_DIRECTORY) + PIPELINE_CACHE_FILENAME;
+
+  Core::FileMapping file;
+  Buffer initialData = {};
+
+  if (Core::gFileSystem->isPathValid(
+        (Core::MountPoint)Core::ApplicationMountPoints::Application, path)) {
+    file = Core::gFileSystem->mapFile(
+      (Core::MountPoint)Core::ApplicationMountPoints::Application, path);
+
+    Buffer contents = file.view();
+
+    if (isValid(device, contents)) {
+      initialData.data = contents.data + sizeof(FileHeader);
+      initialData.size = contents.size - sizeof(FileHeader);
+    }
+    else {
+      LOG_WARNING("Pipeline cache is stale, rebuilding it\n");
+    }
+  }
+
+  VkPipelineCacheCreateInfo cacheInfo = {};
+  cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+  cacheInfo.initialDataSize = initialData.size;
+  cacheInfo.pInitialData = initialData.data;
+
+  VK_CHECK(
+    vkCreatePipelineCache(
+      device.mLogicalDevice,
+      &cacheInfo,
+      NULL,
+      &mPipelineCache));
+
+  LOG_INFOV(
+    "Created pipeline cache (%d bytes loaded)\n", (int)initialData.size);
+}
+
+void VulkanPipelineCache::destroy(const VulkanDevice &device) {
+  vkDestroyPipelineCache(device.mLogicalDevice, mPipelineCache, NULL);
+  mPipelineCache = VK_NULL_HANDLE;
+}
+
+void VulkanPipelineCache::save(const VulkanDevice &device) {
+  if (mPipelineCache == VK_NULL_HANDLE) {
+    return;
+  }
+
+  size_t dataSize = 0;
+  vkGetPipelineCacheData(
+    device.mLogicalDevice, mPipelineCache, &dataSize, NULL);
+
+  Buffer data = {
+    flAllocv<uint8_t>(sizeof(FileHeader) + dataSize),
+    sizeof(FileHeader) + dataSize
+  };
+
+  VkResult result = vkGetPipelineCacheData(
+    device.mLogicalDevice, mPipelineCache,
+    &dataSize, data.data + sizeof(FileHeader));
+
+  if (result == VK_SUCCESS) {
+    FileHeader header = makeHeader(device);
+    header.dataSize = dataSize;
+    memcpy(data.data, &header, sizeof(header));
+
+    if (!Core::gFileSystem->isPathValid(
+          (Core::MountPoint)Core::ApplicationMountPoints::Application,
+          DRAW_CACHE_DIRECTORY)) {
+      Core::gFileSystem->makeDirectory(
+        (Core::MountPoint)Core::ApplicationMountPoints::Application,
+        DRAW_CACHE_DIRECTORY);
+    }
+
+    Core::File file = Core::gFileSystem->createFile(
+      (Core::MountPoint)Core::ApplicationMountPoints::Application,
+      std::string(DRAW_CACHE_DIRECTORY) + PIPELINE_CACHE_FILENAME,
+      Core::FileOpenType::Binary |
+      Core::FileOpenType::Out |
+      Core::FileOpenType::Truncate);
+
+    file.write(data.data, sizeof(FileHeader) + dataSize);
+
+    LOG_INFOV("Saved pipeline cache (%d bytes)\n", (int)dataSize);
+  }
+  else {
+    LOG_ERRORV("Failed to get pipeline cache data: %d\n", (int)result);
+  }
+
+  flFreev(data.data);
+}
+
+VulkanPipelineCache::FileHeader VulkanPipelineCache::makeHeader(
+  const VulkanDevice &device) const {
+  const VkPhysicalDeviceProperties &properties = device.mPhysicalDeviceInfo;
+
+  FileHeader header = {};
+  header.magic = CACHE_MAGIC;
+  header.version = CACHE_VERSION;
+  header.vendorID = properties.vendorID;
+  header.deviceID = properties.deviceID;
+  header.driverVersion = properties.driverVersion;
+  memcpy(
+    header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+  return header;
+}
+
+bool VulkanPipelineCache::isValid(
+  const VulkanDevice &device, const Buffer &file) const {
+  if (file.size < sizeof(FileHeader)) {
+    return false;
+  }
+
+  FileHeader expected = makeHeader(device);
+  FileHeader header;
+  memcpy(&header, file.data, sizeof(header));
+
+  if (header.magic != expected.magic ||
+      header.version != expected.version ||
+      header.vendorID != expected.vendorID ||
+      header.deviceID != expected.deviceID ||
+      header.driverVersion != expected.driverVersion ||
+      memcmp(
+        header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) ||
+      header.dataSize != file.size - sizeof(FileHeader)) {
+    return false;
+  }
+
+  /* 
+     The driver also checks its own header but a truncated / corrupted file
+     is better caught here.
+  */
+  if (header.dataSize < sizeof(DriverHeader)) {
+    return false;
+  }
+
+  DriverHeader driverHeader;
+  memcpy(&driverHeader, file.data + sizeof(FileHeader), sizeof(driverHeader));
+
+  return driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+    driverHeader.vendorID == expected.vendorID &&
+    driverHeader.deviceID == expected.deviceID &&
+    !memcmp(
+      driverHeader.pipelineCacheUUID, expected.pipelineCacheUUID,
+      VK_UUID_SIZE);
+}
+
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+#include "Buffer.hpp"
+
+namespace Ondine::Graphics {
+
+class VulkanDevice;
+
+/*
+   Persistent VkPipelineCache. The data on disk is prefixed by a header
+   identifying the device / driver which produced it - if anything doesn't
+   match, the cache gets thrown away and rebuilt from scratch.
+*/
+class VulkanPipelineCache {
+public:
+  VulkanPipelineCache();
+
+  // Loads from the draw cache directory if there's a valid cache there
+  void init(const VulkanDevice &device);
+  void destroy(const VulkanDevice &device);
+
+  void save(const VulkanDevice &device);
+
+private:
+  struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint64_t dataSize;
+  };
+
+  // Layout of the header the driver puts at the start of the cache data
+  struct DriverHeader {
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+  };
+
+  FileHeader makeHeader(const VulkanDevice &device) const;
+  bool isValid(const VulkanDevice &device, const Buffer &file) const;
+
+private:
+  static constexpr uint32_t CACHE_MAGIC = 0x4F4E5043; // ONPC
+  static constexpr uint32_t CACHE_VERSION = 1;
+
+  VkPipelineCache mPipelineCache;
+
+  friend class VulkanPipeline;
+};
+
+}
@@ -0,0 +1,47 @@
+#include "Log.hpp"
+#include "Utils.hpp"
+#include "Vulkan.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanQueryPool.hpp"
+
+namespace Ondine::Graphics {
+
+void VulkanQueryPool::init(
+  const VulkanDevice &device, VkQueryType type, uint32_t count) {
+  mCount = count;
+
+  VkQueryPoolCreateInfo poolInfo = {};
+  poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+  poolInfo.queryType = type;
+  poolInfo.queryCount = count;
+
+  VK_CHECK(
+    vkCreateQueryPool(
+      device.mLogicalDevice,
+      &poolInfo,
+      NULL,
+      &mQueryPool));
+}
+
+void VulkanQueryPool::destroy(const VulkanDevice &device) {
+  vkDestroyQueryPool(device.mLogicalDevice, mQueryPool, NULL);
+}
+
+bool VulkanQueryPool::getResults(
+  const VulkanDevice &device,
+  uint32_t first, uint32_t count,
+  uint64_t *results) const {
+  VkResult result = vkGetQueryPoolResults(
+    device.mLogicalDevice, mQueryPool,
+    first, count,
+    sizeof(uint64_t) * count, results, sizeof(uint64_t),
+    VK_QUERY_RESULT_64_BIT);
+
+  return result == VK_SUCCESS;
+}
+
+uint32_t VulkanQueryPool::count() const {
+  return mCount;
+}
+
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+#include <vulkan/vulkan.h>
+
+namespace Ondine::Graphics {
+
+class VulkanDevice;
+
+class VulkanQueryPool {
+public:
+  VulkanQueryPool() = default;
+
+  void init(const VulkanDevice &device, VkQueryType type, uint32_t count);
+  void destroy(const VulkanDevice &device);
+
+  /* 
+     Doesn't wait - returns false if any of the queries aren't available yet.
+  */
+  bool getResults(
+    const VulkanDevice &device,
+    uint32_t first, uint32_t count,
+    uint64_t *results) const;
+
+  uint32_t count() const;
+
+private:
+  VkQueryPool mQueryPool;
+  uint32_t mCount;
+
+  friend class VulkanCommandBuffer;
+};
+
+}
@@ -2,12 +2,21 @@
 #include "Vulkan.hpp"
 #include "VulkanQueue.hpp"
 #include "VulkanDevice.hpp"
+#include "VulkanUploader.hpp"
 #include "VulkanSwapchain.hpp"
 #include "VulkanCommandBuffer.hpp"
 
 namespace Ondine::Graphics {
 
+VulkanQueue::VulkanQueue()
+  : mQueue(VK_NULL_HANDLE),
+    mSubmitMutex(nullptr),
+    mUploader(nullptr) {
+
+}
+
 void VulkanQueue::idle() const {
+  std::unique_lock<std::mutex> lock(*mSubmitMutex);
   vkQueueWaitIdle(mQueue);
 }
 
@@ -17,9 +26,25 @@ void VulkanQueue::submitCommandBuffer(
   const Array<VulkanSemaphore, AllocationType::Linear> &signalSemaphores,
   VkPipelineStageFlags waitStage,
   const VulkanFence &fence) const {
-  VkSemaphore *waitsRaw = STACK_ALLOC(VkSemaphore, waitSemaphores.size);
+  uint32_t uploadWaitCount = mUploader ? mUploader->pendingWaitCount() : 0;
+  uint32_t waitCount = waitSemaphores.size + uploadWaitCount;
+
+  VkSemaphore *waitsRaw = STACK_ALLOC(VkSemaphore, waitCount);
+  VkPipelineStageFlags *waitStages = STACK_ALLOC(
+    VkPipelineStageFlags, waitCount);
+
   for (int i = 0; i < waitSemaphores.size; ++i) {
     waitsRaw[i] = waitSemaphores[i].mSemaphore;
+    waitStages[i] = waitStage;
+  }
+
+  if (uploadWaitCount) {
+    uploadWaitCount = mUploader->takeWaitSemaphores(
+      uploadWaitCount,
+      waitsRaw + waitSemaphores.size,
+      waitStages + waitSemaphores.size);
+
+    waitCount = waitSemaphores.size + uploadWaitCount;
   }
 
   VkSemaphore *signalsRaw = STACK_ALLOC(VkSemaphore, signalSemaphores.size);
@@ -31,13 +56,26 @@ void VulkanQueue::submitCommandBuffer(
   submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer.mCommandBuffer;
-  submitInfo.waitSemaphoreCount = waitSemaphores.size;
+  submitInfo.waitSemaphoreCount = waitCount;
   submitInfo.pWaitSemaphores = waitsRaw;
-  submitInfo.pWaitDstStageMask = &waitStage;
+  submitInfo.pWaitDstStageMask = waitStages;
   submitInfo.signalSemaphoreCount = signalSemaphores.size;
   submitInfo.pSignalSemaphores = signalsRaw;
 
-  VK_CHECK(vkQueueSubmit(mQueue, 1, &submitInfo, fence.mFence));
+  {
+    // Not held above: gathering the uploads can submit to this VkQueue
+    std::unique_lock<std::mutex> lock(*mSubmitMutex);
+    VK_CHECK(vkQueueSubmit(mQueue, 1, &submitInfo, fence.mFence));
+  }
+
+  if (uploadWaitCount) {
+    mUploader->markConsumed(*this);
+  }
+}
+
+void VulkanQueue::submitFence(const VulkanFence &fence) const {
+  std::unique_lock<std::mutex> lock(*mSubmitMutex);
+  VK_CHECK(vkQueueSubmit(mQueue, 0, NULL, fence.mFence));
 }
 
 VkResult VulkanQueue::present(
@@ -51,6 +89,7 @@ VkResult VulkanQueue::present(
   presentInfo.pSwapchains = &swapchain.mSwapchain;
   presentInfo.pImageIndices = &swapchain.mImageIndex;
 
+  std::unique_lock<std::mutex> lock(*mSubmitMutex);
   return vkQueuePresentKHR(mQueue, &presentInfo);
 }
 
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <vulkan/vulkan.h>
 #include "Buffer.hpp"
 #include "VulkanSync.hpp"
@@ -8,9 +9,12 @@ namespace Ondine::Graphics {
 
 class VulkanCommandBuffer;
 class VulkanSwapchain;
+class VulkanUploader;
 
 class VulkanQueue {
 public:
+  VulkanQueue();
+
   void idle() const;
 
   void submitCommandBuffer(
@@ -20,12 +24,23 @@ public:
     VkPipelineStageFlags waitStage,
     const VulkanFence &fence) const;
 
+  // Fence signals once everything submitted before has finished
+  void submitFence(const VulkanFence &fence) const;
+
   VkResult present(
     const VulkanSwapchain &swapchain,
     const VulkanSemaphore &wait) const;
 
 private:
   VkQueue mQueue;
+  /*
+     vkQueue* calls need external synchronisation and uploads can get
+     submitted from any thread. Shared by the queues which are the same
+     VkQueue (i.e. transfer = graphics without a dedicated transfer family).
+  */
+  std::mutex *mSubmitMutex;
+  // If set, submissions wait on the uploads which came before them
+  VulkanUploader *mUploader;
 
   friend class VulkanDevice;
   friend class VulkanImgui;
@@ -344,6 +344,9 @@ void VulkanRenderPass::init(
       NULL,
       &mRenderPass));
 
+  mEntryDependency = config.mDeps[0];
+  mExitDependency = config.mDeps[config.mDeps.size - 1];
+
   mAttachments = config.mAttachments;
   mAttachmentTypes = config.mAttachmentTypes;
   mSubpasses = config.mSubpasses;
@@ -361,4 +364,12 @@ void VulkanRenderPass::destroy(const VulkanDevice &device) {
   mRefs.free();
 }
 
+const VkSubpassDependency &VulkanRenderPass::entryDependency() const {
+  return mEntryDependency;
+}
+
+const VkSubpassDependency &VulkanRenderPass::exitDependency() const {
+  return mExitDependency;
+}
+
 }
@@ -83,8 +83,14 @@ public:
 
   void destroy(const VulkanDevice &device);
 
+  // Dependencies with whatever comes before / after the render pass
+  const VkSubpassDependency &entryDependency() const;
+  const VkSubpassDependency &exitDependency() const;
+
 private:
   VkRenderPass mRenderPass;
+  VkSubpassDependency mEntryDependency;
+  VkSubpassDependency mExitDependency;
   Array<VkClearValue, AllocationType::Freelist> mClearValues;
   Array<VkAttachmentDescription, AllocationType::Freelist> mAttachments;
   Array<AttachmentType, AllocationType::Freelist> mAttachmentTypes;
@@ -94,6 +100,7 @@ private:
   friend class VulkanFramebufferConfig;
   friend class VulkanImgui;
   friend class VulkanCommandBuffer;
+  friend class VulkanRecordedStage;
   friend class VulkanPipelineConfig;
 };
 
@@ -79,6 +79,11 @@ void VulkanSemaphore::init(const VulkanDevice &device) {
       &mSemaphore));
 }
 
+void VulkanSemaphore::destroy(const VulkanDevice &device) {
+  vkDestroySemaphore(device.mLogicalDevice, mSemaphore, NULL);
+  mSemaphore = VK_NULL_HANDLE;
+}
+
 VulkanFence::VulkanFence()
   : mFence(VK_NULL_HANDLE) {
   
@@ -97,6 +102,11 @@ void VulkanFence::init(const VulkanDevice &device, VkFenceCreateFlags flags) {
       &mFence));
 }
 
+void VulkanFence::destroy(const VulkanDevice &device) {
+  vkDestroyFence(device.mLogicalDevice, mFence, NULL);
+  mFence = VK_NULL_HANDLE;
+}
+
 void VulkanFence::wait(const VulkanDevice &device) {
   vkWaitForFences(device.mLogicalDevice, 1, &mFence, VK_TRUE, UINT64_MAX);
 }
@@ -105,4 +115,8 @@ void VulkanFence::reset(const VulkanDevice &device) {
   vkResetFences(device.mLogicalDevice, 1, &mFence);
 }
 
+bool VulkanFence::isSignaled(const VulkanDevice &device) const {
+  return vkGetFenceStatus(device.mLogicalDevice, mFence) == VK_SUCCESS;
+}
+
 }
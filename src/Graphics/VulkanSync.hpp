@@ -12,12 +12,14 @@ class VulkanDevice;
 class VulkanSemaphore {
 public:
   void init(const VulkanDevice &device);
+  void destroy(const VulkanDevice &device);
 
 private:
   VkSemaphore mSemaphore;
 
   friend class VulkanQueue;
   friend class VulkanSwapchain;
+  friend class VulkanUploader;
 };
 
 class VulkanFence {
@@ -25,8 +27,10 @@ public:
   VulkanFence();
 
   void init(const VulkanDevice &device, VkFenceCreateFlags flags);
+  void destroy(const VulkanDevice &device);
   void wait(const VulkanDevice &device);
   void reset(const VulkanDevice &device);
+  bool isSignaled(const VulkanDevice &device) const;
 
 private:
   VkFence mFence;
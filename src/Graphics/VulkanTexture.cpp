@@ -13,7 +13,7 @@ void VulkanTexture::init(
   const VulkanDevice &device,
   TextureTypeBits type, TextureContents contents, VkFormat format,
   VkFilter filter, VkExtent3D extent, size_t layerCount,
-  size_t mipLevels) {
+  size_t mipLevels, const VulkanTexturePlacement *placement) {
   mExtent = extent;
   mType = type;
   mLayerCount = layerCount;
@@ -29,6 +29,7 @@ void VulkanTexture::init(
   VkMemoryPropertyFlags memoryFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
   VkImageTiling tilingMode = VK_IMAGE_TILING_OPTIMAL;
   VkSamplerAddressMode addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+  bool isAttachment = false;
 
   if (type & (TextureType::WrapSampling)) {
     type &= ~(TextureType::WrapSampling);
@@ -50,6 +51,7 @@ void VulkanTexture::init(
 
   if (type & TextureType::Attachment) {
     type &= ~(TextureType::Attachment);
+    isAttachment = true;
 
     // Yes I know we are doing this switch statement but who cares
     switch (contents) {
@@ -128,8 +130,31 @@ void VulkanTexture::init(
   VK_CHECK(
     vkCreateImage(device.mLogicalDevice, &imageInfo, NULL, &mImage));
 
-  mMemory = device.allocateImageMemory(
-    mImage, memoryFlags, &mMemoryRequirement);
+  mIsPlaced = placement != nullptr;
+
+  if (mIsPlaced) {
+    // Memory gets freed by whoever placed the texture there
+    VkMemoryRequirements requirements = imageMemoryRequirements(device);
+
+    vkBindImageMemory(
+      device.mLogicalDevice, mImage, placement->memory, placement->offset);
+
+    mMemory = {};
+    mMemory.memory = placement->memory;
+    mMemory.offset = placement->offset;
+    mMemory.size = requirements.size;
+    mMemory.blockIndex = -1;
+  }
+  else {
+    // Render targets get their own memory
+    mMemory = device.allocateImageMemory(
+      mImage, memoryFlags,
+      tilingMode == VK_IMAGE_TILING_LINEAR ?
+        VulkanResourceTiling::Linear : VulkanResourceTiling::Optimal,
+      isAttachment);
+  }
+
+  mMemoryRequirement = mMemory.size;
 
   VkImageViewCreateInfo imageViewInfo = {};
   imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -183,11 +208,10 @@ void VulkanTexture::initFromFile(
   const char *imagePath,
   TextureTypeBits type, TextureContents contents, VkFormat format,
   VkFilter filter, size_t mipLevels) {
-  Core::File imageFile = Core::gFileSystem->createFile(
+  Core::FileMapping imageFile = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    imagePath,
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
-  Buffer unparsed = imageFile.readBinary();
+    imagePath);
+  Buffer unparsed = imageFile.view();
   ImagePixels parsed = getImagePixelsFromBuffer(unparsed);
 
   init(
@@ -231,7 +255,9 @@ VkImageMemoryBarrier VulkanTexture::makeBarrier(
 
 void VulkanTexture::destroy(const VulkanDevice &device) {
   vkDestroyImage(device.mLogicalDevice, mImage, nullptr);
-  vkFreeMemory(device.mLogicalDevice, mMemory, nullptr);
+  if (!mIsPlaced) {
+    device.freeMemory(mMemory);
+  }
   vkDestroyImageView(device.mLogicalDevice, mImageViewSample, nullptr);
   if (mImageViewSample != mImageViewAttachment &&
       mImageViewAttachment != VK_NULL_HANDLE) {
@@ -243,13 +269,19 @@ void VulkanTexture::destroy(const VulkanDevice &device) {
   mImageViewSample = VK_NULL_HANDLE;
   mImageViewAttachment = VK_NULL_HANDLE;
   mSampler = VK_NULL_HANDLE;
-  mMemory = VK_NULL_HANDLE;
 }
 
 size_t VulkanTexture::memoryRequirement() const {
   return mMemoryRequirement;
 }
 
+VkMemoryRequirements VulkanTexture::imageMemoryRequirements(
+  const VulkanDevice &device) const {
+  VkMemoryRequirements requirements = {};
+  vkGetImageMemoryRequirements(device.mLogicalDevice, mImage, &requirements);
+  return requirements;
+}
+
 void VulkanTexture::fillWithStaging(
   const VulkanDevice &device,
   const VulkanCommandPool &commandPool,
@@ -262,9 +294,8 @@ void VulkanTexture::fillWithStaging(
     device, data.size,
     VulkanBufferFlag::Mappable | VulkanBufferFlag::TransferSource);
 
-  void *mappedMemory = stagingBuffer.map(device, data.size, 0);
+  void *mappedMemory = stagingBuffer.map(data.size, 0);
   memcpy(mappedMemory, data.data, data.size);
-  stagingBuffer.unmap(device);
 
   VulkanCommandBuffer commandBuffer = commandPool.makeCommandBuffer(
     device, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
@@ -4,6 +4,7 @@
 #include <stddef.h>
 #include "Utils.hpp"
 #include <vulkan/vulkan.h>
+#include "VulkanMemoryAllocator.hpp"
 
 namespace Ondine::Graphics {
 
@@ -33,6 +34,12 @@ enum TextureContents {
 
 class VulkanCommandPool;
 
+/* Memory owned by someone else which a texture gets bound to */
+struct VulkanTexturePlacement {
+  VkDeviceMemory memory;
+  VkDeviceSize offset;
+};
+
 class VulkanTexture {
 public:
   VulkanTexture() = default;
@@ -41,7 +48,7 @@ public:
     const VulkanDevice &device,
     TextureTypeBits type, TextureContents contents, VkFormat format,
     VkFilter filter, VkExtent3D extent, size_t layerCount,
-    size_t mipLevels);
+    size_t mipLevels, const VulkanTexturePlacement *placement = nullptr);
 
   void initFromFile(
     const VulkanDevice &device,
@@ -62,10 +69,13 @@ public:
   void destroy(const VulkanDevice &device);
 
   size_t memoryRequirement() const;
+  // What the image needs to get placed in memory
+  VkMemoryRequirements imageMemoryRequirements(
+    const VulkanDevice &device) const;
 
 private:
   VkImage mImage;
-  VkDeviceMemory mMemory;
+  VulkanMemoryAllocation mMemory;
   VkImageView mImageViewSample;
   VkImageView mImageViewAttachment;
   VkSampler mSampler;
@@ -78,6 +88,7 @@ private:
   TextureTypeBits mType;
   TextureContents mContents;
   VkImageAspectFlags mAspect;
+  bool mIsPlaced;
 
   friend class VulkanSwapchain;
   friend class VulkanFramebufferConfig;
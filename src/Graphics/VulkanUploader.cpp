@@ -0,0 +1,362 @@
+#include <string.h>
+#include "Log.hpp"
+#include "Memory.hpp"
+#include "Vulkan.hpp"
+#include "VulkanSync.hpp"
+#include "VulkanQueue.hpp"
+#include "VulkanDevice.hpp"
+#include "VulkanUploader.hpp"
+#include "VulkanCommandPool.hpp"
+#include "VulkanCommandBuffer.hpp"
+
+namespace Ondine::Graphics {
+
+enum class BatchState {
+  Free,
+  Recording,
+  Submitted,
+  // The graphics queue waited on the semaphore
+  Consumed
+};
+
+struct VulkanUploader::Batch {
+  BatchState state;
+  uint64_t serial;
+  bool isTransferDone;
+  bool isConsumeSubmitted;
+  uint64_t ringEnd;
+  VulkanCommandBuffer commandBuffer;
+  VulkanSemaphore semaphore;
+  VulkanFence transferFence;
+  // Signals once the graphics queue's wait on the semaphore is done
+  VulkanFence consumedFence;
+  std::vector<VulkanBuffer> overflow;
+};
+
+VulkanUploader::VulkanUploader()
+  : mDevice(nullptr),
+    mIsDedicated(false),
+    mCommandPool(nullptr),
+    mCurrent(nullptr) {
+
+}
+
+void VulkanUploader::init(
+  const VulkanDevice &device,
+  const VulkanQueue &transferQueue,
+  uint32_t queueFamily,
+  bool isDedicated) {
+  mDevice = &device;
+  mTransferQueue = &transferQueue;
+  mIsDedicated = isDedicated;
+  mCommandPool = flAlloc<VulkanCommandPool>();
+  mCommandPool->init(device, queueFamily);
+
+  mRing.init(
+    device, RING_SIZE,
+    VulkanBufferFlag::Mappable | VulkanBufferFlag::TransferSource);
+  mRingMapped = (uint8_t *)mRing.map(RING_SIZE, 0);
+  mRingHead = 0;
+  mRingTail = 0;
+
+  mCurrent = nullptr;
+  mNextSerial = 1;
+  mCompletedSerial = 0;
+
+  LOG_INFOV(
+    "Uploading through %s queue (family %d)\n",
+    isDedicated ? "a dedicated transfer" : "the graphics", (int)queueFamily);
+}
+
+void VulkanUploader::destroy(const VulkanDevice &device) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  // A batch still being recorded never got submitted - nothing to wait on
+  mCurrent = nullptr;
+
+  for (auto *batch : mInFlight) {
+    if (!batch->isTransferDone) {
+      batch->transferFence.wait(device);
+    }
+
+    if (batch->isConsumeSubmitted) {
+      batch->consumedFence.wait(device);
+    }
+  }
+
+  mInFlight.clear();
+
+  for (auto *batch : mBatches) {
+    for (auto &overflow : batch->overflow) {
+      overflow.destroy(device);
+    }
+
+    batch->semaphore.destroy(device);
+    batch->transferFence.destroy(device);
+    batch->consumedFence.destroy(device);
+
+    flFree(batch);
+  }
+
+  mBatches.clear();
+
+  // The command buffers go with the pool
+  mCommandPool->destroy(device);
+  flFree(mCommandPool);
+  mCommandPool = nullptr;
+
+  mRing.destroy(device);
+  mRingMapped = nullptr;
+}
+
+void VulkanUploader::upload(
+  const VulkanBuffer &dst, size_t dstOffset, const Buffer &data) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  Batch *batch = currentBatch();
+
+  const VulkanBuffer *src = &mRing;
+  size_t srcOffset;
+
+  if (allocateFromRing(data.size, &srcOffset)) {
+    memcpy(mRingMapped + srcOffset, data.data, data.size);
+  }
+  else {
+    // Too big or the ring is full - still no need to wait on anything
+    batch->overflow.emplace_back();
+    VulkanBuffer &overflow = batch->overflow.back();
+    overflow.init(
+      *mDevice, data.size,
+      VulkanBufferFlag::Mappable | VulkanBufferFlag::TransferSource);
+
+    memcpy(overflow.map(data.size, 0), data.data, data.size);
+
+    src = &overflow;
+    srcOffset = 0;
+  }
+
+  /*
+     No barriers: the host write gets made visible by the submission and
+     the graphics queue waits on the batch's semaphore before using dst.
+  */
+  VkBufferCopy region = {};
+  region.srcOffset = srcOffset;
+  region.dstOffset = dstOffset;
+  region.size = data.size;
+
+  vkCmdCopyBuffer(
+    batch->commandBuffer.mCommandBuffer,
+    src->mBuffer, dst.mBuffer, 1, &region);
+}
+
+uint64_t VulkanUploader::flush() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  return flushLocked();
+}
+
+bool VulkanUploader::isComplete(uint64_t serial) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  retire();
+  return serial <= mCompletedSerial;
+}
+
+void VulkanUploader::wait(uint64_t serial) {
+  std::unique_lock<std::mutex> lock(mMutex);
+  waitLocked(serial);
+}
+
+bool VulkanUploader::isDedicated() const {
+  return mIsDedicated;
+}
+
+uint32_t VulkanUploader::pendingWaitCount() {
+  std::unique_lock<std::mutex> lock(mMutex);
+  flushLocked();
+
+  uint32_t count = 0;
+  for (auto *batch : mInFlight) {
+    count += (batch->state == BatchState::Submitted);
+  }
+
+  return count;
+}
+
+uint32_t VulkanUploader::takeWaitSemaphores(
+  uint32_t maxCount, VkSemaphore *semaphores, VkPipelineStageFlags *stages) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  uint32_t count = 0;
+  for (auto *batch : mInFlight) {
+    if (count < maxCount && batch->state == BatchState::Submitted) {
+      semaphores[count] = batch->semaphore.mSemaphore;
+      // Uploaded buffers can be used by pretty much anything
+      stages[count] = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+      batch->state = BatchState::Consumed;
+      ++count;
+    }
+  }
+
+  return count;
+}
+
+void VulkanUploader::markConsumed(const VulkanQueue &consumer) {
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  /*
+     The semaphore can only get signaled again once the wait is done. A
+     fence-only submission signals after everything submitted before it.
+  */
+  for (auto *batch : mInFlight) {
+    if (batch->state == BatchState::Consumed && !batch->isConsumeSubmitted) {
+      consumer.submitFence(batch->consumedFence);
+      batch->isConsumeSubmitted = true;
+    }
+  }
+}
+
+VulkanUploader::Batch *VulkanUploader::currentBatch() {
+  if (mCurrent) {
+    return mCurrent;
+  }
+
+  retire();
+
+  Batch *batch = nullptr;
+  for (auto *candidate : mBatches) {
+    if (candidate->state == BatchState::Free) {
+      batch = candidate;
+      break;
+    }
+  }
+
+  if (!batch) {
+    batch = flAlloc<Batch>();
+    batch->commandBuffer = mCommandPool->makeCommandBuffer(
+      *mDevice, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+    batch->semaphore.init(*mDevice);
+    batch->transferFence.init(*mDevice, 0);
+    batch->consumedFence.init(*mDevice, 0);
+
+    mBatches.push_back(batch);
+  }
+
+  batch->state = BatchState::Recording;
+  batch->serial = mNextSerial++;
+  batch->isTransferDone = false;
+  batch->isConsumeSubmitted = false;
+
+  batch->commandBuffer.begin(
+    VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT, nullptr);
+
+  mCurrent = batch;
+
+  return batch;
+}
+
+uint64_t VulkanUploader::flushLocked() {
+  if (!mCurrent) {
+    // Last batch which got submitted
+    return mNextSerial - 1;
+  }
+
+  Batch *batch = mCurrent;
+  mCurrent = nullptr;
+
+  batch->commandBuffer.end();
+  batch->ringEnd = mRingHead;
+  batch->state = BatchState::Submitted;
+
+  // Avoids the linear allocator - uploads can come from other threads
+  Array<VulkanSemaphore, AllocationType::Linear> waits(nullptr, 0);
+  Array<VulkanSemaphore, AllocationType::Linear> signals(&batch->semaphore, 1);
+
+  mTransferQueue->submitCommandBuffer(
+    batch->commandBuffer, waits, signals, 0, batch->transferFence);
+
+  mInFlight.push_back(batch);
+
+  return batch->serial;
+}
+
+bool VulkanUploader::allocateFromRing(size_t size, size_t *offset) {
+  size_t alignedSize = (size + RING_ALIGNMENT - 1) & ~(RING_ALIGNMENT - 1);
+  if (alignedSize > RING_SIZE) {
+    return false;
+  }
+
+  // Allocations can't wrap around the end of the ring
+  size_t physical = mRingHead % RING_SIZE;
+  size_t padding = physical + alignedSize > RING_SIZE ?
+    RING_SIZE - physical : 0;
+
+  if (mRingHead + padding + alignedSize - mRingTail > RING_SIZE) {
+    retire();
+
+    if (mRingHead + padding + alignedSize - mRingTail > RING_SIZE) {
+      return false;
+    }
+  }
+
+  mRingHead += padding;
+  *offset = mRingHead % RING_SIZE;
+  mRingHead += alignedSize;
+
+  return true;
+}
+
+void VulkanUploader::retire() {
+  // Transfers finish in submission order
+  for (auto *batch : mInFlight) {
+    if (batch->isTransferDone) {
+      continue;
+    }
+
+    if (!batch->transferFence.isSignaled(*mDevice)) {
+      break;
+    }
+
+    batch->isTransferDone = true;
+    mRingTail = batch->ringEnd;
+    mCompletedSerial = batch->serial;
+
+    for (auto &overflow : batch->overflow) {
+      overflow.destroy(*mDevice);
+    }
+
+    batch->overflow.clear();
+  }
+
+  // Batches can only get reused once the graphics queue waited on them
+  for (uint32_t i = 0; i < mInFlight.size();) {
+    Batch *batch = mInFlight[i];
+
+    if (batch->isTransferDone &&
+        batch->isConsumeSubmitted &&
+        batch->consumedFence.isSignaled(*mDevice)) {
+      batch->transferFence.reset(*mDevice);
+      batch->consumedFence.reset(*mDevice);
+      batch->state = BatchState::Free;
+
+      mInFlight.erase(mInFlight.begin() + i);
+    }
+    else {
+      ++i;
+    }
+  }
+}
+
+void VulkanUploader::waitLocked(uint64_t serial) {
+  if (mCurrent && mCurrent->serial <= serial) {
+    flushLocked();
+  }
+
+  for (auto *batch : mInFlight) {
+    if (batch->serial <= serial && !batch->isTransferDone) {
+      batch->transferFence.wait(*mDevice);
+    }
+  }
+
+  retire();
+}
+
+}
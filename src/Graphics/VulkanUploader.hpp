@@ -0,0 +1,97 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include "Buffer.hpp"
+#include <vulkan/vulkan.h>
+#include "VulkanBuffer.hpp"
+
+namespace Ondine::Graphics {
+
+class VulkanQueue;
+class VulkanCommandPool;
+
+/*
+   Batches buffer uploads instead of stalling the GPU for each one. Data gets
+   copied into a persistently mapped staging ring and the copies get recorded
+   into the current batch. Batches get submitted on the transfer queue (a
+   dedicated one if the device has it) right before the next graphics queue
+   submission, which waits on the batch's semaphore.
+   Space in the ring gets reclaimed once the fence of the batch signals. Data
+   which doesn't fit in the ring gets its own staging buffer, freed with the
+   batch.
+*/
+class VulkanUploader {
+public:
+  VulkanUploader();
+
+  void init(
+    const VulkanDevice &device,
+    const VulkanQueue &transferQueue,
+    uint32_t queueFamily,
+    bool isDedicated);
+
+  // Waits for the batches which are still in flight and frees everything
+  void destroy(const VulkanDevice &device);
+
+  /*
+     Dst can't be in use by the GPU (i.e. a buffer which just got created).
+     The data is visible to every graphics queue submission after this call.
+  */
+  void upload(const VulkanBuffer &dst, size_t dstOffset, const Buffer &data);
+
+  // Submits the current batch if there is one. Returns its serial
+  uint64_t flush();
+  bool isComplete(uint64_t serial);
+  // Waits for the batch with this serial (flushing it if need be)
+  void wait(uint64_t serial);
+
+  bool isDedicated() const;
+
+private:
+  // Holds command buffer, semaphore and fences (defined in the source file)
+  struct Batch;
+
+  // Called by the graphics queue around its submissions
+  uint32_t pendingWaitCount();
+  // Other threads may have submitted more batches since pendingWaitCount
+  uint32_t takeWaitSemaphores(
+    uint32_t maxCount, VkSemaphore *semaphores, VkPipelineStageFlags *stages);
+  void markConsumed(const VulkanQueue &consumer);
+
+  Batch *currentBatch();
+  uint64_t flushLocked();
+  bool allocateFromRing(size_t size, size_t *offset);
+  void retire();
+  void waitLocked(uint64_t serial);
+
+private:
+  static constexpr size_t RING_SIZE = 32 * 1024 * 1024;
+  static constexpr size_t RING_ALIGNMENT = 16;
+
+  const VulkanDevice *mDevice;
+  const VulkanQueue *mTransferQueue;
+  bool mIsDedicated;
+  // Pointer because of the header dependencies (the device holds this)
+  VulkanCommandPool *mCommandPool;
+
+  VulkanBuffer mRing;
+  uint8_t *mRingMapped;
+  // Virtual offsets which only ever go up (physical offset is % RING_SIZE)
+  uint64_t mRingHead;
+  uint64_t mRingTail;
+
+  std::vector<Batch *> mBatches;
+  // Submitted batches whose transfer may not be done, in submission order
+  std::vector<Batch *> mInFlight;
+  Batch *mCurrent;
+  uint64_t mNextSerial;
+  uint64_t mCompletedSerial;
+  // Uploads can be kicked off from other threads
+  std::mutex mMutex;
+
+  friend class VulkanQueue;
+};
+
+}
@@ -41,7 +41,8 @@ void WaterRenderer::tick(
   mGBuffer.beginRender(frame);
   { // Render 3D scene
     sceneSubmitter.submit(
-      mReflectionCamera, planet, mClipping, terrainRenderer, frame);
+      mReflectionCamera, planet, mClipping, terrainRenderer, frame,
+      SceneView::WaterReflection);
     stars.render(1.0f, mReflectionCamera, frame);
   }
   mGBuffer.endRender(frame);
@@ -140,6 +141,10 @@ void WaterRenderer::updateCameraInfo(
     mCameraProperties.mProjection * mCameraProperties.mView;
 }
 
+const CameraProperties &WaterRenderer::cameraProperties() const {
+  return mCameraProperties;
+}
+
 void WaterRenderer::updateCameraUBO(const VulkanCommandBuffer &commandBuffer) {
   mReflectionCamera.updateData(commandBuffer, mCameraProperties);
 }
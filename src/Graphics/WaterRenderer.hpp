@@ -31,6 +31,8 @@ public:
   void updateCameraInfo(
     const CameraProperties &camera,
     const PlanetProperties &planet);
+  // Reflection camera (scene objects get culled against it)
+  const CameraProperties &cameraProperties() const;
 
   void updateCameraUBO(const VulkanCommandBuffer &commandBuffer);
   void updateLightingUBO(
@@ -1,5 +1,6 @@
 #include "Log.hpp"
 #include "Memory.hpp"
+#include "AsyncIO.hpp"
 #include "IOEvent.hpp"
 #include "MapView.hpp"
 #include "GameView.hpp"
@@ -15,7 +16,8 @@ namespace Ondine::Runtime {
 Application::Application(int argc, char **argv)
   : mWindow(Core::WindowMode::Windowed, "Ondine"),
     mRenderer3D(mGraphicsContext),
-    mViewStack(mRenderer3D, mGraphicsContext) {
+    mViewStack(mRenderer3D, mGraphicsContext),
+    mHeadless(parseHeadlessConfig(argc, argv)) {
   /* Initialise graphics context, etc... */
   setMaxFramerate(60.0f);
 }
@@ -25,14 +27,22 @@ Application::~Application() {
 }
 
 void Application::run() {
-  /* Change YONA_PROJECT_ROOT depending on build type */
-  Core::gFileSystem->addMountPoint(
-    (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    YONA_PROJECT_ROOT);
+  addMountPoints();
 
-  Core::gFileSystem->addMountPoint(
-    (Core::MountPoint)Core::ApplicationMountPoints::Raw,
-    "");
+  if (mHeadless.isNoiseBenchmark) {
+    runNoiseBenchmark();
+    return;
+  }
+
+  if (mHeadless.isRenderGraphTest) {
+    runRenderGraphTest();
+    return;
+  }
+
+  if (mHeadless.isEnabled) {
+    runHeadless();
+    return;
+  }
 
   mGraphicsContext.initInstance();
 
@@ -69,6 +79,7 @@ void Application::run() {
 
     mWindow.pollInput();
     Core::gFileSystem->trackFiles(evProc);
+    Core::gAsyncIO->tick(evProc);
     Core::gThreadPool->tick();
 
     /* 
@@ -136,6 +147,119 @@ void Application::run() {
 
   /* Shutdown */
   mRenderer3D.shutdown();
+  mGraphicsContext.shutdown();
+}
+
+void Application::addMountPoints() {
+  /* Change YONA_PROJECT_ROOT depending on build type */
+  Core::gFileSystem->addMountPoint(
+    (Core::MountPoint)Core::ApplicationMountPoints::Application,
+    YONA_PROJECT_ROOT);
+
+  Core::gFileSystem->addMountPoint(
+    (Core::MountPoint)Core::ApplicationMountPoints::Raw,
+    "");
+}
+
+void Application::runHeadless() {
+  LOG_INFOV(
+    "Running headless: %d frames at %dx%d\n",
+    (int)mHeadless.frameCount,
+    (int)mHeadless.resolution.width, (int)mHeadless.resolution.height);
+
+  mGraphicsContext.initInstance(true);
+
+  auto evProc = RECV_EVENT_PROC(recvEvent);
+
+  // Runs need to be comparable with each other
+  srand(0);
+  mGraphicsContext.initHeadlessContext(mHeadless.resolution);
+  mRenderer3D.init();
+  mRenderer3D.enableProfiling();
+  mViewStack.init();
+
+  /* Only the game view - the editor needs a window for imgui */
+  mViewStack.createView("GameView", new View::GameView(mRenderer3D, evProc));
+  mViewStack.push("GameView");
+
+  if (mHeadless.sceneObjectCount) {
+    populateBenchmarkScene(
+      *mRenderer3D.boundScene(), mHeadless.sceneObjectCount);
+  }
+
+  CameraPath cameraPath;
+  cameraPath.init(mHeadless.cameraPath);
+
+  start();
+
+  // Fixed time step so that every run simulates exactly the same frames
+  static constexpr float HEADLESS_DT = 1.0f / 60.0f;
+  float accumulatedTime = 0.0f;
+
+  for (uint32_t i = 0; i < mHeadless.frameCount; ++i) {
+    Core::Tick currentTick = { HEADLESS_DT, accumulatedTime };
+
+    Core::gAsyncIO->tick(evProc);
+    Core::gThreadPool->tick();
+
+    /* No window - nothing needs to react to input / cursor events */
+    mEventQueue.clearEvents();
+
+    lnClear();
+
+    tick();
+
+    float progress = mHeadless.frameCount > 1 ?
+      (float)i / (float)(mHeadless.frameCount - 1) : 0.0f;
+    auto keyframe = cameraPath.sample(progress);
+
+    auto &camera = mRenderer3D.boundScene()->camera;
+    camera.wPosition = keyframe.wPosition;
+    camera.wViewDirection = keyframe.wViewDirection;
+
+    Graphics::VulkanFrame frame = mGraphicsContext.beginFrame();
+    {
+      mRenderer3D.tick(currentTick, frame);
+      mViewStack.render(frame, currentTick);
+
+      mGraphicsContext.beginSwapchainRender(frame);
+      {
+        mViewStack.presentOutput(frame);
+      }
+      mGraphicsContext.endSwapchainRender(frame);
+
+      mGraphicsContext.endFrame(frame);
+    }
+
+    accumulatedTime += HEADLESS_DT;
+  }
+
+  mGraphicsContext.device().idle();
+
+  auto &profiler = mRenderer3D.profiler();
+  profiler.flush(mGraphicsContext.device());
+  profiler.logSummary();
+  logDrawListSummary(*mRenderer3D.boundScene(), profiler);
+
+  if (mHeadless.timingsPath) {
+    Core::File timingsFile(
+      mHeadless.timingsPath,
+      Core::FileOpenType::Out | Core::FileOpenType::Truncate);
+    profiler.writeReport(timingsFile);
+
+    LOG_INFOV("Wrote frame timings to %s\n", mHeadless.timingsPath);
+  }
+
+  if (mHeadless.capturePath) {
+    Buffer pixels = mGraphicsContext.captureHeadlessOutput();
+    writePPM(mHeadless.capturePath, pixels, mHeadless.resolution);
+    flFreev(pixels.data);
+
+    LOG_INFOV("Wrote final frame to %s\n", mHeadless.capturePath);
+  }
+
+  mRenderer3D.shutdown();
+  mGraphicsContext.shutdown();
 }
 
 void Application::recvEvent(Core::Event *ev, void *obj) {
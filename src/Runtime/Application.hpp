@@ -4,6 +4,7 @@
 #include "Time.hpp"
 #include "Event.hpp"
 #include "Window.hpp"
+#include "Headless.hpp"
 #include "Renderer3D.hpp"
 #include "ViewStack.hpp"
 #include "FileSystem.hpp"
@@ -26,6 +27,10 @@ private:
   virtual void start() = 0;
   virtual void tick() = 0;
 
+  void addMountPoints();
+  /* Renders a fixed amount of frames offscreen and reports timings */
+  void runHeadless();
+
   void pushEvent(Core::Event *ev);
   void processInputEvent(Core::Event *ev);
   void processGraphicsEvent(Core::Event *ev);
@@ -41,6 +46,7 @@ private:
   Graphics::Renderer3D mRenderer3D;
   View::ViewStack mViewStack;
   Core::InputTracker mInputTracker;
+  HeadlessConfig mHeadless;
 
   float mDt;
   float mMaxFramerate;
@@ -1,6 +1,9 @@
+#include <string.h>
 #include "Utils.hpp"
 #include "Client.hpp"
+#include "Logger.hpp"
 #include "Memory.hpp"
+#include "AsyncIO.hpp"
 #include "ThreadPool.hpp"
 #include "FileSystem.hpp"
 #include "VulkanContext.hpp"
@@ -8,6 +11,18 @@
 namespace Ondine::Runtime {
 
 int entry(int argc, char **argv) {
+  /* Logs go to stdout unless --log-file <path> was passed */
+  const char *logPath = nullptr;
+  for (int i = 1; i < argc - 1; ++i) {
+    if (!strcmp(argv[i], "--log-file")) {
+      logPath = argv[i + 1];
+    }
+  }
+
+  gLogger = flAlloc<Logger>();
+  gLogger->init(
+    logPath ? LogOutput::RotatingFile : LogOutput::Stdout, logPath);
+
   /* Make sure to also write FL allocator at some point */
   Core::gLinearAllocator = flAlloc<Core::LinearAllocator>(megabytes(10));
   Core::gLinearAllocator->init();
@@ -17,10 +32,18 @@ int entry(int argc, char **argv) {
   Core::gThreadPool = flAlloc<Core::ThreadPool>();
   Core::gThreadPool->init();
 
+  Core::gAsyncIO = flAlloc<Core::AsyncIO>();
+  Core::gAsyncIO->init();
+
   Application *client = flAlloc<Client>(argc, argv);
   client->run();
   flFree(client);
 
+  Core::gAsyncIO->shutdown();
+  Core::gFileSystem->shutdown();
+
+  gLogger->shutdown();
+
   return 0;
 }
 
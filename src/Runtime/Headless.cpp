@@ -0,0 +1,557 @@
+#include <stdio.h>
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Log.hpp"
+#include "File.hpp"
+#include "Time.hpp"
+#include "Noise.hpp"
+#include "Scene.hpp"
+#include "Memory.hpp"
+#include "Headless.hpp"
+#include "RenderGraph.hpp"
+#include "FileMapping.hpp"
+#include "FrameProfiler.hpp"
+
+namespace Ondine::Runtime {
+
+HeadlessConfig parseHeadlessConfig(int argc, char **argv) {
+  HeadlessConfig config = {};
+  config.frameCount = 300;
+  config.resolution = {1280, 720};
+
+  for (int i = 1; i < argc; ++i) {
+    bool hasValue = i + 1 < argc;
+
+    if (!strcmp(argv[i], "--headless")) {
+      config.isEnabled = true;
+    }
+    else if (!strcmp(argv[i], "--frames") && hasValue) {
+      config.frameCount = MAX(atoi(argv[++i]), 1);
+    }
+    else if (!strcmp(argv[i], "--resolution") && hasValue) {
+      unsigned width, height;
+      if (sscanf(argv[++i], "%ux%u", &width, &height) == 2 &&
+          width > 0 && height > 0) {
+        config.resolution = {width, height};
+      }
+      else {
+        LOG_WARNINGV("Invalid resolution %s, expected WxH\n", argv[i]);
+      }
+    }
+    else if (!strcmp(argv[i], "--camera-path") && hasValue) {
+      config.cameraPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--capture") && hasValue) {
+      config.capturePath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--timings") && hasValue) {
+      config.timingsPath = argv[++i];
+    }
+    else if (!strcmp(argv[i], "--scene-objects") && hasValue) {
+      config.sceneObjectCount = MAX(atoi(argv[++i]), 0);
+    }
+    else if (!strcmp(argv[i], "--noise-benchmark")) {
+      config.isNoiseBenchmark = true;
+    }
+    else if (!strcmp(argv[i], "--render-graph-test")) {
+      config.isRenderGraphTest = true;
+    }
+  }
+
+  return config;
+}
+
+void CameraPath::init(const char *path) {
+  mKeyframes.clear();
+
+  if (path) {
+    Core::FileMapping mapping;
+    if (mapping.init(path, Core::FileAccessHint::Sequential)) {
+      std::string contents((const char *)mapping.data(), mapping.size());
+
+      const char *line = contents.c_str();
+      while (*line) {
+        CameraKeyframe keyframe;
+        int count = sscanf(
+          line, "%f %f %f %f %f %f",
+          &keyframe.wPosition.x, &keyframe.wPosition.y, &keyframe.wPosition.z,
+          &keyframe.wViewDirection.x, &keyframe.wViewDirection.y,
+          &keyframe.wViewDirection.z);
+
+        if (count == 6) {
+          keyframe.wViewDirection = glm::normalize(keyframe.wViewDirection);
+          mKeyframes.push_back(keyframe);
+        }
+
+        const char *next = strchr(line, '\n');
+        line = next ? next + 1 : line + strlen(line);
+      }
+    }
+    else {
+      LOG_ERRORV("Failed to open camera path %s\n", path);
+    }
+
+    if (mKeyframes.empty()) {
+      LOG_WARNINGV(
+        "No keyframes in %s, falling back to the default path\n", path);
+    }
+  }
+
+  if (mKeyframes.empty()) {
+    // Circles around the objects of the game scene
+    mKeyframes = {
+      {{100.0f, 140.0f, -180.0f}, {-0.3f, -0.1f, 1.0f}},
+      {{-120.0f, 160.0f, -120.0f}, {0.6f, -0.2f, 0.6f}},
+      {{-150.0f, 200.0f, 120.0f}, {0.7f, -0.3f, -0.6f}},
+      {{120.0f, 120.0f, 150.0f}, {-0.6f, -0.1f, -0.8f}},
+      {{100.0f, 140.0f, -180.0f}, {-0.3f, -0.1f, 1.0f}}
+    };
+
+    for (auto &keyframe : mKeyframes) {
+      keyframe.wViewDirection = glm::normalize(keyframe.wViewDirection);
+    }
+  }
+}
+
+CameraKeyframe CameraPath::sample(float progress) const {
+  if (mKeyframes.size() == 1) {
+    return mKeyframes[0];
+  }
+
+  progress = glm::clamp(progress, 0.0f, 1.0f);
+
+  float position = progress * (float)(mKeyframes.size() - 1);
+  uint32_t index = MIN((uint32_t)position, (uint32_t)mKeyframes.size() - 2);
+  float t = position - (float)index;
+
+  const CameraKeyframe &a = mKeyframes[index];
+  const CameraKeyframe &b = mKeyframes[index + 1];
+
+  CameraKeyframe result;
+  result.wPosition = glm::mix(a.wPosition, b.wPosition, t);
+  result.wViewDirection = glm::normalize(
+    glm::mix(a.wViewDirection, b.wViewDirection, t));
+
+  return result;
+}
+
+void populateBenchmarkScene(Graphics::Scene &scene, uint32_t count) {
+  static const char *RENDER_METHODS[] = {
+    "SphereModelRenderMethod",
+    "TaurusModelRenderMethod",
+    "GlowingTaurusRenderMethod"
+  };
+
+  uint32_t available =
+    Graphics::Scene::MAX_SCENE_OBJECTS_COUNT - scene.sceneObjectCount();
+  count = MIN(count, available);
+
+  auto random = [] {
+    return (float)rand() / (float)RAND_MAX;
+  };
+
+  for (uint32_t i = 0; i < count; ++i) {
+    // Random order so that the draw list actually has something to sort
+    const char *renderMethod = RENDER_METHODS[rand() % 3];
+
+    auto handle = scene.createSceneObject(renderMethod);
+    auto &sceneObj = scene.getSceneObject(handle);
+    sceneObj.pushConstant.color = glm::vec3(random(), random(), random());
+
+    scene.transforms.set(
+      handle,
+      glm::vec3(
+        random() * 400.0f - 200.0f,
+        random() * 100.0f + 100.0f,
+        random() * 400.0f - 200.0f),
+      glm::angleAxis(
+        random() * glm::two_pi<float>(), glm::vec3(0.0f, 1.0f, 0.0f)),
+      glm::vec3(random() * 4.0f + 1.0f));
+  }
+
+  LOG_INFOV("Added %d benchmark objects to the scene\n", (int)count);
+}
+
+void logDrawListSummary(
+  const Graphics::Scene &scene, const Graphics::FrameProfiler &profiler) {
+  const Graphics::SceneDrawStats &stats = scene.drawStats();
+  const Graphics::SceneDrawStats &reflection =
+    scene.drawStats(Graphics::SceneView::WaterReflection);
+
+  uint32_t totalCount = stats.objectCount + stats.culledCount;
+  if (totalCount == 0) {
+    return;
+  }
+
+  float sortTime = 0.0f, recordTime = 0.0f;
+  for (uint32_t i = 0; i < profiler.stageCount(); ++i) {
+    const Graphics::ProfilerStage &stage = profiler.stage(i);
+    const Graphics::ProfilerTimings &timings = stage.timings;
+    float average = timings.cpuSamples ?
+      timings.cpuTotal / (float)timings.cpuSamples : 0.0f;
+
+    if (!strcmp(stage.name, "DrawList")) {
+      sortTime = average;
+    }
+    else if (!strcmp(stage.name, "GBuffer")) {
+      recordTime = average;
+    }
+  }
+
+  LOG_INFOV(
+    "Draw list: %d visible / %d culled objects in %d draw calls, "
+    "%d shader / %d buffer / %d resource binds\n",
+    (int)stats.objectCount, (int)stats.culledCount, (int)stats.drawCalls,
+    (int)stats.shaderBinds, (int)stats.bufferBinds, (int)stats.resourceBinds);
+
+  LOG_INFOV(
+    "\t* water reflection: %d visible / %d culled objects in %d draw calls\n",
+    (int)reflection.objectCount, (int)reflection.culledCount,
+    (int)reflection.drawCalls);
+
+  // Culling / sorting is per scene object, GBuffer also records the terrain
+  LOG_INFOV(
+    "\t* per object: culling + sort %.3fus, GBuffer recording %.3fus\n",
+    sortTime * 1000.0f / (float)totalCount,
+    stats.objectCount ?
+      recordTime * 1000.0f / (float)stats.objectCount : 0.0f);
+}
+
+bool runNoiseBenchmark(uint32_t sampleCount) {
+  using namespace Graphics;
+
+  static constexpr uint32_t ROUND_COUNT = 4;
+
+  float *coords[3];
+  for (int i = 0; i < 3; ++i) {
+    coords[i] = flAllocv<float>(sampleCount);
+  }
+
+  float *expected = flAllocv<float>(sampleCount);
+  float *result = flAllocv<float>(sampleCount);
+
+  // Runs need to be comparable with each other
+  srand(0);
+  for (uint32_t i = 0; i < sampleCount; ++i) {
+    for (int c = 0; c < 3; ++c) {
+      coords[c][i] = ((float)rand() / (float)RAND_MAX) * 2000.0f - 1000.0f;
+    }
+  }
+
+  auto evaluate = [&](NoiseType type, uint32_t dimensions, float *output) {
+    if (dimensions == 2) {
+      noise2D(type, coords[0], coords[1], output, sampleCount);
+    }
+    else {
+      noise3D(type, coords[0], coords[1], coords[2], output, sampleCount);
+    }
+  };
+
+  static const char *TYPE_NAMES[] = { "Perlin", "Simplex", "Value" };
+
+  NoiseISA defaultISA = noiseISA();
+  bool isMatching = true;
+
+  LOG_INFOV(
+    "Noise benchmark: %d samples, default kernels: %s\n",
+    (int)sampleCount, noiseISAName(defaultISA));
+
+  for (uint32_t dimensions = 2; dimensions <= 3; ++dimensions) {
+    for (int t = 0; t < (int)NoiseType::Count; ++t) {
+      NoiseType type = (NoiseType)t;
+
+      setNoiseISA(NoiseISA::Scalar);
+      evaluate(type, dimensions, expected);
+
+      for (int i = 0; i < (int)NoiseISA::Count; ++i) {
+        NoiseISA isa = (NoiseISA)i;
+        if (!setNoiseISA(isa)) {
+          continue;
+        }
+
+        Core::TimeStamp start = Core::getCurrentTime();
+        for (uint32_t r = 0; r < ROUND_COUNT; ++r) {
+          evaluate(type, dimensions, result);
+        }
+        float time = Core::getTimeDifference(Core::getCurrentTime(), start);
+
+        // Has to be exactly the same bits
+        uint32_t mismatchCount = 0;
+        for (uint32_t s = 0; s < sampleCount; ++s) {
+          if (memcmp(&result[s], &expected[s], sizeof(float))) {
+            ++mismatchCount;
+          }
+        }
+
+        float nsPerSample =
+          time * 1e9f / (float)(sampleCount * ROUND_COUNT);
+
+        LOG_INFOV(
+          "\t* %s %dD %s: %f ns / sample, %d mismatches\n",
+          TYPE_NAMES[t], (int)dimensions, noiseISAName(isa),
+          nsPerSample, (int)mismatchCount);
+
+        if (mismatchCount) {
+          LOG_ERRORV(
+            "%s kernels don't match the scalar ones (%s %dD)\n",
+            noiseISAName(isa), TYPE_NAMES[t], (int)dimensions);
+          isMatching = false;
+        }
+      }
+    }
+  }
+
+  setNoiseISA(defaultISA);
+
+  for (int i = 0; i < 3; ++i) {
+    flFreev(coords[i]);
+  }
+
+  flFreev(expected);
+  flFreev(result);
+
+  return isMatching;
+}
+
+bool runRenderGraphTest() {
+  using namespace Graphics;
+
+  static constexpr VkDeviceSize MB = 1024 * 1024;
+
+  bool isPassing = true;
+
+  auto check = [&isPassing](bool condition, const char *what) {
+    if (!condition) {
+      LOG_ERRORV("Render graph test failed: %s\n", what);
+      isPassing = false;
+    }
+  };
+
+  RenderGraph graph;
+
+  /*
+     Culling and forwarding: the blur is disabled so the tone mapping reads
+     the scene colour directly, nobody reads what the debug pass writes.
+  */
+  {
+    VkMemoryRequirements requirements = {4 * MB, 256, 0x3};
+
+    RenderGraphResource sceneColor = graph.addTransientResource(
+      "SceneColor", requirements);
+    RenderGraphResource blurred = graph.addTransientResource(
+      "Blurred", requirements);
+    RenderGraphResource debug = graph.addTransientResource(
+      "Debug", requirements);
+    RenderGraphResource output = graph.importResource("Output");
+    graph.markOutput(output);
+
+    RenderGraphPass scene = graph.addPass("Scene", {}, {});
+    graph.write(
+      scene, sceneColor, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+    RenderGraphPass debugPass = graph.addPass("Debug", {}, {});
+    graph.read(debugPass, sceneColor);
+    graph.write(
+      debugPass, debug, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    RenderGraphPass blur = graph.addPass("Blur", {}, {});
+    graph.read(blur, sceneColor);
+    graph.write(
+      blur, blurred, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    graph.forward(blur, sceneColor, blurred);
+    graph.setEnabled(blur, false);
+
+    RenderGraphPass toneMapping = graph.addPass("ToneMapping", {}, {});
+    graph.read(toneMapping, blurred);
+    graph.write(
+      toneMapping, output, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    graph.compile();
+
+    check(!graph.isCulled(scene), "scene pass got culled");
+    check(graph.isCulled(debugPass), "unread debug pass wasn't culled");
+    check(graph.isCulled(blur), "disabled blur pass wasn't culled");
+    check(!graph.isCulled(toneMapping), "tone mapping pass got culled");
+    check(graph.stats().culledPassCount == 2, "wrong culled pass count");
+    check(
+      graph.resolve(blurred) == sceneColor,
+      "blur output wasn't forwarded to its input");
+
+    // Colour writes need to be visible to the sampling + layout transition
+    const RenderGraphBarrier &barrier = graph.barrier(toneMapping);
+    check(
+      barrier.srcStages & VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      "tone mapping doesn't wait for the scene colour writes");
+    check(
+      barrier.srcAccess & VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      "scene colour writes aren't made available");
+    check(
+      barrier.dstStages & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT &&
+      barrier.dstAccess & VK_ACCESS_SHADER_READ_BIT,
+      "scene colour writes aren't visible to the tone mapping");
+    check(barrier.transitionCount == 1, "wrong tone mapping transitions");
+
+    if (barrier.transitionCount == 1) {
+      const RenderGraphTransition &transition =
+        graph.transition(barrier.firstTransition);
+
+      check(
+        transition.resource == sceneColor &&
+        transition.oldLayout == VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL &&
+        transition.newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        "wrong scene colour transition");
+    }
+
+    // Barriers are never needed for culled passes
+    check(
+      !graph.barrier(debugPass).srcStages && !graph.barrier(blur).srcStages,
+      "culled passes got barriers");
+  }
+
+  /*
+     A render pass whose entry dependency already makes the writes visible
+     doesn't need a barrier on top of it.
+  */
+  {
+    graph.reset();
+
+    VkMemoryRequirements requirements = {MB, 256, 0x3};
+    RenderGraphResource color = graph.addTransientResource(
+      "Color", requirements);
+    RenderGraphResource output = graph.importResource("Output");
+    graph.markOutput(output);
+
+    RenderGraphPass first = graph.addPass("First", {}, {});
+    graph.write(
+      first, color, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    RenderGraphSync entry = {
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+      VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT
+    };
+
+    RenderGraphPass second = graph.addPass("Second", entry, {});
+    graph.read(second, color);
+    graph.write(
+      second, output, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+    graph.compile();
+
+    check(
+      !(graph.barrier(second).srcStages &
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT),
+      "barrier duplicates the render pass' entry dependency");
+  }
+
+  /*
+     Aliasing: a chain of passes where each intermediate result is only
+     alive between two neighbouring passes, A and C can share memory.
+  */
+  {
+    graph.reset();
+
+    RenderGraphResource a = graph.addTransientResource(
+      "A", {4 * MB, 256, 0x3});
+    RenderGraphResource b = graph.addTransientResource(
+      "B", {4 * MB, 256, 0x3});
+    RenderGraphResource c = graph.addTransientResource(
+      "C", {2 * MB, 256, 0x3});
+    // No memory type in common with the others
+    RenderGraphResource d = graph.addTransientResource(
+      "D", {MB, 256, 0x4});
+    RenderGraphResource output = graph.importResource("Output");
+    graph.markOutput(output);
+
+    RenderGraphResource chain[] = {a, b, c, output};
+
+    for (int i = 0; i < 4; ++i) {
+      RenderGraphPass pass = graph.addPass("Chain", {}, {});
+
+      if (i > 0) {
+        graph.read(pass, chain[i - 1]);
+      }
+
+      graph.write(
+        pass, chain[i], RenderGraphAccess::ColorAttachment,
+        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    }
+
+    // D lives from the first to the last pass
+    graph.write(
+      0, d, RenderGraphAccess::ColorAttachment,
+      VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    graph.read(3, d);
+
+    graph.compile();
+
+    check(
+      graph.isPlaced(a) && graph.isPlaced(b) && graph.isPlaced(c),
+      "compatible transient resources weren't placed");
+    check(!graph.isPlaced(d), "incompatible resource got placed");
+    check(graph.memoryOffset(a) == 0, "wrong offset for A");
+    check(graph.memoryOffset(b) == 4 * MB, "wrong offset for B");
+    check(graph.memoryOffset(c) == 0, "C doesn't alias A");
+    check(graph.memoryRequirements().size == 8 * MB, "wrong block size");
+    check(
+      graph.memoryRequirements().memoryTypeBits == 0x3,
+      "wrong block memory types");
+    check(
+      graph.stats().transientBytes == 10 * MB &&
+      graph.stats().aliasedBytes == 8 * MB,
+      "wrong aliasing stats");
+
+    // C reuses the memory A gets sampled from in the previous pass
+    check(
+      graph.barrier(2).srcStages & VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+      "C gets written before the reads of its memory are done");
+  }
+
+  if (isPassing) {
+    LOG_INFO("Render graph test passed\n");
+  }
+
+  return isPassing;
+}
+
+void writePPM(const char *path, const Buffer &pixels, Resolution resolution) {
+  uint32_t pixelCount = resolution.width * resolution.height;
+  assert(pixels.size >= pixelCount * 4);
+
+  char header[64];
+  int headerLength = snprintf(
+    header, sizeof(header), "P6\n%u %u\n255\n",
+    resolution.width, resolution.height);
+
+  size_t size = headerLength + pixelCount * 3;
+  uint8_t *output = flAllocv<uint8_t>(size);
+  memcpy(output, header, headerLength);
+
+  uint8_t *dst = output + headerLength;
+  for (uint32_t i = 0; i < pixelCount; ++i) {
+    dst[i * 3 + 0] = pixels.data[i * 4 + 0];
+    dst[i * 3 + 1] = pixels.data[i * 4 + 1];
+    dst[i * 3 + 2] = pixels.data[i * 4 + 2];
+  }
+
+  Core::File file(
+    path,
+    Core::FileOpenType::Out |
+    Core::FileOpenType::Binary |
+    Core::FileOpenType::Truncate);
+
+  file.write(output, size);
+
+  flFreev(output);
+}
+
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <stdint.h>
+#include <glm/glm.hpp>
+#include "Utils.hpp"
+#include "Buffer.hpp"
+
+namespace Ondine::Graphics {
+
+class Scene;
+class FrameProfiler;
+
+}
+
+namespace Ondine::Runtime {
+
+/*
+   --headless [--frames N] [--resolution WxH] [--camera-path file]
+   [--capture file.ppm] [--timings file.csv] [--scene-objects N]
+
+   --noise-benchmark runs the noise benchmark instead of the application
+   --render-graph-test compiles a few render graphs and checks the results
+*/
+struct HeadlessConfig {
+  bool isEnabled;
+  uint32_t frameCount;
+  Resolution resolution;
+  // These are all optional (null if not passed)
+  const char *cameraPath;
+  const char *capturePath;
+  const char *timingsPath;
+  // Extra objects scattered around the scene (stress tests the draw list)
+  uint32_t sceneObjectCount;
+  bool isNoiseBenchmark;
+  bool isRenderGraphTest;
+};
+
+HeadlessConfig parseHeadlessConfig(int argc, char **argv);
+
+struct CameraKeyframe {
+  glm::vec3 wPosition;
+  glm::vec3 wViewDirection;
+};
+
+/* Camera path which gets followed (at constant speed) during headless runs */
+class CameraPath {
+public:
+  /*
+     File contains a keyframe per line: "x y z dirX dirY dirZ". If path is
+     null, a default path around the game scene gets used.
+  */
+  void init(const char *path);
+
+  // Progress goes from 0 (first keyframe) to 1 (last keyframe)
+  CameraKeyframe sample(float progress) const;
+
+private:
+  std::vector<CameraKeyframe> mKeyframes;
+};
+
+/*
+   Adds count objects with random render methods / transforms to the scene
+   (clamped to the scene's capacity).
+*/
+void populateBenchmarkScene(Graphics::Scene &scene, uint32_t count);
+
+// Per object CPU cost of sorting and recording the draw list
+void logDrawListSummary(
+  const Graphics::Scene &scene, const Graphics::FrameProfiler &profiler);
+
+/*
+   Times every noise type with every set of kernels the CPU supports and
+   checks that they all give exactly the same results as the scalar ones.
+   Returns false if any of them don't.
+*/
+bool runNoiseBenchmark(uint32_t sampleCount = 1 << 20);
+
+/*
+   Compiles small render graphs on the CPU and checks which passes get
+   culled, how resources get forwarded, which barriers get emitted and
+   where the transient resources end up. Returns false if anything is off.
+*/
+bool runRenderGraphTest();
+
+/* Writes tightly packed RGBA8 pixels to a binary PPM (alpha gets dropped) */
+void writePPM(const char *path, const Buffer &pixels, Resolution resolution);
+
+}
@@ -307,19 +307,17 @@ void EditorView::destroyRenderTarget(Graphics::VulkanContext &graphicsContext) {
 
 void EditorView::initViewportRendering(
   Graphics::VulkanContext &graphicsContext) {
-  Core::File vshFile = Core::gFileSystem->createFile(
+  Core::FileMapping vshFile = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/TexturedQuad.vert.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/TexturedQuad.vert.spv");
 
-  Buffer vsh = vshFile.readBinary();
+  Buffer vsh = vshFile.view();
 
-  Core::File fshFile = Core::gFileSystem->createFile(
+  Core::FileMapping fshFile = Core::gFileSystem->mapFile(
     (Core::MountPoint)Core::ApplicationMountPoints::Application,
-    "res/spv/TexturedQuad.frag.spv",
-    Core::FileOpenType::Binary | Core::FileOpenType::In);
+    "res/spv/TexturedQuad.frag.spv");
 
-  Buffer fsh = fshFile.readBinary();
+  Buffer fsh = fshFile.view();
 
   Graphics::VulkanPipelineConfig pipelineConfig(
     {mRenderPass, 0},
@@ -555,6 +553,19 @@ void EditorView::renderTerrainWindow() {
     static glm::vec3 paintColor = glm::vec3(0.0f);
 
     ImGui::ColorEdit3("Paint Color", &paintColor[0]);
+
+    auto &terrain = mRenderer3D.mBoundScene->terrain;
+
+    const char *reductions[] = {"Min", "Max", "Average"};
+    int currentReduction = (int)terrain.densityMipReduction();
+
+    // Stays as is if a modification is in flight - can be picked again
+    if (ImGui::Combo(
+          "Density Mip Reduction", &currentReduction, reductions,
+          sizeof(reductions) / sizeof(reductions[0]))) {
+      terrain.setDensityMipReduction(
+        (Graphics::DensityMipReduction)currentReduction);
+    }
   }
 
   ImGui::End();
@@ -612,6 +623,26 @@ void EditorView::renderToolsWindow() {
         "Allocated nodes", "%d",
         terrainRenderer.mQuadTree.mAllocatedNodeCount);
 
+      auto &quadTree = terrainRenderer.mQuadTree;
+
+      float hysteresis = quadTree.mMergeHysteresis;
+      if (ImGui::SliderFloat("LOD Hysteresis", &hysteresis, 1.0f, 2.0f)) {
+        quadTree.setLODHysteresis(hysteresis);
+      }
+
+      float lookahead = quadTree.mLookahead;
+      if (ImGui::SliderFloat("LOD Lookahead", &lookahead, 0.0f, 8.0f)) {
+        quadTree.setLODLookahead(lookahead);
+      }
+
+      const auto &lodStats = quadTree.lodStats();
+      ImGui::LabelText("Splits (last update)", "%u", lodStats.splitCount);
+      ImGui::LabelText("Merges (last update)", "%u", lodStats.mergeCount);
+      ImGui::LabelText("Total splits", "%u", lodStats.totalSplitCount);
+      ImGui::LabelText("Total merges", "%u", lodStats.totalMergeCount);
+      ImGui::LabelText(
+        "Focal point updates", "%u", lodStats.focalPointUpdateCount);
+
       auto *node = terrainRenderer.mQuadTree.getDeepestNode(
         terrainRenderer.mIsosurface.worldToQuadTreeCoords(
           terrainRenderer.mQuadTree,
@@ -23,46 +23,49 @@ GameView::GameView(
     auto handle5 = mGameScene->createSceneObject("GlowingTaurusRenderMethod"); 
     auto &sceneObj5 = mGameScene->getSceneObject(handle5);
     sceneObj5.pushConstant.color = glm::vec3(1.8f, 0.9f, 2.85f) * 1.0f;
-    sceneObj5.position = glm::vec3(0.0f, 240.0f, 0.0f);
-    sceneObj5.scale = glm::vec3(10.0f);
-    sceneObj5.rotation = glm::angleAxis(
-      glm::radians(30.0f), glm::vec3(-1.0f, 0.0f, 0.0f));
-    sceneObj5.constructTransform();
+    mGameScene->transforms.set(
+      handle5,
+      glm::vec3(0.0f, 240.0f, 0.0f),
+      glm::angleAxis(glm::radians(30.0f), glm::vec3(-1.0f, 0.0f, 0.0f)),
+      glm::vec3(10.0f));
 #endif
 
     #if 1
     auto handle1 = mGameScene->createSceneObject("TaurusModelRenderMethod"); 
     auto &sceneObj1 = mGameScene->getSceneObject(handle1);
     sceneObj1.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj1.position = glm::vec3(0.0f, 140.0f, 0.0f);
-    sceneObj1.scale = glm::vec3(10.0f);
-    sceneObj1.rotation = glm::angleAxis(
-      glm::radians(30.0f), glm::vec3(-1.0f, 0.0f, 0.0f));
-    sceneObj1.constructTransform();
+    mGameScene->transforms.set(
+      handle1,
+      glm::vec3(0.0f, 140.0f, 0.0f),
+      glm::angleAxis(glm::radians(30.0f), glm::vec3(-1.0f, 0.0f, 0.0f)),
+      glm::vec3(10.0f));
 
     auto handle2 = mGameScene->createSceneObject("SphereModelRenderMethod"); 
     auto &sceneObj2 = mGameScene->getSceneObject(handle2);
     sceneObj2.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj2.position = glm::vec3(30.0f, 150.0f, 0.0f);
-    sceneObj2.scale = glm::vec3(5.0f);
-    sceneObj2.rotation = glm::angleAxis(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    sceneObj2.constructTransform();
+    mGameScene->transforms.set(
+      handle2,
+      glm::vec3(30.0f, 150.0f, 0.0f),
+      glm::angleAxis(0.0f, glm::vec3(0.0f, 1.0f, 0.0f)),
+      glm::vec3(5.0f));
 
     auto handle3 = mGameScene->createSceneObject("SphereModelRenderMethod"); 
     auto &sceneObj3 = mGameScene->getSceneObject(handle3);
     sceneObj3.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj3.position = glm::vec3(0.0f, 105.0f, -30.0f);
-    sceneObj3.scale = glm::vec3(5.0f);
-    sceneObj3.rotation = glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-    sceneObj3.constructTransform();
+    mGameScene->transforms.set(
+      handle3,
+      glm::vec3(0.0f, 105.0f, -30.0f),
+      glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+      glm::vec3(5.0f));
 
     auto handle4 = mGameScene->createSceneObject("SphereModelRenderMethod"); 
     auto &sceneObj4 = mGameScene->getSceneObject(handle4);
     sceneObj4.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj4.position = glm::vec3(-100.0f, 90.0f, 100.0f);
-    sceneObj4.scale = glm::vec3(20.0f);
-    sceneObj4.rotation = glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-    sceneObj4.constructTransform();
+    mGameScene->transforms.set(
+      handle4,
+      glm::vec3(-100.0f, 90.0f, 100.0f),
+      glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+      glm::vec3(20.0f));
     #endif
   }
 
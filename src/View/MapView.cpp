@@ -31,46 +31,44 @@ MapView::MapView(
   mMapScene->terrain.makeSphere(500.0f, glm::vec3(1000.0f, 580.0f, 1100.0f));
   */
   
-  mMapScene->terrain.makeIslands(
-    100, 5, 0.1f, 1.4f, 20.0f, 0.8f,
-    glm::ivec2(-250, -250) * 7,
-    glm::ivec2(250, 250) * 7);
-
   // mMapScene->terrain.generateVoxelNormals();
 
   { // Set up scene objects
     auto handle1 = mMapScene->createSceneObject("TaurusModelRenderMethod"); 
     auto &sceneObj1 = mMapScene->getSceneObject(handle1);
     sceneObj1.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f) * 2.0f;
-    sceneObj1.position = glm::vec3(1051.0f, 130.0f, 605.0f);
-    sceneObj1.scale = glm::vec3(10.0f);
-    sceneObj1.rotation = glm::angleAxis(
-      glm::radians(30.0f), glm::vec3(-1.0f, 0.0f, 0.0f));
-    sceneObj1.constructTransform();
+    mMapScene->transforms.set(
+      handle1,
+      glm::vec3(1051.0f, 130.0f, 605.0f),
+      glm::angleAxis(glm::radians(30.0f), glm::vec3(-1.0f, 0.0f, 0.0f)),
+      glm::vec3(10.0f));
 
     auto handle2 = mMapScene->createSceneObject("SphereModelRenderMethod"); 
     auto &sceneObj2 = mMapScene->getSceneObject(handle2);
     sceneObj2.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj2.position = glm::vec3(1081.0f, 150.0f, 605.0f);
-    sceneObj2.scale = glm::vec3(5.0f);
-    sceneObj2.rotation = glm::angleAxis(0.0f, glm::vec3(0.0f, 1.0f, 0.0f));
-    sceneObj2.constructTransform();
+    mMapScene->transforms.set(
+      handle2,
+      glm::vec3(1081.0f, 150.0f, 605.0f),
+      glm::angleAxis(0.0f, glm::vec3(0.0f, 1.0f, 0.0f)),
+      glm::vec3(5.0f));
 
     auto handle3 = mMapScene->createSceneObject("SphereModelRenderMethod"); 
     auto &sceneObj3 = mMapScene->getSceneObject(handle3);
     sceneObj3.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj3.position = glm::vec3(1051.0f, 105.0f, 575.0f);
-    sceneObj3.scale = glm::vec3(5.0f);
-    sceneObj3.rotation = glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-    sceneObj3.constructTransform();
+    mMapScene->transforms.set(
+      handle3,
+      glm::vec3(1051.0f, 105.0f, 575.0f),
+      glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+      glm::vec3(5.0f));
 
     auto handle4 = mMapScene->createSceneObject("SphereModelRenderMethod"); 
     auto &sceneObj4 = mMapScene->getSceneObject(handle4);
     sceneObj4.pushConstant.color = glm::vec3(0.8f, 0.9f, 0.85f);
-    sceneObj4.position = glm::vec3(951.0f, 90.0f, 705.0f);
-    sceneObj4.scale = glm::vec3(20.0f);
-    sceneObj4.rotation = glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-    sceneObj4.constructTransform();
+    mMapScene->transforms.set(
+      handle4,
+      glm::vec3(951.0f, 90.0f, 705.0f),
+      glm::angleAxis(0.0f, glm::vec3(1.0f, 0.0f, 0.0f)),
+      glm::vec3(20.0f));
   }
 
   renderer.bindScene(mMapScene);
@@ -106,6 +104,14 @@ MapView::MapView(
       glm::normalize(glm::vec3(0.415, -0.123f, 0.9f));
     mMapScene->camera.wUp = glm::vec3(0.0f, 1.0f, 0.0f);
   }
+
+  // Islands appear around the camera first, while the view is already up
+  mMapScene->terrain.queueIslands(
+    100, 5, 0.1f, 1.4f, 20.0f, 0.8f,
+    glm::ivec2(-250, -250) * 7,
+    glm::ivec2(250, 250) * 7,
+    mMapScene->camera.wPosition,
+    mOnEvent);
 }
 
 void MapView::onPush(ViewPushParams &params) {
@@ -146,6 +152,16 @@ void MapView::processGraphicsEvent(Core::Event *ev) {
     resizeEvent->isHandled = true;
   } break;
 
+  case Core::EventType::TerrainGenerationProgress: {
+    auto *progressEvent = (Core::EventTerrainGenerationProgress *)ev;
+    if (progressEvent->finishedColumnCount == progressEvent->columnCount) {
+      LOG_INFOV(
+        "Finished generating terrain (%d chunk columns)\n",
+        (int)progressEvent->columnCount);
+    }
+    progressEvent->isHandled = true;
+  } break;
+
   default:;
   }
 }